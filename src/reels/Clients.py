@@ -22,6 +22,9 @@ from . import new_clients
 from . import destroy_clients
 from . import clients_hash_client_id
 from . import clients_add_client_id
+from . import clients_add_array
+from . import clients_load_client_ids
+from . import clients_set_hash_function
 from . import clients_hash_by_index
 from . import clients_num_clients
 from . import clients_load_block
@@ -63,14 +66,24 @@ class Clients:
     Args:
         binary_image (list): An optional binary image (returned by save_as_binary_image())
                              to initialize the object with data copied from another Clients object.
+        hash_function (str): The function used to hash the client IDs. Either 'murmur' (the default) or the faster
+                             'wyhash'. A Clips object hashes the client IDs with the function of its Clients object (even
+                             if it is empty) and the Targets built from it inherit the same function.
+        client_ids:          Optionally, client IDs to be added in bulk. Anything accepted by add_client_ids().
     """
 
-    def __init__(self, binary_image=None):
+    def __init__(self, binary_image=None, hash_function='murmur', client_ids=None):
         self.cl_id = new_clients()
 
+        if not clients_set_hash_function(self.cl_id, hash_function):
+            raise ValueError("hash_function must be 'murmur' or 'wyhash'.")
+
         if binary_image is not None:
             self.load_from_binary_image(binary_image)
 
+        if client_ids is not None:
+            self.add_client_ids(client_ids)
+
     def __del__(self):
         destroy_clients(self.cl_id)
 
@@ -114,6 +127,32 @@ class Clients:
         """
         return clients_add_client_id(self.cl_id, client)
 
+    def add_client_ids(self, client_ids):
+        """Define many clients at once, a much faster alternative to calling add_client_id() in a loop.
+
+        The client IDs are hashed in parallel. As in add_client_id(), empty and already defined IDs are skipped.
+
+        Args:
+            client_ids: Either the path (str) of a text file with one client ID per line, a NumPy array of already hashed
+                        client IDs (uint64, as returned by hash_client_id() and used by client_hashes()) or a list of str.
+
+        Returns:
+            (int): The number of client IDs added.
+        """
+        if isinstance(client_ids, str):
+            added = clients_load_client_ids(self.cl_id, client_ids)
+            if added < 0:
+                raise FileNotFoundError("Cannot read the file '%s'." % client_ids)
+
+            return added
+
+        if hasattr(client_ids, '__array__'):
+            import numpy as np
+
+            client_ids = np.ascontiguousarray(client_ids)
+
+        return clients_add_array(self.cl_id, client_ids)
+
     def client_hashes(self):
         """Return an iterator to iterate over all the hashed client ids.
 
@@ -21,13 +21,21 @@
 from . import new_clients, new_clips, new_events
 from . import destroy_clips
 from . import clips_set_time_format
+from . import clips_set_client_filter
+from . import clips_set_history
+from . import clips_freeze
+from . import clips_begin_bulk
+from . import clips_end_bulk
+from . import clips_merge
 from . import clips_scan_event
 from . import clips_hash_by_previous
 from . import clips_load_block
 from . import clips_save
+from . import clips_save_empty
 from . import clips_describe_clip
 from . import clips_num_clips
 from . import clips_num_events
+from . import clips_export
 from . import clips_test_sequence
 
 from . import size_binary_image_iterator
@@ -77,19 +85,33 @@ class Clips:
         binary_image: An optional binary image (returned by save_as_binary_image())
                       to initialize the object with data copied from another Clips
                       object. You have to pass empty clients and events to use this.
+        client_filter: Use a Bloom filter (built from clients) to reject faster the rows of clients not in clients in
+                      scan_event(). It is only worth disabling it to save its memory (2 bytes per client).
+        history_length: If not zero, keep only this many of the most recent events of each client. Fitting a Targets only uses
+                      the last tree_depth events before the target, so, for targets after the retained events, this bounds memory
+                      without changing the model.
+        history_seconds: If not zero, keep only the events within this many seconds of the most recent event of each client.
+                      (Neither history setting is saved in the binary image.)
     """
 
     def __init__(
-        self, clients: Clients, events: Events, time_format: str=None, binary_image: list=None
+        self, clients: Clients, events: Events, time_format: str=None, binary_image: list=None, client_filter: bool=True,
+        history_length: int=0, history_seconds: int=0
     ):
         self.cp_id = new_clips(clients.cl_id, events.ev_id)
 
         if time_format is not None:
             clips_set_time_format(self.cp_id, time_format)
 
+        if not client_filter:
+            clips_set_client_filter(self.cp_id, False)
+
         if binary_image is not None:
             self.load_from_binary_image(binary_image)
 
+        if history_length or history_seconds:
+            clips_set_history(self.cp_id, history_length, history_seconds)
+
     def __del__(self):
         destroy_clips(self.cp_id)
 
@@ -125,6 +147,60 @@ class Clips:
         """
         return clips_scan_event(self.cp_id, emitter, description, weight, client, time)
 
+    def freeze(self, compress=False):
+        """Convert the clips into a compact layout of contiguous arrays when no more events will be scanned.
+
+        This uses around 16 bytes per event instead of a tree node per event and makes fitting and predicting from Targets faster.
+        Everything works the same on a frozen object. (Calling scan_event() converts it back to the original layout.)
+
+        Args:
+            compress: If True, the times are stored as varint deltas and the codes as bit-packed indices into the distinct codes.
+                This typically uses 3 to 6 bytes per event at a small cost in decoding speed.
+
+        Returns:
+            (bool): True on success.
+        """
+        return clips_freeze(self.cp_id, compress)
+
+    def begin_bulk(self, compress=False):
+        """Collect the events given to scan_event() in a flat array, to be sorted all at once by end_bulk() for large batch loads.
+
+        This replaces a tree insertion per row by a (multithreaded) sort. Any other method ends the bulk mode. Memory bound: 24 bytes
+        per scanned row (plus at most 1.5 MB) while in bulk mode. end_bulk() counts the events of the clips already in the object as
+        rows and peaks at 48 bytes per row while sorting, or 56 bytes per row when the uncompressed clips have a single event each.
+
+        Args:
+            compress: If True, end_bulk() builds the compressed layout of freeze(compress=True).
+
+        Returns:
+            (bool): True on success.
+        """
+        return clips_begin_bulk(self.cp_id, compress)
+
+    def end_bulk(self):
+        """Sort the events scanned since begin_bulk() and build the clips from them as in freeze(). The clips already in the
+            object are kept and, for the same client and time, the last scanned event wins, the same as without the bulk mode.
+
+        Returns:
+            (bool): True on success.
+        """
+        return clips_end_bulk(self.cp_id)
+
+    def merge(self, other):
+        """Add the clips of another Clips object, built over a disjoint slice of the same transactions, to this one.
+
+        This allows running scan_event() over disjoint slices of the transactions (e.g., Spark partitions) in different Clips
+        objects and reducing them into one. The events of the same client are merged in time order and an event of other at the
+        same time as one in this object replaces it.
+
+        Args:
+            other (Clips): Another Clips object built with the same Events.
+
+        Returns:
+            (bool): True on success. It fails if the objects use a different hash function for the clients.
+        """
+        return clips_merge(self.cp_id, other.cp_id)
+
     def clips_client_hashes(self):
         """Return an iterator to iterate over all the hashed client ids.
 
@@ -163,17 +239,44 @@ class Clips:
         if len(s) != 0:
             return [int(i) for i in s.split('\t')]
 
-    def save_as_binary_image(self):
+    def export_columns(self):
+        """Export all the clips at once as columns, a much faster alternative to clips_client_hashes() and describe_clip() for large
+            objects. The clips of client_hash[i] are time[offset[i]:offset[i + 1]] and code[offset[i]:offset[i + 1]].
+
+        Returns:
+            (dict): A dictionary of NumPy arrays with keys 'client_hash' (uint64, increasing), 'offset' (uint64, one more than the
+                    clients), 'time' (int64, seconds since the epoch, increasing within each clip) and 'code' (uint64). The arrays are
+                    read-only views of a single buffer written once by the c++ object (copied as whole blocks if frozen).
+        """
+        import numpy as np
+
+        raw = clips_export(self.cp_id)
+        n, m = (int(x) for x in np.frombuffer(raw, dtype=np.uint64, count=2))
+
+        cols = {}
+        ofs = 16
+        for key, dtype, count in [('client_hash', np.uint64, n), ('offset', np.uint64, n + 1), ('time', np.int64, m),
+                                  ('code', np.uint64, m)]:
+            cols[key] = np.frombuffer(raw, dtype=dtype, count=count, offset=ofs)
+            ofs += 8*count
+
+        return cols
+
+    def save_as_binary_image(self, empty=False):
         """Saves the state of the c++ Clips object as a Python
             list of strings referred to a binary_image.
 
+        Args:
+            empty: If True, the clips are not saved and the image loads as an empty Clips object with the same clients, events
+                   and time format.
+
         Returns:
             (list): The binary_image containing the state of the Clips. There is
                 not much you can do with it except serializing it as a Python
                 (e.g., pickle) object and loading it into another Clips object.
                 Pass it to the constructor to create an initialized object,
         """
-        bi_idx = clips_save(self.cp_id)
+        bi_idx = clips_save_empty(self.cp_id) if empty else clips_save(self.cp_id)
         if bi_idx == 0:
             return None
 
@@ -21,13 +21,24 @@
 from . import new_events
 from . import destroy_events
 from . import events_insert_row
+from . import events_insert_row_count
 from . import events_define_event
 from . import events_optimize_events
 from . import events_load_block
 from . import events_save
+from . import events_save_empty
 from . import events_describe_next_event
+from . import events_export
 from . import events_set_max_num_events
 from . import events_set_store_strings
+from . import events_set_discovery
+from . import events_set_hash_function
+from . import events_merge
+from . import events_set_admission_filter
+from . import events_set_decay
+from . import events_decay_events
+from . import events_set_sample_rate
+from . import events_estimate_count
 from . import events_num_events
 
 from . import size_binary_image_iterator
@@ -71,15 +82,53 @@ class Events:
         binary_image (bool):  An optional binary image (returned by save_as_binary_image())
                               to initialize the object with data copied from another Events
                               object.
+        discovery (str):      The algorithm used by insert_row() to discover the events. Either
+                              'priority' (the default) or 'space_saving' (a faster Space-Saving
+                              stream-summary with the same code assignment).
+        admission_width (int): If not zero (and discovery is 'priority'), the width of a Count-Min sketch that counts all
+                              the rows and, once max_num_events is reached, only lets a new event in if it is estimated
+                              to be more frequent than the event it would evict. Memory is admission_width*admission_depth
+                              32-bit counters. Small widths overestimate the long tail, the width should be of the order
+                              of the number of distinct events seen in admission_width*10 rows.
+        admission_depth (int): The number of rows (hash functions) of the Count-Min sketch.
+        hash_function (str):  The function used to hash the strings. Either 'murmur' (the default) or the faster 'wyhash'.
+                              (Binary images record it.)
+        decay_half_life (int): If not zero, the counts used to rank the events are halved every decay_half_life rows, so the
+                              events that stop occurring age out and the top max_num_events follow the recent transactions.
+                              (For a window of days, leave it at zero and call decay_events() once per day instead.)
+        sample_rate (float):  If less than 1, insert_row() only uses this fraction of the rows, selected deterministically
+                              by row number, for a faster approximate discovery. See estimate_count().
     """
 
-    def __init__(self, max_num_events=1000, binary_image=None):
+    def __init__(self, max_num_events=1000, binary_image=None, discovery='priority', admission_width=0, admission_depth=4,
+                 hash_function='murmur', decay_half_life=0, sample_rate=1.0):
         self.ev_id = new_events()
 
         events_set_max_num_events(self.ev_id, max_num_events)
         events_set_store_strings(self.ev_id, True)
 
+        if not events_set_discovery(self.ev_id, discovery):
+            raise ValueError("discovery must be 'priority' or 'space_saving'.")
+
+        if not events_set_hash_function(self.ev_id, hash_function):
+            raise ValueError("hash_function must be 'murmur' or 'wyhash'.")
+
+        if admission_width != 0 and not events_set_admission_filter(self.ev_id, admission_width, admission_depth):
+            raise ValueError("admission_width and admission_depth must be positive and discovery must be 'priority'.")
+
+        if decay_half_life != 0 and not events_set_decay(self.ev_id, decay_half_life):
+            raise ValueError("decay_half_life must be positive.")
+
+        if sample_rate != 1 and not events_set_sample_rate(self.ev_id, sample_rate):
+            raise ValueError("sample_rate must be in (0, 1].")
+
         self.max_num_events = max_num_events
+        self.discovery = discovery
+        self.admission_width = admission_width
+        self.admission_depth = admission_depth
+        self.hash_function = hash_function
+        self.decay_half_life = decay_half_life
+        self.sample_rate = sample_rate
 
         if binary_image is not None:
             self.load_from_binary_image(binary_image)
@@ -119,6 +168,23 @@ class Events:
         """
         return events_insert_row(self.ev_id, emitter, description, weight)
 
+    def insert_row_count(self, emitter, description, weight, count):
+        """Process a pre-aggregated row, the same event seen count times (e.g., the result of a GROUP BY emitter, description,
+        weight).
+
+        The result is the same as calling insert_row() count times, but in a single call.
+
+        Args:
+            emitter (str):     The "emitter". A C/Python string representing "owner of event".
+            description (str): The "description". A C/Python string representing "the event".
+            weight (float):    The "weight". A double representing a weight of the event.
+            count (int):       The number of times the event was seen.
+
+        Returns:
+            (bool): True on success.
+        """
+        return events_insert_row_count(self.ev_id, emitter, description, weight, count)
+
     def define_event(self, emitter, description, weight, code):
         """Define events explicitly.
 
@@ -137,6 +203,53 @@ class Events:
         """
         return events_define_event(self.ev_id, emitter, description, weight, code)
 
+    def merge(self, other):
+        """Combine the discovery state of another Events object into this one.
+
+        This allows running insert_row() over disjoint slices of the transactions (e.g., threads or Spark partitions) in different
+        Events objects and reducing them into one. The counts of the same event are added (as mergeable summaries in 'space_saving'
+        mode), the string usage counts are added and the top max_num_events events (by count and then by event) are kept. The
+        events already in this object keep their codes.
+
+        Args:
+            other (Events): Another Events object with the same discovery mode, populated via insert_row().
+
+        Returns:
+            (bool): True on success. It fails if the discovery modes differ or any object contains defined events.
+        """
+        return events_merge(self.ev_id, other.ev_id)
+
+    def estimate_count(self, emitter, description, weight):
+        """Estimate the number of rows of a discovered event from its count in the sampled rows.
+
+        Args:
+            emitter (str):     The "emitter". A C/Python string representing "owner of event".
+            description (str): The "description". A C/Python string representing "the event".
+            weight (float):    The "weight". A double representing a weight of the event.
+
+        Returns:
+            (tuple): The (estimate, lower, upper) of the count with a 95% confidence interval or None if the event is not
+                     in the object. Without sampling, the count is exact and lower == upper == estimate.
+        """
+        ret = events_estimate_count(self.ev_id, emitter, description, weight)
+        if ret == '':
+            return None
+
+        estimate, lower, upper = ret.split('\t')
+
+        return float(estimate), float(lower), float(upper)
+
+    def decay_events(self):
+        """Halve the counts of all the discovered events.
+
+        Events whose count becomes zero are removed, the others keep their codes. This is done automatically every
+        decay_half_life rows if set in the constructor, calling it once per day keeps the events of the recent days.
+
+        Returns:
+            (bool): True on success.
+        """
+        return events_decay_events(self.ev_id)
+
     def num_events(self):
         """Return the number of events in the object.
 
@@ -153,17 +266,47 @@ class Events:
         """
         return EventTuples(self.ev_id)
 
-    def save_as_binary_image(self):
+    def export_columns(self):
+        """Export all the events at once as columns, a much faster alternative to describe_events() for large objects.
+
+        Returns:
+            (dict): A dictionary of NumPy arrays (in the same order) with keys 'e', 'd' (the hashes of the emitter and description,
+                    uint64), 'w' (the weight, float64), 'seen', 'code', 'priority' (uint64), 'emitter' and 'description' (the
+                    strings as object arrays). The numeric arrays are read-only views of a single buffer.
+        """
+        import numpy as np
+
+        raw = events_export(self.ev_id)
+        n = int(np.frombuffer(raw, dtype=np.uint64, count=1)[0])
+
+        cols = {}
+        for i, (key, dtype) in enumerate([('e', np.uint64), ('d', np.uint64), ('w', np.float64), ('seen', np.uint64),
+                                          ('code', np.uint64), ('priority', np.uint64)]):
+            cols[key] = np.frombuffer(raw, dtype=dtype, count=n, offset=8 + 8*n*i)
+
+        str_ix = np.frombuffer(raw, dtype=np.uint32, count=2*n, offset=8 + 48*n)
+        strings = np.array([s.decode('utf-8', errors='replace') for s in raw[8 + 56*n:-1].split(b'\0')], dtype=object)
+
+        cols['emitter'] = strings[str_ix[0:n]]
+        cols['description'] = strings[str_ix[n:2*n]]
+
+        return cols
+
+    def save_as_binary_image(self, empty=False):
         """Saves the state of the c++ Events object as a Python
             list of strings referred to a binary_image.
 
+        Args:
+            empty: If True, the events are not saved and the image loads as an empty Events object with the same settings
+                   (discovery, admission filter, decay, sampling, hash function and max_num_events).
+
         Returns:
             (list): The binary_image containing the state of the Events. There is
                 not much you can do with it except serializing it as a Python
                 (e.g., pickle) object and loading it into another Events object.
                 Pass it to the constructor to create an initialized object,
         """
-        bi_idx = events_save(self.ev_id)
+        bi_idx = events_save_empty(self.ev_id) if empty else events_save(self.ev_id)
         if bi_idx == 0:
             return None
 
@@ -219,9 +362,9 @@ class Events:
             The algorithm builds a list of most promising (not already used) codes at the beginning of each step by full tree search.
             From that list, each code is tried downwards as {noise, new_code, last_code} for score improvement above threshold
             up to codes_per_step steps. And assigned a new code accordingly.
-            The codes assigned become part of the internal EventCodeMap and in the next step they will replace their old values.
+            The codes assigned become part of the internal dictionary and in the next step they will replace their old values.
 
-            When the algorithm finishes, the internal EventCodeMap is used to rename the object codes and the whole process is reported.
+            When the algorithm finishes, the internal dictionary is used to rename the object codes and the whole process is reported.
 
         Args:
             clips:          The id of a clips object with the same codes and clips for a set of clients whose prediction we optimize.
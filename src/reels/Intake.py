@@ -101,6 +101,7 @@ class SparkClipsAcc(AccumulatorParam):
         resources (number of workers) is high and therefore the process will benefit from parallelism.
         In any other setting, you should not use this class. This class is created when you construct an Intake object with
         spark_method == 'accumulator'. The much safer (and possibly slower) spark_method == 'local_iterator' will not require a lot of RAM.
+        With spark_method == 'merge', the workers ship binary images of partial Clips objects instead of the tuples.
     """
 
     def zero(self, value):
@@ -133,17 +134,21 @@ class Intake:
 
     This object implements data populating methods (in plural) that call the equivalent methods (in singular) over a complete dataframe.
 
-      - insert_rows()    is Events.insert_row() for each row
-      - define_events()  is Events.define_event() for each row
-      - scan_events()    is Clips.scan_event() for each row
-      - insert_targets() is Targets.insert_target() for each row
+      - insert_rows()       is Events.insert_row() for each row
+      - insert_row_counts() is Events.insert_row_count() for each row
+      - define_events()     is Events.define_event() for each row
+      - scan_events()       is Clips.scan_event() for each row
+      - insert_targets()    is Targets.insert_target() for each row
 
     Args:
         dataframe:    Either a pandas or a pyspark dataframe with the data to be loaded into reels objects.
         spark_method: This only applies to pyspark dataframe. It has two possible values 'local_iterator' (default) the safest and less
                       RAM consuming. If your environment has many workers (and therefore you would want to improve performance via
                       parallelism) and you have enough RAM in the driver to hold a list of tuples with the values you want to load,
-                      you can try the more efficient but also more experimental 'accumulator' value.
+                      you can try the more efficient but also more experimental 'accumulator' value. A third value 'merge' only
+                      applies to insert_rows() and scan_events(): each partition builds its own Events or Clips object (in the
+                      workers) and the driver merges their binary images using Events.merge() or Clips.merge(). Other methods use
+                      'local_iterator' in that case.
     """
 
     def __init__(self, dataframe: pd.DataFrame, spark_method: str='local_iterator'):
@@ -159,6 +164,7 @@ class Intake:
             self.sp_data = dataframe
 
             self.use_accumulator = (spark_method == 'accumulator') and SPARK is not None
+            self.use_merge = (spark_method == 'merge')
 
             return
 
@@ -174,6 +180,8 @@ class Intake:
             cols = len(self.sp_data.columns)
             names = ', '.join(self.sp_data.columns)
             title = 'reels.Intake object using pyspark %s' % ['(iterator)', '(accumulator)'][int(self.use_accumulator)]
+            if self.use_merge:
+                title = 'reels.Intake object using pyspark (merge)'
 
         return '%s\n\nColumn names: %s\n\nShape: %i x %i' % (title, names, rows, cols)
 
@@ -192,6 +200,25 @@ class Intake:
         if columns is None:
             columns = ['emitter', 'description', 'weight']
 
+        if self.sp_data is not None and self.use_merge:
+            from reels.Events import Events
+
+            events_image = events.save_as_binary_image(empty=True)
+
+            def f(rows):
+                part = Events(binary_image=events_image)
+
+                for row in rows:
+                    part.insert_row(str(row[columns[0]]), str(row[columns[1]]), float(row[columns[2]]))
+
+                yield part.save_as_binary_image()
+
+            for binary_image in self.sp_data.rdd.mapPartitions(f).toLocalIterator():
+                if not events.merge(Events(binary_image=binary_image)):
+                    raise ValueError('Events.merge() failed, the events cannot be merged with a partition.')
+
+            return
+
         if self.sp_data is not None and self.use_accumulator:
             events_acc.value = events
 
@@ -220,6 +247,33 @@ class Intake:
             for row in self.sp_data.rdd.toLocalIterator():
                 lambda_f(row)
 
+    def insert_row_counts(self, events: object, columns: list=None):
+        """Populate an Events object calling events.insert_row_count() over the entire (pre-aggregated) dataframe.
+
+        Since aggregated data is expected to be small, pyspark dataframes are always read using 'local_iterator'.
+
+        Args:
+            events:  The Events object to be filled with data.
+            columns: A list with the names of the four columns containing (emitter, description, weight, count) in the dataframe.
+                     The default value is ['emitter', 'description', 'weight', 'count'].
+        """
+
+        if columns is None:
+            columns = ['emitter', 'description', 'weight', 'count']
+
+        lambda_f = lambda row: events.insert_row_count(     # noqa: E731
+            str(row[columns[0]]),
+            str(row[columns[1]]),
+            float(row[columns[2]]),
+            int(row[columns[3]]),
+        )
+
+        if self.pd_data is not None:
+            self.pd_data.apply(lambda_f, axis=1)
+        else:
+            for row in self.sp_data.rdd.toLocalIterator():
+                lambda_f(row)
+
     def define_events(self, events: object, columns: str=None):
         """Populate an Events object calling events.define_event() over the entire dataframe.
 
@@ -257,6 +311,28 @@ class Intake:
         if columns is None:
             columns = ['emitter', 'description', 'weight', 'client', 'time']
 
+        if self.sp_data is not None and self.use_merge:
+            from reels.Clients import Clients
+            from reels.Clips import Clips
+            from reels.Events import Events
+
+            clips_image = clips.save_as_binary_image(empty=True)
+
+            def f(rows):
+                part = Clips(Clients(), Events(), binary_image=clips_image)
+
+                for row in rows:
+                    part.scan_event(str(row[columns[0]]), str(row[columns[1]]), float(row[columns[2]]), str(row[columns[3]]),
+                                    str(row[columns[4]]))
+
+                yield part.save_as_binary_image()
+
+            for binary_image in self.sp_data.rdd.mapPartitions(f).toLocalIterator():
+                if not clips.merge(Clips(Clients(), Events(), binary_image=binary_image)):
+                    raise ValueError('Clips.merge() failed, the clips cannot be merged with a partition.')
+
+            return
+
         if self.sp_data is not None and self.use_accumulator:
             clips_acc.value = clips
 
@@ -22,6 +22,7 @@ from . import new_clients, new_clips, new_events, new_targets
 from . import destroy_targets
 from . import clips_num_clips
 from . import targets_set_time_format
+from . import targets_set_window
 from . import targets_insert_target
 from . import targets_fit
 from . import targets_predict_clients
@@ -81,15 +82,24 @@ class Targets:
         binary_image: An optional binary image (returned by save_as_binary_image())
                       to initialize the object with data copied from another Clips
                       object. You have to pass empty clips to use this.
+        since:        An optional time (in time_format) of the first event of the clips seen by
+                      fit(), predict() and save(). The events before it are ignored.
+        until:        An optional time (in time_format) after the last event of the clips seen by
+                      fit(), predict() and save(). The events at or after it are ignored. This allows
+                      backtesting as of different dates on the same Clips object without rebuilding it.
     """
 
-    def __init__(self, clips: Clips, time_format: str=None, binary_image: list=None):
+    def __init__(self, clips: Clips, time_format: str=None, binary_image: list=None, since: str=None, until: str=None):
         self.tr_id = new_targets(clips.cp_id)
         self.cp_id = clips.cp_id
 
         if time_format is not None:
             targets_set_time_format(self.tr_id, time_format)
 
+        if since is not None or until is not None:
+            if not targets_set_window(self.tr_id, since or '', until or ''):
+                raise ValueError('Wrong time format in since or until.')
+
         if binary_image is not None:
             self.load_from_binary_image(binary_image)
 
@@ -68,6 +68,9 @@ def destroy_events(id):
 def events_insert_row(id, p_e, p_d, w):
     return _py_reels.events_insert_row(id, p_e, p_d, w)
 
+def events_insert_row_count(id, p_e, p_d, w, n):
+    return _py_reels.events_insert_row_count(id, p_e, p_d, w, n)
+
 def events_define_event(id, p_e, p_d, w, code):
     return _py_reels.events_define_event(id, p_e, p_d, w, code)
 
@@ -80,15 +83,45 @@ def events_load_block(id, p_block):
 def events_save(id):
     return _py_reels.events_save(id)
 
+def events_save_empty(id):
+    return _py_reels.events_save_empty(id)
+
 def events_describe_next_event(id, prev_event):
     return _py_reels.events_describe_next_event(id, prev_event)
 
+def events_export(id):
+    return _py_reels.events_export(id)
+
 def events_set_max_num_events(id, max_events):
     return _py_reels.events_set_max_num_events(id, max_events)
 
 def events_set_store_strings(id, store):
     return _py_reels.events_set_store_strings(id, store)
 
+def events_set_discovery(id, mode):
+    return _py_reels.events_set_discovery(id, mode)
+
+def events_set_hash_function(id, p_name):
+    return _py_reels.events_set_hash_function(id, p_name)
+
+def events_merge(id, id_other):
+    return _py_reels.events_merge(id, id_other)
+
+def events_set_admission_filter(id, width, depth):
+    return _py_reels.events_set_admission_filter(id, width, depth)
+
+def events_set_decay(id, half_life):
+    return _py_reels.events_set_decay(id, half_life)
+
+def events_decay_events(id):
+    return _py_reels.events_decay_events(id)
+
+def events_set_sample_rate(id, rate):
+    return _py_reels.events_set_sample_rate(id, rate)
+
+def events_estimate_count(id, p_e, p_d, w):
+    return _py_reels.events_estimate_count(id, p_e, p_d, w)
+
 def events_num_events(id):
     return _py_reels.events_num_events(id)
 
@@ -104,6 +137,15 @@ def clients_hash_client_id(id, p_cli):
 def clients_add_client_id(id, p_cli):
     return _py_reels.clients_add_client_id(id, p_cli)
 
+def clients_add_array(id, p_ids):
+    return _py_reels.clients_add_array(id, p_ids)
+
+def clients_load_client_ids(id, p_path):
+    return _py_reels.clients_load_client_ids(id, p_path)
+
+def clients_set_hash_function(id, p_name):
+    return _py_reels.clients_set_hash_function(id, p_name)
+
 def clients_hash_by_index(id, idx):
     return _py_reels.clients_hash_by_index(id, idx)
 
@@ -125,6 +167,24 @@ def destroy_clips(id):
 def clips_set_time_format(id, fmt):
     return _py_reels.clips_set_time_format(id, fmt)
 
+def clips_set_client_filter(id, use):
+    return _py_reels.clips_set_client_filter(id, use)
+
+def clips_set_history(id, length, seconds):
+    return _py_reels.clips_set_history(id, length, seconds)
+
+def clips_freeze(id, compress):
+    return _py_reels.clips_freeze(id, compress)
+
+def clips_begin_bulk(id, compress):
+    return _py_reels.clips_begin_bulk(id, compress)
+
+def clips_end_bulk(id):
+    return _py_reels.clips_end_bulk(id)
+
+def clips_merge(id, id_other):
+    return _py_reels.clips_merge(id, id_other)
+
 def clips_scan_event(id, p_e, p_d, w, p_c, p_t):
     return _py_reels.clips_scan_event(id, p_e, p_d, w, p_c, p_t)
 
@@ -137,6 +197,9 @@ def clips_load_block(id, p_block):
 def clips_save(id):
     return _py_reels.clips_save(id)
 
+def clips_save_empty(id):
+    return _py_reels.clips_save_empty(id)
+
 def clips_describe_clip(id, client_id):
     return _py_reels.clips_describe_clip(id, client_id)
 
@@ -146,6 +209,9 @@ def clips_num_clips(id):
 def clips_num_events(id):
     return _py_reels.clips_num_events(id)
 
+def clips_export(id):
+    return _py_reels.clips_export(id)
+
 def clips_test_sequence(seq_num, target):
     return _py_reels.clips_test_sequence(seq_num, target)
 
@@ -158,6 +224,9 @@ def destroy_targets(id):
 def targets_set_time_format(id, fmt):
     return _py_reels.targets_set_time_format(id, fmt)
 
+def targets_set_window(id, since, until):
+    return _py_reels.targets_set_window(id, since, until)
+
 def targets_insert_target(id, p_c, p_t):
     return _py_reels.targets_insert_target(id, p_c, p_t)
 
@@ -4,21 +4,35 @@
 	extern int  new_events();
 	extern bool destroy_events(int id);
 	extern bool events_insert_row(int id, char *p_e, char *p_d, double w);
+	extern bool events_insert_row_count(int id, char *p_e, char *p_d, double w, int n);
 	extern bool events_define_event(int id, char *p_e, char *p_d, double w, int code);
 	extern char *events_optimize_events(int id, int id_clips, int id_targets, int num_steps, int codes_per_step, double threshold,
 										char *force_include, char *force_exclude, char *x_form, char *agg, double p, int depth,
 										int as_states, double exp_decay, double lower_bound_p, bool log_lift);
 	extern bool events_load_block(int id, char *p_block);
 	extern int	events_save(int id);
+	extern int	events_save_empty(int id);
 	extern char *events_describe_next_event(int id, char *prev_event);
+	extern PyObject *events_export(int id);
 	extern bool events_set_max_num_events(int id, int max_events);
 	extern bool events_set_store_strings(int id, bool store);
+	extern bool events_set_discovery(int id, char *mode);
+	extern bool events_set_hash_function(int id, char *p_name);
+	extern bool events_merge(int id, int id_other);
+	extern bool events_set_admission_filter(int id, int width, int depth);
+	extern bool events_set_decay(int id, int half_life);
+	extern bool events_decay_events(int id);
+	extern bool events_set_sample_rate(int id, double rate);
+	extern char *events_estimate_count(int id, char *p_e, char *p_d, double w);
 	extern int  events_num_events(int id);
 
 	extern int  new_clients();
 	extern bool destroy_clients(int id);
 	extern char *clients_hash_client_id(int id, char *p_cli);
 	extern bool clients_add_client_id(int id, char *p_cli);
+	extern PyObject *clients_add_array(int id, PyObject *p_ids);
+	extern int	clients_load_client_ids(int id, char *p_path);
+	extern bool clients_set_hash_function(int id, char *p_name);
 	extern char *clients_hash_by_index(int id, int idx);
 	extern int	clients_num_clients(int id);
 	extern bool clients_load_block(int id, char *p_block);
@@ -27,18 +41,27 @@
 	extern int  new_clips(int id_clients, int id_events);
 	extern bool destroy_clips(int id);
 	extern bool clips_set_time_format(int id, char *fmt);
+	extern bool clips_set_client_filter(int id, bool use);
+	extern bool clips_set_history(int id, int length, int seconds);
+	extern bool clips_freeze(int id, bool compress);
+	extern bool clips_begin_bulk(int id, bool compress);
+	extern bool clips_end_bulk(int id);
+	extern bool clips_merge(int id, int id_other);
 	extern bool clips_scan_event(int id, char *p_e, char *p_d, double w, char *p_c, char *p_t);
 	extern char *clips_hash_by_previous(int id, char *prev_hash);
 	extern bool clips_load_block(int id, char *p_block);
 	extern int	clips_save(int id);
+	extern int	clips_save_empty(int id);
 	extern char *clips_describe_clip(int id, char *client_id);
 	extern int	clips_num_clips(int id);
 	extern int	clips_num_events(int id);
+	extern PyObject *clips_export(int id);
 	extern char *clips_test_sequence(int seq_num, bool target);
 
 	extern int  new_targets(int id_clips);
 	extern bool destroy_targets(int id);
 	extern bool targets_set_time_format(int id, char *fmt);
+	extern bool targets_set_window(int id, char *since, char *until);
 	extern bool targets_insert_target(int id, char *p_c, char *p_t);
 	extern bool targets_fit(int id, char *x_form, char *agg, double p, int depth, int as_states);
 	extern int	targets_predict_clients(int id, int id_clients);
@@ -58,26 +81,147 @@
 	extern int  size_binary_image_iterator(int image_id);
 	extern char *next_binary_image_iterator(int image_id);
 	extern bool destroy_binary_image_iterator(int image_id);
+
+	#include <string>
+	#include <vector>
+
+	extern bool events_export_columns(int id, std::string &raw);
+
+	PyObject *events_export(int id) {
+		std::string raw;
+
+		if (!events_export_columns(id, raw))
+			Py_RETURN_NONE;
+
+		return PyBytes_FromStringAndSize(raw.data(), raw.size());
+	}
+
+	extern int64_t clients_add_client_hashes(int id, const uint64_t *p_hash, uint64_t n);
+	extern int	   clients_hash_function(int id);
+	extern void	   hash_client_ids(int hash_fn, char **p_cli, uint64_t *p_len, uint64_t n, uint64_t *p_hash);
+
+	PyObject *clients_add_array(int id, PyObject *p_ids) {
+		int64_t added;
+
+		if (PyObject_CheckBuffer(p_ids)) {
+			Py_buffer view;
+
+			if (PyObject_GetBuffer(p_ids, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0)
+				return NULL;
+
+			const char *p_fmt = view.format == NULL ? "B" : view.format;
+
+			if (*p_fmt == '@' || *p_fmt == '=' || *p_fmt == '<')
+				p_fmt++;
+
+			if (view.itemsize != 8 || (strcmp(p_fmt, "Q") != 0 && strcmp(p_fmt, "L") != 0)) {
+				PyBuffer_Release(&view);
+				PyErr_SetString(PyExc_TypeError, "The array must contain 64 bit hashes (dtype uint64).");
+				return NULL;
+			}
+
+			added = clients_add_client_hashes(id, (uint64_t *) view.buf, view.len/8);
+
+			PyBuffer_Release(&view);
+		} else {
+			int hash_fn = clients_hash_function(id);
+
+			if (hash_fn < 0)
+				Py_RETURN_NONE;
+
+			PyObject *p_seq = PySequence_Fast(p_ids, "The client ids must be a NumPy array or a sequence of str.");
+
+			if (p_seq == NULL)
+				return NULL;
+
+			Py_ssize_t n = PySequence_Fast_GET_SIZE(p_seq);
+
+			std::vector<char *>	  p_cli(n);
+			std::vector<uint64_t> p_len(n), hash(n);
+
+			for (Py_ssize_t i = 0; i < n; i++) {
+				Py_ssize_t len;
+
+				p_cli[i] = (char *) PyUnicode_AsUTF8AndSize(PySequence_Fast_GET_ITEM(p_seq, i), &len);
+
+				if (p_cli[i] == NULL) {
+					Py_DECREF(p_seq);
+					return NULL;
+				}
+				p_len[i] = len;
+			}
+
+			Py_BEGIN_ALLOW_THREADS
+			hash_client_ids(hash_fn, p_cli.data(), p_len.data(), n, hash.data());
+			Py_END_ALLOW_THREADS
+
+			Py_DECREF(p_seq);
+
+			added = clients_add_client_hashes(id, hash.data(), n);
+		}
+
+		if (added < 0)
+			Py_RETURN_NONE;
+
+		return PyLong_FromLongLong(added);
+	}
+
+	extern void *clips_export_prepare(int id, uint64_t &n, uint64_t &m);
+	extern void	 clips_export_columns(void *p_clips, char *p_raw, uint64_t n, uint64_t m);
+
+	PyObject *clips_export(int id) {
+		uint64_t n, m;
+
+		void *p_clips = clips_export_prepare(id, n, m);
+
+		if (p_clips == NULL)
+			Py_RETURN_NONE;
+
+		PyObject *p_raw = PyBytes_FromStringAndSize(NULL, (3 + 2*n + 2*m)*sizeof(uint64_t));
+
+		if (p_raw == NULL)
+			return NULL;
+
+		Py_BEGIN_ALLOW_THREADS
+		clips_export_columns(p_clips, PyBytes_AS_STRING(p_raw), n, m);
+		Py_END_ALLOW_THREADS
+
+		return p_raw;
+	}
 %}
 
 extern int  new_events();
 extern bool destroy_events(int id);
 extern bool events_insert_row(int id, char *p_e, char *p_d, double w);
+extern bool events_insert_row_count(int id, char *p_e, char *p_d, double w, int n);
 extern bool events_define_event(int id, char *p_e, char *p_d, double w, int code);
 extern char *events_optimize_events(int id, int id_clips, int id_targets, int num_steps, int codes_per_step, double threshold,
 									char *force_include, char *force_exclude, char *x_form, char *agg, double p, int depth,
 									int as_states, double exp_decay, double lower_bound_p, bool log_lift);
 extern bool events_load_block(int id, char *p_block);
 extern int	events_save(int id);
+extern int	events_save_empty(int id);
 extern char *events_describe_next_event(int id, char *prev_event);
+extern PyObject *events_export(int id);
 extern bool events_set_max_num_events(int id, int max_events);
 extern bool events_set_store_strings(int id, bool store);
+extern bool events_set_discovery(int id, char *mode);
+extern bool events_set_hash_function(int id, char *p_name);
+extern bool events_merge(int id, int id_other);
+extern bool events_set_admission_filter(int id, int width, int depth);
+extern bool events_set_decay(int id, int half_life);
+extern bool events_decay_events(int id);
+extern bool events_set_sample_rate(int id, double rate);
+extern char *events_estimate_count(int id, char *p_e, char *p_d, double w);
 extern int  events_num_events(int id);
 
 extern int  new_clients();
 extern bool destroy_clients(int id);
 extern char *clients_hash_client_id(int id, char *p_cli);
 extern bool clients_add_client_id(int id, char *p_cli);
+extern PyObject *clients_add_array(int id, PyObject *p_ids);
+extern int	clients_load_client_ids(int id, char *p_path);
+extern bool clients_set_hash_function(int id, char *p_name);
 extern char *clients_hash_by_index(int id, int idx);
 extern int	clients_num_clients(int id);
 extern bool clients_load_block(int id, char *p_block);
@@ -86,18 +230,27 @@ extern int	clients_save(int id);
 extern int  new_clips(int id_clients, int id_events);
 extern bool destroy_clips(int id);
 extern bool clips_set_time_format(int id, char *fmt);
+extern bool clips_set_client_filter(int id, bool use);
+extern bool clips_set_history(int id, int length, int seconds);
+extern bool clips_freeze(int id, bool compress);
+extern bool clips_begin_bulk(int id, bool compress);
+extern bool clips_end_bulk(int id);
+extern bool clips_merge(int id, int id_other);
 extern bool clips_scan_event(int id, char *p_e, char *p_d, double w, char *p_c, char *p_t);
 extern char *clips_hash_by_previous(int id, char *prev_hash);
 extern bool clips_load_block(int id, char *p_block);
 extern int	clips_save(int id);
+extern int	clips_save_empty(int id);
 extern char *clips_describe_clip(int id, char *client_id);
 extern int	clips_num_clips(int id);
 extern int	clips_num_events(int id);
+extern PyObject *clips_export(int id);
 extern char *clips_test_sequence(int seq_num, bool target);
 
 extern int  new_targets(int id_clips);
 extern bool destroy_targets(int id);
 extern bool targets_set_time_format(int id, char *fmt);
+extern bool targets_set_window(int id, char *since, char *until);
 extern bool targets_insert_target(int id, char *p_c, char *p_t);
 extern bool targets_fit(int id, char *x_form, char *agg, double p, int depth, int as_states);
 extern int	targets_predict_clients(int id, int id_clients);
@@ -3180,21 +3180,35 @@ static swig_module_info swig_module = {swig_types, 1, 0, 0, 0, 0};
 	extern int  new_events();
 	extern bool destroy_events(int id);
 	extern bool events_insert_row(int id, char *p_e, char *p_d, double w);
+	extern bool events_insert_row_count(int id, char *p_e, char *p_d, double w, int n);
 	extern bool events_define_event(int id, char *p_e, char *p_d, double w, int code);
 	extern char *events_optimize_events(int id, int id_clips, int id_targets, int num_steps, int codes_per_step, double threshold,
 										char *force_include, char *force_exclude, char *x_form, char *agg, double p, int depth,
 										int as_states, double exp_decay, double lower_bound_p, bool log_lift);
 	extern bool events_load_block(int id, char *p_block);
 	extern int	events_save(int id);
+	extern int	events_save_empty(int id);
 	extern char *events_describe_next_event(int id, char *prev_event);
+	extern PyObject *events_export(int id);
 	extern bool events_set_max_num_events(int id, int max_events);
 	extern bool events_set_store_strings(int id, bool store);
+	extern bool events_set_discovery(int id, char *mode);
+	extern bool events_set_hash_function(int id, char *p_name);
+	extern bool events_merge(int id, int id_other);
+	extern bool events_set_admission_filter(int id, int width, int depth);
+	extern bool events_set_decay(int id, int half_life);
+	extern bool events_decay_events(int id);
+	extern bool events_set_sample_rate(int id, double rate);
+	extern char *events_estimate_count(int id, char *p_e, char *p_d, double w);
 	extern int  events_num_events(int id);
 
 	extern int  new_clients();
 	extern bool destroy_clients(int id);
 	extern char *clients_hash_client_id(int id, char *p_cli);
 	extern bool clients_add_client_id(int id, char *p_cli);
+	extern PyObject *clients_add_array(int id, PyObject *p_ids);
+	extern int	clients_load_client_ids(int id, char *p_path);
+	extern bool clients_set_hash_function(int id, char *p_name);
 	extern char *clients_hash_by_index(int id, int idx);
 	extern int	clients_num_clients(int id);
 	extern bool clients_load_block(int id, char *p_block);
@@ -3203,18 +3217,27 @@ static swig_module_info swig_module = {swig_types, 1, 0, 0, 0, 0};
 	extern int  new_clips(int id_clients, int id_events);
 	extern bool destroy_clips(int id);
 	extern bool clips_set_time_format(int id, char *fmt);
+	extern bool clips_set_client_filter(int id, bool use);
+	extern bool clips_set_history(int id, int length, int seconds);
+	extern bool clips_freeze(int id, bool compress);
+	extern bool clips_begin_bulk(int id, bool compress);
+	extern bool clips_end_bulk(int id);
+	extern bool clips_merge(int id, int id_other);
 	extern bool clips_scan_event(int id, char *p_e, char *p_d, double w, char *p_c, char *p_t);
 	extern char *clips_hash_by_previous(int id, char *prev_hash);
 	extern bool clips_load_block(int id, char *p_block);
 	extern int	clips_save(int id);
+	extern int	clips_save_empty(int id);
 	extern char *clips_describe_clip(int id, char *client_id);
 	extern int	clips_num_clips(int id);
 	extern int	clips_num_events(int id);
+	extern PyObject *clips_export(int id);
 	extern char *clips_test_sequence(int seq_num, bool target);
 
 	extern int  new_targets(int id_clips);
 	extern bool destroy_targets(int id);
 	extern bool targets_set_time_format(int id, char *fmt);
+	extern bool targets_set_window(int id, char *since, char *until);
 	extern bool targets_insert_target(int id, char *p_c, char *p_t);
 	extern bool targets_fit(int id, char *x_form, char *agg, double p, int depth, int as_states);
 	extern int	targets_predict_clients(int id, int id_clients);
@@ -3235,6 +3258,113 @@ static swig_module_info swig_module = {swig_types, 1, 0, 0, 0, 0};
 	extern char *next_binary_image_iterator(int image_id);
 	extern bool destroy_binary_image_iterator(int image_id);
 
+	#include <string>
+	#include <vector>
+
+	extern bool events_export_columns(int id, std::string &raw);
+
+	PyObject *events_export(int id) {
+		std::string raw;
+
+		if (!events_export_columns(id, raw))
+			Py_RETURN_NONE;
+
+		return PyBytes_FromStringAndSize(raw.data(), raw.size());
+	}
+
+	extern int64_t clients_add_client_hashes(int id, const uint64_t *p_hash, uint64_t n);
+	extern int	   clients_hash_function(int id);
+	extern void	   hash_client_ids(int hash_fn, char **p_cli, uint64_t *p_len, uint64_t n, uint64_t *p_hash);
+
+	PyObject *clients_add_array(int id, PyObject *p_ids) {
+		int64_t added;
+
+		if (PyObject_CheckBuffer(p_ids)) {
+			Py_buffer view;
+
+			if (PyObject_GetBuffer(p_ids, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0)
+				return NULL;
+
+			const char *p_fmt = view.format == NULL ? "B" : view.format;
+
+			if (*p_fmt == '@' || *p_fmt == '=' || *p_fmt == '<')
+				p_fmt++;
+
+			if (view.itemsize != 8 || (strcmp(p_fmt, "Q") != 0 && strcmp(p_fmt, "L") != 0)) {
+				PyBuffer_Release(&view);
+				PyErr_SetString(PyExc_TypeError, "The array must contain 64 bit hashes (dtype uint64).");
+				return NULL;
+			}
+
+			added = clients_add_client_hashes(id, (uint64_t *) view.buf, view.len/8);
+
+			PyBuffer_Release(&view);
+		} else {
+			int hash_fn = clients_hash_function(id);
+
+			if (hash_fn < 0)
+				Py_RETURN_NONE;
+
+			PyObject *p_seq = PySequence_Fast(p_ids, "The client ids must be a NumPy array or a sequence of str.");
+
+			if (p_seq == NULL)
+				return NULL;
+
+			Py_ssize_t n = PySequence_Fast_GET_SIZE(p_seq);
+
+			std::vector<char *>	  p_cli(n);
+			std::vector<uint64_t> p_len(n), hash(n);
+
+			for (Py_ssize_t i = 0; i < n; i++) {
+				Py_ssize_t len;
+
+				p_cli[i] = (char *) PyUnicode_AsUTF8AndSize(PySequence_Fast_GET_ITEM(p_seq, i), &len);
+
+				if (p_cli[i] == NULL) {
+					Py_DECREF(p_seq);
+					return NULL;
+				}
+				p_len[i] = len;
+			}
+
+			Py_BEGIN_ALLOW_THREADS
+			hash_client_ids(hash_fn, p_cli.data(), p_len.data(), n, hash.data());
+			Py_END_ALLOW_THREADS
+
+			Py_DECREF(p_seq);
+
+			added = clients_add_client_hashes(id, hash.data(), n);
+		}
+
+		if (added < 0)
+			Py_RETURN_NONE;
+
+		return PyLong_FromLongLong(added);
+	}
+
+	extern void *clips_export_prepare(int id, uint64_t &n, uint64_t &m);
+	extern void	 clips_export_columns(void *p_clips, char *p_raw, uint64_t n, uint64_t m);
+
+	PyObject *clips_export(int id) {
+		uint64_t n, m;
+
+		void *p_clips = clips_export_prepare(id, n, m);
+
+		if (p_clips == NULL)
+			Py_RETURN_NONE;
+
+		PyObject *p_raw = PyBytes_FromStringAndSize(NULL, (3 + 2*n + 2*m)*sizeof(uint64_t));
+
+		if (p_raw == NULL)
+			return NULL;
+
+		Py_BEGIN_ALLOW_THREADS
+		clips_export_columns(p_clips, PyBytes_AS_STRING(p_raw), n, m);
+		Py_END_ALLOW_THREADS
+
+		return p_raw;
+	}
+
 
 SWIGINTERNINLINE PyObject*
   SWIG_From_int  (int value)
@@ -3653,6 +3783,67 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_events_insert_row_count(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  char *arg3 = (char *) 0 ;
+  double arg4 ;
+  int arg5 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  int res3 ;
+  char *buf3 = 0 ;
+  int alloc3 = 0 ;
+  double val4 ;
+  int ecode4 = 0 ;
+  int val5 ;
+  int ecode5 = 0 ;
+  PyObject *swig_obj[5] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "events_insert_row_count", 5, 5, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_insert_row_count" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "events_insert_row_count" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  res3 = SWIG_AsCharPtrAndSize(swig_obj[2], &buf3, NULL, &alloc3);
+  if (!SWIG_IsOK(res3)) {
+    SWIG_exception_fail(SWIG_ArgError(res3), "in method '" "events_insert_row_count" "', argument " "3"" of type '" "char *""'");
+  }
+  arg3 = (char *)(buf3);
+  ecode4 = SWIG_AsVal_double(swig_obj[3], &val4);
+  if (!SWIG_IsOK(ecode4)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode4), "in method '" "events_insert_row_count" "', argument " "4"" of type '" "double""'");
+  }
+  arg4 = (double)(val4);
+  ecode5 = SWIG_AsVal_int(swig_obj[4], &val5);
+  if (!SWIG_IsOK(ecode5)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode5), "in method '" "events_insert_row_count" "', argument " "5"" of type '" "int""'");
+  }
+  arg5 = (int)(val5);
+  result = (bool)events_insert_row_count(arg1,arg2,arg3,arg4,arg5);
+  resultobj = SWIG_From_bool((bool)(result));
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  if (alloc3 == SWIG_NEWOBJ) free((char*)buf3);
+  return resultobj;
+fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  if (alloc3 == SWIG_NEWOBJ) free((char*)buf3);
+  return NULL;
+}
+
+
 SWIGINTERN PyObject *_wrap_events_define_event(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
@@ -3927,6 +4118,30 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_events_save_empty(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  int result;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_save_empty" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (int)events_save_empty(arg1);
+  resultobj = SWIG_From_int((int)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
 SWIGINTERN PyObject *_wrap_events_describe_next_event(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
@@ -3961,6 +4176,30 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_events_export(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  PyObject *result = 0 ;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_export" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (PyObject *)events_export(arg1);
+  resultobj = result;
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
 SWIGINTERN PyObject *_wrap_events_set_max_num_events(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
@@ -4023,137 +4262,145 @@ fail:
 }
 
 
-SWIGINTERN PyObject *_wrap_events_num_events(PyObject *self, PyObject *args) {
+SWIGINTERN PyObject *_wrap_events_set_discovery(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
+  char *arg2 = (char *) 0 ;
   int val1 ;
   int ecode1 = 0 ;
-  PyObject *swig_obj[1] ;
-  int result;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
 
   (void)self;
-  if (!args) SWIG_fail;
-  swig_obj[0] = args;
+  if (!SWIG_Python_UnpackTuple(args, "events_set_discovery", 2, 2, swig_obj)) SWIG_fail;
   ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
   if (!SWIG_IsOK(ecode1)) {
-    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_num_events" "', argument " "1"" of type '" "int""'");
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_set_discovery" "', argument " "1"" of type '" "int""'");
   }
   arg1 = (int)(val1);
-  result = (int)events_num_events(arg1);
-  resultobj = SWIG_From_int((int)(result));
-  return resultobj;
-fail:
-  return NULL;
-}
-
-
-SWIGINTERN PyObject *_wrap_new_clients(PyObject *self, PyObject *args) {
-  PyObject *resultobj = 0;
-  int result;
-
-  (void)self;
-  if (!SWIG_Python_UnpackTuple(args, "new_clients", 0, 0, 0)) SWIG_fail;
-  result = (int)new_clients();
-  resultobj = SWIG_From_int((int)(result));
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "events_set_discovery" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  result = (bool)events_set_discovery(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
   return resultobj;
 fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
   return NULL;
 }
 
 
-SWIGINTERN PyObject *_wrap_destroy_clients(PyObject *self, PyObject *args) {
+SWIGINTERN PyObject *_wrap_events_set_hash_function(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
+  char *arg2 = (char *) 0 ;
   int val1 ;
   int ecode1 = 0 ;
-  PyObject *swig_obj[1] ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  PyObject *swig_obj[2] ;
   bool result;
 
   (void)self;
-  if (!args) SWIG_fail;
-  swig_obj[0] = args;
+  if (!SWIG_Python_UnpackTuple(args, "events_set_hash_function", 2, 2, swig_obj)) SWIG_fail;
   ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
   if (!SWIG_IsOK(ecode1)) {
-    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "destroy_clients" "', argument " "1"" of type '" "int""'");
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_set_hash_function" "', argument " "1"" of type '" "int""'");
   }
   arg1 = (int)(val1);
-  result = (bool)destroy_clients(arg1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "events_set_hash_function" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  result = (bool)events_set_hash_function(arg1,arg2);
   resultobj = SWIG_From_bool((bool)(result));
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
   return resultobj;
 fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
   return NULL;
 }
 
 
-SWIGINTERN PyObject *_wrap_clients_hash_client_id(PyObject *self, PyObject *args) {
+SWIGINTERN PyObject *_wrap_events_merge(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
-  char *arg2 = (char *) 0 ;
+  int arg2 ;
   int val1 ;
   int ecode1 = 0 ;
-  int res2 ;
-  char *buf2 = 0 ;
-  int alloc2 = 0 ;
+  int val2 ;
+  int ecode2 = 0 ;
   PyObject *swig_obj[2] ;
-  char *result = 0 ;
+  bool result;
 
   (void)self;
-  if (!SWIG_Python_UnpackTuple(args, "clients_hash_client_id", 2, 2, swig_obj)) SWIG_fail;
+  if (!SWIG_Python_UnpackTuple(args, "events_merge", 2, 2, swig_obj)) SWIG_fail;
   ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
   if (!SWIG_IsOK(ecode1)) {
-    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_hash_client_id" "', argument " "1"" of type '" "int""'");
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_merge" "', argument " "1"" of type '" "int""'");
   }
   arg1 = (int)(val1);
-  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
-  if (!SWIG_IsOK(res2)) {
-    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "clients_hash_client_id" "', argument " "2"" of type '" "char *""'");
+  ecode2 = SWIG_AsVal_int(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "events_merge" "', argument " "2"" of type '" "int""'");
   }
-  arg2 = (char *)(buf2);
-  result = (char *)clients_hash_client_id(arg1,arg2);
-  resultobj = SWIG_FromCharPtr((const char *)result);
-  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  arg2 = (int)(val2);
+  result = (bool)events_merge(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
   return resultobj;
 fail:
-  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
   return NULL;
 }
 
 
-SWIGINTERN PyObject *_wrap_clients_add_client_id(PyObject *self, PyObject *args) {
+SWIGINTERN PyObject *_wrap_events_set_admission_filter(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
-  char *arg2 = (char *) 0 ;
+  int arg2 ;
+  int arg3 ;
   int val1 ;
   int ecode1 = 0 ;
-  int res2 ;
-  char *buf2 = 0 ;
-  int alloc2 = 0 ;
-  PyObject *swig_obj[2] ;
+  int val2 ;
+  int ecode2 = 0 ;
+  int val3 ;
+  int ecode3 = 0 ;
+  PyObject *swig_obj[3] ;
   bool result;
 
   (void)self;
-  if (!SWIG_Python_UnpackTuple(args, "clients_add_client_id", 2, 2, swig_obj)) SWIG_fail;
+  if (!SWIG_Python_UnpackTuple(args, "events_set_admission_filter", 3, 3, swig_obj)) SWIG_fail;
   ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
   if (!SWIG_IsOK(ecode1)) {
-    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_add_client_id" "', argument " "1"" of type '" "int""'");
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_set_admission_filter" "', argument " "1"" of type '" "int""'");
   }
   arg1 = (int)(val1);
-  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
-  if (!SWIG_IsOK(res2)) {
-    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "clients_add_client_id" "', argument " "2"" of type '" "char *""'");
+  ecode2 = SWIG_AsVal_int(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "events_set_admission_filter" "', argument " "2"" of type '" "int""'");
   }
-  arg2 = (char *)(buf2);
-  result = (bool)clients_add_client_id(arg1,arg2);
+  arg2 = (int)(val2);
+  ecode3 = SWIG_AsVal_int(swig_obj[2], &val3);
+  if (!SWIG_IsOK(ecode3)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode3), "in method '" "events_set_admission_filter" "', argument " "3"" of type '" "int""'");
+  }
+  arg3 = (int)(val3);
+  result = (bool)events_set_admission_filter(arg1,arg2,arg3);
   resultobj = SWIG_From_bool((bool)(result));
-  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
   return resultobj;
 fail:
-  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
   return NULL;
 }
 
 
-SWIGINTERN PyObject *_wrap_clients_hash_by_index(PyObject *self, PyObject *args) {
+SWIGINTERN PyObject *_wrap_events_set_decay(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
   int arg2 ;
@@ -4162,60 +4409,422 @@ SWIGINTERN PyObject *_wrap_clients_hash_by_index(PyObject *self, PyObject *args)
   int val2 ;
   int ecode2 = 0 ;
   PyObject *swig_obj[2] ;
-  char *result = 0 ;
+  bool result;
 
   (void)self;
-  if (!SWIG_Python_UnpackTuple(args, "clients_hash_by_index", 2, 2, swig_obj)) SWIG_fail;
+  if (!SWIG_Python_UnpackTuple(args, "events_set_decay", 2, 2, swig_obj)) SWIG_fail;
   ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
   if (!SWIG_IsOK(ecode1)) {
-    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_hash_by_index" "', argument " "1"" of type '" "int""'");
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_set_decay" "', argument " "1"" of type '" "int""'");
   }
   arg1 = (int)(val1);
   ecode2 = SWIG_AsVal_int(swig_obj[1], &val2);
   if (!SWIG_IsOK(ecode2)) {
-    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "clients_hash_by_index" "', argument " "2"" of type '" "int""'");
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "events_set_decay" "', argument " "2"" of type '" "int""'");
   }
   arg2 = (int)(val2);
-  result = (char *)clients_hash_by_index(arg1,arg2);
-  resultobj = SWIG_FromCharPtr((const char *)result);
+  result = (bool)events_set_decay(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
   return resultobj;
 fail:
   return NULL;
 }
 
 
-SWIGINTERN PyObject *_wrap_clients_num_clients(PyObject *self, PyObject *args) {
+SWIGINTERN PyObject *_wrap_events_decay_events(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
   int val1 ;
   int ecode1 = 0 ;
   PyObject *swig_obj[1] ;
-  int result;
+  bool result;
 
   (void)self;
   if (!args) SWIG_fail;
   swig_obj[0] = args;
   ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
   if (!SWIG_IsOK(ecode1)) {
-    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_num_clients" "', argument " "1"" of type '" "int""'");
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_decay_events" "', argument " "1"" of type '" "int""'");
   }
   arg1 = (int)(val1);
-  result = (int)clients_num_clients(arg1);
-  resultobj = SWIG_From_int((int)(result));
+  result = (bool)events_decay_events(arg1);
+  resultobj = SWIG_From_bool((bool)(result));
   return resultobj;
 fail:
   return NULL;
 }
 
 
-SWIGINTERN PyObject *_wrap_clients_load_block(PyObject *self, PyObject *args) {
+SWIGINTERN PyObject *_wrap_events_set_sample_rate(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
-  char *arg2 = (char *) 0 ;
+  double arg2 ;
   int val1 ;
   int ecode1 = 0 ;
-  int res2 ;
-  char *buf2 = 0 ;
+  double val2 ;
+  int ecode2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "events_set_sample_rate", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_set_sample_rate" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  ecode2 = SWIG_AsVal_double(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "events_set_sample_rate" "', argument " "2"" of type '" "double""'");
+  }
+  arg2 = (double)(val2);
+  result = (bool)events_set_sample_rate(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_events_estimate_count(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  char *arg3 = (char *) 0 ;
+  double arg4 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  int res3 ;
+  char *buf3 = 0 ;
+  int alloc3 = 0 ;
+  double val4 ;
+  int ecode4 = 0 ;
+  PyObject *swig_obj[4] ;
+  char *result = 0 ;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "events_estimate_count", 4, 4, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_estimate_count" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "events_estimate_count" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  res3 = SWIG_AsCharPtrAndSize(swig_obj[2], &buf3, NULL, &alloc3);
+  if (!SWIG_IsOK(res3)) {
+    SWIG_exception_fail(SWIG_ArgError(res3), "in method '" "events_estimate_count" "', argument " "3"" of type '" "char *""'");
+  }
+  arg3 = (char *)(buf3);
+  ecode4 = SWIG_AsVal_double(swig_obj[3], &val4);
+  if (!SWIG_IsOK(ecode4)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode4), "in method '" "events_estimate_count" "', argument " "4"" of type '" "double""'");
+  }
+  arg4 = (double)(val4);
+  result = (char *)events_estimate_count(arg1,arg2,arg3,arg4);
+  resultobj = SWIG_FromCharPtr((const char *)result);
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  if (alloc3 == SWIG_NEWOBJ) free((char*)buf3);
+  return resultobj;
+fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  if (alloc3 == SWIG_NEWOBJ) free((char*)buf3);
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_events_num_events(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  int result;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "events_num_events" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (int)events_num_events(arg1);
+  resultobj = SWIG_From_int((int)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_new_clients(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "new_clients", 0, 0, 0)) SWIG_fail;
+  result = (int)new_clients();
+  resultobj = SWIG_From_int((int)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_destroy_clients(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  bool result;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "destroy_clients" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (bool)destroy_clients(arg1);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_hash_client_id(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  PyObject *swig_obj[2] ;
+  char *result = 0 ;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clients_hash_client_id", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_hash_client_id" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "clients_hash_client_id" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  result = (char *)clients_hash_client_id(arg1,arg2);
+  resultobj = SWIG_FromCharPtr((const char *)result);
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return resultobj;
+fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_add_client_id(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clients_add_client_id", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_add_client_id" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "clients_add_client_id" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  result = (bool)clients_add_client_id(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return resultobj;
+fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_add_array(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  PyObject *arg2 = (PyObject *) 0 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[2] ;
+  PyObject *result = 0 ;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clients_add_array", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_add_array" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  arg2 = swig_obj[1];
+  result = (PyObject *)clients_add_array(arg1,arg2);
+  resultobj = result;
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_load_client_ids(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  PyObject *swig_obj[2] ;
+  int result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clients_load_client_ids", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_load_client_ids" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "clients_load_client_ids" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  result = (int)clients_load_client_ids(arg1,arg2);
+  resultobj = SWIG_From_int((int)(result));
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return resultobj;
+fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_set_hash_function(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clients_set_hash_function", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_set_hash_function" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "clients_set_hash_function" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  result = (bool)clients_set_hash_function(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return resultobj;
+fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_hash_by_index(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int arg2 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int val2 ;
+  int ecode2 = 0 ;
+  PyObject *swig_obj[2] ;
+  char *result = 0 ;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clients_hash_by_index", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_hash_by_index" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  ecode2 = SWIG_AsVal_int(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "clients_hash_by_index" "', argument " "2"" of type '" "int""'");
+  }
+  arg2 = (int)(val2);
+  result = (char *)clients_hash_by_index(arg1,arg2);
+  resultobj = SWIG_FromCharPtr((const char *)result);
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_num_clients(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  int result;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clients_num_clients" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (int)clients_num_clients(arg1);
+  resultobj = SWIG_From_int((int)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clients_load_block(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
   int alloc2 = 0 ;
   PyObject *swig_obj[2] ;
   bool result;
@@ -4355,6 +4964,193 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_clips_set_client_filter(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  bool arg2 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  bool val2 ;
+  int ecode2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clips_set_client_filter", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_set_client_filter" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  ecode2 = SWIG_AsVal_bool(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "clips_set_client_filter" "', argument " "2"" of type '" "bool""'");
+  }
+  arg2 = (bool)(val2);
+  result = (bool)clips_set_client_filter(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clips_set_history(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int arg2 ;
+  int arg3 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int val2 ;
+  int ecode2 = 0 ;
+  int val3 ;
+  int ecode3 = 0 ;
+  PyObject *swig_obj[3] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clips_set_history", 3, 3, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_set_history" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  ecode2 = SWIG_AsVal_int(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "clips_set_history" "', argument " "2"" of type '" "int""'");
+  }
+  arg2 = (int)(val2);
+  ecode3 = SWIG_AsVal_int(swig_obj[2], &val3);
+  if (!SWIG_IsOK(ecode3)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode3), "in method '" "clips_set_history" "', argument " "3"" of type '" "int""'");
+  }
+  arg3 = (int)(val3);
+  result = (bool)clips_set_history(arg1,arg2,arg3);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clips_freeze(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  bool arg2 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  bool val2 ;
+  int ecode2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clips_freeze", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_freeze" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  ecode2 = SWIG_AsVal_bool(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "clips_freeze" "', argument " "2"" of type '" "bool""'");
+  }
+  arg2 = (bool)(val2);
+  result = (bool)clips_freeze(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clips_begin_bulk(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  bool arg2 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  bool val2 ;
+  int ecode2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clips_begin_bulk", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_begin_bulk" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  ecode2 = SWIG_AsVal_bool(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "clips_begin_bulk" "', argument " "2"" of type '" "bool""'");
+  }
+  arg2 = (bool)(val2);
+  result = (bool)clips_begin_bulk(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clips_end_bulk(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  bool result;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_end_bulk" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (bool)clips_end_bulk(arg1);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
+SWIGINTERN PyObject *_wrap_clips_merge(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int arg2 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int val2 ;
+  int ecode2 = 0 ;
+  PyObject *swig_obj[2] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "clips_merge", 2, 2, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_merge" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  ecode2 = SWIG_AsVal_int(swig_obj[1], &val2);
+  if (!SWIG_IsOK(ecode2)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode2), "in method '" "clips_merge" "', argument " "2"" of type '" "int""'");
+  }
+  arg2 = (int)(val2);
+  result = (bool)clips_merge(arg1,arg2);
+  resultobj = SWIG_From_bool((bool)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
 SWIGINTERN PyObject *_wrap_clips_scan_event(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
@@ -4522,6 +5318,30 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_clips_save_empty(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  int result;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_save_empty" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (int)clips_save_empty(arg1);
+  resultobj = SWIG_From_int((int)(result));
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
 SWIGINTERN PyObject *_wrap_clips_describe_clip(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
@@ -4604,6 +5424,30 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_clips_export(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  PyObject *swig_obj[1] ;
+  PyObject *result = 0 ;
+
+  (void)self;
+  if (!args) SWIG_fail;
+  swig_obj[0] = args;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "clips_export" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  result = (PyObject *)clips_export(arg1);
+  resultobj = result;
+  return resultobj;
+fail:
+  return NULL;
+}
+
+
 SWIGINTERN PyObject *_wrap_clips_test_sequence(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
@@ -4717,6 +5561,51 @@ fail:
 }
 
 
+SWIGINTERN PyObject *_wrap_targets_set_window(PyObject *self, PyObject *args) {
+  PyObject *resultobj = 0;
+  int arg1 ;
+  char *arg2 = (char *) 0 ;
+  char *arg3 = (char *) 0 ;
+  int val1 ;
+  int ecode1 = 0 ;
+  int res2 ;
+  char *buf2 = 0 ;
+  int alloc2 = 0 ;
+  int res3 ;
+  char *buf3 = 0 ;
+  int alloc3 = 0 ;
+  PyObject *swig_obj[3] ;
+  bool result;
+
+  (void)self;
+  if (!SWIG_Python_UnpackTuple(args, "targets_set_window", 3, 3, swig_obj)) SWIG_fail;
+  ecode1 = SWIG_AsVal_int(swig_obj[0], &val1);
+  if (!SWIG_IsOK(ecode1)) {
+    SWIG_exception_fail(SWIG_ArgError(ecode1), "in method '" "targets_set_window" "', argument " "1"" of type '" "int""'");
+  }
+  arg1 = (int)(val1);
+  res2 = SWIG_AsCharPtrAndSize(swig_obj[1], &buf2, NULL, &alloc2);
+  if (!SWIG_IsOK(res2)) {
+    SWIG_exception_fail(SWIG_ArgError(res2), "in method '" "targets_set_window" "', argument " "2"" of type '" "char *""'");
+  }
+  arg2 = (char *)(buf2);
+  res3 = SWIG_AsCharPtrAndSize(swig_obj[2], &buf3, NULL, &alloc3);
+  if (!SWIG_IsOK(res3)) {
+    SWIG_exception_fail(SWIG_ArgError(res3), "in method '" "targets_set_window" "', argument " "3"" of type '" "char *""'");
+  }
+  arg3 = (char *)(buf3);
+  result = (bool)targets_set_window(arg1,arg2,arg3);
+  resultobj = SWIG_From_bool((bool)(result));
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  if (alloc3 == SWIG_NEWOBJ) free((char*)buf3);
+  return resultobj;
+fail:
+  if (alloc2 == SWIG_NEWOBJ) free((char*)buf2);
+  if (alloc3 == SWIG_NEWOBJ) free((char*)buf3);
+  return NULL;
+}
+
+
 SWIGINTERN PyObject *_wrap_targets_insert_target(PyObject *self, PyObject *args) {
   PyObject *resultobj = 0;
   int arg1 ;
@@ -5247,18 +6136,32 @@ static PyMethodDef SwigMethods[] = {
 	 { "new_events", _wrap_new_events, METH_NOARGS, NULL},
 	 { "destroy_events", _wrap_destroy_events, METH_O, NULL},
 	 { "events_insert_row", _wrap_events_insert_row, METH_VARARGS, NULL},
+	 { "events_insert_row_count", _wrap_events_insert_row_count, METH_VARARGS, NULL},
 	 { "events_define_event", _wrap_events_define_event, METH_VARARGS, NULL},
 	 { "events_optimize_events", _wrap_events_optimize_events, METH_VARARGS, NULL},
 	 { "events_load_block", _wrap_events_load_block, METH_VARARGS, NULL},
 	 { "events_save", _wrap_events_save, METH_O, NULL},
+	 { "events_save_empty", _wrap_events_save_empty, METH_O, NULL},
 	 { "events_describe_next_event", _wrap_events_describe_next_event, METH_VARARGS, NULL},
+	 { "events_export", _wrap_events_export, METH_O, NULL},
 	 { "events_set_max_num_events", _wrap_events_set_max_num_events, METH_VARARGS, NULL},
 	 { "events_set_store_strings", _wrap_events_set_store_strings, METH_VARARGS, NULL},
+	 { "events_set_discovery", _wrap_events_set_discovery, METH_VARARGS, NULL},
+	 { "events_set_hash_function", _wrap_events_set_hash_function, METH_VARARGS, NULL},
+	 { "events_merge", _wrap_events_merge, METH_VARARGS, NULL},
+	 { "events_set_admission_filter", _wrap_events_set_admission_filter, METH_VARARGS, NULL},
+	 { "events_set_decay", _wrap_events_set_decay, METH_VARARGS, NULL},
+	 { "events_decay_events", _wrap_events_decay_events, METH_O, NULL},
+	 { "events_set_sample_rate", _wrap_events_set_sample_rate, METH_VARARGS, NULL},
+	 { "events_estimate_count", _wrap_events_estimate_count, METH_VARARGS, NULL},
 	 { "events_num_events", _wrap_events_num_events, METH_O, NULL},
 	 { "new_clients", _wrap_new_clients, METH_NOARGS, NULL},
 	 { "destroy_clients", _wrap_destroy_clients, METH_O, NULL},
 	 { "clients_hash_client_id", _wrap_clients_hash_client_id, METH_VARARGS, NULL},
 	 { "clients_add_client_id", _wrap_clients_add_client_id, METH_VARARGS, NULL},
+	 { "clients_add_array", _wrap_clients_add_array, METH_VARARGS, NULL},
+	 { "clients_load_client_ids", _wrap_clients_load_client_ids, METH_VARARGS, NULL},
+	 { "clients_set_hash_function", _wrap_clients_set_hash_function, METH_VARARGS, NULL},
 	 { "clients_hash_by_index", _wrap_clients_hash_by_index, METH_VARARGS, NULL},
 	 { "clients_num_clients", _wrap_clients_num_clients, METH_O, NULL},
 	 { "clients_load_block", _wrap_clients_load_block, METH_VARARGS, NULL},
@@ -5266,17 +6169,26 @@ static PyMethodDef SwigMethods[] = {
 	 { "new_clips", _wrap_new_clips, METH_VARARGS, NULL},
 	 { "destroy_clips", _wrap_destroy_clips, METH_O, NULL},
 	 { "clips_set_time_format", _wrap_clips_set_time_format, METH_VARARGS, NULL},
+	 { "clips_set_client_filter", _wrap_clips_set_client_filter, METH_VARARGS, NULL},
+	 { "clips_set_history", _wrap_clips_set_history, METH_VARARGS, NULL},
+	 { "clips_freeze", _wrap_clips_freeze, METH_VARARGS, NULL},
+	 { "clips_begin_bulk", _wrap_clips_begin_bulk, METH_VARARGS, NULL},
+	 { "clips_end_bulk", _wrap_clips_end_bulk, METH_O, NULL},
+	 { "clips_merge", _wrap_clips_merge, METH_VARARGS, NULL},
 	 { "clips_scan_event", _wrap_clips_scan_event, METH_VARARGS, NULL},
 	 { "clips_hash_by_previous", _wrap_clips_hash_by_previous, METH_VARARGS, NULL},
 	 { "clips_load_block", _wrap_clips_load_block, METH_VARARGS, NULL},
 	 { "clips_save", _wrap_clips_save, METH_O, NULL},
+	 { "clips_save_empty", _wrap_clips_save_empty, METH_O, NULL},
 	 { "clips_describe_clip", _wrap_clips_describe_clip, METH_VARARGS, NULL},
 	 { "clips_num_clips", _wrap_clips_num_clips, METH_O, NULL},
 	 { "clips_num_events", _wrap_clips_num_events, METH_O, NULL},
+	 { "clips_export", _wrap_clips_export, METH_O, NULL},
 	 { "clips_test_sequence", _wrap_clips_test_sequence, METH_VARARGS, NULL},
 	 { "new_targets", _wrap_new_targets, METH_O, NULL},
 	 { "destroy_targets", _wrap_destroy_targets, METH_O, NULL},
 	 { "targets_set_time_format", _wrap_targets_set_time_format, METH_VARARGS, NULL},
+	 { "targets_set_window", _wrap_targets_set_window, METH_VARARGS, NULL},
 	 { "targets_insert_target", _wrap_targets_insert_target, METH_VARARGS, NULL},
 	 { "targets_fit", _wrap_targets_fit, METH_VARARGS, NULL},
 	 { "targets_predict_clients", _wrap_targets_predict_clients, METH_VARARGS, NULL},
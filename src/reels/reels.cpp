@@ -95,6 +95,182 @@ uint64_t MurmurHash64A (const void *key, int len) {
 }
 
 
+/** \brief Multiply two 64-bit numbers into a 128-bit result (the core of wyhash).
+
+	\param p_a	The first factor on input, the low 64 bits of the product on output.
+	\param p_b	The second factor on input, the high 64 bits of the product on output.
+*/
+inline void wy_mum(uint64_t *p_a, uint64_t *p_b) {
+#ifdef __SIZEOF_INT128__
+	__uint128_t r = *p_a;
+
+	r *= *p_b;
+
+	*p_a = (uint64_t) r;
+	*p_b = (uint64_t) (r >> 64);
+#else
+	uint64_t ha = *p_a >> 32, hb = *p_b >> 32, la = (uint32_t) *p_a, lb = (uint32_t) *p_b;
+	uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb, t = rl + (rm0 << 32), c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+
+	c += lo < t;
+
+	*p_a = lo;
+	*p_b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+
+/** \brief Mix two 64-bit numbers (the xor of both halves of their 128-bit product).
+*/
+inline uint64_t wy_mix(uint64_t a, uint64_t b) {
+	wy_mum(&a, &b);
+
+	return a ^ b;
+}
+
+
+/** \brief Unaligned little-endian reads used by WyHash64().
+*/
+inline uint64_t wy_r8(const uint8_t *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint64_t wy_r4(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+inline uint64_t wy_r3(const uint8_t *p, int k) { return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1]; }
+
+
+/** \brief wyhash (final version), 64-bit, by Wang Yi
+
+	(from https://github.com/wangyi-fudan/wyhash) released to the public domain (The Unlicense). Strings up to 16 bytes are read
+	in (at most) four overlapping 32-bit loads, longer ones in 16 or 48 byte blocks of 64-bit loads mixed with 128-bit multiplies.
+
+	\param key address of the memory block to hash.
+	\param len Number of bytes to hash.
+	\return	 64-bit hash of the memory block.
+*/
+uint64_t WyHash64 (const void *key, int len) {
+	static const uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+	const uint8_t *p = (const uint8_t *) key;
+
+	uint64_t seed = MURMUR_SEED ^ wy_mix(MURMUR_SEED ^ secret[0], secret[1]);
+	uint64_t a, b;
+
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (wy_r4(p) << 32) | wy_r4(p + ((len >> 3) << 2));
+			b = (wy_r4(p + len - 4) << 32) | wy_r4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = wy_r3(p, len);
+			b = 0;
+		} else
+			a = b = 0;
+	} else {
+		int i = len;
+
+		if (i >= 48) {
+			uint64_t see1 = seed, see2 = seed;
+
+			do {
+				seed = wy_mix(wy_r8(p) ^ secret[1], wy_r8(p + 8) ^ seed);
+				see1 = wy_mix(wy_r8(p + 16) ^ secret[2], wy_r8(p + 24) ^ see1);
+				see2 = wy_mix(wy_r8(p + 32) ^ secret[3], wy_r8(p + 40) ^ see2);
+
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+
+			seed ^= see1 ^ see2;
+		}
+
+		while (i > 16) {
+			seed = wy_mix(wy_r8(p) ^ secret[1], wy_r8(p + 8) ^ seed);
+
+			p += 16;
+			i -= 16;
+		}
+
+		a = wy_r8(p + i - 16);
+		b = wy_r8(p + i - 8);
+	}
+
+	a ^= secret[1];
+	b ^= seed;
+
+	wy_mum(&a, &b);
+
+	return wy_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+
+/** \brief Convert the name of a hash function into a HashFunction.
+
+	\param p_name	Either "murmur" or "wyhash".
+	\param hash_fn	The HashFunction returned by reference.
+
+	\return	True on success.
+*/
+bool parse_hash_function(pChar p_name, HashFunction &hash_fn) {
+
+	if (strcmp(p_name, "murmur") == 0) {
+		hash_fn = hf_murmur;
+
+		return true;
+	}
+
+	if (strcmp(p_name, "wyhash") == 0) {
+		hash_fn = hf_wyhash;
+
+		return true;
+	}
+
+	return false;
+}
+
+
+/** \brief The name of the first section of an image, which also records the HashFunction of the object.
+
+	Objects using hf_murmur write the plain section name, so images are unchanged and images that do not record it load as
+	hf_murmur. Any other function appends its name (e.g., "events/wyhash").
+
+	\param section	The name of the section.
+	\param hash_fn	The HashFunction of the object.
+
+	\return	The section name to be hashed (always by MurmurHash64A) as the section tag.
+*/
+String hashed_section(pChar section, HashFunction hash_fn) {
+
+	if (hash_fn == hf_wyhash)
+		return String(section) + "/wyhash";
+
+	return section;
+}
+
+
+/** \brief Find the HashFunction recorded in the tag of the first section of an image.
+
+	\param hs		The section tag read from the image.
+	\param section	The name of the section.
+	\param hash_fn	The HashFunction returned by reference.
+
+	\return	True if the tag is the section for any HashFunction.
+*/
+bool find_hashed_section(ElementHash hs, pChar section, HashFunction &hash_fn) {
+
+	HashFunction all[] = {hf_murmur, hf_wyhash};
+
+	for (int i = 0; i < (int) (sizeof(all)/sizeof(HashFunction)); i++) {
+		String name = hashed_section(section, all[i]);
+
+		if (hs == MurmurHash64A(name.c_str(), name.length())) {
+			hash_fn = all[i];
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
 /** \brief A function to push arbitrary raw data into a BinaryImage
 
 	\param p_bi		A pointer to an existing BinaryImage that receives the data
@@ -195,27 +371,193 @@ bool image_get(pBinaryImage p_bi, int &c_block, int &c_ofs, void *p_data, int si
 	return size == 0;
 }
 
+// -----------------------------------------------------------------------------------------------------------------------------------------
+//	StringTable Implementation
+// -----------------------------------------------------------------------------------------------------------------------------------------
+
+/** \brief Remove all the strings and release the memory.
+*/
+void StringTable::clear() {
+
+	StringSlots().swap(slot);
+	StringArena().swap(arena);
+
+	num_used = 0;
+	garbage	 = 0;
+}
+
+
+/** \brief The indices of the used slots sorted by hash. (The order in which they are saved, as the previous std::map did.)
+
+	\return	A vector of slot indices.
+*/
+std::vector<int> StringTable::sorted_slots() const {
+
+	std::vector<std::pair<ElementHash, int>> hx;
+
+	hx.reserve(num_used);
+
+	for (int ix = 0; ix < (int) slot.size(); ix++)
+		if (slot[ix].hash != 0)
+			hx.push_back(std::make_pair(slot[ix].hash, ix));
+
+	std::sort(hx.begin(), hx.end());
+
+	std::vector<int> ret;
+
+	ret.reserve(hx.size());
+
+	for (std::vector<std::pair<ElementHash, int>>::iterator it = hx.begin(); it != hx.end(); ++it)
+		ret.push_back(it->second);
+
+	return ret;
+}
+
+
+/** \brief Double the number of slots (starting at 64) and rehash the used ones. The arena is not modified.
+*/
+void StringTable::grow() {
+
+	StringSlots old = {};
+
+	old.swap(slot);
+
+	StringSlot empty = {0, 0, 0, 0};
+
+	slot.assign(std::max((uint64_t) 64, (uint64_t) 2*old.size()), empty);
+
+	uint64_t mask = slot.size() - 1;
+
+	for (StringSlots::iterator it = old.begin(); it != old.end(); ++it) {
+		if (it->hash != 0) {
+			uint64_t i = it->hash & mask;
+
+			while (slot[i].hash != 0)
+				i = (i + 1) & mask;
+
+			slot[i] = *it;
+		}
+	}
+}
+
+
+/** \brief Empty a slot by backward shift deletion (no tombstones) and compact the arena if more than half of it is unused.
+
+	\param ix	The index of the slot.
+*/
+void StringTable::erase_slot(int ix) {
+
+	garbage += slot[ix].len;
+	num_used--;
+
+	uint64_t mask = slot.size() - 1;
+	uint64_t i	  = ix;
+
+	for (uint64_t j = (i + 1) & mask; slot[j].hash != 0; j = (j + 1) & mask) {
+		uint64_t home = slot[j].hash & mask;
+
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			slot[i] = slot[j];
+			i		= j;
+		}
+	}
+
+	slot[i].hash = 0;
+
+	if (num_used == 0)
+		clear();
+	else if (garbage > 4096 && 2*garbage > arena.size())
+		compact();
+}
+
+
+/** \brief Copy the used strings to a new arena (in slot order) and release the old one.
+*/
+void StringTable::compact() {
+
+	StringArena used = {};
+
+	used.reserve(arena.size() - garbage);
+
+	for (StringSlots::iterator it = slot.begin(); it != slot.end(); ++it) {
+		if (it->hash != 0) {
+			uint64_t ofs = used.size();
+
+			used.insert(used.end(), arena.begin() + it->ofs, arena.begin() + it->ofs + it->len);
+
+			it->ofs = ofs;
+		}
+	}
+
+	used.swap(arena);
+
+	garbage = 0;
+}
+
 // -----------------------------------------------------------------------------------------------------------------------------------------
 //	Events Implementation
 // -----------------------------------------------------------------------------------------------------------------------------------------
 
 void Events::insert_row(pChar p_e, pChar p_d, double w) {
 
+	insert_row_count(p_e, p_d, w, 1);
+}
+
+
+void Events::insert_row_count(pChar p_e, pChar p_d, double w, uint64_t count) {
+
+	if (sample_rate < 1)
+		count = sample_count(count);
+
+	if (count == 0)
+		return;
+
+	thaw();
+
+	if (decay_half_life > 0) {
+		decay_rows += count;
+
+		uint64_t halvings = decay_rows/decay_half_life;
+
+		if (halvings > 0) {
+			decay_rows %= decay_half_life;
+
+			decay_events(std::min(halvings, (uint64_t) 64));
+		}
+	}
+
 	BinEventPt ept;
 
-	ept.e = add_str(p_e);
-	ept.d = add_str(p_d);
+	if (cm_width > 0) {
+		ept.e = hash_str(p_e);
+		ept.d = hash_str(p_d);
+		ept.w = w;
+
+		if (!admit_event(ept, count))
+			return;
+	}
+
+	ept.e = add_str(p_e, count);
+	ept.d = add_str(p_d, count);
 	ept.w = w;
 
+	if (discovery == ds_space_saving) {
+		summary_insert(ept, count);
+
+		return;
+	}
+
 	EventMap::iterator it = event.find(ept);
 
 	if (it != event.end()) {
-		it->second.seen++;
+		it->second.seen += count;
 
 		uint64_t pri = it->second.priority;
 		priority.erase(pri);
 
-		pri = ++priority_low + PRIORITY_SEEN_FACTOR*it->second.seen;
+		priority_low += count;
+
+		pri = priority_low + PRIORITY_SEEN_FACTOR*it->second.seen;
 
 		priority[pri] = ept;
 		it->second.priority = pri;
@@ -235,10 +577,12 @@ void Events::insert_row(pChar p_e, pChar p_d, double w) {
 		event.erase(low_ept);
 	}
 
+	priority_low += count;
+
 	EventStat es;
 
-	es.seen		= 1;
-	es.priority = ++priority_low + PRIORITY_SEEN_FACTOR;
+	es.seen		= count;
+	es.priority = priority_low + PRIORITY_SEEN_FACTOR*count;
 	es.code		= ++next_code;
 
 	event[ept] = es;
@@ -249,6 +593,8 @@ void Events::insert_row(pChar p_e, pChar p_d, double w) {
 
 bool Events::define_event(pChar	p_e, pChar p_d, double w, uint64_t code) {
 
+	thaw();
+
 	BinEventPt ept;
 
 	ept.e = add_str(p_e);
@@ -257,7 +603,7 @@ bool Events::define_event(pChar	p_e, pChar p_d, double w, uint64_t code) {
 
 	EventMap::iterator it = event.find(ept);
 
-	if (it != event.end() || priority.size() != 0)
+	if (it != event.end() || priority.size() != 0 || ss_slot.size() != 0)
 		return false;								// Event is defined or insert_row() was called before.
 
 	EventStat es;
@@ -272,607 +618,2473 @@ bool Events::define_event(pChar	p_e, pChar p_d, double w, uint64_t code) {
 }
 
 
-String Events::optimize_events (Clips &clips, TargetMap &targets, int num_steps, int codes_per_step, double threshold,
-								pCodeSet p_force_include, pCodeSet p_force_exclude, Transform x_form, Aggregate agg, double p,
-								int depth, bool as_states, double exp_decay, double lower_bound_p, bool log_lift) {
-
-	// Use a logger as a debug tool and to return errors.
+/** \brief Count rows in the Count-Min sketch and decide if they can be processed by insert_row_count() in ds_priority mode.
 
-	Logger log = {};
+	\param ept		The event. (The hashes are computed, but the strings are not stored yet.)
+	\param count	The number of rows.
 
-	// Prerequisites: Build the list of codes from clips as a dictionary, initially to itself.
+	\return	True if the event is already in the EventMap, the EventMap is not full or the estimated frequency of the event is higher
+			than the estimated frequency of the event that would be evicted (the lowest priority).
 
-	EventCodeMap large_dict = {};
+	This is a conservative update Count-Min sketch: no counter is raised above the new estimate (the current minimum + count).
+	Every ADMISSION_RESET_FACTOR*cm_width rows all counters are halved, so the estimates follow the recent frequencies, like the
+	priorities do.
+*/
+bool Events::admit_event(BinEventPt &ept, uint64_t count) {
 
-	for (ClipMap::iterator it = clips.clip_map()->begin(); it != clips.clip_map()->end(); ++it) {
-		for (Clip::iterator jt = it->second.begin(); jt != it->second.end(); ++jt) {
-			large_dict[jt->second] = jt->second;
-		}
-	}
+	uint64_t h1 = ept.hash(), h2 = (h1 >> 32) | 1;
 
-	uint64_t code_base = large_dict.rbegin()->first + 1;		// Define the range base for the new codes
+	uint32_t est = (uint32_t) std::min((uint64_t) sketch_estimate(ept) + count, (uint64_t) 0xffffffff);
 
-	// Prerequisites: Another dictionary, initially to code_base.
+	for (int i = 0; i < cm_depth; i++) {
+		uint32_t &cnt = cm_count[(uint64_t) i*cm_width + (h1 + i*h2) % cm_width];
 
-	EventCodeMap small_dict = {};
+		if (cnt < est)
+			cnt = est;
+	}
 
-	uint64_t code_noise = code_base + 1;
-	uint64_t code_new	= code_noise + 1;
+	cm_rows += count;
 
-	for (EventCodeMap::iterator it = large_dict.begin(); it != large_dict.end(); ++it) {
-		small_dict[it->first] = code_noise;
+	while (cm_rows >= (uint64_t) ADMISSION_RESET_FACTOR*cm_width) {
+		for (SketchCounters::iterator it = cm_count.begin(); it != cm_count.end(); ++it)
+			*it >>= 1;
 
-		if (p_force_include != nullptr && p_force_include->find(it->first) != p_force_include->end())
-			small_dict[it->first] = code_new++;
+		cm_rows >>= 1;
 	}
 
-	log.log_printf("Preprocessing:\n\n  %i codes found in clips.\n", large_dict.size());
+	if (max_num_events != (int) event.size() || priority.size() == 0 || event.find(ept) != event.end())
+		return true;
 
-	// Prerequisites: Check the codes in the internal EventMap, remove if in excess, fail if missing.
+	return est > sketch_estimate(priority.begin()->second);
+}
 
-	CodeSet codes = {};
 
-	int removed = 0;
-	for (EventMap::const_iterator it = event.cbegin(); it != event.cend();) {
-		EventCodeMap::iterator jt = large_dict.find(it->second.code);
-		if (jt == large_dict.end()) {
-			event.erase(it++);
-			removed++;
-		} else {
-			codes.insert(it->second.code);
-			++it;
-		}
-	}
-	log.log_printf("  %i codes removed from internal EventMap.\n", removed);
+/** \brief The Count-Min sketch estimation of the frequency of an event.
 
-	if (codes.size() != large_dict.size()) {
-		log.log_printf("  %i codes in clips not defined in internal EventMap.\n", large_dict.size() - codes.size());
+	\param ept	The event.
 
-		log.log = "ERROR\n" + log.log;
+	\return	The minimum of its counters across all rows.
+*/
+uint32_t Events::sketch_estimate(const BinEventPt &ept) const {
 
-		return log.log;
-	}
+	uint64_t h1 = ept.hash(), h2 = (h1 >> 32) | 1;
 
-	// First model run
+	uint32_t est = 0xffffffff;
 
-	double large_score = -1, targ_prop;
+	for (int i = 0; i < cm_depth; i++)
+		est = std::min(est, cm_count[(uint64_t) i*cm_width + (h1 + i*h2) % cm_width]);
 
-	CodeInTreeStatMap codes_stat = {};
+	return est;
+}
 
-	if (!score_model(large_score, targ_prop, codes_stat, true, clips, targets, large_dict, x_form, agg, p, depth, as_states)) {
-		log.log = "ERROR\nscore_model() failed!\n" + log.log;
 
-		return log.log;
-	};
+/** \brief Add the Count-Min sketch counters of another object (with the same dimensions) to the counters of this one.
 
-	log.log_printf("  Current score = %.6f\n", large_score);
+	\param other	The other Events object.
 
-	CodeScores top_code = get_top_codes(codes_stat, targ_prop, exp_decay, lower_bound_p, log_lift);
+	Sketches of different dimensions cannot be combined, in that case the sketch of this object is left unchanged.
+*/
+void Events::sketch_merge(const Events &other) {
 
-	// Main (over num_steps) loop
+	if (cm_width == 0 || cm_width != other.cm_width || cm_depth != other.cm_depth)
+		return;
 
-	double best_score = -1;
+	for (size_t i = 0; i < cm_count.size(); i++)
+		cm_count[i] = (uint32_t) std::min((uint64_t) cm_count[i] + other.cm_count[i], (uint64_t) 0xffffffff);
 
-	int top_ix = 0;
+	cm_rows += other.cm_rows;
+}
 
-	for (int step = 0; step < num_steps; step++) {
-		log.log_printf("\nStep %i of %i\n\n", step + 1, num_steps);
 
-		EventCodeMap dict = small_dict;
-		int new_codes = 0;
-		log.log_printf("  Trying:\n");
-		while (new_codes < codes_per_step) {
-			if (top_ix == (int) top_code.size())
-				break;
+void Events::freeze() {
 
-			uint64_t code_try = top_code[top_ix++].code;
+	sync_event_map();
 
-			if (p_force_exclude != nullptr && p_force_exclude->find(code_try) != p_force_exclude->end()) {
-	 			log.log_printf("    Code %i was excluded by the caller\n", code_try);
+	FrozenEvents().swap(frozen);
+	CodeDict().swap(id_code);
 
-				continue;
-			}
+	if (event.size() == 0)
+		return;
 
- 			log.log_printf("    Code %i as %i\n", code_try, code_new - code_base);
+	for (EventMap::iterator it = event.begin(); it != event.end(); ++it) {
+		if (it->second.code != 0)
+			id_code.push_back(it->second.code);
+	}
 
-			dict[code_try] = code_new++;
+	std::sort(id_code.begin(), id_code.end());
 
-			new_codes++;
-		}
-		if (new_codes == 0) {
-			log.log_printf("  -- No more codes --\n");
-			break;
-		}
+	id_code.erase(std::unique(id_code.begin(), id_code.end()), id_code.end());
 
-		double new_score;
-		if (!score_model(new_score, targ_prop, codes_stat, false, clips, targets, dict, x_form, agg, p, depth, as_states)) {
-			log.log = "ERROR\nscore_model() failed!\n" + log.log;
+	uint64_t size = 16;
 
-			return log.log;
-		}
- 		log.log_printf("    ---------------\n    Score = %0.6f\n", new_score);
+	while (size < 2*event.size())
+		size *= 2;
 
-		if (new_score - best_score >= threshold) {
-			best_score = new_score;
-			small_dict = dict;
-			log.log_printf("    Best score so far.\n");
-		} else
-			log.log_printf("    Threshold (%.6f) not met (diff = %.6f)\n", threshold, new_score - best_score);
-	}
+	FrozenEvent empty = {0, 0, 0, 0};
 
-	log.log_printf("\n== F I N A L ==\n\n");
-	log.log_printf("  Final score      = %.6f\n", best_score);
-	log.log_printf("  Final dictionary = {");
+	frozen.assign(size, empty);
 
-	EventCodeMap::iterator it_small = small_dict.begin();
-	for (int i = 1; i < (int) small_dict.size(); i++) {
-		log.log_printf("%i:%i, ", it_small->first, it_small->second - code_base);
+	uint64_t mask = size - 1;
 
-		++it_small;
-	}
-	log.log_printf("%i:%i}\n", it_small->first, it_small->second - code_base);
+	for (EventMap::iterator it = event.begin(); it != event.end(); ++it) {
+		if (it->second.code == 0)
+			continue;						// Same as not found for event_code()
 
-	for (EventMap::iterator it = event.begin(); it != event.end(); ++it)
-		it->second.code = small_dict[it->second.code] - code_base;
+		FrozenEvent fe = {it->first.e, it->first.d, (int64_t) round(WEIGHT_PRECISION*it->first.w), it->second.code};
 
-	log.log = "SUCCESS\n" + log.log;
+		uint64_t i = BinEventPt::hash_key(fe.e, fe.d, fe.wq) & mask;
 
-	return log.log;
+		while (frozen[i].code != 0)
+			i = (i + 1) & mask;
+
+		frozen[i] = fe;
+	}
 }
 
 
-/** \brief Compare two OptimizeEvalItem structures for sorting.
+void Events::export_columns(EventColumns &cols) {
 
-	\param a  The first structure
-	\param b  The second one
+	sync_event_map();
 
-	\return	True if a < b.
-*/
-bool compare_optimize_eval(const OptimizeEvalItem a, const OptimizeEvalItem b) {
-	if (a.t_hat != b.t_hat)
-		return a.t_hat < b.t_hat;
+	size_t n = event.size();
 
-	return a.seq_len < b.seq_len;
+	cols.e.resize(n);
+	cols.d.resize(n);
+	cols.w.resize(n);
+	cols.seen.resize(n);
+	cols.code.resize(n);
+	cols.priority.resize(n);
+	cols.emitter.resize(n);
+	cols.description.resize(n);
+
+	cols.strings.clear();
+	cols.strings.push_back("");
+
+	std::vector<uint32_t> slot_str(store_strings ? names_map.capacity() : 0, 0);
+
+	size_t i = 0;
+
+	for (EventMap::iterator it = event.begin(); it != event.end(); ++it, i++) {
+		cols.e[i]		 = it->first.e;
+		cols.d[i]		 = it->first.d;
+		cols.w[i]		 = it->first.w;
+		cols.seen[i]	 = it->second.seen;
+		cols.code[i]	 = it->second.code;
+		cols.priority[i] = it->second.priority;
+
+		for (int k = 0; k < 2; k++) {
+			uint32_t &ix = k == 0 ? cols.emitter[i] : cols.description[i];
+			int		  sx = store_strings ? names_map.find(k == 0 ? it->first.e : it->first.d) : -1;
+
+			ix = 0;
+
+			if (sx >= 0) {
+				if (slot_str[sx] == 0) {
+					slot_str[sx] = cols.strings.size();
+					cols.strings.push_back(names_map.str(sx));
+				}
+				ix = slot_str[sx];
+			}
+		}
+	}
 }
 
 
-bool Events::score_model(double &score, double &targ_prop, CodeInTreeStatMap &codes_stat, bool calc_tree_stats, Clips &clips,
-						 TargetMap &targets, EventCodeMap code_dict, Transform x_form, Aggregate agg, double p, int depth, bool as_states) {
+/** \brief Select the sampled rows of a pre-aggregated row.
 
-	// Creates t_clips as a copy and renames its codes.
-	Clips t_clips = clips;
+	\param count	The number of rows.
 
-	for (ClipMap::iterator it = t_clips.clip_map()->begin(); it != t_clips.clip_map()->end(); ++it)
-		for (Clip::iterator jt = it->second.begin(); jt != it->second.end(); ++jt)
-			jt->second = code_dict[jt->second];
+	\return	The number of them that are kept: floor(count*sample_rate) plus one with the probability of the fractional part.
+
+	The uniform number is the SplitMix64 finalizer of the row number, which makes the selection deterministic and independent of the
+	content of the rows, so the rejected rows are not even hashed.
+*/
+uint64_t Events::sample_count(uint64_t count) {
+
+	uint64_t h = (sample_rows += count)*0x9e3779b97f4a7c15;
 
-	// Creates a Targets with the renamed codes and fits it to the targets.
-	Targets targ = Targets(t_clips.clip_map(), targets);
+	h = (h ^ (h >> 30))*0xbf58476d1ce4e5b9;
+	h = (h ^ (h >> 27))*0x94d049bb133111eb;
+	h =	 h ^ (h >> 31);
 
-	if (as_states)
-		t_clips.collapse_to_states();
+	double	 expected = count*sample_rate;
+	uint64_t kept	  = (uint64_t) expected;
+
+	if ((h >> 11)*(1.0/9007199254740992.0) < expected - kept)
+		kept++;
+
+	return kept;
+}
+
+
+bool Events::estimate_count(BinEventPt &ept, double &estimate, double &lower, double &upper) {
+
+	sync_event_map();
+
+	EventMap::iterator it = event.find(ept);
 
-	if (!targ.fit(x_form, agg, p, depth, false))
+	if (it == event.end())
 		return false;
 
-	targ_prop = targ.p_tree()->at(0).n_seen > 0 ? targ.p_tree()->at(0).n_target/targ.p_tree()->at(0).n_seen : 0;
+	double seen	  = it->second.seen;
+	double margin = SAMPLE_CONFIDENCE_Z*sqrt(seen*(1 - sample_rate))/sample_rate;
 
-	// Predicts, builds an OptimizeEval with (observed and predicted), sorts it and computes score.
-	TimesToTarget t_hat = targ.predict();
+	estimate = seen/sample_rate;
+	upper	 = estimate + margin;
+	lower	 = estimate - margin;
 
-	OptimizeEval ev = {};
-	int i = 0;
-	for (ClipMap::iterator it_client = t_clips.clip_map()->begin(); it_client != t_clips.clip_map()->end(); ++it_client) {
-		TimePoint elapsed = 0;
+	if (discovery == ds_space_saving) {
+		int ix = summary_find(ept);
 
-		TargetMap::iterator it_target = targets.find(it_client->first);
-		if (it_target != targets.end()) {
-			for (Clip::reverse_iterator it_point = it_client->second.rbegin(); it_point != it_client->second.rend(); it_point++) {
-				TimePoint et = it_target->second - it_point->first;
-				if (et > 0) {
-					elapsed = et;
-					break;
-				}
-			}
-			elapsed++;	// Adds 1 second to avoid the case when the client is a target but no events before ir are recorded.
+		if (ix >= 0)
+			lower -= ss_slot[ix].error/sample_rate;
+	}
+
+	if (lower < 0)
+		lower = 0;
+
+	return true;
+}
+
+
+void Events::decay_events(int halvings) {
+
+	if (has_defined_events() || halvings <= 0)
+		return;
+
+	thaw();
+	sync_event_map();
+
+	EventCountMap error = {};
+
+	if (discovery == ds_space_saving) {
+		for (SummarySlots::iterator it = ss_slot.begin(); it != ss_slot.end(); ++it)
+			error[it->ept] = halvings < 64 ? it->error >> halvings : 0;
+	}
+
+	PriorityMap decayed = {};
+
+	for (PriorityMap::iterator it = priority.begin(); it != priority.end(); ++it) {
+		EventMap::iterator jt = event.find(it->second);
+
+		uint64_t seen = halvings < 64 ? jt->second.seen >> halvings : 0;
+
+		if (seen == 0) {
+			event.erase(jt);
+			error.erase(it->second);
+
+			continue;
 		}
 
-		OptimizeEvalItem itm = {t_hat[i], elapsed, (int) it_client->second.size()};
+		uint64_t pri = it->first - PRIORITY_SEEN_FACTOR*(jt->second.seen - seen);
 
-		ev.push_back(itm);
+		while (decayed.find(pri) != decayed.end())
+			pri++;
 
-		++i;
+		jt->second.seen		= seen;
+		jt->second.priority = pri;
+
+		decayed[pri] = it->second;
 	}
-	std::sort(ev.begin(), ev.end(), compare_optimize_eval);
 
-	int tp = 0;
-	int fp = 0;
-	int tot_targ = targets.size();
+	bool aged_out = decayed.size() < priority.size();
 
-	for (int i = 0; i < tot_targ; i++)
-		if (ev[i].t_obs != 0) tp++; else fp++;
+	priority.swap(decayed);
 
-	// This is the F1 score: The harmonic mean of precision and recall.
-	// In general: F1 = 2*tp / (2*tp + fp + fn)
-	// In this case, fn == fp -> 2*tp / (2*tp + 2*fp)
-	score = tp/(1.0*tp + fp);
+	if (discovery == ds_space_saving)
+		summary_from_event_map(error);
 
-	if (tp < tot_targ && tp > 0) {		// Score adjustment by correlation
-		double max_diff = ((tp + 1)/(tp + 1.0 + fp) - (tp - 1)/(tp - 1.0 + fp))/2;	// The maximum score adjustment size is the mean
-																					// difference between tp+/-1 scores.
-		double pearson_corr = linear_correlation(ev);
+	if (aged_out && store_strings) {
+		std::set<ElementHash> used = {};
 
-		score = score + max_diff*pearson_corr;
+		for (EventMap::iterator it = event.begin(); it != event.end(); ++it) {
+			used.insert(it->first.e);
+			used.insert(it->first.d);
+		}
+
+		std::vector<ElementHash> unused = {};
+
+		for (int ix = 0; ix < names_map.capacity(); ix++)
+			if (names_map.used(ix) && used.find(names_map.hash(ix)) == used.end())
+				unused.push_back(names_map.hash(ix));
+
+		for (std::vector<ElementHash>::iterator it = unused.begin(); it != unused.end(); ++it)
+			names_map.erase(*it, names_map.seen(names_map.find(*it)));
 	}
+}
 
-	// Exit if tree statistics are not required.
-	if (!calc_tree_stats)
-		return true;
 
-	// Builds an empty CodeInTreeStatMap
-	CodeInTreeStatistics void_code_stat = {0, 0, 0, 0, 0, 0};
+/** \brief Process a row (already converted into a BinEventPt) seen count times in ds_space_saving mode.
+
+	\param ept		The event.
+	\param count	The number of times it was seen.
+
+	This is the Space-Saving algorithm (Metwally, Agrawal, El Abbadi 2005): a monitored event increases its count, a new event
+	takes a free slot or replaces the oldest slot with the minimum count inheriting that count (plus the new ones) as its count and that count
+	as its error. The replaced event loses its code, the new one gets a new code, just like an eviction from the PriorityMap.
+*/
+void Events::summary_insert(BinEventPt &ept, uint64_t count) {
+
+	if (max_num_events <= 0) {
+		erase_str(ept.d, count);
+		erase_str(ept.e, count);
+
+		return;
+	}
+
+	ss_dirty	  = true;
+	priority_low += count;
 
-	for (EventCodeMap::iterator it = code_dict.begin(); it != code_dict.end(); ++it)
-		codes_stat[it->first] = void_code_stat;
+	int ix = summary_find(ept);
 
-	// Calls the Targets recurse_tree_stats() to update the tree statistics
-	return targ.recurse_tree_stats(0, 0, -1, 0, codes_stat);
+	if (ix >= 0) {
+		ss_slot[ix].stamp = priority_low;
+
+		summary_attach(ix, ss_slot[ix].count + count, summary_detach(ix));
+
+		return;
+	}
+
+	if ((int) ss_slot.size() < max_num_events) {
+		SummarySlot slot = {ept, 0, 0, ++next_code, priority_low, -1, -1, -1};
+
+		ix = ss_slot.size();
+
+		ss_slot.push_back(slot);
+
+		summary_index_insert(ix);
+		summary_attach(ix, count, -1);
+
+		return;
+	}
+
+	ix = ss_bucket[ss_min_bucket].first;
+
+	erase_str(ss_slot[ix].ept.d);
+	erase_str(ss_slot[ix].ept.e);
+
+	summary_index_erase(ix);
+
+	uint64_t min_count = ss_slot[ix].count;
+	int		 after	   = summary_detach(ix);
+
+	ss_slot[ix].ept	  = ept;
+	ss_slot[ix].error = min_count;
+	ss_slot[ix].code  = ++next_code;
+	ss_slot[ix].stamp = priority_low;
+
+	summary_index_insert(ix);
+	summary_attach(ix, min_count + count, after);
 }
 
 
-/** \brief Compare two CodeScoreItem structures for sorting.
+/** \brief Find the slot of an event in the Space-Saving stream-summary.
 
-	\param a  The first structure
-	\param b  The second one
+	\param ept	The event.
 
-	\return	True if a < b.
+	\return	The index of the slot in ss_slot or -1 if not found.
 */
-bool compare_score_item(const CodeScoreItem a, const CodeScoreItem b) {
-	return b.score < a.score;
+int Events::summary_find(BinEventPt &ept) {
+
+	if (ss_index.size() == 0)
+		return -1;
+
+	uint64_t mask = ss_index.size() - 1;
+
+	for (uint64_t i = ept.hash() & mask;; i = (i + 1) & mask) {
+		int ix = ss_index[i];
+
+		if (ix < 0)
+			return -1;
+
+		if (ss_slot[ix].ept == ept)
+			return ix;
+	}
 }
 
 
-CodeScores Events::get_top_codes(CodeInTreeStatMap &codes_stat, double targ_prop, double exp_decay, double lower_bound_p, bool log_lift) {
+/** \brief Add a slot to the Space-Saving index (linear probing) doubling its size when the load factor would exceed 1/2.
 
-	CodeScores	ev = {};
-	ClipMap		clm	= {};
-	TargetMap	tm	= {};
-	Targets		tar(&clm, tm);
+	\param ix	The index of the slot in ss_slot.
+*/
+void Events::summary_index_insert(int ix) {
 
-	tar.fit(tr_linear, ag_mean, lower_bound_p, 10, false);
+	if (2*ss_slot.size() > ss_index.size()) {
+		uint64_t size = std::max((uint64_t) 64, (uint64_t) ss_index.size());
 
-#ifdef DEBUG
-	std::ofstream f_stream;
-	std::filebuf *f_buff = f_stream.rdbuf();
+		while (size < 2*ss_slot.size())
+			size *= 2;
 
-	String fn = "/home/jadmin/bbva/x2/source/logs/get_top_codes.log";
+		ss_index.assign(size, -1);
 
-	f_buff->open(fn, std::ios::out);
-#endif
+		for (int jx = 0; jx < (int) ss_slot.size(); jx++)
+			summary_index_insert(jx);
 
-	REELS_logger.log = "";
+		return;
+	}
 
-	REELS_logger.log_printf("n_succ_seen\tn_succ_target\tn_incl_seen\tn_incl_target\tsum_dep\tn_dep\tedf\tprop_succ\tprop_incl\tlift\tscore\tcode\n");
+	uint64_t mask = ss_index.size() - 1;
+	uint64_t i	  = ss_slot[ix].ept.hash() & mask;
 
-	for (CodeInTreeStatMap::iterator it = codes_stat.begin(); it != codes_stat.end(); ++it) {
-		double edf = it->second.n_dep > 0 ? exp(-exp_decay*it->second.sum_dep/it->second.n_dep) : 0;
-		double succ = std::max((double) 0.0, tar.agresti_coull_lower_bound(it->second.n_succ_target, it->second.n_succ_seen));
-		double incl = std::max((double) 0.0, tar.agresti_coull_lower_bound(it->second.n_incl_target, it->second.n_incl_seen));
-		double lift = succ > 0.001 ? incl/succ : 0;
+	while (ss_index[i] >= 0)
+		i = (i + 1) & mask;
+
+	ss_index[i] = ix;
+}
 
-		lift = tar.agresti_coull_upper_bound(it->second.n_incl_target, it->second.n_incl_seen) < targ_prop ? 0 : log_lift ? log(lift + 1) : lift;
 
-		double score = edf*incl*lift;
+/** \brief Remove a slot from the Space-Saving index using backward shift deletion.
 
-		REELS_logger.log_printf("%i\t%i\t%i\t%i\t%i\t%i\t%0.6f\t%0.6f\t%0.6f\t%0.6f\t%0.6f\t%i\n",
-								it->second.n_succ_seen,
-								it->second.n_succ_target,
-								it->second.n_incl_seen,
-								it->second.n_incl_target,
-								it->second.sum_dep,
-								it->second.n_dep,
-								edf, succ, incl, lift, score, it->first);
+	\param ix	The index of the slot in ss_slot.
+*/
+void Events::summary_index_erase(int ix) {
 
-		CodeScoreItem itm = {it->first, score};
+	uint64_t mask = ss_index.size() - 1;
+	uint64_t i	  = ss_slot[ix].ept.hash() & mask;
 
-		ev.push_back(itm);
+	while (ss_index[i] != ix)
+		i = (i + 1) & mask;
+
+	for (uint64_t j = (i + 1) & mask; ss_index[j] >= 0; j = (j + 1) & mask) {
+		uint64_t home = ss_slot[ss_index[j]].ept.hash() & mask;
+
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			ss_index[i] = ss_index[j];
+			i = j;
+		}
 	}
 
-#ifdef DEBUG
-	f_buff->sputn(REELS_logger.log.c_str(), REELS_logger.log.length());
+	ss_index[i] = -1;
+}
 
-	f_stream.flush();
-	f_stream.close();
-#endif
 
-	std::sort(ev.begin(), ev.end(), compare_score_item);
+/** \brief Unlink a slot from its bucket and free the bucket if it becomes empty.
 
-	int top_n = ev.size();
+	\param ix	The index of the slot in ss_slot.
 
-	for (int i = 0; i < top_n; i++) {
-		if (ev[i].score < 5e-7) {
-			top_n = i;
-			break;
+	\return	The index of a bucket with a count smaller than any future count of the slot (to start searching from) or -1 for the start.
+*/
+int Events::summary_detach(int ix) {
+
+	SummarySlot &slot = ss_slot[ix];
+	int			 bx	  = slot.bucket;
+
+	if (slot.prev >= 0)
+		ss_slot[slot.prev].next = slot.next;
+	else
+		ss_bucket[bx].first = slot.next;
+
+	if (slot.next >= 0)
+		ss_slot[slot.next].prev = slot.prev;
+	else
+		ss_bucket[bx].last = slot.prev;
+
+	slot.bucket = -1;
+
+	if (ss_bucket[bx].first >= 0)
+		return bx;
+
+	int px = ss_bucket[bx].prev;
+	int nx = ss_bucket[bx].next;
+
+	if (px >= 0)
+		ss_bucket[px].next = nx;
+	else
+		ss_min_bucket = nx;
+
+	if (nx >= 0)
+		ss_bucket[nx].prev = px;
+
+	ss_bucket[bx].next = ss_free;
+	ss_free = bx;
+
+	return px;
+}
+
+
+/** \brief Link a slot as the last (newest) of the bucket of a given count, creating the bucket if required.
+
+	\param ix		The index of the slot in ss_slot.
+	\param count	The new count of the slot.
+	\param after	The index of a bucket with a smaller count to start searching from or -1 to start from the minimum.
+*/
+void Events::summary_attach(int ix, uint64_t count, int after) {
+
+	int px = after;
+	int bx = after >= 0 ? ss_bucket[after].next : ss_min_bucket;
+
+	while (bx >= 0 && ss_bucket[bx].count < count) {
+		px = bx;
+		bx = ss_bucket[bx].next;
+	}
+
+	if (bx < 0 || ss_bucket[bx].count != count) {
+		SummaryBucket bucket = {count, -1, -1, px, bx};
+
+		int nx = bx;
+
+		if (ss_free >= 0) {
+			bx		= ss_free;
+			ss_free = ss_bucket[bx].next;
+
+			ss_bucket[bx] = bucket;
+		} else {
+			bx = ss_bucket.size();
+
+			ss_bucket.push_back(bucket);
 		}
+
+		if (px >= 0)
+			ss_bucket[px].next = bx;
+		else
+			ss_min_bucket = bx;
+
+		if (nx >= 0)
+			ss_bucket[nx].prev = bx;
 	}
 
-	ev.resize(top_n);
+	SummarySlot &slot = ss_slot[ix];
 
-	return ev;
+	slot.count	= count;
+	slot.bucket = bx;
+	slot.prev	= ss_bucket[bx].last;
+	slot.next	= -1;
+
+	if (slot.prev >= 0)
+		ss_slot[slot.prev].next = ix;
+	else
+		ss_bucket[bx].first = ix;
+
+	ss_bucket[bx].last = ix;
 }
 
 
-bool Events::load(pBinaryImage &p_bi) {
-	int c_block = 0, c_ofs = 0;
+/** \brief Materialize the Space-Saving stream-summary as the EventMap and PriorityMap it is equivalent to.
 
-	return load(p_bi, c_block, c_ofs);
+	The priorities are computed exactly as insert_row() does in ds_priority mode, therefore, the PriorityMap is in eviction order.
+*/
+void Events::summary_to_event_map() {
+
+	event.clear();
+	priority.clear();
+
+	for (SummarySlots::iterator it = ss_slot.begin(); it != ss_slot.end(); ++it) {
+		EventStat es;
+
+		es.seen		= it->count;
+		es.code		= it->code;
+		es.priority = it->stamp + PRIORITY_SEEN_FACTOR*it->count;
+
+		event[it->ept] = es;
+
+		priority[es.priority] = it->ept;
+	}
+
+	ss_dirty = false;
 }
 
 
-bool Events::load(pBinaryImage &p_bi, int &c_block, int &c_ofs) {
+/** \brief Rebuild the Space-Saving stream-summary from the EventMap and PriorityMap (after load() or optimize_events()).
 
-	String		section = "events";
-	ElementHash hs;
-	char		buffer[8192];
+	\param error	The error of each event. (Events not found have error zero.)
+*/
+void Events::summary_from_event_map(EventCountMap &error) {
 
-	bool ok = image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	ss_slot.clear();
+	ss_bucket.clear();
+	ss_index.clear();
 
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+	ss_min_bucket = -1;
+	ss_free		  = -1;
+	ss_dirty	  = false;
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &store_strings, sizeof(store_strings));
+	int last = -1;
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &max_num_events, sizeof(max_num_events));
+	for (PriorityMap::iterator it = priority.begin(); it != priority.end(); ++it) {
+		EventMap::iterator jt = event.find(it->second);
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &priority_low, sizeof(priority_low));
+		if (jt == event.end())
+			continue;
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &next_code, sizeof(next_code));
+		EventCountMap::iterator kt = error.find(it->second);
 
-	section = "names_map";
+		SummarySlot slot = {it->second, 0, kt == error.end() ? 0 : kt->second, jt->second.code,
+							jt->second.priority - PRIORITY_SEEN_FACTOR*jt->second.seen, -1, -1, -1};
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+		int ix = ss_slot.size();
+
+		ss_slot.push_back(slot);
+
+		summary_index_insert(ix);
+
+		int after = -1;
+
+		if (last >= 0 && ss_bucket[last].count <= jt->second.seen)
+			after = ss_bucket[last].count == jt->second.seen ? ss_bucket[last].prev : last;
+
+		summary_attach(ix, jt->second.seen, after);
+
+		last = ss_slot[ix].bucket;
+	}
+}
+
+
+/** \brief An item used by Events::merge() to rank the events of both objects.
+*/
+struct EventMergeItem {
+	BinEventPt ept;			///< The event.
+	uint64_t   seen;		///< The merged count.
+	uint64_t   error;		///< The merged error (ds_space_saving only).
+	uint64_t   code;		///< The code in this object or 0 if the event is new.
+};
+
+
+/** \brief Compare two EventMergeItem structures for ranking in Events::merge().
+
+	\param a  The first structure
+	\param b  The second one
+
+	\return	True if a ranks before b (more frequent or the same and smaller BinEventPt).
+*/
+bool compare_merge_item(const EventMergeItem &a, const EventMergeItem &b) {
+	if (a.seen != b.seen)
+		return a.seen > b.seen;
+
+	return a.ept < b.ept;
+}
+
+
+bool Events::merge(const Events &other) {
+
+	if (&other == this || discovery != other.discovery || hash_function != other.hash_function ||
+		decay_half_life != other.decay_half_life || sample_rate != other.sample_rate || has_defined_events() ||
+		other.has_defined_events())
+		return false;
+
+	thaw();
+	sync_event_map();
+
+	uint64_t min_this  = summary_min_count();
+	uint64_t min_other = other.summary_min_count();
+
+	EventCountMap other_count = {}, other_error = {};
+
+	if (other.discovery == ds_space_saving) {
+		for (SummarySlots::const_iterator it = other.ss_slot.begin(); it != other.ss_slot.end(); ++it) {
+			other_count[it->ept] = it->count;
+			other_error[it->ept] = it->error;
+		}
+	} else {
+		for (EventMap::const_iterator it = other.event.begin(); it != other.event.end(); ++it)
+			other_count[it->first] = it->second.seen;
+	}
+
+	EventCountMap error = {};
+
+	if (discovery == ds_space_saving) {
+		for (SummarySlots::iterator it = ss_slot.begin(); it != ss_slot.end(); ++it)
+			error[it->ept] = it->error;
+	}
+
+	std::map<BinEventPt, EventMergeItem> merged = {};
+
+	for (EventMap::iterator it = event.begin(); it != event.end(); ++it) {
+		EventMergeItem item = {it->first, it->second.seen, error[it->first], it->second.code};
+
+		EventCountMap::iterator jt = other_count.find(it->first);
+
+		if (jt != other_count.end()) {
+			item.seen  += jt->second;
+			item.error += other_error[it->first];
+		} else {
+			item.seen  += min_other;
+			item.error += min_other;
+		}
+
+		merged[it->first] = item;
+	}
+
+	for (EventCountMap::iterator it = other_count.begin(); it != other_count.end(); ++it) {
+		if (merged.find(it->first) == merged.end()) {
+			EventMergeItem item = {it->first, it->second + min_this, other_error[it->first] + min_this, 0};
+
+			merged[it->first] = item;
+		}
+	}
+
+	if (store_strings) {
+		for (int ix = 0; ix < other.names_map.capacity(); ix++) {
+			if (other.names_map.used(ix)) {
+				String str = other.names_map.str(ix);
+
+				names_map.add(other.names_map.hash(ix), str.c_str(), str.length(), other.names_map.seen(ix));
+			}
+		}
+	}
+
+	std::vector<EventMergeItem> rank = {};
+
+	for (std::map<BinEventPt, EventMergeItem>::iterator it = merged.begin(); it != merged.end(); ++it)
+		rank.push_back(it->second);
+
+	std::sort(rank.begin(), rank.end(), compare_merge_item);
+
+	int n_keep = std::min((int) rank.size(), std::max(max_num_events, 0));
+
+	for (int i = n_keep; i < (int) rank.size(); i++) {
+		erase_str(rank[i].ept.d);
+		erase_str(rank[i].ept.e);
+	}
+
+	for (int i = 0; i < n_keep; i++)
+		if (rank[i].code == 0)
+			rank[i].code = ++next_code;
+
+	priority_low = std::max(priority_low + other.priority_low, (uint64_t) n_keep);
+
+	event.clear();
+	priority.clear();
+	error.clear();
+
+	for (int i = n_keep - 1; i >= 0; i--) {
+		EventStat es;
+
+		es.seen		= rank[i].seen;
+		es.code		= rank[i].code;
+		es.priority = priority_low - i + PRIORITY_SEEN_FACTOR*rank[i].seen;
+
+		event[rank[i].ept] = es;
+
+		priority[es.priority] = rank[i].ept;
+
+		error[rank[i].ept] = rank[i].error;
+	}
+
+	if (discovery == ds_space_saving)
+		summary_from_event_map(error);
+
+	sketch_merge(other);
+
+	return true;
+}
+
+
+/** \brief Check if the object contains events created by define_event() rather than discovered by insert_row().
+
+	\return	True if it does.
+*/
+bool Events::has_defined_events() const {
+
+	if (discovery == ds_space_saving)
+		return ss_slot.size() == 0 && event.size() != 0;
+
+	return event.size() != priority.size();
+}
+
+
+/** \brief The minimum count in a full Space-Saving stream-summary. (The maximum number of times a missing event may have been seen.)
+
+	\return	The count of the minimum bucket if the summary is full, else (including ds_priority mode) zero.
+*/
+uint64_t Events::summary_min_count() const {
+
+	if (discovery != ds_space_saving || ss_min_bucket < 0 || (int) ss_slot.size() < max_num_events)
+		return 0;
+
+	return ss_bucket[ss_min_bucket].count;
+}
+
+
+String Events::optimize_events (Clips &clips, TargetMap &targets, int num_steps, int codes_per_step, double threshold,
+								pCodeSet p_force_include, pCodeSet p_force_exclude, Transform x_form, Aggregate agg, double p,
+								int depth, bool as_states, double exp_decay, double lower_bound_p, bool log_lift) {
+
+	// Use a logger as a debug tool and to return errors.
+
+	Logger log = {};
+
+	thaw();
+	sync_event_map();
+
+	// Prerequisites: Collect the different codes of the clips (reading the frozen layout without thawing it) in increasing order.
+
+	pFrozenClips p_frozen = clips.frozen_clips();
+	pClipMap	 p_clips  = clips.raw_clip_map();		// Empty if the clips are frozen
+
+	ClipCursor cur;
+	TimePoint  time_pt;
+	uint64_t   code;
+
+	CodeIdMap code_set = {};
+
+	for (uint64_t i = 0; i < p_frozen->size(); i++) {
+		p_frozen->last_event(i, cur);
+
+		while (p_frozen->prev_event(cur, time_pt, code))
+			code_set.insert(code);
+	}
+
+	for (ClipMap::iterator it = p_clips->begin(); it != p_clips->end(); ++it) {
+		for (Clip::iterator jt = it->second.begin(); jt != it->second.end(); ++jt)
+			code_set.insert(jt->second);
+	}
+
+	CodeDict clip_codes = {};
+
+	clip_codes.reserve(code_set.size());
+
+	for (uint64_t i = 0; i < code_set.size(); i++)
+		clip_codes.push_back(code_set.code(i));
+
+	std::sort(clip_codes.begin(), clip_codes.end());
+
+	log.log_printf("Preprocessing:\n\n  %i codes found in clips.\n", clip_codes.size());
+
+	// Prerequisites: Check the codes in the internal EventMap, remove if in excess, fail if missing.
+
+	int removed = 0;
+	for (EventMap::const_iterator it = event.cbegin(); it != event.cend();) {
+		if (!std::binary_search(clip_codes.begin(), clip_codes.end(), it->second.code)) {
+			event.erase(it++);
+			removed++;
+		} else
+			++it;
+	}
+	log.log_printf("  %i codes removed from internal EventMap.\n", removed);
+
+	// The ids of the remaining events are the dense ids of the optimizer. (The object stays frozen until the codes are renamed.)
+	freeze();
+
+	if (num_ids() != clip_codes.size()) {
+		log.log_printf("  %i codes in clips not defined in internal EventMap.\n", clip_codes.size() - num_ids());
+
+		log.log = "ERROR\n" + log.log;
+
+		return log.log;
+	}
+
+	const CodeDict &large_dict = id_codes();		// The dense ids to their codes, initially the identity.
+
+	// Prerequisites: Copy the clips with the codes renamed to the ids.
+
+	Clips	 id_clips	= {};
+	pClipMap p_id_clips = id_clips.clip_map();
+
+	for (uint64_t i = 0; i < p_frozen->size(); i++) {
+		Clip &clip = p_id_clips->emplace_hint(p_id_clips->end(), p_frozen->client[i], Clip())->second;
+
+		p_frozen->last_event(i, cur);
+
+		while (p_frozen->prev_event(cur, time_pt, code))
+			clip.emplace_hint(clip.begin(), time_pt, event_id(code));
+	}
+
+	for (ClipMap::iterator it = p_clips->begin(); it != p_clips->end(); ++it) {
+		Clip &clip = p_id_clips->emplace_hint(p_id_clips->end(), it->first, Clip())->second;
+
+		for (Clip::iterator jt = it->second.begin(); jt != it->second.end(); ++jt)
+			clip.emplace_hint(clip.end(), jt->first, event_id(jt->second));
+	}
+
+	uint64_t code_base = large_dict.back() + 1;		// Define the range base for the new codes
+
+	// Prerequisites: Another dictionary, initially to code_base.
+
+	uint64_t code_noise = code_base + 1;
+	uint64_t code_new	= code_noise + 1;
+
+	CodeDict small_dict(large_dict.size(), code_noise);
+
+	for (size_t i = 0; i < large_dict.size(); i++) {
+		if (p_force_include != nullptr && p_force_include->find(large_dict[i]) != p_force_include->end())
+			small_dict[i] = code_new++;
+	}
+
+	// First model run
+
+	double large_score = -1, targ_prop;
+
+	CodeInTreeStats codes_stat = {};
+
+	if (!score_model(large_score, targ_prop, codes_stat, true, id_clips, targets, large_dict, x_form, agg, p, depth, as_states)) {
+		log.log = "ERROR\nscore_model() failed!\n" + log.log;
+
+		return log.log;
+	};
+
+	log.log_printf("  Current score = %.6f\n", large_score);
+
+	CodeScores top_code = get_top_codes(codes_stat, large_dict, targ_prop, exp_decay, lower_bound_p, log_lift);
+
+	// Main (over num_steps) loop
+
+	double best_score = -1;
+
+	int top_ix = 0;
+
+	for (int step = 0; step < num_steps; step++) {
+		log.log_printf("\nStep %i of %i\n\n", step + 1, num_steps);
+
+		CodeDict dict = small_dict;
+		int new_codes = 0;
+		log.log_printf("  Trying:\n");
+		while (new_codes < codes_per_step) {
+			if (top_ix == (int) top_code.size())
+				break;
+
+			uint64_t code_try = top_code[top_ix++].code;
+
+			if (p_force_exclude != nullptr && p_force_exclude->find(code_try) != p_force_exclude->end()) {
+	 			log.log_printf("    Code %i was excluded by the caller\n", code_try);
+
+				continue;
+			}
+
+ 			log.log_printf("    Code %i as %i\n", code_try, code_new - code_base);
+
+			dict[event_id(code_try)] = code_new++;
+
+			new_codes++;
+		}
+		if (new_codes == 0) {
+			log.log_printf("  -- No more codes --\n");
+			break;
+		}
+
+		double new_score;
+		if (!score_model(new_score, targ_prop, codes_stat, false, id_clips, targets, dict, x_form, agg, p, depth, as_states)) {
+			log.log = "ERROR\nscore_model() failed!\n" + log.log;
+
+			return log.log;
+		}
+ 		log.log_printf("    ---------------\n    Score = %0.6f\n", new_score);
+
+		if (new_score - best_score >= threshold) {
+			best_score = new_score;
+			small_dict = dict;
+			log.log_printf("    Best score so far.\n");
+		} else
+			log.log_printf("    Threshold (%.6f) not met (diff = %.6f)\n", threshold, new_score - best_score);
+	}
+
+	log.log_printf("\n== F I N A L ==\n\n");
+	log.log_printf("  Final score      = %.6f\n", best_score);
+	log.log_printf("  Final dictionary = {");
+
+	for (int i = 0; i < (int) small_dict.size() - 1; i++)
+		log.log_printf("%i:%i, ", large_dict[i], small_dict[i] - code_base);
+
+	log.log_printf("%i:%i}\n", large_dict.back(), small_dict.back() - code_base);
+
+	for (EventMap::iterator it = event.begin(); it != event.end(); ++it)
+		it->second.code = small_dict[event_id(it->second.code)] - code_base;
+
+	thaw();
+
+	if (discovery == ds_space_saving) {
+		EventCountMap error = {};
+
+		for (SummarySlots::iterator it = ss_slot.begin(); it != ss_slot.end(); ++it)
+			error[it->ept] = it->error;
+
+		summary_from_event_map(error);
+	}
+
+	log.log = "SUCCESS\n" + log.log;
+
+	return log.log;
+}
+
+
+/** \brief Compare two OptimizeEvalItem structures for sorting.
+
+	\param a  The first structure
+	\param b  The second one
+
+	\return	True if a < b.
+*/
+bool compare_optimize_eval(const OptimizeEvalItem a, const OptimizeEvalItem b) {
+	if (a.t_hat != b.t_hat)
+		return a.t_hat < b.t_hat;
+
+	return a.seq_len < b.seq_len;
+}
+
+
+bool Events::score_model(double &score, double &targ_prop, CodeInTreeStats &codes_stat, bool calc_tree_stats, Clips &clips,
+						 TargetMap &targets, const CodeDict &code_dict, Transform x_form, Aggregate agg, double p, int depth,
+						 bool as_states) {
+
+	// Creates a Targets that reads the dense ids through code_dict (rather than a renamed copy of the clips) and fits it to the targets.
+	pClipMap p_clips = clips.clip_map();
+
+	Targets targ = Targets(p_clips, targets);
+
+	targ.set_code_map(code_dict);
+
+	if (!targ.fit(x_form, agg, p, depth, as_states))
+		return false;
+
+	targ_prop = targ.p_tree()->at(0).n_seen > 0 ? targ.p_tree()->at(0).n_target/targ.p_tree()->at(0).n_seen : 0;
+
+	// Predicts, builds an OptimizeEval with (observed and predicted), sorts it and computes score.
+	TimesToTarget t_hat = targ.predict(p_clips, as_states);
+
+	OptimizeEval ev = {};
+	int i = 0;
+	for (ClipMap::iterator it_client = p_clips->begin(); it_client != p_clips->end(); ++it_client) {
+		TimePoint elapsed = 0;
+
+		// As states, only the first event of a run of the same code counts.
+		int		 seq_len   = 0;
+		uint64_t last_code = 0;
+
+		TargetMap::iterator it_target = targets.find(it_client->first);
+
+		for (Clip::iterator it_point = it_client->second.begin(); it_point != it_client->second.end(); ++it_point) {
+			uint64_t code = code_dict[it_point->second];
+
+			if (as_states && seq_len > 0 && code == last_code)
+				continue;
+
+			seq_len++;
+			last_code = code;
+
+			if (it_target != targets.end() && it_point->first < it_target->second)
+				elapsed = it_target->second - it_point->first;
+		}
+
+		if (it_target != targets.end())
+			elapsed++;	// Adds 1 second to avoid the case when the client is a target but no events before ir are recorded.
+
+		OptimizeEvalItem itm = {t_hat[i], elapsed, seq_len};
+
+		ev.push_back(itm);
+
+		++i;
+	}
+	std::sort(ev.begin(), ev.end(), compare_optimize_eval);
+
+	int tp = 0;
+	int fp = 0;
+	int tot_targ = targets.size();
+
+	for (int i = 0; i < tot_targ; i++)
+		if (ev[i].t_obs != 0) tp++; else fp++;
+
+	// This is the F1 score: The harmonic mean of precision and recall.
+	// In general: F1 = 2*tp / (2*tp + fp + fn)
+	// In this case, fn == fp -> 2*tp / (2*tp + 2*fp)
+	score = tp/(1.0*tp + fp);
+
+	if (tp < tot_targ && tp > 0) {		// Score adjustment by correlation
+		double max_diff = ((tp + 1)/(tp + 1.0 + fp) - (tp - 1)/(tp - 1.0 + fp))/2;	// The maximum score adjustment size is the mean
+																					// difference between tp+/-1 scores.
+		double pearson_corr = linear_correlation(ev);
+
+		score = score + max_diff*pearson_corr;
+	}
+
+	// Exit if tree statistics are not required.
+	if (!calc_tree_stats)
+		return true;
+
+	// Calls the Targets recurse_tree_stats() to update the tree statistics (indexed by the ids of the tree)
+	CodeInTreeStatistics void_code_stat = {0, 0, 0, 0, 0, 0};
+	CodeInTreeStats		 tree_stat(targ.num_codes(), void_code_stat);
+
+	if (!targ.recurse_tree_stats(0, 0, -1, 0, tree_stat))
+		return false;
+
+	// Returns them indexed by the dense ids of the clips
+	codes_stat.assign(code_dict.size(), void_code_stat);
+
+	for (uint64_t i = 0; i < code_dict.size(); i++) {
+		int64_t id = targ.tree_id(i);
+
+		if (id >= 0)
+			codes_stat[i] = tree_stat[id];
+	}
+
+	return true;
+}
+
+
+/** \brief Compare two CodeScoreItem structures for sorting.
+
+	\param a  The first structure
+	\param b  The second one
+
+	\return	True if a < b.
+*/
+bool compare_score_item(const CodeScoreItem a, const CodeScoreItem b) {
+	return b.score < a.score;
+}
+
+
+CodeScores Events::get_top_codes(CodeInTreeStats &codes_stat, const CodeDict &code_dict, double targ_prop, double exp_decay,
+								 double lower_bound_p, bool log_lift) {
+
+	CodeScores	ev = {};
+	ClipMap		clm	= {};
+	TargetMap	tm	= {};
+	Targets		tar(&clm, tm);
+
+	tar.fit(tr_linear, ag_mean, lower_bound_p, 10, false);
+
+#ifdef DEBUG
+	std::ofstream f_stream;
+	std::filebuf *f_buff = f_stream.rdbuf();
+
+	String fn = "/home/jadmin/bbva/x2/source/logs/get_top_codes.log";
+
+	f_buff->open(fn, std::ios::out);
+#endif
+
+	REELS_logger.log = "";
+
+	REELS_logger.log_printf("n_succ_seen\tn_succ_target\tn_incl_seen\tn_incl_target\tsum_dep\tn_dep\tedf\tprop_succ\tprop_incl\tlift\tscore\tcode\n");
+
+	for (uint64_t i = 0; i < codes_stat.size(); i++) {
+		CodeInTreeStatistics *p_stat = &codes_stat[i];
+
+		double edf = p_stat->n_dep > 0 ? exp(-exp_decay*p_stat->sum_dep/p_stat->n_dep) : 0;
+		double succ = std::max((double) 0.0, tar.agresti_coull_lower_bound(p_stat->n_succ_target, p_stat->n_succ_seen));
+		double incl = std::max((double) 0.0, tar.agresti_coull_lower_bound(p_stat->n_incl_target, p_stat->n_incl_seen));
+		double lift = succ > 0.001 ? incl/succ : 0;
+
+		lift = tar.agresti_coull_upper_bound(p_stat->n_incl_target, p_stat->n_incl_seen) < targ_prop ? 0 : log_lift ? log(lift + 1) : lift;
+
+		double score = edf*incl*lift;
+
+		REELS_logger.log_printf("%i\t%i\t%i\t%i\t%i\t%i\t%0.6f\t%0.6f\t%0.6f\t%0.6f\t%0.6f\t%i\n",
+								p_stat->n_succ_seen,
+								p_stat->n_succ_target,
+								p_stat->n_incl_seen,
+								p_stat->n_incl_target,
+								p_stat->sum_dep,
+								p_stat->n_dep,
+								edf, succ, incl, lift, score, code_dict[i]);
+
+		CodeScoreItem itm = {code_dict[i], score};
+
+		ev.push_back(itm);
+	}
+
+#ifdef DEBUG
+	f_buff->sputn(REELS_logger.log.c_str(), REELS_logger.log.length());
+
+	f_stream.flush();
+	f_stream.close();
+#endif
+
+	std::sort(ev.begin(), ev.end(), compare_score_item);
+
+	int top_n = ev.size();
+
+	for (int i = 0; i < top_n; i++) {
+		if (ev[i].score < 5e-7) {
+			top_n = i;
+			break;
+		}
+	}
+
+	ev.resize(top_n);
+
+	return ev;
+}
+
+
+bool Events::load(pBinaryImage &p_bi) {
+	int c_block = 0, c_ofs = 0;
+
+	return load(p_bi, c_block, c_ofs);
+}
+
+
+bool Events::load(pBinaryImage &p_bi, int &c_block, int &c_ofs) {
+
+	thaw();
+
+	String		section = "events";
+	ElementHash hs;
+	char		buffer[8192];
+
+	bool ok = image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+
+	ok = ok && find_hashed_section(hs, section.c_str(), hash_function);
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &store_strings, sizeof(store_strings));
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &max_num_events, sizeof(max_num_events));
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &priority_low, sizeof(priority_low));
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &next_code, sizeof(next_code));
+
+	section = "names_map";
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+
+	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+	ok = ok && (names_map.size() == 0);
+
+	int len;
+
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+
+	for (int i = 0; ok && i < len; i++) {
+		ElementHash hh;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &hh, sizeof(hh));
+
+		uint64_t seen;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &seen, sizeof(seen));
+
+		int ll;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &ll, sizeof(ll));
+		ok = ok && (ll >= 0) && (ll < 8192);
+
+		if (ok && ll > 0 && !image_get(p_bi, c_block, c_ofs, &buffer, ll))
+			return false;
+
+		if (ok && hh != 0)
+			names_map.add(hh, buffer, ll, seen);
+	}
+
+	section = "event";
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+
+	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+	ok = ok && (event.size() == 0);
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+
+	for (int i = 0; ok && i < len; i++) {
+		BinEventPt ev;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &ev, sizeof(ev));
+
+		EventStat es;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &es, sizeof(es));
+
+		event[ev] = es;
+	}
+
+	section = "priority";
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+
+	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+	ok = ok && (priority.size() == 0);
+
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+
+	for (int i = 0; ok && i < len; i++) {
+		uint64_t hh;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &hh, sizeof(hh));
+
+		BinEventPt ev;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &ev, sizeof(ev));
+
+		priority[hh] = ev;
+	}
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+
+	discovery = ds_priority;
+
+	section = "space_saving";
+
+	if (ok && hs == MurmurHash64A(section.c_str(), section.length())) {
+		EventCountMap error = {};
+
+		ok = ok && (ss_slot.size() == 0);
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+
+		for (int i = 0; ok && i < len; i++) {
+			BinEventPt ev;
+
+			ok = ok && image_get(p_bi, c_block, c_ofs, &ev, sizeof(ev));
+
+			uint64_t err;
+
+			ok = ok && image_get(p_bi, c_block, c_ofs, &err, sizeof(err));
+
+			error[ev] = err;
+		}
+
+		if (ok) {
+			discovery = ds_space_saving;
+
+			summary_from_event_map(error);
+		}
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	}
+
+	cm_width = 0;
+	cm_depth = 0;
+	cm_rows	 = 0;
+	cm_count.clear();
+
+	section = "admission";
+
+	if (ok && hs == MurmurHash64A(section.c_str(), section.length())) {
+		ok = ok && image_get(p_bi, c_block, c_ofs, &cm_width, sizeof(cm_width));
+		ok = ok && image_get(p_bi, c_block, c_ofs, &cm_depth, sizeof(cm_depth));
+		ok = ok && image_get(p_bi, c_block, c_ofs, &cm_rows, sizeof(cm_rows));
+		ok = ok && cm_width > 0 && cm_depth > 0;
+
+		if (ok) {
+			cm_count.resize((size_t) cm_width*cm_depth);
+
+			ok = image_get(p_bi, c_block, c_ofs, cm_count.data(), cm_count.size()*sizeof(uint32_t));
+		}
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	}
+
+	decay_half_life = 0;
+	decay_rows		= 0;
+
+	section = "decay";
+
+	if (ok && hs == MurmurHash64A(section.c_str(), section.length())) {
+		ok = ok && image_get(p_bi, c_block, c_ofs, &decay_half_life, sizeof(decay_half_life));
+		ok = ok && image_get(p_bi, c_block, c_ofs, &decay_rows, sizeof(decay_rows));
+		ok = ok && decay_half_life > 0;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	}
+
+	sample_rate = 1;
+	sample_rows = 0;
+
+	section = "sampling";
+
+	if (ok && hs == MurmurHash64A(section.c_str(), section.length())) {
+		ok = ok && image_get(p_bi, c_block, c_ofs, &sample_rate, sizeof(sample_rate));
+		ok = ok && image_get(p_bi, c_block, c_ofs, &sample_rows, sizeof(sample_rows));
+		ok = ok && sample_rate > 0 && sample_rate < 1;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	}
+
+	section = "end";
+
+	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+
+	return ok;
+}
+
+
+bool Events::save(pBinaryImage &p_bi, bool with_events) {
+
+	sync_event_map();
+
+	EventMap	   no_event	   = {};
+	PriorityMap	   no_priority = {};
+	SummarySlots   no_slot	   = {};
+	SketchCounters no_count(with_events ? 0 : cm_count.size(), 0);
+
+	EventMap	   &save_event	  = with_events ? event : no_event;
+	PriorityMap	   &save_priority = with_events ? priority : no_priority;
+	SummarySlots   &save_slot	  = with_events ? ss_slot : no_slot;
+	SketchCounters &save_count	  = with_events ? cm_count : no_count;
+
+	uint64_t low  = with_events ? priority_low : 0;
+	uint64_t code = with_events ? next_code : 0;
+	uint64_t zero = 0;
+
+	String section = hashed_section("events", hash_function);
+	ElementHash hs = MurmurHash64A(section.c_str(), section.length());
+
+	image_put(p_bi, &hs, sizeof(hs));
+
+	image_put(p_bi, &store_strings, sizeof(store_strings));
+	image_put(p_bi, &max_num_events, sizeof(max_num_events));
+	image_put(p_bi, &low, sizeof(low));
+	image_put(p_bi, &code, sizeof(code));
+
+	section = "names_map";
+	hs		= MurmurHash64A(section.c_str(), section.length());
+
+	image_put(p_bi, &hs, sizeof(hs));
+
+	int len = with_events ? names_map.size() : 0;
+
+	image_put(p_bi, &len, sizeof(len));
+
+	std::vector<int> sorted = with_events ? names_map.sorted_slots() : std::vector<int>();
+
+	for (std::vector<int>::iterator it = sorted.begin(); it != sorted.end(); ++it) {
+		ElementHash hh = names_map.hash(*it);
+		image_put(p_bi, &hh, sizeof(hh));
+		uint64_t su_seen = names_map.seen(*it);
+
+		image_put(p_bi, &su_seen, sizeof(su_seen));
+
+		String str = names_map.str(*it);
+		int	   ll  = str.length();
+
+		image_put(p_bi, &ll, sizeof(ll));
+		image_put(p_bi, (void *) str.c_str(), ll);
+	}
+
+	section = "event";
+	hs		= MurmurHash64A(section.c_str(), section.length());
+
+	image_put(p_bi, &hs, sizeof(hs));
+
+	len = save_event.size();
+
+	image_put(p_bi, &len, sizeof(len));
+
+	for (EventMap::iterator it = save_event.begin(); it != save_event.end(); ++it) {
+		BinEventPt ev = it->first;
+		image_put(p_bi, &ev, sizeof(ev));
+		EventStat es = it->second;
+		image_put(p_bi, &es, sizeof(es));
+	}
+
+	section = "priority";
+	hs		= MurmurHash64A(section.c_str(), section.length());
+
+	image_put(p_bi, &hs, sizeof(hs));
+
+	len = save_priority.size();
+
+	image_put(p_bi, &len, sizeof(len));
+
+	for (PriorityMap::iterator it = save_priority.begin(); it != save_priority.end(); ++it) {
+		uint64_t hh = it->first;
+		image_put(p_bi, &hh, sizeof(hh));
+		BinEventPt ev = it->second;
+		image_put(p_bi, &ev, sizeof(ev));
+	}
+
+	if (discovery == ds_space_saving) {
+		section = "space_saving";
+		hs		= MurmurHash64A(section.c_str(), section.length());
+
+		image_put(p_bi, &hs, sizeof(hs));
+
+		len = save_slot.size();
+
+		image_put(p_bi, &len, sizeof(len));
+
+		for (SummarySlots::iterator it = save_slot.begin(); it != save_slot.end(); ++it) {
+			BinEventPt ev = it->ept;
+			image_put(p_bi, &ev, sizeof(ev));
+			uint64_t err = it->error;
+			image_put(p_bi, &err, sizeof(err));
+		}
+	}
+
+	if (cm_width > 0) {
+		section = "admission";
+		hs		= MurmurHash64A(section.c_str(), section.length());
+
+		image_put(p_bi, &hs, sizeof(hs));
+
+		image_put(p_bi, &cm_width, sizeof(cm_width));
+		image_put(p_bi, &cm_depth, sizeof(cm_depth));
+		image_put(p_bi, with_events ? &cm_rows : &zero, sizeof(cm_rows));
+		image_put(p_bi, save_count.data(), save_count.size()*sizeof(uint32_t));
+	}
+
+	if (decay_half_life > 0) {
+		section = "decay";
+		hs		= MurmurHash64A(section.c_str(), section.length());
+
+		image_put(p_bi, &hs, sizeof(hs));
+
+		image_put(p_bi, &decay_half_life, sizeof(decay_half_life));
+		image_put(p_bi, with_events ? &decay_rows : &zero, sizeof(decay_rows));
+	}
+
+	if (sample_rate < 1) {
+		section = "sampling";
+		hs		= MurmurHash64A(section.c_str(), section.length());
+
+		image_put(p_bi, &hs, sizeof(hs));
+
+		image_put(p_bi, &sample_rate, sizeof(sample_rate));
+		image_put(p_bi, with_events ? &sample_rows : &zero, sizeof(sample_rows));
+	}
+
+	section = "end";
+	hs		= MurmurHash64A(section.c_str(), section.length());
+
+	image_put(p_bi, &hs, sizeof(hs));
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------------
+//	Clients Implementation
+// -----------------------------------------------------------------------------------------------------------------------------------------
+
+void ClientIDSet::clear() {
+	slot.clear();
+
+	num_used = 0;
+	shift	 = 64;
+}
+
+
+void ClientIDSet::resize(uint64_t n, const ClientIDs &id) {
+	uint64_t size = 64;
+	int		 bits = 6;
+
+	while (size < n) {
+		size <<= 1;
+		bits++;
+	}
+
+	ClientSlots old_slot;
+
+	old_slot.swap(slot);
+
+	slot.resize(size, 0);
+	shift = 64 - bits;
+
+	uint64_t mask = size - 1;
+
+	for (uint64_t j = 0; j < old_slot.size(); j++) {
+		uint32_t ix = old_slot[j];
+
+		if (ix != 0) {
+			uint64_t i = slot_of(id[ix - 1]);
+
+			while (slot[i] != 0)
+				i = (i + 1) & mask;
+
+			slot[i] = ix;
+		}
+	}
+}
+
+
+void ClipIndex::clear() {
+	slot.clear();
+
+	num_used = 0;
+	shift	 = 64;
+}
+
+
+void ClipIndex::resize(uint64_t n) {
+	uint64_t size = 64;
+	int		 bits = 6;
+
+	while (size < n) {
+		size <<= 1;
+		bits++;
+	}
+
+	ClipSlots old_slot;
+
+	old_slot.swap(slot);
+
+	slot.resize(size, ClipSlot {0, nullptr});
+	shift = 64 - bits;
+
+	uint64_t mask = size - 1;
+
+	for (ClipSlots::iterator it = old_slot.begin(); it != old_slot.end(); ++it) {
+		if (it->p_clip == nullptr)
+			continue;
+
+		uint64_t i = slot_of(it->hash);
+
+		while (slot[i].p_clip != nullptr)
+			i = (i + 1) & mask;
+
+		slot[i] = *it;
+	}
+}
+
+
+const uint32_t ClientFilter::salt[8] = {0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d, 0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31};
+
+
+void ClientFilter::build(const ClientIDs &id, int bits_per_id) {
+
+	num_blocks = (id.size()*bits_per_id + 255)/256;
+
+	if (num_blocks == 0)
+		num_blocks = 1;
+
+	word.assign(8*num_blocks, 0);
+
+	for (ClientIDs::const_iterator it = id.begin(); it != id.end(); ++it) {
+		uint32_t *p_block = &word[8*(((*it >> 32)*num_blocks) >> 32)];
+
+		uint32_t key = (uint32_t) *it;
+
+		for (int i = 0; i < 8; i++)
+			p_block[i] |= 1u << ((key*salt[i]) >> 27);
+	}
+}
+
+
+void Clients::add_client_id(pChar p_cli) {
+
+	ElementHash hash = hash_client_id(p_cli);
+
+	id.push_back(hash);
+	id_set.insert(id.size() - 1, id);
+}
+
+
+uint64_t Clients::add_client_hashes(const ElementHash *p_hash, uint64_t n) {
+	return add_new_hashes(p_hash, n);
+}
+
+
+uint64_t Clients::add_client_ids(const pChar *p_cli, const uint64_t *p_len, uint64_t n) {
+
+	std::vector<ElementHash> hash(n);
+
+	hash_in_parallel(hash_function, p_cli, p_len, n, hash.data());
+
+	return add_new_hashes(hash.data(), n);
+}
+
+
+int64_t Clients::load_client_ids(pChar p_path) {
+
+	FILE *f = fopen(p_path, "rb");
+
+	if (f == nullptr)
+		return -1;
+
+	std::vector<char> buff;
+	char block[65536];
+	size_t len;
+
+	while ((len = fread(block, 1, sizeof(block), f)) > 0)
+		buff.insert(buff.end(), block, block + len);
+
+	bool ok = ferror(f) == 0;
+
+	fclose(f);
+
+	if (!ok)
+		return -1;
+
+	std::vector<pChar>	  p_cli;
+	std::vector<uint64_t> p_len;
+
+	uint64_t size = buff.size(), start = 0;
+
+	for (uint64_t i = 0; i <= size; i++) {
+		if (i == size || buff[i] == '\n') {
+			uint64_t end = i;
+
+			if (end > start && buff[end - 1] == '\r')
+				end--;
+
+			p_cli.push_back(buff.data() + start);
+			p_len.push_back(end - start);
+
+			start = i + 1;
+		}
+	}
+
+	return add_client_ids(p_cli.data(), p_len.data(), p_cli.size());
+}
+
+
+bool Clients::load(pBinaryImage &p_bi) {
+	int c_block = 0, c_ofs = 0;
+
+	return load(p_bi, c_block, c_ofs);
+}
+
+
+bool Clients::load(pBinaryImage &p_bi, int &c_block, int &c_ofs) {
+
+	String		section = "clients";
+	ElementHash hs;
+
+	bool ok = image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+
+	ok = ok && find_hashed_section(hs, section.c_str(), hash_function);
+	ok = ok && (id.size() == 0);
+	ok = ok && (id_set.size() == 0);
+
+	int len;
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+
+	if (ok)
+		id_set.reserve(len, id);
+
+	for (int i = 0; ok && i < len; i++) {
+		ElementHash hh;
+
+		ok = ok && image_get(p_bi, c_block, c_ofs, &hh, sizeof(hh));
+
+		id.push_back(hh);
+		id_set.insert(id.size() - 1, id);
+	}
+
+	section = "end";
+
+	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+
+	return ok;
+}
+
+
+bool Clients::save(pBinaryImage &p_bi) {
+
+	String section = hashed_section("clients", hash_function);
+	ElementHash hs = MurmurHash64A(section.c_str(), section.length());
+
+	image_put(p_bi, &hs, sizeof(hs));
+
+	int len = id.size();
+
+	image_put(p_bi, &len, sizeof(len));
+
+	for (int i = 0; i < len; i++) {
+		ElementHash hh = id[i];
+		image_put(p_bi, &hh, sizeof(hh));
+	}
+
+	section = "end";
+	hs		= MurmurHash64A(section.c_str(), section.length());
+
+	image_put(p_bi, &hs, sizeof(hs));
+
+	return true;
+}
+
+
+void Clients::hash_in_parallel(HashFunction hash_fn, const pChar *p_cli, const uint64_t *p_len, uint64_t n, ElementHash *p_hash) {
+
+	auto hash_range = [=](uint64_t from, uint64_t to) {
+		for (uint64_t i = from; i < to; i++)
+			p_hash[i] = p_len[i] == 0 ? 0 : hash_block(hash_fn, p_cli[i], p_len[i]);
+	};
+
+	uint64_t num_threads = std::min((uint64_t) std::max(std::thread::hardware_concurrency(), 1u), n/BULK_HASH_MIN_PER_THREAD + 1);
+
+	if (num_threads == 1) {
+		hash_range(0, n);
+
+		return;
+	}
+
+	std::vector<std::thread> worker;
+
+	uint64_t step = (n + num_threads - 1)/num_threads;
+
+	for (uint64_t t = 0; t < num_threads; t++)
+		worker.push_back(std::thread(hash_range, std::min(n, t*step), std::min(n, (t + 1)*step)));
+
+	for (uint64_t t = 0; t < num_threads; t++)
+		worker[t].join();
+}
+
+
+uint64_t Clients::add_new_hashes(const ElementHash *p_hash, uint64_t n) {
+
+	id_set.reserve(id_set.size() + n, id);
+
+	uint64_t added = 0;
+
+	for (uint64_t i = 0; i < n; i++) {
+		if (p_hash[i] == 0)
+			continue;
+
+		id.push_back(p_hash[i]);
+
+		if (id_set.insert(id.size() - 1, id))
+			added++;
+		else
+			id.pop_back();
+	}
+
+	return added;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------------
+//	FrozenClips Implementation
+// -----------------------------------------------------------------------------------------------------------------------------------------
+
+void FrozenClips::build(const ClipMap &clip_map, bool compress, const CodeDict *p_ids) {
+
+	uint64_t num_events = 0;
+
+	for (ClipMap::const_iterator it = clip_map.begin(); it != clip_map.end(); ++it)
+		num_events += it->second.size();
+
+	CodeIdMap clip_codes = {};
+
+	if (compress) {
+		for (ClipMap::const_iterator it_clip = clip_map.begin(); it_clip != clip_map.end(); ++it_clip)
+			for (Clip::const_iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it)
+				clip_codes.insert(it->second);
+	}
+
+	start_build(clip_map.size(), num_events, clip_codes, p_ids, compress);
+
+	TimePoints times;
+	ClipCodes  codes;
+
+	for (ClipMap::const_iterator it_clip = clip_map.begin(); it_clip != clip_map.end(); ++it_clip) {
+		times.clear();
+		codes.clear();
+
+		for (Clip::const_iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it) {
+			times.push_back(it->first);
+			codes.push_back(it->second);
+		}
+
+		push_clip(it_clip->first, times.data(), codes.data(), times.size());
+	}
+}
+
+
+void FrozenClips::build(const ClipEvent *p_event, uint64_t n, bool compress, const CodeDict *p_ids) {
+
+	uint64_t num_clips = 0;
+
+	CodeIdMap clip_codes = {};
+
+	for (uint64_t j = 0; j < n; j++) {
+		num_clips += j == 0 || p_event[j].client != p_event[j - 1].client;
+
+		if (compress)
+			clip_codes.insert(p_event[j].code);
+	}
+
+	start_build(num_clips, n, clip_codes, p_ids, compress);
+
+	TimePoints times;
+	ClipCodes  codes;
+
+	for (uint64_t j = 0; j < n;) {
+		ElementHash hash = p_event[j].client;
+
+		times.clear();
+		codes.clear();
+
+		for (; j < n && p_event[j].client == hash; j++) {
+			times.push_back(p_event[j].time);
+			codes.push_back(p_event[j].code);
+		}
+
+		push_clip(hash, times.data(), codes.data(), times.size());
+	}
+}
+
+
+void FrozenClips::to_clip_map(ClipMap &clip_map) const {
+
+	for (uint64_t i = 0; i < client.size(); i++)
+		clip_map[client[i]] = clip(i);
+}
+
+
+void FrozenClips::collapse_to_states() {
+
+	if (compressed) {
+		FrozenClips states;
+
+		states.compressed  = true;
+		states.code_dict   = code_dict;
+		states.code_bits   = code_bits;
+		states.packed_code.assign(packed_code.size(), 0);
+		states.offset.push_back(0);
+		states.time_offset.push_back(0);
+
+		TimePoints times;
+		ClipCodes  codes;
+
+		for (uint64_t i = 0; i < client.size(); i++) {
+			clip_events(i, times, codes);
+
+			uint64_t dst = 0, last_code = 0xA30BdefacedCabal;
+
+			for (uint64_t j = 0; j < codes.size(); j++) {
+				if (codes[j] != last_code) {
+					times[dst] = times[j];
+					codes[dst] = codes[j];
+					dst++;
+				}
+				last_code = codes[j];
+			}
+
+			states.push_clip(client[i], times.data(), codes.data(), dst);
+		}
+
+		states.packed_code.resize((states.num_events()*code_bits + 63)/64 + 1);
+		states.time_bytes.shrink_to_fit();
+		states.packed_code.shrink_to_fit();
+
+		std::swap(*this, states);
+
+		return;
+	}
+
+	uint64_t dst = 0;
+
+	for (uint64_t i = 0; i < client.size(); i++) {
+		uint64_t start = offset[i], last_code = 0xA30BdefacedCabal;
+
+		offset[i] = dst;
+
+		for (uint64_t j = start; j < offset[i + 1]; j++) {
+			if (code[j] != last_code) {
+				time[dst] = time[j];
+				code[dst] = code[j];
+				dst++;
+			}
+			last_code = code[j];
+		}
+	}
+	offset[client.size()] = dst;
+
+	time.resize(dst);
+	code.resize(dst);
+
+	time.shrink_to_fit();
+	code.shrink_to_fit();
+}
+
+
+void FrozenClips::save_clips(pBinaryImage &p_bi) {
+
+	int len_clips = client.size();
+
+	image_put(p_bi, &len_clips, sizeof(len_clips));
+
+	TimePoints times;
+	ClipCodes  codes;
+
+	for (int i = 0; i < len_clips; i++) {
+		ElementHash hh = client[i];
+		image_put(p_bi, &hh, sizeof(hh));
+
+		clip_events(i, times, codes);
+
+		int len = times.size();
+		image_put(p_bi, &len, sizeof(len));
+
+		for (int j = 0; j < len; j++) {
+			TimePoint tp = times[j];
+			image_put(p_bi, &tp, sizeof(tp));
+
+			uint64_t ev = codes[j];
+			image_put(p_bi, &ev, sizeof(ev));
+		}
+	}
+}
+
+
+void FrozenClips::clear() {
+	ClientIDs().swap(client);
+	ClipCodes().swap(offset);
+	TimePoints().swap(time);
+	ClipCodes().swap(code);
+
+	compressed = false;
+	code_bits  = 1;
+
+	ClipCodes().swap(code_dict);
+	ClipCodes().swap(packed_code);
+	ClipBytes().swap(time_bytes);
+	ClipCodes().swap(time_offset);
+	TimePoints().swap(last_time);
+}
+
+
+uint64_t FrozenClips::memory_size() const {
+	return sizeof(ElementHash)*client.capacity() + sizeof(uint64_t)*offset.capacity() + sizeof(TimePoint)*time.capacity()
+		 + sizeof(uint64_t)*code.capacity() + sizeof(uint64_t)*code_dict.capacity() + sizeof(uint64_t)*packed_code.capacity()
+		 + time_bytes.capacity() + sizeof(uint64_t)*time_offset.capacity() + sizeof(TimePoint)*last_time.capacity();
+}
+
+
+void FrozenClips::clip_events(uint64_t ix, TimePoints &times, ClipCodes &codes) const {
+
+	times.clear();
+	codes.clear();
+
+	ClipCursor cur;
+	TimePoint  time_pt;
+	uint64_t   code;
+
+	last_event(ix, cur);
+
+	while (prev_event(cur, time_pt, code)) {
+		times.push_back(time_pt);
+		codes.push_back(code);
+	}
+
+	std::reverse(times.begin(), times.end());
+	std::reverse(codes.begin(), codes.end());
+}
+
+
+void FrozenClips::push_varint(uint64_t value) {
+
+	while (value >= 0x80) {
+		time_bytes.push_back((uint8_t) (value | 0x80));
+
+		value >>= 7;
+	}
+	time_bytes.push_back((uint8_t) value);
+}
+
+
+void FrozenClips::start_build(uint64_t num_clips, uint64_t num_events, CodeIdMap &clip_codes, const CodeDict *p_ids, bool compress) {
+
+	clear();
+
+	compressed = compress;
+
+	if (compressed) {
+		code_dict.reserve(clip_codes.size());
+
+		for (uint64_t i = 0; i < clip_codes.size(); i++)
+			code_dict.push_back(clip_codes.code(i));
+
+		clip_codes.clear();
+
+		std::sort(code_dict.begin(), code_dict.end());
+
+		// The ids of the Events replace the codes if they contain all of them.
+		if (p_ids != nullptr && std::includes(p_ids->begin(), p_ids->end(), code_dict.begin(), code_dict.end()))
+			code_dict = *p_ids;
+
+		code_bits = 1;
+
+		while (code_bits < 64 && (1ull << code_bits) < code_dict.size())
+			code_bits++;
+
+		packed_code.assign((num_events*code_bits + 63)/64 + 1, 0);
+
+		time_offset.reserve(num_clips + 1);
+		last_time.reserve(num_clips);
+
+		time_offset.push_back(0);
+	} else {
+		time.reserve(num_events);
+		code.reserve(num_events);
+	}
+
+	client.reserve(num_clips);
+	offset.reserve(num_clips + 1);
+
+	offset.push_back(0);
+}
+
+
+void FrozenClips::push_clip(ElementHash hash, const TimePoint *p_time, const uint64_t *p_code, uint64_t n) {
+
+	uint64_t j0 = offset.back();
+
+	client.push_back(hash);
+	offset.push_back(j0 + n);
+
+	if (!compressed) {
+		time.insert(time.end(), p_time, p_time + n);
+		code.insert(code.end(), p_code, p_code + n);
+
+		return;
+	}
+
+	for (uint64_t k = 0; k < n; k++) {
+		uint64_t ix	 = dense_id(code_dict, p_code[k]);
+		uint64_t bit = (j0 + k)*code_bits, word = bit >> 6;
+		int		 sh	 = bit & 63;
+
+		packed_code[word] |= ix << sh;
+
+		if (sh + code_bits > 64)
+			packed_code[word + 1] |= ix >> (64 - sh);
+	}
+
+	if (n > 0) {
+		push_varint(((uint64_t) p_time[0] << 1) ^ (uint64_t) (p_time[0] >> 63));		// zigzag, in case of times before 1970
+
+		for (uint64_t k = 1; k < n; k++)
+			push_varint(p_time[k] - p_time[k - 1]);
+	}
+
+	time_offset.push_back(time_bytes.size());
+	last_time.push_back(n > 0 ? p_time[n - 1] : 0);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------------
+//	Clips Implementation
+// -----------------------------------------------------------------------------------------------------------------------------------------
+
+void Clips::freeze(bool compress) {
+
+	end_ingestion();
+
+	if (frozen.is_frozen()) {
+		if (frozen.compressed == compress)
+			return;
+
+		thaw();
+	}
+
+	frozen.build(clips, compress, &events.id_codes());
+
+	ClipMap().swap(clips);
+
+	clip_index.clear();
+}
+
+
+void Clips::thaw() {
+
+	if (!frozen.is_frozen())
+		return;
+
+	frozen.to_clip_map(clips);
+
+	frozen.clear();
+}
+
+
+void Clips::set_history(uint64_t length, TimePoint seconds) {
+
+	history_length	= length;
+	history_seconds = std::max((TimePoint) 0, seconds);
+
+	if (history_length == 0 && history_seconds == 0)
+		return;
+
+	pClipMap p_clips = clip_map();
+
+	for (ClipMap::iterator it = p_clips->begin(); it != p_clips->end(); ++it)
+		trim_clip(it->second);
+}
+
+
+void Clips::scan_rows(char *p_buf, uint64_t size, int num_threads) {
+
+	auto scan_range = [](Clips *p_clips, char *p_row, char *p_end) {
+		while (p_row < p_end) {
+			char *field[5];
+			int	  n = 0;
+
+			field[0] = p_row;
+
+			for (; *p_row != '\n'; p_row++) {
+				if (*p_row == '\t' && n < 4) {
+					*p_row	   = 0;
+					field[++n] = p_row + 1;
+				}
+			}
+			*p_row++ = 0;
+
+			if (n == 4)
+				p_clips->scan_event(field[0], field[1], strtod(field[2], nullptr), field[3], field[4]);
+		}
+	};
+
+	std::vector<uint64_t> bound = {0};
+
+	for (int t = 0; t < num_threads && bound.back() < size; t++) {
+		uint64_t end = t == num_threads - 1 ? size : std::max(bound.back() + 1, size*(t + 1)/num_threads);
+
+		while (end < size && p_buf[end - 1] != '\n')
+			end++;
+
+		bound.push_back(end);
+	}
 
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
-	ok = ok && (names_map.size() == 0);
+	uint64_t num_ranges = bound.size() - 1;
 
-	int len;
+	if (num_ranges <= 1) {
+		scan_range(this, p_buf, p_buf + size);
 
+		return;
+	}
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+	std::vector<Clips> part(num_ranges - 1);
 
-	for (int i = 0; ok && i < len; i++) {
-		ElementHash hh;
+	pBinaryImage p_bi = new BinaryImage;
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &hh, sizeof(hh));
+	save(p_bi, false);
 
-		StringUsage su;
+	for (uint64_t t = 0; t < part.size(); t++)
+		part[t].load(p_bi);
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &su.seen, sizeof(su.seen));
+	delete p_bi;
 
-		int ll;
+	std::vector<std::thread> worker;
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &ll, sizeof(ll));
-		ok = ok && (ll >= 0) && (ll < 8192);
+	for (uint64_t t = 0; t < num_ranges; t++)
+		worker.push_back(std::thread(scan_range, t == 0 ? this : &part[t - 1], p_buf + bound[t], p_buf + bound[t + 1]));
 
-		if (ll == 0)
-			su.str = (char *) "";
-		else {
-			if (!image_get(p_bi, c_block, c_ofs, &buffer, ll))
-				return false;
+	for (uint64_t t = 0; t < num_ranges; t++)
+		worker[t].join();
 
-			buffer[ll] = 0;
+	for (uint64_t t = 0; t < part.size(); t++)
+		merge(part[t]);
+}
 
-			su.str = buffer;
-		}
 
-		names_map[hh] = su;
-	}
+void Clips::begin_concurrent(int num_shards) {
 
-	section = "event";
+	end_ingestion();
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	if (frozen.is_frozen())
+		thaw();
 
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
-	ok = ok && (event.size() == 0);
+	events.freeze();	// event_code() only reads the object after this.
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+	int bits = 1;
 
-	for (int i = 0; ok && i < len; i++) {
-		BinEventPt ev;
+	while ((1 << bits) < num_shards && (1 << bits) < MAX_CLIP_SHARDS)
+		bits++;
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &ev, sizeof(ev));
+	shard_shift = 64 - bits;
 
-		EventStat es;
+	ClipShards(1 << bits).swap(shards);
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &es, sizeof(es));
+	for (ClipMap::iterator it = clips.begin(); it != clips.end(); ++it) {
+		ClipMap &shard_clips = shards[it->first >> shard_shift].clips;
 
-		event[ev] = es;
+		shard_clips.emplace_hint(shard_clips.end(), it->first, std::move(it->second));
 	}
 
-	section = "priority";
+	ClipMap().swap(clips);
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+	clip_index.clear();
+}
 
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
-	ok = ok && (priority.size() == 0);
 
+void Clips::end_concurrent() {
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+	if (shards.size() == 0)
+		return;
 
-	for (int i = 0; ok && i < len; i++) {
-		uint64_t hh;
+	for (ClipShards::iterator it_shard = shards.begin(); it_shard != shards.end(); ++it_shard) {
+		for (ClipMap::iterator it = it_shard->clips.begin(); it != it_shard->clips.end(); ++it)
+			clips.emplace_hint(clips.end(), it->first, std::move(it->second));
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &hh, sizeof(hh));
+		ClipMap().swap(it_shard->clips);
+	}
 
-		BinEventPt ev;
+	ClipShards().swap(shards);
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &ev, sizeof(ev));
+	shard_shift = 64;
+}
 
-		priority[hh] = ev;
-	}
 
-	section = "end";
+void Clips::begin_bulk(bool compress) {
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+	end_ingestion();
 
-	return ok;
+	bulk_mode	  = true;
+	bulk_compress = compress;
 }
 
 
-bool Events::save(pBinaryImage &p_bi) {
+void Clips::end_bulk() {
 
-	String section = "events";
-	ElementHash hs = MurmurHash64A(section.c_str(), section.length());
+	if (!bulk_mode)
+		return;
 
-	image_put(p_bi, &hs, sizeof(hs));
+	bulk_mode = false;
 
-	image_put(p_bi, &store_strings, sizeof(store_strings));
-	image_put(p_bi, &max_num_events, sizeof(max_num_events));
-	image_put(p_bi, &priority_low, sizeof(priority_low));
-	image_put(p_bi, &next_code, sizeof(next_code));
+	ClipEventChunks chunks = {};
 
-	section = "names_map";
-	hs		= MurmurHash64A(section.c_str(), section.length());
+	if (frozen.is_frozen() || clips.size() > 0) {
 
-	image_put(p_bi, &hs, sizeof(hs));
+		// The clips already in the object go first, so that the rows inserted in bulk mode replace their events at the same time.
+		// (The order of the events of a clip does not matter, since their times are all different.)
 
-	int len = names_map.size();
+		if (frozen.is_frozen()) {
+			for (uint64_t i = 0; i < frozen.size(); i++) {
+				ClipCursor cur;
+				TimePoint  time_pt;
+				uint64_t   code;
 
-	image_put(p_bi, &len, sizeof(len));
+				frozen.last_event(i, cur);
 
-	for (StringUsageMap::iterator it = names_map.begin(); it != names_map.end(); ++it) {
-		ElementHash hh = it->first;
-		image_put(p_bi, &hh, sizeof(hh));
-		uint64_t su_seen = it->second.seen;
+				while (frozen.prev_event(cur, time_pt, code))
+					push_bulk(chunks, ClipEvent {frozen.client[i], time_pt, code});
+			}
+			frozen.clear();
+		}
 
-		image_put(p_bi, &su_seen, sizeof(su_seen));
+		for (ClipMap::iterator it_clip = clips.begin(); it_clip != clips.end(); clips.erase(it_clip++))
+			for (Clip::iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it)
+				push_bulk(chunks, ClipEvent {it_clip->first, it->first, it->second});
 
-		int ll = it->second.str.length();
+		for (ClipEventChunks::iterator it = bulk_events.begin(); it != bulk_events.end(); ++it) {
+			chunks.push_back(ClipEvents());
+			chunks.back().swap(*it);
+		}
+		ClipEventChunks().swap(bulk_events);
 
-		image_put(p_bi, &ll, sizeof(ll));
-		image_put(p_bi, (void *) it->second.str.c_str(), ll);
-	}
+	} else
+		chunks.swap(bulk_events);
 
-	section = "event";
-	hs		= MurmurHash64A(section.c_str(), section.length());
+	clip_index.clear();
 
-	image_put(p_bi, &hs, sizeof(hs));
+	uint64_t n = 0;
 
-	len = event.size();
+	for (ClipEventChunks::iterator it = chunks.begin(); it != chunks.end(); ++it)
+		n += it->size();
 
-	image_put(p_bi, &len, sizeof(len));
+	uint64_t num_threads = std::min((uint64_t) std::max(std::thread::hardware_concurrency(), 1u), n/BULK_SORT_MIN_PER_THREAD + 1);
 
-	for (EventMap::iterator it = event.begin(); it != event.end(); ++it) {
-		BinEventPt ev = it->first;
-		image_put(p_bi, &ev, sizeof(ev));
-		EventStat es = it->second;
-		image_put(p_bi, &es, sizeof(es));
-	}
+	ClipEvents rows = {};
 
-	section = "priority";
-	hs		= MurmurHash64A(section.c_str(), section.length());
+	sort_bulk(chunks, rows, num_threads);
 
-	image_put(p_bi, &hs, sizeof(hs));
+	// Remove the replaced rows (keeping the last of each (client, time)) and apply the bounded history, in place.
 
-	len = priority.size();
+	uint64_t w = 0;
 
-	image_put(p_bi, &len, sizeof(len));
+	for (uint64_t i = 0; i < n;) {
+		ElementHash hash  = rows[i].client;
+		uint64_t	start = w;
 
-	for (PriorityMap::iterator it = priority.begin(); it != priority.end(); ++it) {
-		uint64_t hh = it->first;
-		image_put(p_bi, &hh, sizeof(hh));
-		BinEventPt ev = it->second;
-		image_put(p_bi, &ev, sizeof(ev));
-	}
+		for (; i < n && rows[i].client == hash; i++) {
+			if (i + 1 < n && rows[i + 1].client == hash && rows[i + 1].time == rows[i].time)
+				continue;
 
-	section = "end";
-	hs		= MurmurHash64A(section.c_str(), section.length());
+			rows[w++] = rows[i];
+		}
 
-	image_put(p_bi, &hs, sizeof(hs));
+		uint64_t first = start;
 
-	return true;
-}
+		if (history_seconds > 0)
+			while (rows[first].time < rows[w - 1].time - history_seconds)
+				first++;
 
-// -----------------------------------------------------------------------------------------------------------------------------------------
-//	Clients Implementation
-// -----------------------------------------------------------------------------------------------------------------------------------------
+		if (history_length > 0 && w - first > history_length)
+			first = w - history_length;
 
-void Clients::add_client_id(pChar p_cli) {
+		if (first > start) {
+			std::copy(rows.begin() + first, rows.begin() + w, rows.begin() + start);
 
-	ElementHash hash = hash_client_id(p_cli);
+			w -= first - start;
+		}
+	}
 
-	id.push_back(hash);
-	id_set.insert(hash);
+	frozen.build(rows.data(), w, bulk_compress, &events.id_codes());
 }
 
 
-bool Clients::load(pBinaryImage &p_bi) {
-	int c_block = 0, c_ofs = 0;
+void Clips::sort_bulk(ClipEventChunks &chunks, ClipEvents &rows, uint64_t num_threads) {
 
-	return load(p_bi, c_block, c_ofs);
-}
+	uint64_t n = 0;
 
+	for (ClipEventChunks::iterator it = chunks.begin(); it != chunks.end(); ++it)
+		n += it->size();
 
-bool Clients::load(pBinaryImage &p_bi, int &c_block, int &c_ofs) {
+	ClipEvents().swap(rows);
 
-	String		section = "clients";
-	ElementHash hs;
+	if (n == 0) {
+		ClipEventChunks().swap(chunks);
 
-	bool ok = image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
+		return;
+	}
 
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
-	ok = ok && (id.size() == 0);
-	ok = ok && (id_set.size() == 0);
+	// A stable radix partition by the top bits of the client hash into rows, in partitions of (typically) less than 64K rows.
 
-	int len;
+	int bits = 1;
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &len, sizeof(len));
+	while ((n >> bits) > 65536 && bits < 16)
+		bits++;
 
-	for (int i = 0; ok && i < len; i++) {
-		ElementHash hh;
+	int		 shift		 = 64 - bits;
+	uint64_t num_parts	 = 1ull << bits;
+	uint64_t num_readers = std::min(num_threads, (uint64_t) chunks.size());	// Each one reads consecutive chunks
+	uint64_t step		 = (chunks.size() + num_readers - 1)/num_readers;
 
-		ok = ok && image_get(p_bi, c_block, c_ofs, &hh, sizeof(hh));
+	std::vector<uint64_t> count(num_readers*num_parts, 0);
 
-		id.push_back(hh);
-		id_set.insert(hh);
-	}
+	auto run_threads = [](uint64_t num_workers, std::function<void(uint64_t)> work) {
+		if (num_workers == 1) {
+			work(0);
 
-	section = "end";
+			return;
+		}
 
-	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+		std::vector<std::thread> worker;
 
-	return ok;
-}
+		for (uint64_t t = 0; t < num_workers; t++)
+			worker.push_back(std::thread(work, t));
 
+		for (uint64_t t = 0; t < num_workers; t++)
+			worker[t].join();
+	};
 
-bool Clients::save(pBinaryImage &p_bi) {
+	run_threads(num_readers, [&](uint64_t t) {
+		uint64_t *p_count = &count[t*num_parts];
 
-	String section = "clients";
-	ElementHash hs = MurmurHash64A(section.c_str(), section.length());
+		for (uint64_t c = t*step; c < std::min((uint64_t) chunks.size(), (t + 1)*step); c++)
+			for (ClipEvents::iterator it = chunks[c].begin(); it != chunks[c].end(); ++it)
+				p_count[it->client >> shift]++;
+	});
 
-	image_put(p_bi, &hs, sizeof(hs));
+	std::vector<uint64_t> part_start(num_parts + 1);
 
-	int len = id.size();
+	uint64_t sum = 0;
 
-	image_put(p_bi, &len, sizeof(len));
+	for (uint64_t p = 0; p < num_parts; p++) {
+		part_start[p] = sum;
 
-	for (int i = 0; i < len; i++) {
-		ElementHash hh = id[i];
-		image_put(p_bi, &hh, sizeof(hh));
+		for (uint64_t t = 0; t < num_readers; t++) {
+			uint64_t c = count[t*num_parts + p];
+
+			count[t*num_parts + p] = sum;
+
+			sum += c;
+		}
 	}
+	part_start[num_parts] = n;
 
-	section = "end";
-	hs		= MurmurHash64A(section.c_str(), section.length());
+	rows.resize(n);
 
-	image_put(p_bi, &hs, sizeof(hs));
+	run_threads(num_readers, [&](uint64_t t) {
+		uint64_t *p_count = &count[t*num_parts];
 
-	return true;
+		for (uint64_t c = t*step; c < std::min((uint64_t) chunks.size(), (t + 1)*step); c++)
+			for (ClipEvents::iterator it = chunks[c].begin(); it != chunks[c].end(); ++it)
+				rows[p_count[it->client >> shift]++] = *it;
+	});
+
+	ClipEventChunks().swap(chunks);
+
+	// The partitions are sorted by (client, time), each thread taking one of every num_threads.
+
+	run_threads(num_threads, [&](uint64_t t) {
+		for (uint64_t p = t; p < num_parts; p += num_threads)
+			std::stable_sort(rows.begin() + part_start[p], rows.begin() + part_start[p + 1], [](const ClipEvent &a, const ClipEvent &b) {
+				return a.client < b.client || (a.client == b.client && a.time < b.time);
+			});
+	});
 }
 
-// -----------------------------------------------------------------------------------------------------------------------------------------
-//	Clips Implementation
-// -----------------------------------------------------------------------------------------------------------------------------------------
 
 bool Clips::scan_event(pChar p_e, pChar p_d, double w, pChar p_c, pChar p_t) {
 
@@ -883,20 +3095,17 @@ bool Clips::scan_event(pChar p_e, pChar p_d, double w, pChar p_c, pChar p_t) {
 	if (ll == 0)
 		return false;
 
-	ElementHash client_hash = MurmurHash64A(p_c, ll);
+	ElementHash client_hash = hash_block(clients.hash_function, p_c, ll);
 
-	if (clients.id_set.size() > 0) {
-		ClientIDSet::iterator it = clients.id_set.find(client_hash);
-		if (it == clients.id_set.end())
-			return false;						// clients.id_set is not empty and the client is not in it.
-	}
+	if (clients.id_set.size() > 0 && !(client_filter.may_contain(client_hash) && clients.contains(client_hash)))
+		return false;							// clients.id_set is not empty and the client is not in it.
 
 	// Is it an event that should be tracked?
 
 	BinEventPt ept;
 
-	ept.e = events.add_str(p_e);
-	ept.d = events.add_str(p_d);
+	ept.e = events.hash_str(p_e);
+	ept.d = events.hash_str(p_d);
 	ept.w = w;
 
 	uint64_t code = events.event_code(ept);
@@ -906,7 +3115,9 @@ bool Clips::scan_event(pChar p_e, pChar p_d, double w, pChar p_c, pChar p_t) {
 
 	// Is the timestamp valid?
 
-	TimePoint time_pt = get_time(p_t);
+	static thread_local DayCache thread_day_cache = {};
+
+	TimePoint time_pt = shards.size() > 0 ? get_time(p_t, thread_day_cache) : get_time(p_t);
 
 	if (time_pt < 0)
 		return false;	// Times before the epoch are not supported, format error returns -1.
@@ -921,6 +3132,8 @@ bool Clips::scan_event(pChar p_e, pChar p_d, double w, pChar p_c, pChar p_t) {
 
 bool Clips::load(pBinaryImage &p_bi) {
 
+	end_ingestion();
+
 	int c_block = 0, c_ofs = 0;
 
 	String		section = "clips";
@@ -929,9 +3142,18 @@ bool Clips::load(pBinaryImage &p_bi) {
 	bool ok = image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
 	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
 	ok = ok && image_get(p_bi, c_block, c_ofs, &time_format, sizeof(time_format));
+
+	detect_time_layout();
+
 	ok = ok && clients.load(p_bi, c_block, c_ofs);
 	ok = ok && events.load(p_bi, c_block, c_ofs);
 
+	if (ok) {
+		events.freeze();
+
+		set_client_filter(use_client_filter);
+	}
+
 	section = "clip_map";
 
 	ok = ok && image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
@@ -976,7 +3198,9 @@ bool Clips::load(pBinaryImage &p_bi) {
 }
 
 
-bool Clips::save(pBinaryImage &p_bi) {
+bool Clips::save(pBinaryImage &p_bi, bool with_clips) {
+
+	end_ingestion();
 
 	String section = "clips";
 	ElementHash hs = MurmurHash64A(section.c_str(), section.length());
@@ -996,23 +3220,33 @@ bool Clips::save(pBinaryImage &p_bi) {
 
 	image_put(p_bi, &hs, sizeof(hs));
 
-	int len_clips = clips.size();
+	if (!with_clips) {
+		int len_clips = 0;
 
-	image_put(p_bi, &len_clips, sizeof(len_clips));
+		image_put(p_bi, &len_clips, sizeof(len_clips));
 
-	for (ClipMap::iterator it_clip = clips.begin(); it_clip != clips.end(); ++it_clip) {
-		ElementHash hh = it_clip->first;
-		image_put(p_bi, &hh, sizeof(hh));
+	} else if (frozen.is_frozen())
+		frozen.save_clips(p_bi);
 
-		int len = it_clip->second.size();
-		image_put(p_bi, &len, sizeof(len));
+	else {
+		int len_clips = clips.size();
 
-		for (Clip::iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it) {
-			TimePoint tp = it->first;
-			image_put(p_bi, &tp, sizeof(tp));
+		image_put(p_bi, &len_clips, sizeof(len_clips));
 
-			uint64_t ev = it->second;
-			image_put(p_bi, &ev, sizeof(ev));
+		for (ClipMap::iterator it_clip = clips.begin(); it_clip != clips.end(); ++it_clip) {
+			ElementHash hh = it_clip->first;
+			image_put(p_bi, &hh, sizeof(hh));
+
+			int len = it_clip->second.size();
+			image_put(p_bi, &len, sizeof(len));
+
+			for (Clip::iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it) {
+				TimePoint tp = it->first;
+				image_put(p_bi, &tp, sizeof(tp));
+
+				uint64_t ev = it->second;
+				image_put(p_bi, &ev, sizeof(ev));
+			}
 		}
 	}
 
@@ -1024,10 +3258,135 @@ bool Clips::save(pBinaryImage &p_bi) {
 	return true;
 }
 
+
+bool Clips::merge(Clips &other) {
+
+	if (&other == this || clients.hash_function != other.clients.hash_function)
+		return false;
+
+	other.end_ingestion();
+
+	pClipMap p_clips = clip_map();
+
+	if (other.frozen.is_frozen()) {
+		for (uint64_t i = 0; i < other.frozen.size(); i++) {
+			Clip &clip = (*p_clips)[other.frozen.client[i]];
+
+			Clip other_clip = other.frozen.clip(i);
+
+			for (Clip::iterator it = other_clip.begin(); it != other_clip.end(); ++it)
+				clip[it->first] = it->second;
+
+			if (history_length > 0 || history_seconds > 0)
+				trim_clip(clip);
+		}
+
+		return true;
+	}
+
+	for (ClipMap::iterator it_clip = other.clips.begin(); it_clip != other.clips.end(); ++it_clip) {
+		ClipMap::iterator jt = p_clips->lower_bound(it_clip->first);
+
+		if (jt == p_clips->end() || jt->first != it_clip->first)
+			jt = p_clips->emplace_hint(jt, it_clip->first, it_clip->second);
+		else {
+			for (Clip::iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it)
+				jt->second[it->first] = it->second;
+		}
+
+		if (history_length > 0 || history_seconds > 0)
+			trim_clip(jt->second);
+	}
+
+	return true;
+}
+
+
+void Clips::export_columns(ClipColumns &cols) {
+
+	end_ingestion();
+
+	if (frozen.is_frozen()) {
+		uint64_t n_clips = frozen.size(), n_events = frozen.offset[n_clips];
+
+		memcpy(cols.client, frozen.client.data(), n_clips*sizeof(ElementHash));
+		memcpy(cols.offset, frozen.offset.data(), (n_clips + 1)*sizeof(uint64_t));
+
+		if (!frozen.compressed) {
+			memcpy(cols.time, frozen.time.data(), n_events*sizeof(TimePoint));
+			memcpy(cols.code, frozen.code.data(), n_events*sizeof(uint64_t));
+
+			return;
+		}
+
+		for (uint64_t i = 0; i < n_clips; i++) {
+			ClipCursor cur;
+			TimePoint  time_pt;
+			uint64_t   code;
+
+			frozen.last_event(i, cur);
+
+			for (uint64_t j = frozen.offset[i + 1]; frozen.prev_event(cur, time_pt, code);) {
+				cols.time[--j] = time_pt;
+				cols.code[j]   = code;
+			}
+		}
+
+		return;
+	}
+
+	uint64_t i = 0, j = 0;
+
+	for (ClipMap::iterator it_clip = clips.begin(); it_clip != clips.end(); ++it_clip) {
+		cols.client[i]	 = it_clip->first;
+		cols.offset[i++] = j;
+
+		for (Clip::iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it) {
+			cols.time[j]   = it->first;
+			cols.code[j++] = it->second;
+		}
+	}
+	cols.offset[i] = j;
+}
+
 // -----------------------------------------------------------------------------------------------------------------------------------------
 //	Targets Implementation
 // -----------------------------------------------------------------------------------------------------------------------------------------
 
+void CodeIdMap::clear() {
+	slot.clear();
+	code_of.clear();
+
+	shift = 64;
+}
+
+
+void CodeIdMap::resize(uint64_t n) {
+	uint64_t size = 64;
+	int		 bits = 6;
+
+	while (size < n) {
+		size <<= 1;
+		bits++;
+	}
+
+	slot.clear();
+	slot.resize(size, 0);
+	shift = 64 - bits;
+
+	uint64_t mask = size - 1;
+
+	for (uint64_t id = 0; id < code_of.size(); id++) {
+		uint64_t i = slot_of(code_of[id]);
+
+		while (slot[i] != 0)
+			i = (i + 1) & mask;
+
+		slot[i] = id + 1;
+	}
+}
+
+
 bool Targets::insert_target(pChar p_c, pChar p_t) {
 
 	int ll = strlen(p_c);
@@ -1040,7 +3399,7 @@ bool Targets::insert_target(pChar p_c, pChar p_t) {
 	if (time_pt < 0)
 		return false;	// Times before the epoch are not supported, format error returns -1.
 
-	ElementHash client_hash = MurmurHash64A(p_c, ll);
+	ElementHash client_hash = hash_block(hash_function, p_c, ll);
 
 	if (target.find(client_hash) != target.end())
 		return false;
@@ -1077,14 +3436,7 @@ bool Targets::fit(Transform x_form, Aggregate agg, double p, int depth, bool as_
 
 	tree_depth = std::max(1, std::min(MAX_SEQ_LEN_IN_PREDICT, depth));
 
-	pClipMap p_clip_map = p_clips;
-	Clips state_clips;
-
-	if (as_states) {
-		state_clips = Clips(*p_clip_map);
-		state_clips.collapse_to_states();
-		p_clip_map = state_clips.clip_map();
-	}
+	pFrozenClips p_frozen_map = use_frozen() ? p_frozen : nullptr;
 
 	ClipMap   clm	= {};
 	TargetMap tm	= {};
@@ -1109,34 +3461,81 @@ bool Targets::fit(Transform x_form, Aggregate agg, double p, int depth, bool as_
 
 	// Fill the tree
 
-	for (ClipMap::iterator it_client = p_clip_map->begin(); it_client != p_clip_map->end(); ++it_client) {
+	if (p_frozen_map != nullptr) {
+
+		// In the compressed layout, the events are read as indices in the code_dict (the Events ids of the clips) mapped to tree ids
+		// through an array, filled the first time each index is seen (so the ids are given in the same order as by code).
+		bool by_index = p_frozen_map->compressed;
+
+		std::vector<uint32_t> index_id(by_index ? p_frozen_map->code_dict.size() : 0, 0xffffffff);
+
+		for (uint64_t i = 0; i < p_frozen_map->size(); i++) {
+
+			// Find the client in TargetMap
+			TargetMap::iterator it_target = target.find(p_frozen_map->client[i]);
+
+			TimePoint target_time = it_target == target.end() ? 0 : it_target->second;
+			ExtFloat time_d = 0;
+			int n = 0, parent_idx = 0;
+
+			ClipCursor cur;
+			TimePoint  time_pt;
+			uint64_t   code;
+
+			if (window_to == INT64_MAX)
+				p_frozen_map->last_event(i, cur);
+			else
+				p_frozen_map->last_event_before(i, window_to, cur);
+
+			// As states, the runs of the same code are walked as one event at the time of the first (without collapsing a copy).
+			while (as_states ? p_frozen_map->prev_state(cur, time_pt, code, window_from, by_index)
+							 : p_frozen_map->prev_event(cur, time_pt, code, by_index)) {
+				if (time_pt < window_from)
+					break;
+
+				uint32_t id;
+
+				if (by_index) {
+					if (index_id[code] == 0xffffffff)
+						index_id[code] = fit_id(p_frozen_map->code_dict[code]);
+
+					id = index_id[code];
+				} else
+					id = fit_id(code);
+
+				if (!fit_event(target_time, time_pt, id, n, parent_idx, time_d))
+					break;
+			}
+		}
+
+		return true;
+	}
+
+	for (ClipMap::iterator it_client = p_clips->begin(); it_client != p_clips->end(); ++it_client) {
 
 		// Find the client in TargetMap
 		TargetMap::iterator it_target = target.find(it_client->first);
 
 		TimePoint target_time = it_target == target.end() ? 0 : it_target->second;
-		ExtFloat time_d;
+		ExtFloat time_d = 0;
 		int n = 0, parent_idx = 0;
 
-		for (Clip::reverse_iterator it_point = it_client->second.rbegin(); it_point != it_client->second.rend(); it_point++) {
-			if (target_time == 0) {
-				parent_idx = update_node(parent_idx, it_point->second, false, 0);
+		Clip &clip = it_client->second;
 
-				if (++n == tree_depth)
-					break;
+		Clip::reverse_iterator it_point(window_to == INT64_MAX ? clip.end() : clip.lower_bound(window_to));
 
-			} else {
-				TimePoint elapsed_sec = target_time - it_point->first;
-				if (elapsed_sec > 0) {
-					if (n == 0)
-						time_d = transform == tr_linear ? elapsed_sec : log(elapsed_sec);
+		while (it_point != clip.rend() && it_point->first >= window_from) {
+			TimePoint time_pt = it_point->first;
+			uint32_t  id	  = fit_id(it_point->second);
 
-					parent_idx = update_node(parent_idx, it_point->second, true, time_d);
+			if (as_states) {
+				while (++it_point != clip.rend() && it_point->first >= window_from && fit_id(it_point->second) == id)
+					time_pt = it_point->first;
+			} else
+				++it_point;
 
-					if (++n == tree_depth)
-						break;
-				}
-			}
+			if (!fit_event(target_time, time_pt, id, n, parent_idx, time_d))
+				break;
 		}
 	}
 
@@ -1146,17 +3545,9 @@ bool Targets::fit(Transform x_form, Aggregate agg, double p, int depth, bool as_
 
 TimesToTarget Targets::predict() {
 
-	TimesToTarget ret = {};
-
-	if (tree.size() > 1 && tree[0].n_seen > 0) {
-		for (ClipMap::iterator it = p_clips->begin(); it != p_clips->end(); ++it) {
-			double t = predict_clip(it->second);
-
-			ret.push_back(t);
-		}
-	}
+	ClipsView view = {p_clips, p_frozen, window_from, window_to};
 
-	return ret;
+	return predict(view);
 }
 
 
@@ -1167,10 +3558,20 @@ TimesToTarget Targets::predict(Clients clients) {
 	if (tree.size() > 1 && tree[0].n_seen > 0) {
 		double t_not_found = predict_time(tree[0]);
 
+		if (use_frozen()) {
+			for (int i = 0; i < (int) clients.id.size(); i++) {
+				int64_t ix = p_frozen->find(clients.id[i]);
+
+				ret.push_back(ix < 0 ? t_not_found : predict_clip(*p_frozen, ix, window_from, window_to));
+			}
+
+			return ret;
+		}
+
 		for (int i = 0; i < (int) clients.id.size(); i++) {
 			ClipMap::iterator it = p_clips->find(clients.id[i]);
 
-			double t = it == p_clips->end() ? t_not_found : predict_clip(it->second);
+			double t = it == p_clips->end() ? t_not_found : predict_clip(it->second, window_from, window_to);
 
 			ret.push_back(t);
 		}
@@ -1180,13 +3581,13 @@ TimesToTarget Targets::predict(Clients clients) {
 }
 
 
-TimesToTarget Targets::predict(pClipMap p_clips) {
+TimesToTarget Targets::predict(pClipMap p_clips, bool as_states) {
 
 	TimesToTarget ret = {};
 
 	if (tree.size() > 1 && tree[0].n_seen > 0) {
 		for (ClipMap::iterator it = p_clips->begin(); it != p_clips->end(); ++it) {
-			double t = predict_clip(it->second);
+			double t = predict_clip(it->second, window_from, window_to, as_states);
 
 			ret.push_back(t);
 		}
@@ -1196,6 +3597,43 @@ TimesToTarget Targets::predict(pClipMap p_clips) {
 }
 
 
+TimesToTarget Targets::predict(pFrozenClips p_frozen) {
+
+	TimesToTarget ret = {};
+
+	if (tree.size() > 1 && tree[0].n_seen > 0) {
+		ret.reserve(p_frozen->size());
+
+		for (uint64_t i = 0; i < p_frozen->size(); i++)
+			ret.push_back(predict_clip(*p_frozen, i, window_from, window_to));
+	}
+
+	return ret;
+}
+
+
+TimesToTarget Targets::predict(const ClipsView &view) {
+
+	TimesToTarget ret = {};
+
+	if (tree.size() > 1 && tree[0].n_seen > 0) {
+		if (view.p_frozen != nullptr && view.p_frozen->is_frozen()) {
+			ret.reserve(view.p_frozen->size());
+
+			for (uint64_t i = 0; i < view.p_frozen->size(); i++)
+				ret.push_back(predict_clip(*view.p_frozen, i, view.from, view.to));
+
+			return ret;
+		}
+
+		for (ClipMap::iterator it = view.p_clips->begin(); it != view.p_clips->end(); ++it)
+			ret.push_back(predict_clip(it->second, view.from, view.to));
+	}
+
+	return ret;
+}
+
+
 void Targets::verbose_predict_clip(const ElementHash &client,
 								   Clip				 &clip,
 								   TimePoint		 &obs_time,
@@ -1227,13 +3665,13 @@ void Targets::verbose_predict_clip(const ElementHash &client,
 				obs_time = t;
 		}
 
-		ChildIndex::iterator it = tree[idx].child.find(it_point->second);
+		int idx_child = child_of(idx, tree_id(it_point->second));
 
-		if (it == tree[idx].child.end())
+		if (idx_child < 0)
 			break;
 
 		++longest_seq;
-		idx = it->second;
+		idx = idx_child;
 	}
 
 	n_visits	= tree[idx].n_seen;
@@ -1244,7 +3682,7 @@ void Targets::verbose_predict_clip(const ElementHash &client,
 }
 
 
-bool Targets::recurse_tree_stats(int depth, int idx, int parent_idx, uint64_t code, CodeInTreeStatMap &codes_stat) {
+bool Targets::recurse_tree_stats(int depth, int idx, int parent_idx, uint32_t id, CodeInTreeStats &codes_stat) {
 
 	int ts = tree.size();
 
@@ -1252,7 +3690,7 @@ bool Targets::recurse_tree_stats(int depth, int idx, int parent_idx, uint64_t co
 		return false;
 
 	if (parent_idx >= 0 && parent_idx < ts) {
-		CodeInTreeStatistics *p_stat = &codes_stat[code];
+		CodeInTreeStatistics *p_stat = &codes_stat[id];
 		pCodeTreeNode		  p_incl = &tree[idx];
 		pCodeTreeNode		  p_succ = &tree[parent_idx];
 
@@ -1265,13 +3703,26 @@ bool Targets::recurse_tree_stats(int depth, int idx, int parent_idx, uint64_t co
 	}
 
 	for (ChildIndex::iterator it = tree[idx].child.begin(); it != tree[idx].child.end(); ++it)
-		if (!recurse_tree_stats(depth + 1, it->second, idx, it->first, codes_stat))
+		if (!recurse_tree_stats(depth + 1, it->idx, idx, it->id, codes_stat))
 			return false;
 
 	return true;
 }
 
 
+CodeDict Targets::child_codes(int idx) {
+
+	CodeDict ret = {};
+
+	for (ChildIndex::iterator it = tree[idx].child.begin(); it != tree[idx].child.end(); ++it)
+		ret.push_back(code_id.code(it->id));
+
+	std::sort(ret.begin(), ret.end());
+
+	return ret;
+}
+
+
 bool Targets::load(pBinaryImage &p_bi) {
 
 	int c_block = 0, c_ofs = 0;
@@ -1281,10 +3732,12 @@ bool Targets::load(pBinaryImage &p_bi) {
 
 	bool ok = image_get(p_bi, c_block, c_ofs, &hs, sizeof(hs));
 
-	ok = ok && (hs == MurmurHash64A(section.c_str(), section.length()));
+	ok = ok && find_hashed_section(hs, section.c_str(), hash_function);
 
 	ok = ok && image_get(p_bi, c_block, c_ofs, &time_format, sizeof(time_format));
 
+	detect_time_layout();
+
 	ok = ok && image_get(p_bi, c_block, c_ofs, &transform, sizeof(transform));
 
 	ok = ok && image_get(p_bi, c_block, c_ofs, &aggregate, sizeof(aggregate));
@@ -1307,7 +3760,8 @@ bool Targets::load(pBinaryImage &p_bi) {
 
 	ok = ok && image_get(p_bi, c_block, c_ofs, &len_clips, sizeof(len_clips));
 
-	p_clips = new ClipMap;
+	p_clips  = new ClipMap;
+	p_frozen = nullptr;
 
 	for (int i = 0; ok && i < len_clips; i++) {
 		ElementHash hh;
@@ -1390,8 +3844,9 @@ bool Targets::load(pBinaryImage &p_bi) {
 
 			ok = ok && image_get(p_bi, c_block, c_ofs, &idx, sizeof(idx));
 
-			nd.child[key] = idx;
+			nd.child.push_back(ChildLink {code_id.insert(key), idx});
 		}
+		std::sort(nd.child.begin(), nd.child.end());
 
 		if (i == 0)
 			tree[0] = nd;
@@ -1410,7 +3865,7 @@ bool Targets::load(pBinaryImage &p_bi) {
 
 bool Targets::save(pBinaryImage &p_bi) {
 
-	String section = "targets";
+	String section = hashed_section("targets", hash_function);
 	ElementHash hs = MurmurHash64A(section.c_str(), section.length());
 
 	image_put(p_bi, &hs, sizeof(hs));
@@ -1428,23 +3883,47 @@ bool Targets::save(pBinaryImage &p_bi) {
 
 	image_put(p_bi, &hs, sizeof(hs));
 
-	int len_clips = p_clips->size();
+	pClipMap p_save_clips = p_clips;
+	ClipMap	 window		  = {};
 
-	image_put(p_bi, &len_clips, sizeof(len_clips));
+	if (window_from != INT64_MIN || window_to != INT64_MAX) {
 
-	for (ClipMap::iterator it_clip = p_clips->begin(); it_clip != p_clips->end(); ++it_clip) {
-		ElementHash hh = it_clip->first;
-		image_put(p_bi, &hh, sizeof(hh));
+		// Only the events in the window are saved, so that the loaded object predicts the same.
+		for (uint64_t i = 0, n = use_frozen() ? p_frozen->size() : 0; i < n; i++) {
+			Clip clip = p_frozen->clip(i);
 
-		int len = it_clip->second.size();
-		image_put(p_bi, &len, sizeof(len));
+			window_clip(p_frozen->client[i], clip, window);
+		}
 
-		for (Clip::iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it) {
-			TimePoint tp = it->first;
-			image_put(p_bi, &tp, sizeof(tp));
+		if (!use_frozen())
+			for (ClipMap::iterator it_clip = p_clips->begin(); it_clip != p_clips->end(); ++it_clip)
+				window_clip(it_clip->first, it_clip->second, window);
 
-			uint64_t ev = it->second;
-			image_put(p_bi, &ev, sizeof(ev));
+		p_save_clips = &window;
+	}
+
+	if (use_frozen() && p_save_clips == p_clips)
+		p_frozen->save_clips(p_bi);
+
+	else {
+		int len_clips = p_save_clips->size();
+
+		image_put(p_bi, &len_clips, sizeof(len_clips));
+
+		for (ClipMap::iterator it_clip = p_save_clips->begin(); it_clip != p_save_clips->end(); ++it_clip) {
+			ElementHash hh = it_clip->first;
+			image_put(p_bi, &hh, sizeof(hh));
+
+			int len = it_clip->second.size();
+			image_put(p_bi, &len, sizeof(len));
+
+			for (Clip::iterator it = it_clip->second.begin(); it != it_clip->second.end(); ++it) {
+				TimePoint tp = it->first;
+				image_put(p_bi, &tp, sizeof(tp));
+
+				uint64_t ev = it->second;
+				image_put(p_bi, &ev, sizeof(ev));
+			}
 		}
 	}
 
@@ -1483,10 +3962,12 @@ bool Targets::save(pBinaryImage &p_bi) {
 		int ll = pn->child.size();
 		image_put(p_bi, &ll, sizeof(ll));
 
-		for (ChildIndex::iterator it = pn->child.begin(); it != pn->child.end(); ++it) {
-			uint64_t key = it->first;
+		CodeDict code = child_codes(i);		// The image stores the children by code.
+
+		for (int j = 0; j < ll; j++) {
+			uint64_t key = code[j];
 			image_put(p_bi, &key, sizeof(key));
-			int idx =  it->second;
+			int idx = child_of(i, code_id.find(key));
 			image_put(p_bi, &idx, sizeof(idx));
 		}
 	}
@@ -1694,6 +4175,29 @@ bool events_insert_row(int id, char *p_e, char *p_d, double w) {
 }
 
 
+/** \brief Process a pre-aggregated row (the same event seen n times) in an Events object stored by the EventsServer.
+
+	\param id	The id returned by a previous new_events() call.
+	\param p_e	The "emitter". A C/Python string representing "owner of event".
+	\param p_d	The "description". A C/Python string representing "the event".
+	\param w	The "weight". A double representing a weight of the event.
+	\param n	The number of times the event was seen.
+
+	\return	 True on success. (It fails on a negative n.)
+*/
+bool events_insert_row_count(int id, char *p_e, char *p_d, double w, int n) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end() || n < 0)
+		return false;
+
+	it->second->insert_row_count(p_e, p_d, w, n);
+
+	return true;
+}
+
+
 /** \brief Define events explicitly in an Events object stored by the EventsServer.
 
 	\param id	The id returned by a previous new_events() call.
@@ -1728,9 +4232,9 @@ bool events_define_event(int id, char *p_e, char *p_d, double w, int code) {
 	The algorithm builds a list of most promising (not already used) codes at the beginning of each step by full tree search.
 	From that list, each code is tried downwards as {noise, new_code, last_code} for score improvement above threshold
 	up to codes_per_step steps. And assigned a new code accordingly.
-	The codes assigned become part of the internal EventCodeMap and in the next step they will replace their old values.
+	The codes assigned become part of the internal dictionary and in the next step they will replace their old values.
 
-	When the algorithm finishes, the internal EventCodeMap is used to rename the object codes and the whole process is reported.
+	When the algorithm finishes, the internal dictionary is used to rename the object codes and the whole process is reported.
 
 	\param id				The id returned by a previous new_events() call. The object must be empty (never called).
 	\param id_clips			The id of a clips object with the same codes and clips for a set of clients whose prediction we optimize.
@@ -1916,7 +4420,39 @@ int events_save(int id) {
 }
 
 
-bool parse_bin_event_pt(char *line, BinEventPt &ev) {
+/** \brief Saves an Events object without its events as a BinaryImage.
+
+	The image loads as an empty Events object with the same settings. It is used to seed the partial Events objects of the workers of
+	a parallel insert_rows().
+
+	\param id  The id returned by a previous new_events() call.
+
+	\return	 0 on error, or a binary_image_id > 0 which is the same as id and must be destroyed using destroy_binary_image_iterator()
+*/
+int events_save_empty(int id) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return 0;
+
+	pBinaryImage p_bi = new BinaryImage;
+
+	if (!it->second->save(p_bi, false)) {
+		delete p_bi;
+
+		return 0;
+	}
+
+	destroy_binary_image_iterator(id);
+
+	image[id] = p_bi;
+
+	return id;
+}
+
+
+bool parse_bin_event_pt(char *line, BinEventPt &ev, HashFunction hash_fn) {
 
 	char *pt = strchr(line, '\t');
 
@@ -1926,7 +4462,7 @@ bool parse_bin_event_pt(char *line, BinEventPt &ev) {
 	uint64_t l = (uint64_t) pt - (uint64_t) line;
 
 	if (line[0] != '<' || l != 18 || sscanf(line, "<%016lx>\t", &ev.e) != 1)
-		ev.e = MurmurHash64A(line, l);
+		ev.e = hash_block(hash_fn, line, l);
 
 	char *pt2 = strchr(++pt, '\t');
 
@@ -1936,7 +4472,7 @@ bool parse_bin_event_pt(char *line, BinEventPt &ev) {
 	l = (uint64_t) pt2 - (uint64_t) pt;
 
 	if (pt[0] != '<' || l != 18 || sscanf(pt, "<%016lx>\t", &ev.d) != 1)
-		ev.d = MurmurHash64A(pt, l);
+		ev.d = hash_block(hash_fn, pt, l);
 
 	char *pt3 = strchr(++pt2, '\t');
 
@@ -1972,7 +4508,7 @@ char *events_describe_next_event(int id, char *prev_event) {
 
 	if (ll == 0)
 		it_ev = it->second->events_begin();
-	else if (parse_bin_event_pt(prev_event, ev)) it_ev = it->second->events_next_after_find(ev);
+	else if (parse_bin_event_pt(prev_event, ev, it->second->hash_function)) it_ev = it->second->events_next_after_find(ev);
 
 	if (it_ev != it_ev_end) {
 		double round_w = round(WEIGHT_PRECISION*it_ev->first.w)/WEIGHT_PRECISION;
@@ -1988,6 +4524,49 @@ char *events_describe_next_event(int id, char *prev_event) {
 }
 
 
+/** \brief Exports all the events of an Events object stored by the EventsServer in a single call.
+
+	\param id	The id returned by a previous new_events() call.
+	\param raw	Returns the bytes of: the number of events n (uint64), the columns e, d (uint64[n]), w (double[n]), seen, code,
+				priority (uint64[n]), the columns emitter, description (uint32[n]) as indices into the list of distinct strings and
+				finally that list, each string terminated by a zero. (All in native byte order.)
+
+	\return	True on success.
+
+	The Python API wraps this as events_export() returning the bytes, so NumPy can map the columns without copying them.
+*/
+bool events_export_columns(int id, String &raw) {
+
+	raw.clear();
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	EventColumns cols;
+
+	it->second->export_columns(cols);
+
+	uint64_t n = cols.e.size();
+
+	raw.append((const char *) &n, sizeof(n));
+	raw.append((const char *) cols.e.data(), n*sizeof(ElementHash));
+	raw.append((const char *) cols.d.data(), n*sizeof(ElementHash));
+	raw.append((const char *) cols.w.data(), n*sizeof(double));
+	raw.append((const char *) cols.seen.data(), n*sizeof(uint64_t));
+	raw.append((const char *) cols.code.data(), n*sizeof(uint64_t));
+	raw.append((const char *) cols.priority.data(), n*sizeof(uint64_t));
+	raw.append((const char *) cols.emitter.data(), n*sizeof(uint32_t));
+	raw.append((const char *) cols.description.data(), n*sizeof(uint32_t));
+
+	for (std::vector<String>::iterator jt = cols.strings.begin(); jt != cols.strings.end(); ++jt)
+		raw.append(jt->c_str(), jt->length() + 1);
+
+	return true;
+}
+
+
 /** \brief Sets the public property max_num_events in an Events object stored by the EventsServer.
 
 	\param id		  The id returned by a previous new_events() call.
@@ -2013,18 +4592,189 @@ bool events_set_max_num_events(int id, int max_events) {
 	\param id	 The id returned by a previous new_events() call.
 	\param store True for storing the string contents.
 
-	\return	 True on success.
+	\return	 True on success.
+*/
+bool events_set_store_strings(int id, bool store) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	it->second->set_store_strings(store);
+
+	return true;
+}
+
+
+/** \brief Combine the discovery state of another Events object into an Events object stored by the EventsServer.
+
+	\param id		 The id returned by a previous new_events() call.
+	\param id_other The id of another Events object populated over a disjoint slice of the same transactions.
+
+	\return	 True on success.
+*/
+bool events_merge(int id, int id_other) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	EventsServer::iterator it_other = events.find(id_other);
+
+	if (it_other == events.end() || it_other == it)
+		return false;
+
+	return it->second->merge(*it_other->second);
+}
+
+
+/** \brief Set up (or remove) the Count-Min sketch admission filter of an Events object stored by the EventsServer.
+
+	\param id		The id returned by a previous new_events() call.
+	\param width	The number of counters per row of the sketch (0 removes the filter).
+	\param depth	The number of rows of the sketch (0 removes the filter).
+
+	\return	 True on success. (It fails on invalid arguments, in "space_saving" mode or if the object already contains events.)
+*/
+bool events_set_admission_filter(int id, int width, int depth) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	return it->second->set_admission_filter(width, depth);
+}
+
+
+/** \brief Set up (or remove) the exponential decay of the counts of an Events object stored by the EventsServer.
+
+	\param id			The id returned by a previous new_events() call.
+	\param half_life	The number of rows after which the counts are halved (0 removes the decay).
+
+	\return	 True on success. (It fails on a negative half_life or if the object already contains events.)
+*/
+bool events_set_decay(int id, int half_life) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	return it->second->set_decay(half_life);
+}
+
+
+/** \brief Halve the counts of the discovered events of an Events object stored by the EventsServer (aging out the rare ones).
+
+	\param id	The id returned by a previous new_events() call.
+
+	\return	 True on success.
+*/
+bool events_decay_events(int id) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	it->second->decay_events();
+
+	return true;
+}
+
+
+/** \brief Set the fraction of the rows used for the discovery in an Events object stored by the EventsServer.
+
+	\param id		The id returned by a previous new_events() call.
+	\param rate	The probability of using each row, in (0, 1].
+
+	\return	 True on success. (It fails on a rate out of range or if the object already contains events.)
+*/
+bool events_set_sample_rate(int id, double rate) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	return it->second->set_sample_rate(rate);
+}
+
+
+/** \brief Estimate the number of rows of an event discovered by an Events object stored by the EventsServer.
+
+	\param id	The id returned by a previous new_events() call.
+	\param p_e	The "emitter".
+	\param p_d	The "description".
+	\param w	The "weight".
+
+	\return	 On success, the tab separated estimate, lower and upper bound of its 95% confidence interval. An empty string if the
+			 event is not found.
+*/
+char *events_estimate_count(int id, char *p_e, char *p_d, double w) {
+
+	answer_buffer[0] = 0;
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return answer_buffer;
+
+	BinEventPt ept = {it->second->hash_str(p_e), it->second->hash_str(p_d), w};
+
+	double estimate, lower, upper;
+
+	if (it->second->estimate_count(ept, estimate, lower, upper))
+		sprintf(answer_buffer, "%.3f\t%.3f\t%.3f", estimate, lower, upper);
+
+	return answer_buffer;
+}
+
+
+/** \brief Select the algorithm used to discover events in an Events object stored by the EventsServer.
+
+	\param id	 The id returned by a previous new_events() call.
+	\param mode Either "priority" (the default) or "space_saving".
+
+	\return	 True on success. (It fails on an unknown mode or if the object already contains events.)
+*/
+bool events_set_discovery(int id, char *mode) {
+
+	EventsServer::iterator it = events.find(id);
+
+	if (it == events.end())
+		return false;
+
+	if (strcmp(mode, "priority") == 0)
+		return it->second->set_discovery(ds_priority);
+
+	if (strcmp(mode, "space_saving") == 0)
+		return it->second->set_discovery(ds_space_saving);
+
+	return false;
+}
+
+
+/** \brief Select the function used to hash the strings of an Events object stored by the EventsServer.
+
+	\param id		The id returned by a previous new_events() call.
+	\param p_name	Either "murmur" (the default) or "wyhash".
+
+	\return	 True on success. (It fails on an unknown name or if the object already contains events.)
 */
-bool events_set_store_strings(int id, bool store) {
+bool events_set_hash_function(int id, char *p_name) {
 
 	EventsServer::iterator it = events.find(id);
 
-	if (it == events.end())
-		return false;
+	HashFunction hash_fn;
 
-	it->second->set_store_strings(store);
+	if (it == events.end() || !parse_hash_function(p_name, hash_fn))
+		return false;
 
-	return true;
+	return it->second->set_hash_function(hash_fn);
 }
 
 
@@ -2123,9 +4873,9 @@ bool clients_add_client_id(int id, char *p_cli) {
 	if (ll == 0)
 		return false;
 
-	ElementHash client_hash = MurmurHash64A(p_cli, ll);
+	ElementHash client_hash = it->second->hash_client_id(p_cli);
 
-	if (it->second->id_set.find(client_hash) != it->second->id_set.end())
+	if (it->second->contains(client_hash))
 		return false;
 
 	it->second->add_client_id(p_cli);
@@ -2134,6 +4884,97 @@ bool clients_add_client_id(int id, char *p_cli) {
 }
 
 
+/** \brief Add many already hashed client IDs to a Clients object stored by the ClientsServer. Only the new ones are added.
+
+	\param id		The id returned by a previous new_clients() call.
+	\param p_hash	An array of hashes (as returned by clients_hash_client_id()).
+	\param n		The number of hashes in the array.
+
+	\return	 The number of client IDs added or -1 on id not found.
+*/
+int64_t clients_add_client_hashes(int id, const uint64_t *p_hash, uint64_t n) {
+
+	ClientsServer::iterator it = clients.find(id);
+
+	if (it == clients.end())
+		return -1;
+
+	return it->second->add_client_hashes(p_hash, n);
+}
+
+
+/** \brief Return the function used to hash the client IDs of a Clients object stored by the ClientsServer.
+
+	\param id		The id returned by a previous new_clients() call.
+
+	\return	 The HashFunction (as an int) or -1 on id not found.
+*/
+int clients_hash_function(int id) {
+
+	ClientsServer::iterator it = clients.find(id);
+
+	if (it == clients.end())
+		return -1;
+
+	return it->second->hash_function;
+}
+
+
+/** \brief Hash many client IDs in parallel, without accessing any object.
+
+	\param hash_fn	The function returned by clients_hash_function().
+	\param p_cli	An array of pointers to the "clients". (Not necessarily zero terminated.)
+	\param p_len	An array with the length of each client ID.
+	\param n		The number of client IDs.
+	\param p_hash	An array of n hashes to be filled. (Empty IDs hash to zero, which clients_add_client_hashes() ignores.)
+
+	Since it does not touch the ClientsServer, the Python API calls it with the GIL released and then passes the hashes to
+	clients_add_client_hashes().
+*/
+void hash_client_ids(int hash_fn, char **p_cli, uint64_t *p_len, uint64_t n, uint64_t *p_hash) {
+
+	Clients::hash_in_parallel((HashFunction) hash_fn, p_cli, p_len, n, p_hash);
+}
+
+
+/** \brief Add all the client IDs in a text file (one per line) to a Clients object stored by the ClientsServer. Only the new ones are added.
+
+	\param id		The id returned by a previous new_clients() call.
+	\param p_path	The path of the file.
+
+	\return	 The number of client IDs added or -1 on id not found or file not readable.
+*/
+int clients_load_client_ids(int id, char *p_path) {
+
+	ClientsServer::iterator it = clients.find(id);
+
+	if (it == clients.end())
+		return -1;
+
+	return it->second->load_client_ids(p_path);
+}
+
+
+/** \brief Select the function used to hash the client IDs of a Clients object stored by the ClientsServer.
+
+	\param id		The id returned by a previous new_clients() call.
+	\param p_name	Either "murmur" (the default) or "wyhash".
+
+	\return	 True on success. (It fails on an unknown name or if the object already contains client IDs.)
+*/
+bool clients_set_hash_function(int id, char *p_name) {
+
+	ClientsServer::iterator it = clients.find(id);
+
+	HashFunction hash_fn;
+
+	if (it == clients.end() || !parse_hash_function(p_name, hash_fn))
+		return false;
+
+	return it->second->set_hash_function(hash_fn);
+}
+
+
 /** \brief Return the hash of a stored client ID by index as a decimal string.
 
 	\param id	The id returned by a previous new_clients() call.
@@ -2335,6 +5176,131 @@ bool clips_set_time_format(int id, char *fmt) {
 }
 
 
+/** \brief Convert a Clips object stored by the ClipsServer to a compact frozen layout when no more events will be inserted.
+
+	\param id		  The id returned by a previous new_clips() call.
+	\param compress  Store the times as varint deltas and the codes as bit-packed indices in a dictionary of codes.
+
+	\return	 True on valid id.
+*/
+bool clips_freeze(int id, bool compress) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end())
+		return false;
+
+	it->second->freeze(compress);
+
+	return true;
+}
+
+
+/** \brief Make a Clips object stored by the ClipsServer collect the scanned events in a flat vector to be sorted at once (bulk mode).
+
+	\param id		  The id returned by a previous new_clips() call.
+	\param compress  Build the compressed frozen layout when the bulk mode ends.
+
+	Any other call on the object ends the bulk mode. See Clips::begin_bulk() for the memory bound.
+
+	\return	 True on valid id.
+*/
+bool clips_begin_bulk(int id, bool compress) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end())
+		return false;
+
+	it->second->begin_bulk(compress);
+
+	return true;
+}
+
+
+/** \brief End the bulk mode of a Clips object stored by the ClipsServer, sorting the events into a frozen layout.
+
+	\param id	The id returned by a previous new_clips() call.
+
+	\return	 True on valid id.
+*/
+bool clips_end_bulk(int id) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end())
+		return false;
+
+	it->second->end_bulk();
+
+	return true;
+}
+
+
+/** \brief Add the clips of another Clips object stored by the ClipsServer to a Clips object stored by the ClipsServer.
+
+	\param id		 The id returned by a previous new_clips() call.
+	\param id_other The id of another Clips object populated over a disjoint slice of the same transactions with the same Events.
+
+	\return	 True on success.
+*/
+bool clips_merge(int id, int id_other) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end())
+		return false;
+
+	ClipsServer::iterator it_other = clips.find(id_other);
+
+	if (it_other == clips.end() || it_other == it)
+		return false;
+
+	return it->second->merge(*it_other->second);
+}
+
+
+/** \brief Keep only the most recent events of each clip in a Clips object stored by the ClipsServer.
+
+	\param id		The id returned by a previous new_clips() call.
+	\param length	The maximum number of events per clip (0 for no limit).
+	\param seconds	The maximum time in seconds between an event and the most recent event of the same clip (0 for no limit).
+
+	\return	 True on valid id.
+*/
+bool clips_set_history(int id, int length, int seconds) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end() || length < 0 || seconds < 0)
+		return false;
+
+	it->second->set_history(length, seconds);
+
+	return true;
+}
+
+
+/** \brief Use or not a Bloom filter to reject the clients faster in a Clips object stored by the ClipsServer.
+
+	\param id	The id returned by a previous new_clips() call.
+	\param use	Build the filter if true (the default), destroy it if false.
+
+	\return	 True on valid id.
+*/
+bool clips_set_client_filter(int id, bool use) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end())
+		return false;
+
+	it->second->set_client_filter(use);
+
+	return true;
+}
+
+
 /** \brief Process a row from a transaction file, to add the event to the client's timeline in a Clips object stored by the ClipsServer.
 
 	\param id	The id returned by a previous new_clips() call.
@@ -2381,6 +5347,28 @@ char *clips_hash_by_previous(int id, char *prev_hash) {
 	if (prev_hash[0] == '<' && ll == 18 && sscanf(prev_hash, "<%016lx>", &hh) != 1)
 		hh = 0;
 
+	if (it->second->is_frozen()) {
+		pFrozenClips p_frozen = it->second->frozen_clips();
+
+		int64_t ix = 0;
+
+		if (hh != 0) {
+			ix = p_frozen->find(hh);
+
+			if (ix < 0)
+				return answer_buffer;
+
+			ix++;
+		}
+
+		if (ix >= (int64_t) p_frozen->size())
+			return answer_buffer;
+
+		sprintf(answer_buffer, "<%016lx>", p_frozen->client[ix]);
+
+		return answer_buffer;
+	}
+
 	ClipMap::iterator it_clip;
 	if (hh == 0)
 		it_clip = it->second->clip_map()->begin();
@@ -2493,6 +5481,38 @@ int clips_save(int id) {
 }
 
 
+/** \brief Saves a Clips object without its clips as a BinaryImage.
+
+	The image loads as an empty Clips object with the same clients, events and time format. It is used to seed the partial Clips
+	objects of the workers of a parallel scan.
+
+	\param id  The id returned by a previous new_clips() call.
+
+	\return	 0 on error, or a binary_image_id > 0 which is the same as id and must be destroyed using destroy_binary_image_iterator()
+*/
+int clips_save_empty(int id) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end())
+		return 0;
+
+	pBinaryImage p_bi = new BinaryImage;
+
+	if (!it->second->save(p_bi, false)) {
+		delete p_bi;
+
+		return 0;
+	}
+
+	destroy_binary_image_iterator(id);
+
+	image[id] = p_bi;
+
+	return id;
+}
+
+
 /** \brief Describes the internal representation of a clip.
 
 	\param id		 The id returned by a previous new_clips() call.
@@ -2517,21 +5537,35 @@ char *clips_describe_clip(int id, char *client_id) {
 		hh = 0;
 
 	if (hh == 0 && ll > 0)
-		hh = MurmurHash64A(client_id, ll);
+		hh = hash_block(it->second->client_hash_function(), client_id, ll);
 
 	if (hh == 0)
 		return answer_buffer;
 
-	ClipMap::iterator it_clip_map = it->second->clip_map()->find(hh);
+	Clip clip;
 
-	if (it_clip_map == it->second->clip_map()->end())
-		return answer_buffer;
+	if (it->second->is_frozen()) {
+		int64_t ix = it->second->frozen_clips()->find(hh);
+
+		if (ix < 0)
+			return answer_buffer;
+
+		clip = it->second->frozen_clips()->clip(ix);
+
+	} else {
+		ClipMap::iterator it_clip_map = it->second->clip_map()->find(hh);
+
+		if (it_clip_map == it->second->clip_map()->end())
+			return answer_buffer;
+
+		clip = it_clip_map->second;
+	}
 
 	bool first = true;
 
 	char *pt = answer_buffer;
 
-	for (Clip::iterator it_clip = it_clip_map->second.begin(); it_clip != it_clip_map->second.end(); ++it_clip) {
+	for (Clip::iterator it_clip = clip.begin(); it_clip != clip.end(); ++it_clip) {
 		if (!first)
 			*pt++ = '\t';
 
@@ -2559,7 +5593,7 @@ int clips_num_clips(int id) {
 	if (it == clips.end())
 		return false;
 
-	return it->second->clip_map()->size();
+	return it->second->num_clips();
 }
 
 
@@ -2580,6 +5614,56 @@ int clips_num_events(int id) {
 }
 
 
+/** \brief Find a Clips object stored by the ClipsServer and count its clips and events for clips_export_columns().
+
+	\param id	The id returned by a previous new_clips() call.
+	\param n	Returns the number of clips.
+	\param m	Returns the number of events.
+
+	\return	The address of the Clips object or nullptr on id not found.
+
+	This reads the ClipsServer and ends any ingestion in progress (which changes the object), so the Python API calls it holding
+	the GIL. The export is (3 + 2*n + 2*m) uint64 long.
+*/
+void *clips_export_prepare(int id, uint64_t &n, uint64_t &m) {
+
+	ClipsServer::iterator it = clips.find(id);
+
+	if (it == clips.end())
+		return nullptr;
+
+	n = it->second->num_clips();
+	m = it->second->num_events();
+
+	return it->second;
+}
+
+
+/** \brief Exports all the clips of a Clips object in a single call.
+
+	\param p_clips	The address returned by clips_export_prepare().
+	\param p_raw	A buffer of (3 + 2*n + 2*m) uint64, aligned to 8 bytes.
+	\param n		The number of clips returned by clips_export_prepare().
+	\param m		The number of events returned by clips_export_prepare().
+
+	The buffer gets: the number of clips n and events m (uint64), the columns client (uint64[n]), offset (uint64[n + 1]), time
+	(int64[m]) and code (uint64[m]) of Clips::export_columns(). (All in native byte order.)
+
+	The Python API wraps this as clips_export() writing straight into a bytes object, with the GIL released only around this copy.
+*/
+void clips_export_columns(void *p_clips, char *p_raw, uint64_t n, uint64_t m) {
+
+	uint64_t *p_col = (uint64_t *) p_raw;
+
+	p_col[0] = n;
+	p_col[1] = m;
+
+	ClipColumns cols = {p_col + 2, p_col + 2 + n, (TimePoint *) p_col + 3 + 2*n, p_col + 3 + 2*n + m};
+
+	((pClips) p_clips)->export_columns(cols);
+}
+
+
 /** \brief Generates a constant sequence of codes for testing the Event Optimizer.
 
 	This returns one of the 500 non target sequences or one of the 500 target sequences.
@@ -2622,10 +5706,12 @@ int new_targets(int id_clips) {
 	if (it_clips == clips.end())
 		return -1;
 
-	if (it_clips->second->clip_map()->size() == 0)
+	if (it_clips->second->num_clips() == 0)
 		targets[++targets_num] = new Targets(nullptr, {});
 	else
-		targets[++targets_num] = new Targets(it_clips->second->clip_map(), {});
+		targets[++targets_num] = new Targets(it_clips->second->raw_clip_map(), {}, it_clips->second->frozen_clips());
+
+	targets[targets_num]->set_hash_function(it_clips->second->client_hash_function());
 
 	return targets_num;
 }
@@ -2673,6 +5759,37 @@ bool targets_set_time_format(int id, char *fmt) {
 }
 
 
+/** \brief Restrict a Targets object stored by the TargetsServer to the events of its clips inside a time window.
+
+	\param id	  The id returned by a previous new_targets() call.
+	\param since The first time included as a C/Python string in the time_format of the object. Empty for no lower bound.
+	\param until The first time not included as a C/Python string in the time_format of the object. Empty for no upper bound.
+
+	Like time_format, the window must be set before fit() and applies to fit(), predict() and save().
+
+	\return	 True on valid id and times.
+*/
+bool targets_set_window(int id, char *since, char *until) {
+
+	TargetsServer::iterator it = targets.find(id);
+
+	if (it == targets.end())
+		return false;
+
+	TimePoint time_from = INT64_MIN, time_to = INT64_MAX;
+
+	if (since[0] != 0 && (time_from = it->second->get_time(since)) < 0)
+		return false;
+
+	if (until[0] != 0 && (time_to = it->second->get_time(until)) < 0)
+		return false;
+
+	it->second->set_window(time_from, time_to);
+
+	return true;
+}
+
+
 /** \brief Utility to fill the internal TargetMap target in a Targets object stored by the TargetsServer.
 
 	The TargetMap can be initialized and given to the constructor, or an empty TargetMap can be given to the constructor ans
@@ -2782,7 +5899,7 @@ int	targets_predict_clips(int id, int id_clips) {
 	if (it_clips == clips.end())
 		return -1;
 
-	TimesToTarget ret = it->second->predict(it_clips->second->clip_map());
+	TimesToTarget ret = it->second->predict(*it_clips->second);
 
 	if (ret.size() == 0)
 		return -1;
@@ -2921,14 +6038,7 @@ int	targets_tree_node_idx(int id, int parent_idx, int code) {
 	if (parent_idx < 0 || parent_idx >= (int) pT->size())
 		return -1;
 
-	pCodeTreeNode pN = &pT->at(parent_idx);
-
-	ChildIndex::iterator jt = pN->child.find(code);
-
-	if (jt == pN->child.end())
-		return -1;
-
-	return jt->second;
+	return it->second->tree_child(parent_idx, code);
 }
 
 
@@ -2953,19 +6063,19 @@ char *targets_tree_node_children(int id, int idx) {
 	if (idx < 0 || idx >= (int) pT->size())
 		return answer_buffer;
 
-	pCodeTreeNode pN = &pT->at(idx);
+	CodeDict code = it->second->child_codes(idx);
 
 	bool first = true;
 
 	char *pt = answer_buffer;
 
-	for (ChildIndex::iterator it_child = pN->child.begin(); it_child != pN->child.end(); ++it_child) {
+	for (CodeDict::iterator it_child = code.begin(); it_child != code.end(); ++it_child) {
 		if (!first)
 			*pt++ = '\t';
 
 		first = false;
 
-		int l = sprintf(pt, "%li", it_child->first);
+		int l = sprintf(pt, "%li", *it_child);
 
 		pt += l;
 	}
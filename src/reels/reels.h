@@ -19,11 +19,14 @@
 	limitations under the License.
 */
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <math.h>
+#include <mutex>
 #include <set>
 #include <string>
 #include <string.h>
+#include <thread>
 #include <time.h>
 #include <vector>
 #include <stdarg.h>
@@ -61,6 +64,13 @@ namespace reels
 #define MAX_SEQ_LEN_IN_PREDICT	1000					///< The maximum sequence length used in prediction.
 #define PREDICT_MAX_TIME		(100*365.25*24*3600)	///< Hundred years when the target was never seen.
 #define WEIGHT_PRECISION		10000					///< 10^ the number of digits at which weight is rounded
+#define ADMISSION_RESET_FACTOR	10						///< The admission sketch halves its counters every width*this rows
+#define SAMPLE_CONFIDENCE_Z		1.959963985				///< The z of the 95% confidence intervals of Events::estimate_count()
+#define BULK_HASH_MIN_PER_THREAD 65536					///< The minimum number of client ids hashed by each thread in bulk loading
+#define CLIENT_FILTER_BITS		16						///< The number of bits per client id of the Bloom filter built by a Clips object
+#define MAX_CLIP_SHARDS			1024					///< The maximum number of shards of a Clips object in concurrent mode
+#define BULK_SORT_MIN_PER_THREAD 262144					///< The minimum number of events sorted by each thread in Clips bulk loading
+#define BULK_CHUNK_EVENTS		65536					///< The number of events of each chunk (1.5 MB) of the buffer of Clips bulk loading
 
 typedef uint64_t 						ElementHash;	///< A binary hash of a string
 typedef std::string						String;			///< A dynamically allocated c++ string
@@ -115,6 +125,28 @@ struct BinEventPt {
 	bool operator<(const BinEventPt &o) const {
 		return e < o.e || (e == o.e && d < o.d) || (e == o.e && d == o.d && round(WEIGHT_PRECISION*w) < round(WEIGHT_PRECISION*o.w));
 	}
+
+	/** \brief A 64 bit hash of the BinEventPt, consistent with operator==(), to support use as a key in flat hash tables.
+
+		\return	 The hash.
+	*/
+	uint64_t hash() const {
+		return hash_key(e, d, (int64_t) round(WEIGHT_PRECISION*w));
+	}
+
+	/** \brief The same hash as hash() given the weight already quantized.
+
+		\param e	The "emitter".
+		\param d	The "description".
+		\param wq	The "weight" quantized as round(WEIGHT_PRECISION*w).
+
+		\return	 The hash.
+	*/
+	static inline uint64_t hash_key(ElementHash e, ElementHash d, int64_t wq) {
+		uint64_t h = e ^ (d*0x9e3779b97f4a7c15) ^ ((uint64_t) wq*0xc6a4a7935bd1e995);
+
+		return h ^ (h >> 29);
+	}
 };
 
 
@@ -146,6 +178,21 @@ This map is combined with a PriorityMap to update observed events.
 typedef std::map<BinEventPt, EventStat> EventMap;
 
 
+/** \brief FrozenEvent: An event in the read-optimized dictionary built by Events::freeze() with its weight already quantized.
+
+A code of zero marks an empty slot.
+*/
+struct FrozenEvent {
+	ElementHash e;				///< The "emitter".
+	ElementHash d;				///< The "description".
+	int64_t		wq;				///< The "weight" quantized as round(WEIGHT_PRECISION*w).
+	uint64_t	code;			///< The code of the event.
+};
+
+
+typedef std::vector<FrozenEvent> FrozenEvents;	///< An open addressing hash table (linear probing) of FrozenEvent
+
+
 /** \brief PriorityMap: A map with all the acceptable priority values in the EventMap as keys.
 
 This map is the priority queue that accepts removal by least priority of current value.
@@ -153,12 +200,98 @@ This map is the priority queue that accepts removal by least priority of current
 typedef std::map<uint64_t, BinEventPt> PriorityMap;
 
 
+/** \brief EventCountMap: A map from BinEventPt to a count.
+
+This map is used to pass the per event error bounds of the Space-Saving discovery mode.
+*/
+typedef std::map<BinEventPt, uint64_t> EventCountMap;
+
+
+/** \brief EventColumns: The content of an EventMap as contiguous columns (one row per event in EventMap order).
+
+This is the result of Events::export_columns(), a bulk alternative to iterating the events one by one.
+*/
+struct EventColumns {
+	std::vector<ElementHash> e;				///< The hashes of the "emitters".
+	std::vector<ElementHash> d;				///< The hashes of the "descriptions".
+	std::vector<double>		 w;				///< The "weights".
+	std::vector<uint64_t>	 seen;			///< Number of times each event has been seen (EventStat.seen).
+	std::vector<uint64_t>	 code;			///< The codes (EventStat.code).
+	std::vector<uint64_t>	 priority;		///< The priorities (EventStat.priority).
+	std::vector<uint32_t>	 emitter;		///< The "emitters" as indices into strings.
+	std::vector<uint32_t>	 description;	///< The "descriptions" as indices into strings.
+	std::vector<String>		 strings;		///< The distinct strings. (Only an empty string if the strings are not stored.)
+};
+
+
+/** \brief Discovery: The algorithm used by Events::insert_row() to keep track of the most frequent events.
+
+	ds_priority is the original EventMap + PriorityMap queue, ds_space_saving is a Space-Saving stream-summary stored in flat arrays.
+*/
+enum Discovery {ds_priority, ds_space_saving};
+
+
+/** \brief SummarySlot: An event monitored by the Space-Saving stream-summary.
+
+The slots of the same count are a doubly linked list (by index) inside a SummaryBucket ordered by arrival (oldest first).
+*/
+struct SummarySlot {
+	BinEventPt ept;				///< The event.
+	uint64_t   count;			///< The (over)estimated number of times the event has been seen.
+	uint64_t   error;			///< The maximum overestimation in count (the count of the event it replaced).
+	uint64_t   code;			///< A code number identifying the event.
+	uint64_t   stamp;			///< The value of the visit counter at the last update. (Same tie breaking as the PriorityMap.)
+	int		   bucket;			///< Index of the SummaryBucket containing the slot.
+	int		   prev;			///< Index of the previous slot in the same bucket or -1.
+	int		   next;			///< Index of the next slot in the same bucket or -1.
+};
+
+
+/** \brief SummaryBucket: All the slots of the Space-Saving stream-summary sharing the same count.
+
+The buckets are a doubly linked list (by index) in increasing order of count.
+*/
+struct SummaryBucket {
+	uint64_t count;				///< The count of all the slots in the bucket.
+	int		 first;				///< Index of the first (oldest) slot.
+	int		 last;				///< Index of the last (newest) slot.
+	int		 prev;				///< Index of the bucket with the previous (smaller) count or -1.
+	int		 next;				///< Index of the bucket with the next (larger) count or -1. (Also links the free buckets.)
+};
+
+
+typedef std::vector<SummarySlot>	SummarySlots;	///< The slots of a Space-Saving stream-summary
+typedef std::vector<SummaryBucket>	SummaryBuckets;	///< The buckets of a Space-Saving stream-summary
+typedef std::vector<int>			SummaryIndex;	///< An open addressing hash table of slot indices (-1 is empty)
+typedef std::vector<uint32_t>		SketchCounters;	///< The (depth x width) counters of a Count-Min sketch, row after row
+
+
 /** \brief EventCodeMap: A map converting the space of Event codes into a lower cardinality set for Event optimization.
 
 */
 typedef std::map<uint64_t, uint64_t> EventCodeMap;
 
 
+/** \brief CodeDict: A dictionary of codes indexed by a dense id (0..K-1) for Event optimization.
+
+Events::optimize_events() renames the codes in the clips to the dense ids of the Events (Events::id_codes()) once, so the code
+transformations tried at each step are array lookups rather than map lookups. The same type maps the dense ids back to the codes.
+*/
+typedef std::vector<uint64_t> CodeDict;
+
+
+/** \brief The dense id of a code in a CodeDict whose codes are in increasing order.
+
+	\param dict	The CodeDict.
+	\param code	The code. (It must be in dict.)
+
+	\return	The id.
+*/
+inline uint64_t dense_id(const CodeDict &dict, uint64_t code) {
+	return std::lower_bound(dict.begin(), dict.end(), code) - dict.begin();
+}
+
+
 /** \brief CodeInTreeStatistics: A structure to compute aggregated statistics of for each code
 
 */
@@ -172,26 +305,26 @@ struct CodeInTreeStatistics {
 };
 
 
-/** \brief CodeInTreeStatMap: A map to store all the CodeInTreeStatistics by code.
+/** \brief CodeInTreeStats: A vector to store all the CodeInTreeStatistics indexed by a dense code id.
 
 */
-typedef std::map<uint64_t, CodeInTreeStatistics> CodeInTreeStatMap;
+typedef std::vector<CodeInTreeStatistics> CodeInTreeStats;
 
 
-/** \brief StringUsage: A pair of String and number of times it is used.
+/** \brief StringSlot: A string interned in a StringTable and the number of times it is used.
 
+The bytes of the string are stored in the arena of the table. A hash of zero (the hash of the empty string) marks an empty slot.
 */
-struct StringUsage {
-	uint64_t seen;	///< Number of times string is used. Increase by add_str() calls to the same string, decreased/destroyed by erase_str().
-	String str;		///< The string as plain text.
+struct StringSlot {
+	ElementHash hash;	///< The hash of the string.
+	uint64_t	seen;	///< Number of times string is used. Increase by add_str() calls to the same string, decreased/destroyed by erase_str().
+	uint64_t	ofs;	///< The offset of the string in the arena.
+	uint64_t	len;	///< The length of the string.
 };
 
 
-/** \brief StringUsageMap: A map from hashes to string and number of times the string is used.
-
-This map allows doing the reverse conversion to a hash() function finding out the original string.
-*/
-typedef std::map<ElementHash, StringUsage> StringUsageMap;
+typedef std::vector<StringSlot> StringSlots;	///< The slots of a StringTable (an open addressing hash table)
+typedef std::vector<char>		StringArena;	///< The bytes of all the strings in a StringTable
 
 
 /** \brief ClientIDs: A vector of client ID hashes.
@@ -201,11 +334,8 @@ This map is the fundamental storage of the Clients class preserving the order in
 typedef std::vector<ElementHash> ClientIDs;
 
 
-/** \brief ClientIDSet: A set of client ID hashes.
-
-This set allows fast search of a Client ID hash.
-*/
-typedef std::set<ElementHash> ClientIDSet;
+typedef std::vector<uint32_t> ClientSlots;	///< The slots of a ClientIDSet (an index in ClientIDs plus one, zero when empty)
+typedef std::vector<uint32_t> FilterWords;	///< The bits of a ClientFilter as 32 byte blocks of 8 words
 
 
 /** \brief Clip: The clip (timeline) of a client is just a map of time points and codes.
@@ -221,6 +351,55 @@ typedef std::map<ElementHash, Clip> ClipMap;
 typedef ClipMap * pClipMap;	///< Pointer to a ClipMap
 
 
+/** \brief ClipShard: The clips of the clients in a range of hashes and the lock serializing the insertions into them.
+
+	Clips::begin_concurrent() splits the ClipMap into shards by the top bits of the client hash, so the shards are consecutive ranges of
+	the ClipMap and joining them back is a linear append.
+*/
+struct ClipShard {
+	std::mutex lock;		///< Held while inserting into clips
+	ClipMap	   clips;		///< The clips of the shard
+
+	ClipShard() {}
+	ClipShard(const ClipShard &o) : clips(o.clips) {}							///< Copies the clips (the lock is never copied)
+	ClipShard &operator=(const ClipShard &o) { clips = o.clips; return *this; }	///< Copies the clips (the lock is never copied)
+};
+
+typedef std::vector<ClipShard> ClipShards;		///< All the shards of a Clips object in increasing order of hash
+
+
+/** \brief ClipEvent: An event of a clip as a flat (client, time, code) triple.
+
+	Clips::begin_bulk() makes insert_event() append these to fixed size chunks, which are sorted and turned into a FrozenClips by
+	end_bulk().
+*/
+struct ClipEvent {
+	ElementHash client;		///< The hash of the client
+	TimePoint	time;		///< The time of the event
+	uint64_t	code;		///< The code of the event
+};
+
+typedef std::vector<ClipEvent> ClipEvents;			///< A chunk of the events inserted in bulk mode (or all of them, sorted)
+typedef std::vector<ClipEvents> ClipEventChunks;	///< The events inserted in bulk mode in chunks of BULK_CHUNK_EVENTS, in order of arrival
+
+typedef std::vector<TimePoint> TimePoints;		///< The times of the events in a FrozenClips
+typedef std::vector<uint64_t>  ClipCodes;		///< The codes of the events (or the clip offsets) in a FrozenClips
+typedef std::vector<uint8_t>   ClipBytes;		///< The varint encoded times of the events in a compressed FrozenClips
+
+
+/** \brief ClipColumns: Where Clips::export_columns() writes the content of a Clips object as contiguous columns.
+
+The arrays are allocated by the caller (num_clips() and num_events() give the sizes) so that they can be the memory of the final
+consumer (E.g., a single Python bytes object that NumPy maps without copying) and the clips are never copied twice.
+*/
+struct ClipColumns {
+	ElementHash *client;				///< The hashes of the clients in increasing order. (num_clips() elements.)
+	uint64_t	*offset;				///< The first event of each clip plus the total number of events. (num_clips() + 1 elements.)
+	TimePoint	*time;					///< The times of the events, clip after clip in increasing time. (num_events() elements.)
+	uint64_t	*code;					///< The codes of the events. (num_events() elements.)
+};
+
+
 /** \brief TargetMap: A map from clients to target event TimePoints.
 
 This map is given to the constructor of a Target object.
@@ -272,9 +451,30 @@ struct CodeScoreItem {
 typedef std::vector <CodeScoreItem> CodeScores;
 
 
-/** \brief ChildIndex: A map to find the next child in a CodeTree.
+/** \brief ChildLink: A link from a node of a CodeTree to one of its children.
+*/
+struct ChildLink {
+	uint32_t id;		///< The dense id of the code (in the CodeIdMap of the Targets) leading to the child.
+	int		 idx;		///< The index of the child in the CodeTree.
+
+	/** \brief Compare to another ChildLink by id to keep a ChildIndex sorted.
+
+		\param o Another ChildLink to which the current object is compared.
+
+		\return	 True if the id is strictly smaller.
+	*/
+	bool operator<(const ChildLink &o) const {
+		return id < o.id;
+	}
+};
+
+
+/** \brief ChildIndex: The children of a node in a CodeTree sorted by id to find the next child with a binary search.
+
+	Most nodes have very few children, so a small sorted array is faster to search (and much smaller) than a std::map. An array directly
+	indexed by id would cost 4 bytes per code in the tree for each internal node.
 */
-typedef std::map<uint64_t, int>	ChildIndex;
+typedef std::vector<ChildLink>	ChildIndex;
 
 
 /** \brief CodeTreeNode: Each node in a fitted CodeTree.
@@ -283,7 +483,7 @@ struct CodeTreeNode {
 	uint64_t   n_seen;		///< The number of clips that visited the node (target and no target).
 	uint64_t   n_target;	///< The number of clips that visited the node with the target.
 	ExtFloat   sum_time_d;	///< Sum of time differences for the elements with a defined target.
-	ChildIndex child;		///< A map of children by code (key) to index in the CodeTree.
+	ChildIndex child;		///< The children sorted by the id of their code.
 };
 typedef CodeTreeNode * pCodeTreeNode;			///< Pointer to a CodeTreeNode
 
@@ -296,6 +496,108 @@ typedef std::vector<CodeTreeNode>	CodeTree;
 typedef CodeTree * pCodeTree;					///< Pointer to a CodeTree
 
 
+typedef std::vector<uint32_t> CodeIdSlots;		///< The slots of a CodeIdMap (a dense id plus one, zero when empty)
+
+
+/** \brief CodeIdMap: A map from the event codes found in a CodeTree to dense ids (0, 1, 2, ... in order of insertion).
+
+	It is an open addressing (linear probing) table whose slots only store the id, the codes are kept in a CodeDict indexed by id. The
+	ids allow a CodeTree to index its children and its statistics by arrays rather than maps.
+*/
+class CodeIdMap {
+
+	public:
+
+		CodeIdMap() {}
+
+
+		/** \brief The number of codes in the map.
+		*/
+		inline uint64_t size() const {
+			return code_of.size();
+		}
+
+
+		/** \brief The code of an id.
+
+			\param id	A dense id returned by insert() or find().
+
+			\return	The code.
+		*/
+		inline uint64_t code(uint32_t id) const {
+			return code_of[id];
+		}
+
+
+		/** \brief Find the id of a code.
+
+			\param code	The event code.
+
+			\return	The id or -1 if the code is not in the map.
+		*/
+		inline int64_t find(uint64_t code) const {
+			if (code_of.size() == 0)
+				return -1;
+
+			uint64_t mask = slot.size() - 1;
+
+			for (uint64_t i = slot_of(code); ; i = (i + 1) & mask) {
+				uint32_t id = slot[i];
+
+				if (id == 0)
+					return -1;
+
+				if (code_of[id - 1] == code)
+					return id - 1;
+			}
+		}
+
+
+		/** \brief Find the id of a code, adding the code with the next id if it is not in the map.
+
+			\param code	The event code.
+
+			\return	The id.
+		*/
+		inline uint32_t insert(uint64_t code) {
+			if (2*(code_of.size() + 1) > slot.size())
+				resize(2*(code_of.size() + 1));
+
+			uint64_t mask = slot.size() - 1;
+			uint64_t i	  = slot_of(code);
+
+			while (slot[i] != 0) {
+				if (code_of[slot[i] - 1] == code)
+					return slot[i] - 1;
+
+				i = (i + 1) & mask;
+			}
+			code_of.push_back(code);
+
+			slot[i] = code_of.size();
+
+			return code_of.size() - 1;
+		}
+
+		void clear();
+
+#ifndef TEST
+	private:
+#endif
+
+		/// The slot where a code starts probing. (A Fibonacci multiplication, since the codes are often consecutive.)
+		inline uint64_t slot_of(uint64_t code) const {
+			return (code*0x9e3779b97f4a7c15ull) >> shift;
+		}
+
+		void resize(uint64_t n);	///< Set the number of slots to a power of two >= max(n, 64) and rehash
+
+		CodeIdSlots slot	= {};
+		CodeDict	code_of = {};
+		int			shift	= 64;
+};
+
+
 /** \brief Transform: The transformation applied to time differences. (And inverted again in predict().)
 */
 enum Transform {tr_undefined, tr_linear, tr_log};
@@ -306,10 +608,54 @@ enum Transform {tr_undefined, tr_linear, tr_log};
 enum Aggregate {ag_undefined, ag_mean, ag_minimax, ag_longest};
 
 
+/** \brief HashFunction: The function used to hash the strings (emitter, description, client) of an object.
+
+	hf_murmur is MurmurHash64A (the default and the only one in images that do not record it), hf_wyhash is a wyhash-class
+	function doing 16 byte wide loads with 128-bit multiplies, which is faster on the ingestion hot path.
+*/
+enum HashFunction {hf_murmur, hf_wyhash};
+
+
+/** \brief TimeLayout: The layout of a time_format that TimeUtil::get_time() parses without calling strptime().
+
+	tl_date is "%Y-%m-%d", tl_date_time is "%Y-%m-%d %H:%M:%S", tl_iso is "%Y-%m-%dT%H:%M:%S" and tl_iso_z is "%Y-%m-%dT%H:%M:%SZ".
+	Any other format is tl_strptime.
+*/
+enum TimeLayout {tl_strptime, tl_date, tl_date_time, tl_iso, tl_iso_z};
+
+
+/** \brief DayCache: The last date parsed by TimeUtil::get_time() in a fixed layout and its TimePoint.
+
+	The date part of all the layouts is the same, so a cache can be shared by objects with different time_format values, but not by
+	different threads.
+*/
+struct DayCache {
+	char	  key[10];		///< The "YYYY-MM-DD" of the last date parsed
+	TimePoint time;			///< The TimePoint of the midnight starting that date
+};
+
+
 // Forward declaration of utilities used in other functions.
 uint64_t MurmurHash64A (const void *key, int len);
+uint64_t WyHash64 (const void *key, int len);
+bool parse_hash_function(pChar p_name, HashFunction &hash_fn);
 bool image_put(pBinaryImage p_bi, void *p_data, int size);
 bool image_get(pBinaryImage p_bi, int &c_block, int &c_ofs, void *p_data, int size);
+String hashed_section(pChar section, HashFunction hash_fn);
+bool find_hashed_section(ElementHash hs, pChar section, HashFunction &hash_fn);
+
+
+/** \brief Hash a memory block with a HashFunction.
+
+	\param hash_fn	The HashFunction.
+	\param key		Address of the memory block to hash.
+	\param len		Number of bytes to hash.
+
+	\return	64-bit hash of the memory block.
+*/
+inline uint64_t hash_block(HashFunction hash_fn, const void *key, int len) {
+	return hash_fn == hf_wyhash ? WyHash64(key, len) : MurmurHash64A(key, len);
+}
 
 
 /** \brief A minimalist logger stored as a std::string providing sprintf functionality.
@@ -351,6 +697,149 @@ class Logger {
 };
 
 
+/** \brief A string interning table allowing the reverse conversion to a hash() function finding out the original string.
+
+	The strings are found by hash in an open addressing (linear probing) table of StringSlot and their bytes are appended to a single
+	arena. Removing a string only leaves its bytes unused, the arena is compacted in bulk when more than half of it is unused.
+*/
+class StringTable {
+
+	public:
+
+		StringTable() {}
+
+
+		/** \brief The number of strings in the table.
+		*/
+		inline int size() const {
+			return num_used;
+		}
+
+
+		/** \brief The number of slots in the table. The used slots (used(ix) is true) are in [0, capacity()).
+		*/
+		inline int capacity() const {
+			return slot.size();
+		}
+
+
+		/** \brief Check if a slot contains a string.
+		*/
+		inline bool used(int ix) const {
+			return slot[ix].hash != 0;
+		}
+
+
+		/** \brief The hash of the string in a used slot.
+		*/
+		inline ElementHash hash(int ix) const {
+			return slot[ix].hash;
+		}
+
+
+		/** \brief The number of times the string in a used slot is used.
+		*/
+		inline uint64_t seen(int ix) const {
+			return slot[ix].seen;
+		}
+
+
+		/** \brief The string in a used slot.
+		*/
+		inline String str(int ix) const {
+			return String(arena.data() + slot[ix].ofs, slot[ix].len);
+		}
+
+
+		/** \brief Find a string by its hash.
+
+			\param hash	The hash of the string.
+
+			\return	The index of its slot or -1 if not found.
+		*/
+		inline int find(ElementHash hash) const {
+			if (num_used == 0 || hash == 0)
+				return -1;
+
+			uint64_t mask = slot.size() - 1;
+
+			for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+				if (slot[i].hash == hash)
+					return i;
+
+				if (slot[i].hash == 0)
+					return -1;
+			}
+		}
+
+
+		/** \brief Add uses to a string, storing it if it is not in the table.
+
+			\param hash	The hash of the string (not zero).
+			\param p_str	The string.
+			\param len		The length of the string.
+			\param count	The number of uses added.
+		*/
+		inline void add(ElementHash hash, pChar p_str, uint64_t len, uint64_t count) {
+			if (2*(num_used + 1) > (int) slot.size())
+				grow();
+
+			uint64_t mask = slot.size() - 1;
+			uint64_t i	  = hash & mask;
+
+			while (slot[i].hash != 0) {
+				if (slot[i].hash == hash) {
+					slot[i].seen += count;
+
+					return;
+				}
+				i = (i + 1) & mask;
+			}
+
+			StringSlot ss = {hash, count, arena.size(), len};
+
+			arena.insert(arena.end(), p_str, p_str + len);
+
+			slot[i] = ss;
+
+			num_used++;
+		}
+
+
+		/** \brief Remove uses from a string, destroying it if not used anymore.
+
+			\param hash	The hash of the string.
+			\param count	The number of uses removed.
+		*/
+		inline void erase(ElementHash hash, uint64_t count) {
+			int ix = find(hash);
+
+			if (ix >= 0) {
+				if (slot[ix].seen <= count)
+					erase_slot(ix);
+				else
+					slot[ix].seen -= count;
+			}
+		}
+
+		void clear();
+		std::vector<int> sorted_slots() const;
+
+#ifndef TEST
+	private:
+#endif
+
+		void grow();							///< Double the number of slots (at least 64) and rehash
+		void erase_slot(int ix);				///< Empty a slot (backward shift) and compact the arena if required
+		void compact();							///< Rebuild the arena with the used strings only
+
+		StringSlots slot	 = {};
+		StringArena arena	 = {};
+		int			num_used = 0;
+		uint64_t	garbage	 = 0;
+};
+
+
 class Clips;		// Forward declaration
 
 /** \brief A container class to hold events.
@@ -362,6 +851,20 @@ class Clips;		// Forward declaration
 		2. The object is given the events as a series of define_event() calls
 
 	To simplify the Python interface, the object has set_max_num_events() and set_store_strings() as methods.
+
+	The discovery in mode 1. uses either an EventMap + PriorityMap queue (the default) or a Space-Saving stream-summary selected
+	with set_discovery(). The latter does O(1) amortized updates in flat arrays and exposes its result as the same EventMap and
+	PriorityMap (materialized when read) with the same code assignment: a new code for each event entering the set.
+
+	In ds_priority mode, an optional Count-Min sketch admission filter (set_admission_filter()) counts all the rows in fixed memory
+	and, once the object is full, only lets a new event replace the lowest priority event if its estimated frequency is higher.
+	Rejected rows do not touch the EventMap, the PriorityMap or the strings.
+
+	In both modes, an optional exponential decay (set_decay()) halves the counts every given number of rows, so the events that
+	stop occurring age out of the set.
+
+	Also in both modes, a deterministic row sampling (set_sample_rate()) makes insert_row() skip most rows before hashing or
+	storing anything. The counts are then of the sampled rows and estimate_count() scales them back with a confidence interval.
 */
 class Events {
 
@@ -369,8 +872,9 @@ class Events {
 
 		Events() {}
 
-		bool store_strings	= true;						///< If true, the object stores the string values
-		int	 max_num_events	= DEFAULT_NUM_EVENTS;		///< The maximum number of recurrent event stored via insert_row()
+		bool		 store_strings	= true;					///< If true, the object stores the string values
+		int			 max_num_events	= DEFAULT_NUM_EVENTS;	///< The maximum number of recurrent event stored via insert_row()
+		HashFunction hash_function	= hf_murmur;			///< The hash of the strings. (Set it with set_hash_function().)
 
 
 		/** \brief Process a row from a transaction file.
@@ -387,6 +891,22 @@ class Events {
 						double w);
 
 
+		/** \brief Process a pre-aggregated row, the same event seen count times.
+
+			\param p_e		The "emitter". A C/Python string representing "owner of event".
+			\param p_d		The "description". A C/Python string representing "the event".
+			\param w		The "weight". A double representing a weight of the event.
+			\param count	The number of times the event was seen. (Zero does nothing.)
+
+			The result is the same as calling insert_row() count times in a row, at the cost of a single call. (With an admission
+			filter, the decision to admit the event is taken once for all count occurrences.)
+		*/
+		void insert_row_count(pChar	   p_e,
+							  pChar	   p_d,
+							  double   w,
+							  uint64_t count);
+
+
 		/** \brief Define events explicitly.
 
 			\param p_e	The "emitter". A C/Python string representing "owner of event".
@@ -418,9 +938,9 @@ class Events {
 			The algorithm builds a list of most promising (not already used) codes at the beginning of each step by full tree search.
 			From that list, each code is tried downwards as {noise, new_code, last_code} for score improvement above threshold
 			up to codes_per_step steps. And assigned a new code accordingly.
-			The codes assigned become part of the internal EventCodeMap and in the next step they will replace their old values.
+			The codes assigned become part of the internal CodeDict and in the next step they will replace their old values.
 
-			When the algorithm finishes, the internal EventCodeMap is used to rename the object codes and the whole process is reported.
+			When the algorithm finishes, the internal CodeDict is used to rename the object codes and the whole process is reported.
 
 			\param clips			 A clips object with the same codes and clips for a set of clients whose prediction we optimize.
 			\param targets			 The target events in a TargetMap object in the same format expected by a Targets object. (Internally
@@ -453,12 +973,12 @@ class Events {
 
 			\param score			Returns score by reference.
 			\param targ_prop		Returns the targets/seen proportion at the tree root by reference (used by get_top_codes).
-			\param codes_stat		Returns a complete CodeInTreeStatMap if calc_tree_stats is true.
+			\param codes_stat		Returns the CodeInTreeStats of each dense id if calc_tree_stats is true.
 			\param calc_tree_stats	Complete a tree search (if true) or just evaluate the score if not.
-			\param clips			A clips object with the same codes and clips for a set of clients whose prediction we optimize.
+			\param clips			A clips object for a set of clients whose prediction we optimize with the codes renamed to dense ids.
 			\param targets			The target events in a TargetMap object in the same format expected by a Targets object. (Internally
 									a Targets object will be used to make the predictions we want to optimize.)
-			\param code_dict		A dictionary of code transformations to be applied to a copy of the clips before fitting.
+			\param code_dict		The code each dense id is transformed into by the internal Targets object (see Targets::set_code_map()).
 			\param x_form			The x_form argument to fit the internal Targets object prediction model.
 			\param agg				The agg argument to fit the internal Targets object prediction model.
 			\param p				The p argument to fit the internal Targets object prediction model.
@@ -467,13 +987,15 @@ class Events {
 
 			\return	 False on error.
 		*/
-		bool score_model(double &score, double &targ_prop, CodeInTreeStatMap &codes_stat, bool calc_tree_stats, Clips &clips,
-						 TargetMap &targets, EventCodeMap code_dict, Transform x_form, Aggregate agg, double p, int depth, bool as_states);
+		bool score_model(double &score, double &targ_prop, CodeInTreeStats &codes_stat, bool calc_tree_stats, Clips &clips,
+						 TargetMap &targets, const CodeDict &code_dict, Transform x_form, Aggregate agg, double p, int depth,
+						 bool as_states);
 
 
-		/** \brief Internal: Extract the top top_n codes by lift from a CodeInTreeStatMap map.
+		/** \brief Internal: Extract the top top_n codes by lift from a CodeInTreeStats vector.
 
-			\param codes_stat		 A complete CodeInTreeStatMap computed by score_model().
+			\param codes_stat		 The CodeInTreeStats of each dense id computed by score_model().
+			\param code_dict		 The code of each dense id.
 			\param targ_prop		 The targets/seen proportion at the tree root.
 			\param exp_decay		 Exponential Decay Factor applied to the internal score in terms of depth. That score selects what
 									 codes enter the model. The decay is applied to the average tree depth. 0 is no decay, default
@@ -483,8 +1005,8 @@ class Events {
 
 			\return	 A sorted (by lift) vector of codes top first.
 		*/
-		CodeScores get_top_codes(CodeInTreeStatMap &codes_stat, double targ_prop, double exp_decay, double lower_bound_p,
-								 bool log_lift);
+		CodeScores get_top_codes(CodeInTreeStats &codes_stat, const CodeDict &code_dict, double targ_prop, double exp_decay,
+								 double lower_bound_p, bool log_lift);
 
 
 		/** \brief Compute Pearson linear correlation between predicted and observed in an OptimizeEval
@@ -542,11 +1064,53 @@ class Events {
 
 		/** \brief Save the state of an object into a base64 mercury-dynamics serialization using image_put()
 
-			\param p_bi The address of a BinaryImage stream that is either empty or has been used only for writing.
+			\param p_bi		  The address of a BinaryImage stream that is either empty or has been used only for writing.
+			\param with_events If false, no events or counts are saved and the image loads as an empty Events object with the same
+							  settings (discovery, admission, decay, sampling, hash function and max_num_events).
 
 			\return	 True on success (Most likely error is allocation).
 		*/
-		bool save(pBinaryImage &p_bi);
+		bool save(pBinaryImage &p_bi, bool with_events = true);
+
+
+		/** \brief Combine the discovery state of another Events object into this one.
+
+			\param other	 Another Events object populated via insert_row() over a disjoint slice of the same transactions.
+
+			\return	 True on success. It fails if the objects use a different discovery mode or any contains defined events.
+
+			The counts (EventStat.seen) of the same event are added (in ds_space_saving mode, as a mergeable summary, an event
+			missing in a full summary is assumed to have been seen as many times as that summary's minimum count), the names_map usage
+			counts are added and the top max_num_events are kept by (count desc, BinEventPt asc), so the merged set does not depend on
+			the order of the merges. The events already in this object keep their codes, new events get new codes in that order.
+		*/
+		bool merge(const Events &other);
+
+
+		/** \brief Estimate the number of rows of a discovered event from its count in the sampled rows.
+
+			\param ept		The event.
+			\param estimate	Returns the estimated count, the sampled count divided by the sample rate.
+			\param lower	Returns the lower bound of the 95% confidence interval (also below the Space-Saving error, if any).
+			\param upper	Returns the upper bound of the 95% confidence interval.
+
+			\return	 True if the event was found.
+
+			The interval is the normal approximation of the binomial sampling error, it is empty (lower == upper == estimate)
+			without sampling. With set_decay() the counts, and therefore the estimates, are decayed too.
+		*/
+		bool estimate_count(BinEventPt &ept, double &estimate, double &lower, double &upper);
+
+
+		/** \brief Halve the counts of all the discovered events.
+
+			Events whose count becomes zero are removed (aging out) with the strings no other event uses, the others keep their codes
+			and their relative recency.
+			It is called by insert_row() every set_decay() rows and can be called directly, e.g., once per day.
+
+			\param halvings	The number of times the counts are halved, in a single pass. (From 64 on, all the counts become zero.)
+		*/
+		void decay_events(int halvings = 1);
 
 
 		/** \brief Sets the public property max_num_events to simplify the python interface.
@@ -567,51 +1131,149 @@ class Events {
 		}
 
 
-		/** \brief Define a new string and push it into the StringUsageMap.
+		/** \brief Select the algorithm used by insert_row() to discover events.
 
-			\param p_str	The string to be added.
+			\param mode Either ds_priority (default) or ds_space_saving.
 
-			\return	The hash.
+			\return	 True on success, false if the object already contains events.
 		*/
-		inline ElementHash add_str(pChar p_str) {
+		inline bool set_discovery(Discovery mode) {
+			if (event.size() != 0 || ss_slot.size() != 0 || (mode == ds_space_saving && cm_width != 0))
+				return false;
+
+			discovery = mode;
+
+			return true;
+		}
+
+
+		/** \brief Select the function used to hash the strings.
+
+			\param hash_fn The HashFunction.
+
+			\return	 True on success, false if the object already contains events or strings.
+		*/
+		inline bool set_hash_function(HashFunction hash_fn) {
+			if (event.size() != 0 || ss_slot.size() != 0 || names_map.size() != 0)
+				return false;
+
+			hash_function = hash_fn;
+
+			return true;
+		}
+
+
+		/** \brief Set up (or remove) the Count-Min sketch admission filter used by insert_row() in ds_priority mode.
+
+			\param width	The number of counters per row (0 removes the filter).
+			\param depth	The number of rows (hash functions). Must be 0 if and only if width is 0.
+
+			\return	 True on success, false if the arguments are invalid, the object already contains events or is in
+					 ds_space_saving mode.
+		*/
+		inline bool set_admission_filter(int width, int depth) {
+			if (event.size() != 0 || discovery != ds_priority || width < 0 || depth < 0 || (width == 0) != (depth == 0))
+				return false;
+
+			cm_width = width;
+			cm_depth = depth;
+			cm_rows	 = 0;
+
+			cm_count.assign((size_t) width*depth, 0);
+
+			return true;
+		}
+
+
+		/** \brief Set up (or remove) the exponential decay of the counts used by insert_row() in both discovery modes.
+
+			\param half_life	The number of rows after which all the counts are halved by decay_events() (0 removes the decay).
+
+			\return	 True on success, false if the argument is negative or the object already contains events.
+
+			With a decay, the events are ranked by a count that halves every half_life rows, events that stop occurring age out
+			and the top max_num_events follow the recent transactions without a re-scan. For a time window (e.g. the last few
+			days) leave the decay at zero and call decay_events() at each period boundary instead.
+		*/
+		inline bool set_decay(int half_life) {
+			if (event.size() != 0 || ss_slot.size() != 0 || half_life < 0)
+				return false;
+
+			decay_half_life = half_life;
+			decay_rows		= 0;
+
+			return true;
+		}
+
+
+		/** \brief Set the fraction of the rows passed to insert_row() that are used for the discovery.
+
+			\param rate	The probability of using each row, in (0, 1]. (1 uses all the rows.)
+
+			\return	 True on success, false if the rate is out of range or the object already contains events.
+
+			The rows are selected by a hash of the row number, so the same input in the same order always gives the same result.
+			A pre-aggregated row of count n keeps floor(n*rate) rows plus one more with the probability of the fractional part.
+		*/
+		inline bool set_sample_rate(double rate) {
+			if (event.size() != 0 || ss_slot.size() != 0 || !(rate > 0 && rate <= 1))
+				return false;
+
+			sample_rate = rate;
+			sample_rows = 0;
+
+			return true;
+		}
+
+
+		/** \brief Compute the hash of a string without storing it.
+
+			\param p_str	The string.
+
+			\return	The hash (zero for an empty string).
+		*/
+		inline ElementHash hash_str(pChar p_str) {
 			int ll = strlen(p_str);
 
 			if (!ll)
 				return 0;
 
-			ElementHash hash = MurmurHash64A(p_str, ll);
+			return hash_block(hash_function, p_str, ll);
+		}
 
-			if (!store_strings)
-				return hash;
 
-			StringUsageMap::iterator it = names_map.find(hash);
+		/** \brief Define a new string and push it into the StringTable.
 
-			if (it != names_map.end())
-				it->second.seen++;
-			else {
-				StringUsage su = {1, p_str};
+			\param p_str	The string to be added.
+			\param count	The number of uses added. (The default is one.)
+
+			\return	The hash.
+		*/
+		inline ElementHash add_str(pChar p_str, uint64_t count = 1) {
+			int ll = strlen(p_str);
+
+			if (!ll)
+				return 0;
+
+			ElementHash hash = hash_block(hash_function, p_str, ll);
+
+			if (store_strings)
+				names_map.add(hash, p_str, ll, count);
 
-				names_map[hash] = su;
-			}
 			return hash;
 		}
 
 
-		/** \brief Remove a string from the StringUsageMap by decreasing its use count and destroying it if not used anymore.
+		/** \brief Remove a string from the StringTable by decreasing its use count and destroying it if not used anymore.
 
 			\param hash	hash(key)
+			\param count	The number of uses removed. (The default is one.)
 
 		*/
-		inline void erase_str(ElementHash hash) {
-
-			if (store_strings) {
-				StringUsageMap::iterator it = names_map.find(hash);
+		inline void erase_str(ElementHash hash, uint64_t count = 1) {
 
-				if (it != names_map.end()) {
-					if (--it->second.seen == 0)
-						names_map.erase(it);
-				}
-			}
+			if (store_strings)
+				names_map.erase(hash, count);
 		}
 
 
@@ -627,15 +1289,54 @@ class Events {
 				if (!hash)
 					return "";
 
-				StringUsageMap::iterator it = names_map.find(hash);
+				int ix = names_map.find(hash);
 
-				if (it != names_map.end())
-					return it->second.str;
+				if (ix >= 0)
+					return names_map.str(ix);
 			}
 			return "\x04";
 		}
 
 
+		/** \brief Build a flat, read-optimized copy of the (event, code) pairs used by event_code() until the events change.
+
+			A Clips object freezes its events, so the event_code() lookups in scan_event() do not walk the EventMap. Any method
+			modifying the events (insert_row(), define_event(), merge(), load(), optimize_events()) drops the frozen copy.
+
+			It also gives the different codes the dense ids 0..num_ids() - 1 in increasing order of code. These ids are internal: the
+			codes are still what the API (and the ClipMap of a Clips) uses, but a compressed FrozenClips stores the ids of its Events
+			and the optimizer and Targets index arrays by them.
+		*/
+		void freeze();
+
+
+		/** \brief The number of dense ids given to the codes by freeze(). (Zero if the object is not frozen.)
+		*/
+		inline uint64_t num_ids() const {
+			return id_code.size();
+		}
+
+
+		/** \brief The dense id of a code. (Valid while the object is frozen.)
+
+			\param code	The code.
+
+			\return	The id or -1 if no event has the code.
+		*/
+		inline int64_t event_id(uint64_t code) const {
+			uint64_t id = dense_id(id_code, code);
+
+			return id < id_code.size() && id_code[id] == code ? id : -1;
+		}
+
+
+		/** \brief The codes of all the dense ids, in increasing order. (Valid while the object is frozen.)
+		*/
+		inline const CodeDict &id_codes() const {
+			return id_code;
+		}
+
+
 		/** \brief Return the code associated to an BinEventPt if found in the object.
 
 			\param ept	The BinEventPt searched.
@@ -643,6 +1344,23 @@ class Events {
 			\return	The code if found, or zero if not.
 		*/
 		inline uint64_t event_code(BinEventPt &ept) {
+			if (frozen.size() != 0) {
+				int64_t	 wq	  = (int64_t) round(WEIGHT_PRECISION*ept.w);
+				uint64_t mask = frozen.size() - 1;
+
+				for (uint64_t i = BinEventPt::hash_key(ept.e, ept.d, wq) & mask;; i = (i + 1) & mask) {
+					FrozenEvent &fe = frozen[i];
+
+					if (fe.code == 0)
+						return 0;
+
+					if (fe.e == ept.e && fe.d == ept.d && fe.wq == wq)
+						return fe.code;
+				}
+			}
+
+			sync_event_map();
+
 			EventMap::iterator it = event.find(ept);
 
 			if (it == event.end())
@@ -657,6 +1375,8 @@ class Events {
 			\return	The size of the internal EventMap().
 		*/
 		inline int num_events() {
+			sync_event_map();
+
 			return event.size();
 		}
 
@@ -666,6 +1386,8 @@ class Events {
 			\return	The iterator to the first element.
 		*/
 		inline EventMap::iterator events_begin() {
+			sync_event_map();
+
 			return event.begin();
 		}
 
@@ -675,10 +1397,19 @@ class Events {
 			\return	The iterator to the first element past-the-end.
 		*/
 		inline EventMap::iterator events_end() {
+			sync_event_map();
+
 			return event.end();
 		}
 
 
+		/** \brief Copy all the events into contiguous columns in a single pass.
+
+			\param cols	The EventColumns to be filled. (Any previous content is replaced.)
+		*/
+		void export_columns(EventColumns &cols);
+
+
 		/** \brief Return the EventMap::iterator to the next BinEventPt after matching ev or nullptr if not found or is last.
 
 			\param ept	The BinEventPt searched.
@@ -686,6 +1417,8 @@ class Events {
 			\return	The iterator to the next element after the matching element or events_end() when no next element exists.
 		*/
 		inline EventMap::iterator events_next_after_find(BinEventPt &ept) {
+			sync_event_map();
+
 			EventMap::iterator it = event.find(ept);
 
 			if (it != event.end())
@@ -698,12 +1431,318 @@ class Events {
 	private:
 #endif
 
+		/** \brief Drop the frozen copy of the events made by freeze() before the events are modified.
+		*/
+		inline void thaw() {
+			if (frozen.size() != 0)
+				FrozenEvents().swap(frozen);
+
+			if (id_code.size() != 0)
+				CodeDict().swap(id_code);
+		}
+
+
+		/** \brief Make the EventMap and PriorityMap reflect the Space-Saving stream-summary if it has been updated since.
+		*/
+		inline void sync_event_map() {
+			if (ss_dirty)
+				summary_to_event_map();
+		}
+
+		void summary_insert(BinEventPt &ept, uint64_t count);		///< insert_row_count() in ds_space_saving mode
+		int	 summary_find(BinEventPt &ept);							///< Slot index of an event or -1
+		void summary_index_insert(int ix);							///< Add a slot to ss_index (growing it if required)
+		void summary_index_erase(int ix);							///< Remove a slot from ss_index
+		int	 summary_detach(int ix);								///< Unlink a slot from its bucket
+		void summary_attach(int ix, uint64_t count, int after);		///< Link a slot into the bucket of a count
+		void summary_to_event_map();								///< Materialize the summary as EventMap + PriorityMap
+		void summary_from_event_map(EventCountMap &error);			///< Rebuild the summary from EventMap + PriorityMap
+		bool has_defined_events() const;							///< True if define_event() was used
+		uint64_t summary_min_count() const;							///< The minimum count of a full summary (else 0)
+		bool admit_event(BinEventPt &ept, uint64_t count);			///< Count rows in the sketch and decide if they enter
+		uint32_t sketch_estimate(const BinEventPt &ept) const;		///< Count-Min estimated frequency of an event
+		uint64_t sample_count(uint64_t count);						///< The rows of a pre-aggregated row kept by the sampling
+		void sketch_merge(const Events &other);						///< Add the sketch counters of another object
+
 		uint64_t priority_low = 0;
 		uint64_t next_code	  = 0;
 
-		StringUsageMap names_map = {};
+		StringTable	   names_map = {};
 		EventMap	   event	 = {};
 		PriorityMap	   priority	 = {};
+
+		Discovery	   discovery	 = ds_priority;
+		SummarySlots   ss_slot		 = {};
+		SummaryBuckets ss_bucket	 = {};
+		SummaryIndex   ss_index		 = {};
+		int			   ss_min_bucket = -1;
+		int			   ss_free		 = -1;
+		bool		   ss_dirty		 = false;
+
+		int			   cm_width		 = 0;
+		int			   cm_depth		 = 0;
+		uint64_t	   cm_rows		 = 0;
+		SketchCounters cm_count		 = {};
+
+		int			   decay_half_life = 0;
+		uint64_t	   decay_rows	   = 0;
+
+		double		   sample_rate	   = 1;
+		uint64_t	   sample_rows	   = 0;
+
+		FrozenEvents   frozen		 = {};
+		CodeDict	   id_code		 = {};
+};
+
+
+/** \brief ClientIDSet: A set of client ID hashes.
+
+	This set allows fast search of a Client ID hash. It is an open addressing (linear probing) table sharing the storage of the ClientIDs
+	it indexes: its slots only store the position of the hash in the vector (4 bytes per slot instead of a std::set node per hash).
+	Therefore, all the methods that need the hashes take the ClientIDs as an argument.
+*/
+class ClientIDSet {
+
+	public:
+
+		ClientIDSet() {}
+
+
+		/** \brief The number of different hashes in the set.
+		*/
+		inline int size() const {
+			return num_used;
+		}
+
+
+		/** \brief Find a hash in the set.
+
+			\param hash	The hash of the client ID.
+			\param id		The ClientIDs indexed by the set.
+
+			\return	The index of the hash in id or -1 if not found.
+		*/
+		inline int64_t find(ElementHash hash, const ClientIDs &id) const {
+			if (num_used == 0)
+				return -1;
+
+			uint64_t mask = slot.size() - 1;
+
+			for (uint64_t i = slot_of(hash); ; i = (i + 1) & mask) {
+				uint32_t ix = slot[i];
+
+				if (ix == 0)
+					return -1;
+
+				if (id[ix - 1] == hash)
+					return ix - 1;
+			}
+		}
+
+
+		/** \brief Add a hash already pushed into the ClientIDs to the set, unless it was already in it.
+
+			\param ix	The index of the hash in id.
+			\param id	The ClientIDs indexed by the set.
+
+			\return	True if the hash was inserted, false if it was already in the set.
+		*/
+		inline bool insert(uint64_t ix, const ClientIDs &id) {
+			if (2*(num_used + 1) > (int64_t) slot.size())
+				resize(2*(num_used + 1), id);
+
+			uint64_t	mask = slot.size() - 1;
+			ElementHash hash = id[ix];
+
+			uint64_t i = slot_of(hash);
+
+			while (slot[i] != 0) {
+				if (id[slot[i] - 1] == hash)
+					return false;
+
+				i = (i + 1) & mask;
+			}
+			slot[i] = ix + 1;
+
+			num_used++;
+
+			return true;
+		}
+
+
+		/** \brief Make room for a number of hashes at once, to avoid rehashing while inserting them.
+
+			\param n	The total number of hashes the set will contain.
+			\param id	The ClientIDs indexed by the set.
+		*/
+		inline void reserve(uint64_t n, const ClientIDs &id) {
+			if (2*n > slot.size())
+				resize(2*n, id);
+		}
+
+		void clear();
+
+#ifndef TEST
+	private:
+#endif
+
+		/// The slot where a hash starts probing. (A Fibonacci multiplication, since pre-hashed ids may not be well distributed.)
+		inline uint64_t slot_of(ElementHash hash) const {
+			return (hash*0x9e3779b97f4a7c15ull) >> shift;
+		}
+
+		void resize(uint64_t n, const ClientIDs &id);	///< Set the number of slots to a power of two >= max(n, 64) and rehash
+
+		ClientSlots slot	 = {};
+		int64_t		num_used = 0;
+		int			shift	 = 64;
+};
+
+
+/** \brief ClipSlot: A slot of a ClipIndex. (Empty when p_clip is nullptr.)
+*/
+struct ClipSlot {
+	ElementHash hash;					///< The hash of the client
+	Clip	   *p_clip;					///< The address of its clip in the ClipMap
+};
+
+typedef std::vector<ClipSlot> ClipSlots;	///< The slots of a ClipIndex
+
+
+/** \brief ClipIndex: A hash index from client ID hashes to the clips of a ClipMap.
+
+	This allows Clips::insert_event() to find the clip of a client with one probe of an open addressing (linear probing) table rather than
+	a search in the ordered ClipMap. The clips are still nodes of the ClipMap (whose addresses do not change when other clients are
+	inserted), so the ClipMap keeps its order for every reader and only the first event of a client pays for an ordered insertion. The
+	owner must clear() the index whenever the ClipMap may lose nodes. An index is never copied, since it points into the ClipMap of its
+	owner.
+*/
+class ClipIndex {
+
+	public:
+
+		ClipIndex() {}
+		ClipIndex(const ClipIndex &) {}								///< Starts empty (the index is never copied)
+		ClipIndex &operator=(const ClipIndex &) { clear(); return *this; }	///< Becomes empty (the index is never copied)
+
+
+		/** \brief Find the clip of a client.
+
+			\param hash	The hash of the client ID.
+
+			\return	The address of the clip in the ClipMap or nullptr if the client is not in the index.
+		*/
+		inline Clip *find(ElementHash hash) const {
+			if (num_used == 0)
+				return nullptr;
+
+			uint64_t mask = slot.size() - 1;
+
+			for (uint64_t i = slot_of(hash); ; i = (i + 1) & mask) {
+				if (slot[i].p_clip == nullptr || slot[i].hash == hash)
+					return slot[i].p_clip;
+			}
+		}
+
+
+		/** \brief Add a client that is not in the index.
+
+			\param hash	The hash of the client ID.
+			\param p_clip	The address of its clip in the ClipMap.
+		*/
+		inline void insert(ElementHash hash, Clip *p_clip) {
+			if (2*(num_used + 1) > (int64_t) slot.size())
+				resize(2*(num_used + 1));
+
+			uint64_t mask = slot.size() - 1;
+			uint64_t i	  = slot_of(hash);
+
+			while (slot[i].p_clip != nullptr)
+				i = (i + 1) & mask;
+
+			slot[i].hash   = hash;
+			slot[i].p_clip = p_clip;
+
+			num_used++;
+		}
+
+		void clear();
+
+#ifndef TEST
+	private:
+#endif
+
+		/// The slot where a hash starts probing. (A Fibonacci multiplication, since pre-hashed ids may not be well distributed.)
+		inline uint64_t slot_of(ElementHash hash) const {
+			return (hash*0x9e3779b97f4a7c15ull) >> shift;
+		}
+
+		void resize(uint64_t n);	///< Set the number of slots to a power of two >= max(n, 64) and rehash
+
+		ClipSlots slot	   = {};
+		int64_t	  num_used = 0;
+		int		  shift	   = 64;
+};
+
+
+/** \brief ClientFilter: A blocked Bloom filter of client ID hashes.
+
+	Each hash selects one 32 byte block (half a cache line) and sets one bit in each of its 8 words. A negative answer is exact, a positive
+	one must be confirmed by the ClientIDSet. An empty (never built) filter answers positive to everything.
+*/
+class ClientFilter {
+
+	public:
+
+		ClientFilter() {}
+
+
+		/** \brief Check if a hash may be in the filter.
+
+			\param hash	The hash of the client ID.
+
+			\return	False if the hash was never inserted, true if it probably was.
+		*/
+		inline bool may_contain(ElementHash hash) const {
+			if (num_blocks == 0)
+				return true;
+
+			const uint32_t *p_block = &word[8*(((hash >> 32)*num_blocks) >> 32)];
+
+			uint32_t key = (uint32_t) hash;
+
+			for (int i = 0; i < 8; i++)
+				if ((p_block[i] & (1u << ((key*salt[i]) >> 27))) == 0)
+					return false;
+
+			return true;
+		}
+
+
+		/** \brief Build the filter for some ClientIDs, replacing its content.
+
+			\param id				The client ID hashes.
+			\param bits_per_id		The size of the filter in bits per hash. (The default 16 gives around 0.1% false positives.)
+		*/
+		void build(const ClientIDs &id, int bits_per_id = CLIENT_FILTER_BITS);
+
+
+		/** \brief Destroy the filter, after which it answers positive to everything.
+		*/
+		inline void clear() {
+			word.clear();
+
+			num_blocks = 0;
+		}
+
+#ifndef TEST
+	private:
+#endif
+
+		static const uint32_t salt[8];			///< Odd multipliers selecting a bit of each word from the key
+
+		FilterWords word	   = {};
+		uint64_t	num_blocks = 0;
 };
 
 
@@ -726,7 +1765,35 @@ class Clients {
 		inline ElementHash hash_client_id(pChar p_cli) {
 			int ll = strlen(p_cli);
 
-			return ll == 0 ? 0 : MurmurHash64A(p_cli, ll);
+			return ll == 0 ? 0 : hash_block(hash_function, p_cli, ll);
+		}
+
+
+		/** \brief Select the function used to hash the client IDs. (A Clips object hashes the client IDs with the function of its
+			Clients object, even if it is empty.)
+
+			\param hash_fn The HashFunction.
+
+			\return	 True on success, false if the object already contains client IDs.
+		*/
+		inline bool set_hash_function(HashFunction hash_fn) {
+			if (id.size() != 0)
+				return false;
+
+			hash_function = hash_fn;
+
+			return true;
+		}
+
+
+		/** \brief Check if a client ID hash is in this container.
+
+			\param hash The hash of the client ID.
+
+			\return	 True if found.
+		*/
+		inline bool contains(ElementHash hash) const {
+			return id_set.find(hash, id) >= 0;
 		}
 
 
@@ -737,194 +1804,879 @@ class Clients {
 		void add_client_id(pChar p_cli);
 
 
-		/** \brief Load the state of an object from a base64 mercury-dynamics serialization using image_get()
+		/** \brief Add many already hashed client IDs to this container at once. Only the new ones are added.
 
-			\param p_bi The address of a BinaryImage stream containing a previously save()-ed image at the cursor position.
+			\param p_hash	An array of hashes (as returned by hash_client_id()). Zero (the hash of an empty ID) is ignored.
+			\param n		The number of hashes in the array.
 
-			\return	 True on success (Most likely error is a wrong stream).
+			\return	 The number of client IDs added.
 		*/
-		bool load(pBinaryImage &p_bi);
+		uint64_t add_client_hashes(const ElementHash *p_hash, uint64_t n);
 
 
-		/** \brief Load the state of an object from a base64 mercury-dynamics serialization using image_get()
+		/** \brief Add many client IDs to this container at once, hashing them in parallel. Only the new ones are added.
 
-			\param p_bi	   The address of a BinaryImage stream containing a previously save()-ed image at the cursor position.
-			\param c_block The current reading cursor (block number) required only for nested use of load().
-			\param c_ofs   The current reading cursor (offset in block) required only for nested use of load().
+			\param p_cli	An array of pointers to the "clients". (Not necessarily zero terminated.) Empty IDs are ignored.
+			\param p_len	An array with the length of each client ID.
+			\param n		The number of client IDs.
 
-			\return	 True on success (Most likely error is a wrong stream).
+			\return	 The number of client IDs added.
+		*/
+		uint64_t add_client_ids(const pChar *p_cli, const uint64_t *p_len, uint64_t n);
+
+
+		/** \brief Add all the client IDs in a text file (one per line) to this container, hashing them in parallel.
+
+			\param p_path	The path of the file. The lines can end in "\n" or "\r\n". Empty lines are ignored.
+
+			\return	 The number of client IDs added or -1 if the file cannot be read.
+		*/
+		int64_t load_client_ids(pChar p_path);
+
+
+		/** \brief Load the state of an object from a base64 mercury-dynamics serialization using image_get()
+
+			\param p_bi The address of a BinaryImage stream containing a previously save()-ed image at the cursor position.
+
+			\return	 True on success (Most likely error is a wrong stream).
+		*/
+		bool load(pBinaryImage &p_bi);
+
+
+		/** \brief Load the state of an object from a base64 mercury-dynamics serialization using image_get()
+
+			\param p_bi	   The address of a BinaryImage stream containing a previously save()-ed image at the cursor position.
+			\param c_block The current reading cursor (block number) required only for nested use of load().
+			\param c_ofs   The current reading cursor (offset in block) required only for nested use of load().
+
+			\return	 True on success (Most likely error is a wrong stream).
 		*/
 		bool load(pBinaryImage &p_bi, int &c_block, int &c_ofs);
 
 
-		/** \brief Save the state of an object into a base64 mercury-dynamics serialization using image_put()
+		/** \brief Save the state of an object into a base64 mercury-dynamics serialization using image_put()
+
+			\param p_bi The address of a BinaryImage stream that is either empty or has been used only for writing.
+
+			\return	 True on success (Most likely error is allocation).
+		*/
+		bool save(pBinaryImage &p_bi);
+
+		static void hash_in_parallel(HashFunction hash_fn, const pChar *p_cli, const uint64_t *p_len, uint64_t n, ElementHash *p_hash);	///< Hash IDs in threads
+		uint64_t	add_new_hashes(const ElementHash *p_hash, uint64_t n);		///< Append the hashes not already in the set, skipping zero
+
+		ClientIDs	 id			   = {};			///< The vector containing client ids as hashes in the order of definition.
+		ClientIDSet	 id_set		   = {};			///< The set of the same hashes for fast search.
+		HashFunction hash_function = hf_murmur;		///< The hash of the client IDs. (Set it with set_hash_function().)
+};
+
+
+/** \brief A position in a clip of a FrozenClips to iterate it backwards (from the last event to the first) with prev_event().
+*/
+struct ClipCursor {
+	uint64_t  j		= 0;	///< The index of the next event plus one (the event returned by the next prev_event() is j - 1).
+	uint64_t  first	= 0;	///< The index of the first event of the clip.
+	uint64_t  pos	= 0;	///< The end of the varint of the next time delta (compressed layout only).
+	TimePoint time	= 0;	///< The time of the next event (compressed layout only).
+};
+
+
+/** \brief The content of a ClipMap stored in contiguous sorted arrays (compressed sparse row) after ingestion is finished.
+
+	The clip of the i-th client (in increasing order of hash) is made of the events in [offset[i], offset[i + 1]), in increasing order of
+	time. In the raw layout, the events are stored in the arrays time and code, taking 16 bytes per event instead of a std::map node.
+
+	In the compressed layout, the codes are replaced by their index in code_dict, bit-packed in code_bits bits each. When the clips are
+	built with the ids of their Events (Events::id_codes()) and those contain all the codes, code_dict is that CodeDict, so the index of
+	an event is its dense id in the Events. Otherwise, code_dict has just the codes of the clips. The times of each
+	clip are stored in time_bytes as the varint of the (zigzag) first time followed by the varints of the differences to the previous one.
+	Since the last byte of a varint is the only one below 0x80, the varints can be read backwards, starting from the last time of the
+	clip stored in last_time. A typical event takes 3 to 6 bytes, depending on the time between events and the number of codes.
+*/
+class FrozenClips {
+
+	public:
+
+		FrozenClips() {}
+
+
+		/** \brief True if the object contains a (possibly empty) frozen ClipMap, false if it was never built or was cleared.
+		*/
+		inline bool is_frozen() const {
+			return offset.size() > 0;
+		}
+
+
+		/** \brief The number of clips (clients).
+		*/
+		inline uint64_t size() const {
+			return client.size();
+		}
+
+
+		/** \brief The total number of events in all the clips.
+		*/
+		inline uint64_t num_events() const {
+			return offset.size() > 0 ? offset.back() : 0;
+		}
+
+
+		/** \brief Find a client by its hash.
+
+			\param hash	The hash of the client.
+
+			\return	The index of the client or -1 if not found.
+		*/
+		inline int64_t find(ElementHash hash) const {
+			ClientIDs::const_iterator it = std::lower_bound(client.begin(), client.end(), hash);
+
+			if (it == client.end() || *it != hash)
+				return -1;
+
+			return it - client.begin();
+		}
+
+
+		/** \brief Start iterating a clip backwards.
+
+			\param ix	The index of the client (In range 0..size() - 1).
+			\param cur	A ClipCursor to be used by prev_event().
+		*/
+		inline void last_event(uint64_t ix, ClipCursor &cur) const {
+			cur.j	  = offset[ix + 1];
+			cur.first = offset[ix];
+
+			if (compressed) {
+				cur.pos	 = time_offset[ix + 1];
+				cur.time = last_time[ix];
+			}
+		}
+
+
+		/** \brief Start iterating a clip backwards from the last event before a time.
+
+			\param ix	The index of the client (In range 0..size() - 1).
+			\param to	The first time not returned by prev_event().
+			\param cur	A ClipCursor to be used by prev_event().
+		*/
+		inline void last_event_before(uint64_t ix, TimePoint to, ClipCursor &cur) const {
+			if (!compressed) {
+				cur.j	  = std::lower_bound(time.begin() + offset[ix], time.begin() + offset[ix + 1], to) - time.begin();
+				cur.first = offset[ix];
+
+				return;
+			}
+
+			last_event(ix, cur);
+
+			ClipCursor next = cur;
+			TimePoint  time_pt;
+			uint64_t   code;
+
+			while (prev_event(next, time_pt, code) && time_pt >= to)
+				cur = next;
+		}
+
+
+		/** \brief Return the event before the cursor and move the cursor back.
+
+			\param cur		A ClipCursor initialized by last_event().
+			\param time_pt	The time of the event.
+			\param code	The code of the event.
+			\param as_index	Return the index of the code in code_dict instead. (Compressed layout only, the raw one returns the code.)
+
+			\return	False (and nothing is returned) if the cursor is already at the beginning of the clip.
+		*/
+		inline bool prev_event(ClipCursor &cur, TimePoint &time_pt, uint64_t &code, bool as_index = false) const {
+			if (cur.j == cur.first)
+				return false;
+
+			cur.j--;
+
+			if (!compressed) {
+				time_pt = time[cur.j];
+				code	= this->code[cur.j];
+
+				return true;
+			}
+
+			time_pt = cur.time;
+			code	= as_index ? packed_index(cur.j) : code_dict[packed_index(cur.j)];
+
+			if (cur.j > cur.first) {
+				uint64_t start = cur.pos - 1;
+
+				while (start > 0 && time_bytes[start - 1] >= 0x80)
+					start--;
+
+				cur.time -= (TimePoint) read_varint(start);
+				cur.pos	  = start;
+			}
+
+			return true;
+		}
+
+
+		/** \brief Return the state before the cursor (a run of events with the same code) and move the cursor before it.
+
+			This walks the clip as if collapse_to_states() had been called, without modifying it. The time of a state is the time of
+			the first event of the run.
+
+			\param cur		A ClipCursor initialized by last_event().
+			\param time_pt	The time of the first event of the run.
+			\param code	The code of the run.
+			\param from	The first time of the events considered, when walking a time window, the run stops there.
+			\param as_index	Return the index of the code in code_dict instead, as prev_event() does.
+
+			\return	False (and nothing is returned) if the cursor is already at the beginning of the clip.
+		*/
+		inline bool prev_state(ClipCursor &cur, TimePoint &time_pt, uint64_t &code, TimePoint from = INT64_MIN,
+							   bool as_index = false) const {
+			if (!prev_event(cur, time_pt, code, as_index))
+				return false;
+
+			ClipCursor peek = cur;
+			TimePoint  peek_time;
+			uint64_t   peek_code;
+
+			while (prev_event(peek, peek_time, peek_code, as_index) && peek_code == code && peek_time >= from) {
+				time_pt = peek_time;
+				cur		= peek;
+			}
+
+			return true;
+		}
+
+
+		/** \brief Return the clip of a client as a Clip.
+
+			\param ix	The index of the client (In range 0..size() - 1).
+		*/
+		inline Clip clip(uint64_t ix) const {
+			Clip ret = {};
+
+			ClipCursor cur;
+			TimePoint  time_pt;
+			uint64_t   code;
+
+			last_event(ix, cur);
+
+			while (prev_event(cur, time_pt, code))
+				ret[time_pt] = code;
+
+			return ret;
+		}
+
+		void build(const ClipMap &clip_map, bool compress = false, const CodeDict *p_ids = nullptr);
+		void build(const ClipEvent *p_event, uint64_t n, bool compress = false, const CodeDict *p_ids = nullptr);	///< From events sorted by (client, time), without repeated pairs
+		void to_clip_map(ClipMap &clip_map) const;
+		void collapse_to_states();
+		void save_clips(pBinaryImage &p_bi);
+		void clear();
+		uint64_t memory_size() const;
+
+		ClientIDs  client = {};			///< The hashes of the clients in increasing order.
+		ClipCodes  offset = {};			///< The start of each clip (as an event index) plus the total number of events at the end.
+		TimePoints time	  = {};			///< The times of all the events, clip after clip. (Raw layout only.)
+		ClipCodes  code	  = {};			///< The codes of all the events, clip after clip. (Raw layout only.)
+
+		bool	   compressed  = false;	///< The object uses the compressed layout.
+		ClipCodes  code_dict   = {};	///< The different codes (or the Events ids) in increasing order. (Compressed layout only.)
+		int		   code_bits   = 1;		///< The number of bits of an index in code_dict. (Compressed layout only.)
+		ClipCodes  packed_code = {};	///< The indices in code_dict of all the events, bit-packed. (Compressed layout only.)
+		ClipBytes  time_bytes  = {};	///< The varints of the times of all the clips. (Compressed layout only.)
+		ClipCodes  time_offset = {};	///< The start of each clip in time_bytes plus its size at the end. (Compressed layout only.)
+		TimePoints last_time   = {};	///< The time of the last event of each clip. (Compressed layout only.)
+
+#ifndef TEST
+	private:
+#endif
+
+		/// Read the varint starting at pos in time_bytes.
+		inline uint64_t read_varint(uint64_t pos) const {
+			uint64_t ret = 0;
+
+			for (int shift = 0; ; shift += 7) {
+				uint8_t b = time_bytes[pos++];
+
+				ret |= ((uint64_t) (b & 0x7f)) << shift;
+
+				if (b < 0x80)
+					return ret;
+			}
+		}
+
+		/// Read the index in code_dict of the j-th event from packed_code.
+		inline uint64_t packed_index(uint64_t j) const {
+			uint64_t bit = j*code_bits, word = bit >> 6;
+			int		 sh	 = bit & 63;
+
+			uint64_t ret = packed_code[word] >> sh;
+
+			if (sh + code_bits > 64)
+				ret |= packed_code[word + 1] << (64 - sh);
+
+			return code_bits == 64 ? ret : ret & ((1ull << code_bits) - 1);
+		}
+
+		void clip_events(uint64_t ix, TimePoints &times, ClipCodes &codes) const;	///< Copy a clip into arrays in increasing order of time
+		void push_varint(uint64_t value);										///< Append a varint to time_bytes
+		void start_build(uint64_t num_clips, uint64_t num_events, CodeIdMap &clip_codes, const CodeDict *p_ids, bool compress);	///< Clear and reserve (and set the code_dict)
+		void push_clip(ElementHash hash, const TimePoint *p_time, const uint64_t *p_code, uint64_t n);	///< Append a clip
+};
+
+typedef FrozenClips * pFrozenClips;		///< Pointer to a FrozenClips
+
+
+/** \brief ClipsView: The events of a Clips object in a time window [from, to), without copying them.
+
+	Returned by Clips::as_of() and Clips::between() and accepted by Targets, this makes a Targets fitted or predicting from it behave as
+	if the Clips had been built only from the rows in the window. Clients without events in the window are skipped by fit() and get
+	the prediction of the empty clip.
+*/
+struct ClipsView {
+	pClipMap	 p_clips;		///< The raw_clip_map() of the Clips
+	pFrozenClips p_frozen;		///< The frozen_clips() of the Clips
+	TimePoint	 from;			///< The first time in the window
+	TimePoint	 to;			///< The first time after the window
+};
+
+
+/** \brief A common ancestor of Clips and Targets to avoid duplicating time management.
+*/
+class TimeUtil {
+
+	public:
+
+		TimeUtil() {}
+
+		char time_format[128] = "%Y-%m-%d %H:%M:%S";	///< Date and time format for insert_row() and define_event() (set via set_time_format())
+
+
+		/** \brief Convert time as a string to a TimePoint (using the object's time_format).
+
+			When the time_format is one of the layouts in TimeLayout and the string has all its fields zero-padded, it is parsed
+			directly with the date part cached for consecutive times of the same day. Anything else goes through strptime() and
+			timegm(), which give the same result for the strings the fast path accepts.
+
+			\param p_t	A string containing a valid date and time in the object's time_format.
+
+			\return	The TimePoint corresponding to that time or a negative value on error.
+		*/
+		inline TimePoint get_time(pChar p_t) {
+			return get_time(p_t, day_cache);
+		}
+
+
+		/** \brief Convert time as a string to a TimePoint using a DayCache owned by the caller, for calls from many threads.
+
+			\param p_t		A string containing a valid date and time in the object's time_format.
+			\param cache	A DayCache only used by the calling thread.
+
+			\return	The TimePoint corresponding to that time or a negative value on error.
+		*/
+		inline TimePoint get_time(pChar p_t, DayCache &cache) const {
+
+			TimePoint time_pt;
+
+			if (time_layout != tl_strptime && parse_fixed_time(p_t, cache, time_pt))
+				return time_pt;
+
+			TimeStruct ts = {0};
+
+			if (strptime(p_t, time_format, &ts) == nullptr)
+				return -1;
+
+			return timegm(&ts);
+		}
+
+
+		/** \brief Sets the public property time_format to simplify the python interface.
+
+			\param fmt The time format in standard calendar time format
+					   http://www.gnu.org/software/libc/manual/html_node/Formatting-Calendar-Time.html
+		*/
+		inline void set_time_format(pChar fmt) {
+			strncpy(time_format, fmt, sizeof(time_format) - 1);
+
+			detect_time_layout();
+		}
+
+
+		/** \brief Set the TimeLayout matching time_format. (Must be called after time_format is modified other than by set_time_format().)
+		*/
+		inline void detect_time_layout() {
+			if		(strcmp(time_format, "%Y-%m-%d") == 0)			 time_layout = tl_date;
+			else if (strcmp(time_format, "%Y-%m-%d %H:%M:%S") == 0)	 time_layout = tl_date_time;
+			else if (strcmp(time_format, "%Y-%m-%dT%H:%M:%S") == 0)	 time_layout = tl_iso;
+			else if (strcmp(time_format, "%Y-%m-%dT%H:%M:%SZ") == 0) time_layout = tl_iso_z;
+			else													 time_layout = tl_strptime;
+		}
+
+
+		/** \brief The number of days from 1970-01-01 to a date in the proleptic Gregorian calendar.
+
+			Days beyond the end of the month (like Feb 31) overflow into the next month, the same as in timegm().
+
+			\param year	The year.
+			\param month	The month in [1, 12].
+			\param day		The day in [1, 31].
+
+			\return	The number of days, negative before 1970.
+		*/
+		static inline int64_t days_from_civil(int64_t year, int month, int day) {
+
+			year -= month <= 2;
+
+			int64_t era = (year >= 0 ? year : year - 399)/400;
+			int64_t yoe = year - era*400;
+			int64_t doy = (153*(month > 2 ? month - 3 : month + 9) + 2)/5 + day - 1;
+
+			return era*146097 + yoe*365 + yoe/4 - yoe/100 + doy - 719468;
+		}
+
+#ifndef TEST
+	private:
+#endif
+
+		TimeLayout time_layout	= tl_date_time;	///< The layout of time_format, set by detect_time_layout()
+		DayCache   day_cache	= {};			///< The DayCache of get_time() without a cache argument
+
+		/** \brief Parse a time in the fixed layout time_layout checking every character at its offset.
+
+			The checks stop at the first mismatch, so nothing is read beyond the end of a short string. The ranges are those
+			accepted by strptime(), anything not matching returns false to be parsed by strptime().
+
+			\param p_t		A string containing a date and time.
+			\param cache	The DayCache of the last date parsed.
+			\param time_pt	The parsed TimePoint.
+
+			\return	True if the string matches the layout.
+		*/
+		inline bool parse_fixed_time(pChar p_t, DayCache &cache, TimePoint &time_pt) const {
+
+			for (int i = 0; i < 10; i++)
+				if ((i == 4 || i == 7) ? p_t[i] != '-' : (uint8_t) (p_t[i] - '0') > 9)
+					return false;
+
+			if (memcmp(p_t, cache.key, sizeof(cache.key)) != 0) {
+				int year  = 1000*(p_t[0] - '0') + 100*(p_t[1] - '0') + 10*(p_t[2] - '0') + p_t[3] - '0';
+				int month = 10*(p_t[5] - '0') + p_t[6] - '0';
+				int day	  = 10*(p_t[8] - '0') + p_t[9] - '0';
+
+				if (month < 1 || month > 12 || day < 1 || day > 31)
+					return false;
+
+				cache.time = 86400*days_from_civil(year, month, day);
+
+				memcpy(cache.key, p_t, sizeof(cache.key));
+			}
+
+			if (time_layout == tl_date) {
+				time_pt = cache.time;
+
+				return true;
+			}
+
+			if (p_t[10] != (time_layout == tl_date_time ? ' ' : 'T'))
+				return false;
+
+			for (int i = 11; i < 19; i++)
+				if ((i == 13 || i == 16) ? p_t[i] != ':' : (uint8_t) (p_t[i] - '0') > 9)
+					return false;
+
+			if (time_layout == tl_iso_z && p_t[19] != 'Z')
+				return false;
+
+			int hour = 10*(p_t[11] - '0') + p_t[12] - '0';
+			int min	 = 10*(p_t[14] - '0') + p_t[15] - '0';
+			int sec	 = 10*(p_t[17] - '0') + p_t[18] - '0';
+
+			if (hour > 23 || min > 59 || sec > 61)
+				return false;
+
+			time_pt = cache.time + 3600*hour + 60*min + sec;
+
+			return true;
+		}
+};
+
+
+/** \brief A container class to hold clips (sequences of events).
+
+	To simplify the Python interface, the object has a set_time_format() method.
+*/
+class Clips : public TimeUtil {
+
+	public:
+
+		/** \brief Default construct a Clips object as an abstract method.
+			This is required for declaring a Clips object that will later be copy constructed based on conditional statements.
+		*/
+		Clips() {}
+
+
+		/** \brief Construct a Clips object from a Clients and an Events objects.
+
+			\param clients	The list of all the clients to be processed. If empty, all the clients will be considered.
+			\param events	An initialized Events object created either by auto-detection (insert_row) or definition (define_event).
+		*/
+		Clips(Clients clients, Events events) : clients(clients), events(events) {
+			this->events.freeze();
+
+			set_client_filter(true);
+		}
+
+
+		/** \brief Construct a Clips object from a ClipMap to be copied.
+
+			\param clip_map	The Clips object to be copied.
+		*/
+		Clips(const ClipMap &clip_map) {
+			clients = Clients();
+			events	= Events();
+
+			clips = clip_map;
+		}
+
+
+		/** \brief Copy-construct a Clips object.
+
+			\param o_clips	The Clips object to be copied.
+		*/
+		Clips(Clips &o_clips) {
+			use_client_filter = o_clips.use_client_filter;
+			history_length	  = o_clips.history_length;
+			history_seconds	  = o_clips.history_seconds;
+
+			pBinaryImage p_bi = new BinaryImage;
+
+			o_clips.save(p_bi);
+
+			load(p_bi);
+
+			delete p_bi;
+
+			if (o_clips.is_frozen())
+				freeze(o_clips.frozen_clips()->compressed);
+		}
+
+
+		/** \brief Keep only the most recent events of each clip (bounded history), to make memory proportional to the number of clients.
+
+			Targets::fit() only uses the last tree_depth events before the target and a prediction uses at most MAX_SEQ_LEN_IN_PREDICT
+			events, so, when the targets are after the retained events, there is no need to keep more than that. The oldest events are
+			evicted by insert_event() and the clips already in the object are trimmed when this is called. Since the limits are relative
+			to the most recent event of each clip, the result does not depend on the order in which the events arrive. The setting is not
+			serialized.
+
+			\param length	The maximum number of events per clip (0 for no limit).
+			\param seconds	The maximum time between an event and the most recent event of the same clip (0 for no limit).
+		*/
+		void set_history(uint64_t length, TimePoint seconds);
+
+
+		/** \brief Use (the default) or not a Bloom filter to reject the clients not in the Clients object in scan_event() faster.
+
+			The filter is built when the object is constructed or loaded with a non-empty Clients object. It is not serialized.
+
+			\param use	Build the filter if true, destroy it if false.
+		*/
+		inline void set_client_filter(bool use) {
+			use_client_filter = use;
+
+			if (use && clients.id_set.size() > 0)
+				client_filter.build(clients.id);
+			else
+				client_filter.clear();
+		}
+
+
+		/** \brief Process a row from a transaction file, to add the event to the client's timeline (clip).
+
+			\param p_e	The "emitter". A C/Python string representing "owner of event".
+			\param p_d	The "description". A C/Python string representing "the event".
+			\param w	The "weight". A double representing a weight of the event.
+			\param p_c	The "client". A C/Python string representing "the actor".
+			\param p_t	The "time". A timestamp of the event as a C/Python string. (The format is given via set_time_format().)
+
+			\return	 True on insertion. False usually just means, the event is not in events or the client is not in clients.
+					 Occasionally, it may be a time parsing error.
+		*/
+		bool scan_event(pChar p_e,
+						pChar p_d,
+						double w,
+						pChar p_c,
+						pChar p_t);
+
+
+		/** \brief Scan the rows of a transaction file held in memory from many threads, with the same result as scanning them in order.
+
+			The buffer is split into a range of whole rows per thread. The first range is scanned into this object and each of the
+			others into an empty Clips object with the same clients, events and time format, which are then merged in range order.
+			So, as in a single-threaded scan, a row replaces an earlier row of the same client at the same time.
+
+			\param p_buf		The rows, each one "emitter\tdescription\tweight\tclient\ttime\n". The last row must end with '\n'. The
+								fields are cut in place (the separators are overwritten with zeros). Rows without five fields are skipped.
+			\param size			The size of the buffer in bytes.
+			\param num_threads	The number of threads.
+		*/
+		void scan_rows(char *p_buf, uint64_t size, int num_threads);
+
+
+		/** \brief The kernel of a scan_event() made inline, when all checks and conversion to binary are successful.
+
+			\param client_hash	The "client". Already verified for insertion and converted into hash.
+			\param code			The code number identifying the event already found in events.
+			\param time_pt		The "time" already verified and converted into a TimePoint.
+
+		*/
+		inline void insert_event(ElementHash client_hash,
+								 uint64_t	 code,
+								 TimePoint	 time_pt) {
+
+			if (bulk_mode) {
+				push_bulk(bulk_events, ClipEvent {client_hash, time_pt, code});
+
+				return;
+			}
+
+			if (shards.size() > 0) {
+				ClipShard &shard = shards[client_hash >> shard_shift];
+
+				std::lock_guard<std::mutex> guard(shard.lock);
+
+				Clip &clip = shard.clips[client_hash];
+
+				clip[time_pt] = code;
+
+				if (history_length > 0 || history_seconds > 0)
+					trim_clip(clip);
+
+				return;
+			}
+
+			if (frozen.is_frozen())
+				thaw();
+
+			Clip *p_clip = clip_index.find(client_hash);
+
+			if (p_clip == nullptr) {
+				p_clip = &clips[client_hash];
+
+				clip_index.insert(client_hash, p_clip);
+			}
+
+			(*p_clip)[time_pt] = code;
+
+			if (history_length > 0 || history_seconds > 0)
+				trim_clip(*p_clip);
+		};
+
+
+		/** \brief Load the state of an object from a base64 mercury-dynamics serialization using image_get()
+
+			\param p_bi The address of a BinaryImage stream containing a previously save()-ed image at the cursor position.
+
+			\return	 True on success (Most likely error is a wrong stream).
+		*/
+		bool load(pBinaryImage &p_bi);
+
+
+		/** \brief Save the state of an object into a base64 mercury-dynamics serialization using image_put()
+
+			\param p_bi		 The address of a BinaryImage stream that is either empty or has been used only for writing.
+			\param with_clips If false, the clips are not saved and the image loads as an empty Clips object with the same clients,
+							 events and time format.
+
+			\return	 True on success (Most likely error is allocation).
+		*/
+		bool save(pBinaryImage &p_bi, bool with_clips = true);
+
+
+		/** \brief Add the clips of another Clips object, built over a disjoint slice of the same transactions, to this one.
+
+			The events of a client in both objects are merged in time order. An event of the other object at the same time as an
+			event of this one replaces it, the same as if the other object's rows had been scanned after this object's rows. Both
+			objects must have been built with the same Events (codes) and this object is thawed if frozen.
+
+			\param other	Another Clips object. (It is not modified, except for ending its concurrent or bulk mode.)
+
+			\return	 True on success. It fails if the objects are the same or their clients use different hash functions.
+		*/
+		bool merge(Clips &other);
+
+
+		/** \brief Write all the clips as columns in a single pass, a bulk alternative to iterating the clients one by one.
 
-			\param p_bi The address of a BinaryImage stream that is either empty or has been used only for writing.
+			A frozen object (raw layout) is already stored as these columns and is copied as whole blocks.
 
-			\return	 True on success (Most likely error is allocation).
+			\param cols	The ClipColumns with arrays of the sizes given by num_clips() and num_events().
 		*/
-		bool save(pBinaryImage &p_bi);
+		void export_columns(ClipColumns &cols);
 
-		ClientIDs	id	   = {};	///< The vector containing client ids as hashes in the order of definition.
-		ClientIDSet id_set = {};	///< The set of the same hashes for fast search.
-};
 
+		/** \brief Convert the internal ClipMap into a FrozenClips, when no more events will be inserted, to save memory.
 
-/** \brief A common ancestor of Clips and Targets to avoid duplicating time management.
-*/
-class TimeUtil {
+			The methods num_events(), collapse_to_states() and save() and a Targets object built from the Clips work directly on the
+			frozen layout. Inserting events or calling clip_map() thaws the object back to a ClipMap.
 
-	public:
+			\param compress  Store the times as varint deltas and the codes as bit-packed indices (see FrozenClips).
+		*/
+		void freeze(bool compress = false);
 
-		TimeUtil() {}
 
-		char time_format[128] = "%Y-%m-%d %H:%M:%S";	///< Date and time format for insert_row() and define_event()
+		/** \brief Convert a frozen object back to a ClipMap. (Nothing is done if the object is not frozen.)
+		*/
+		void thaw();
 
 
-		/** \brief Convert time as a string to a TimePoint (using the object's time_format).
+		/** \brief Check if the object is frozen.
+		*/
+		inline bool is_frozen() {
+			return frozen.is_frozen();
+		}
 
-			\param p_t	A string containing a valid date and time in the object's time_format.
 
-			\return	The TimePoint corresponding to that time or a negative value on error.
-		*/
-		inline TimePoint get_time(pChar p_t) {
+		/** \brief Split the ClipMap into shards, so that scan_event() and insert_event() can be called from many threads at once.
 
-			TimeStruct ts = {0};
+			Each shard has its own lock, so threads inserting the events of different shards do not wait for each other. Any other
+			method (including num_events(), clip_map(), freeze() or save()) calls end_concurrent() first, so they must only be
+			called after all the threads inserting events have finished. When two threads insert events of the same client at the
+			same time, the one kept is the one inserted last, which depends on the timing of the threads. Use scan_rows() (or a
+			Clips object per thread joined with merge()) to keep the order of the rows.
 
-			if (strptime(p_t, time_format, &ts) == nullptr)
-				return -1;
+			\param num_shards	The number of shards (rounded up to a power of two in [2, MAX_CLIP_SHARDS]). A few times the number
+								of threads is enough to make the waits negligible.
+		*/
+		void begin_concurrent(int num_shards);
 
-			return timegm(&ts);
-		}
 
+		/** \brief Join the shards back into the ClipMap. (Nothing is done if the object is not in concurrent mode.)
+		*/
+		void end_concurrent();
 
-		/** \brief Sets the public property time_format to simplify the python interface.
 
-			\param fmt The time format in standard calendar time format
-					   http://www.gnu.org/software/libc/manual/html_node/Formatting-Calendar-Time.html
+		/** \brief Check if the object is in concurrent mode.
 		*/
-		inline void set_time_format(pChar fmt) {
-			strncpy(time_format, fmt, sizeof(time_format) - 1);
+		inline bool is_concurrent() {
+			return shards.size() > 0;
 		}
-};
 
 
-/** \brief A container class to hold clips (sequences of events).
+		/** \brief Make insert_event() (and scan_event()) append the events to a flat vector, to be sorted at once by end_bulk().
 
-	To simplify the Python interface, the object has a set_time_format() method.
-*/
-class Clips : public TimeUtil {
+			This replaces a map insertion per row by a sort, for batch jobs inserting many events at once. Like the concurrent mode,
+			any other method calls end_bulk() first.
 
-	public:
+			Memory bound: while in bulk mode, 24 bytes per inserted row (overwritten or duplicate rows included), allocated in chunks of
+			BULK_CHUNK_EVENTS rows, so at most one chunk (1.5 MB) is unused. end_bulk() counts the events of the clips already in the
+			object as rows, moving them (a clip at a time) out of the ClipMap or the frozen layout before sorting. The sort scatters the
+			chunks into one buffer of the exact size and frees them, peaking at 48 bytes per row. Then the resulting frozen layout (see
+			freeze()), which takes 16 bytes per event plus 16 per client (or about a third of that if compressed), is built next to the
+			24 bytes per row of that buffer. Therefore, the peak is 48 bytes per row plus one chunk, or 56 bytes per row in the worst
+			case of a raw layout whose clients all have a single event.
 
-		/** \brief Default construct a Clips object as an abstract method.
-			This is required for declaring a Clips object that will later be copy constructed based on conditional statements.
+			\param compress  Build the compressed frozen layout at end_bulk().
 		*/
-		Clips() {}
+		void begin_bulk(bool compress = false);
 
 
-		/** \brief Construct a Clips object from a Clients and an Events objects.
+		/** \brief Sort the events inserted since begin_bulk() and build the frozen layout from them in one sweep.
 
-			\param clients	The list of all the clients to be processed. If empty, all the clients will be considered.
-			\param events	An initialized Events object created either by auto-detection (insert_row) or definition (define_event).
+			The events are sorted by (client, time) with a radix partition by the top bits of the client hash into a second buffer,
+			followed by sorting the partitions from as many threads as cores. The sort is stable, so, as with a ClipMap, a row
+			replaces the row at the same client and time inserted before it. The clips already in the object are included and the
+			bounded history (see set_history()) is applied. Nothing is done if the object is not in bulk mode.
 		*/
-		Clips(Clients clients, Events events) : clients(clients), events(events) {}
-
+		void end_bulk();
 
-		/** \brief Construct a Clips object from a ClipMap to be copied.
 
-			\param clip_map	The Clips object to be copied.
+		/** \brief Check if the object is in bulk mode.
 		*/
-		Clips(const ClipMap &clip_map) {
-			clients = Clients();
-			events	= Events();
-
-			clips = clip_map;
+		inline bool is_bulk() {
+			return bulk_mode;
 		}
 
 
-		/** \brief Copy-construct a Clips object.
+		/** \brief The address of the internal ClipMap to be accessed from a Targets object.
 
-			\param o_clips	The Clips object to be copied.
+			\return	 The address. (If the object was frozen, it is thawed first.)
 		*/
-		Clips(Clips &o_clips) {
-			pBinaryImage p_bi = new BinaryImage;
+		inline pClipMap clip_map() {
+			end_ingestion();
 
-			o_clips.save(p_bi);
+			if (frozen.is_frozen())
+				thaw();
 
-			load(p_bi);
+			clip_index.clear();		// The caller may remove clips through the address.
 
-			delete p_bi;
+			return &clips;
 		}
 
 
-		/** \brief Process a row from a transaction file, to add the event to the client's timeline (clip).
-
-			\param p_e	The "emitter". A C/Python string representing "owner of event".
-			\param p_d	The "description". A C/Python string representing "the event".
-			\param w	The "weight". A double representing a weight of the event.
-			\param p_c	The "client". A C/Python string representing "the actor".
-			\param p_t	The "time". A timestamp of the event as a C/Python string. (The format is given via set_time_format().)
+		/** \brief The address of the internal ClipMap without thawing the object, for a Targets object that also gets frozen_clips().
 
-			\return	 True on insertion. False usually just means, the event is not in events or the client is not in clients.
-					 Occasionally, it may be a time parsing error.
+			\return	 The address. (The ClipMap is empty while the object is frozen.)
 		*/
-		bool scan_event(pChar p_e,
-						pChar p_d,
-						double w,
-						pChar p_c,
-						pChar p_t);
+		inline pClipMap raw_clip_map() {
+			end_ingestion();
 
+			clip_index.clear();		// The caller may remove clips through the address.
 
-		/** \brief The kernel of a scan_event() made inline, when all checks and conversion to binary are successful.
+			return &clips;
+		}
 
-			\param client_hash	The "client". Already verified for insertion and converted into hash.
-			\param code			The code number identifying the event already found in events.
-			\param time_pt		The "time" already verified and converted into a TimePoint.
 
-		*/
-		inline void insert_event(ElementHash client_hash,
-								 uint64_t	 code,
-								 TimePoint	 time_pt) {
+		/** \brief The address of the internal FrozenClips, valid even if the object is thawed later.
 
-			ClipMap::iterator it = clips.find(client_hash);
+			\return	 The address. (If the object is not frozen, it is empty and is_frozen() is false.)
+		*/
+		inline pFrozenClips frozen_clips() {
+			return &frozen;
+		}
 
-			if (it == clips.end()) {
-				Clip clip = {};
 
-				clip[time_pt] = code;
+		/** \brief A view of the events before a time, for backtesting without rebuilding the object.
 
-				clips[client_hash] = clip;
+			\param to	The first time not included in the view.
 
-			} else
-				it->second[time_pt] = code;
-		};
+			\return	 The ClipsView. (It is valid while this object is neither modified nor thawed or frozen.)
+		*/
+		inline ClipsView as_of(TimePoint to) {
+			return between(INT64_MIN, to);
+		}
 
 
-		/** \brief Load the state of an object from a base64 mercury-dynamics serialization using image_get()
+		/** \brief A view of the events in a time window [from, to), for backtesting without rebuilding the object.
 
-			\param p_bi The address of a BinaryImage stream containing a previously save()-ed image at the cursor position.
+			\param from	The first time included in the view.
+			\param to		The first time not included in the view.
 
-			\return	 True on success (Most likely error is a wrong stream).
+			\return	 The ClipsView. (It is valid while this object is neither modified nor thawed or frozen.)
 		*/
-		bool load(pBinaryImage &p_bi);
-
+		inline ClipsView between(TimePoint from, TimePoint to) {
+			ClipsView view = {raw_clip_map(), &frozen, from, to};
 
-		/** \brief Save the state of an object into a base64 mercury-dynamics serialization using image_put()
+			return view;
+		}
 
-			\param p_bi The address of a BinaryImage stream that is either empty or has been used only for writing.
 
-			\return	 True on success (Most likely error is allocation).
+		/** \brief Return the number of clips (clients) in the object.
 		*/
-		bool save(pBinaryImage &p_bi);
+		inline uint64_t num_clips() {
+			end_ingestion();
 
+			return frozen.is_frozen() ? frozen.size() : clips.size();
+		}
 
-		/** \brief The address of the internal ClipMap to be accessed from a Targets object.
 
-			\return	 The address.
+		/** \brief The HashFunction of the client IDs (the keys of the ClipMap).
+
+			\return	 The hash_function of the internal Clients object.
 		*/
-		inline pClipMap clip_map() {
-			return &clips;
+		inline HashFunction client_hash_function() {
+			return clients.hash_function;
 		}
 
 
@@ -934,6 +2686,11 @@ class Clips : public TimeUtil {
 		*/
 		inline uint64_t num_events() {
 
+			end_ingestion();
+
+			if (frozen.is_frozen())
+				return frozen.num_events();
+
 			uint64_t ret = 0;
 
 			for (ClipMap::iterator it = clips.begin(); it != clips.end(); ++it)
@@ -947,6 +2704,14 @@ class Clips : public TimeUtil {
 			This removes identical consecutive codes from all the clips in the ClipMap keeping the time of the first instance.
 		*/
 		inline void collapse_to_states() {
+			end_ingestion();
+
+			if (frozen.is_frozen()) {
+				frozen.collapse_to_states();
+
+				return;
+			}
+
 			for (ClipMap::iterator it_client = clips.begin(); it_client != clips.end(); ++it_client) {
 				uint64_t last_code = 0xA30BdefacedCabal;
 				for (Clip::const_iterator it = it_client->second.cbegin(); it != it_client->second.cend();) {
@@ -964,9 +2729,52 @@ class Clips : public TimeUtil {
 	private:
 #endif
 
-		Clients clients;
-		Events	events;
-		ClipMap	clips	= {};
+		Clients		 clients;
+		Events		 events;
+		ClipMap		 clips			   = {};
+		FrozenClips	 frozen			   = {};
+		ClientFilter client_filter	   = {};
+		bool		 use_client_filter = true;
+		ClipShards	 shards			   = {};	///< The ClipMap split for concurrent insertion (empty if not concurrent)
+		int			 shard_shift	   = 64;	///< The client hash right shift giving the index of its shard
+		uint64_t	 history_length	   = 0;		///< The maximum number of events per clip (0 is no limit)
+		TimePoint	 history_seconds   = 0;		///< The maximum age of an event relative to the last of its clip (0 is no limit)
+		ClipIndex	 clip_index		   = {};	///< The clips of the clients inserted by insert_event() since the ClipMap last lost nodes
+		bool		 bulk_mode		   = false;	///< insert_event() appends to bulk_events
+		bool		 bulk_compress	   = false;	///< end_bulk() builds the compressed frozen layout
+		ClipEventChunks bulk_events	   = {};	///< The events inserted in bulk mode in order of arrival
+
+		/// End both the concurrent and the bulk mode before any access to the clips.
+		inline void end_ingestion() {
+			end_concurrent();
+			end_bulk();
+		}
+
+		/// Append an event to the last chunk, starting a new one of BULK_CHUNK_EVENTS reserved events when it is full.
+		static inline void push_bulk(ClipEventChunks &chunks, const ClipEvent &event) {
+			if (chunks.size() == 0 || chunks.back().size() == BULK_CHUNK_EVENTS) {
+				chunks.push_back(ClipEvents());
+				chunks.back().reserve(BULK_CHUNK_EVENTS);
+			}
+			chunks.back().push_back(event);
+		}
+
+		/// Sort the chunks into rows by (client, time) keeping the order of arrival of equal pairs. The chunks are freed.
+		void sort_bulk(ClipEventChunks &chunks, ClipEvents &rows, uint64_t num_threads);
+
+		/// Evict the events of a clip exceeding history_length or history_seconds.
+		inline void trim_clip(Clip &clip) {
+			if (history_seconds > 0)
+				clip.erase(clip.begin(), clip.lower_bound(clip.rbegin()->first - history_seconds));
+
+			if (history_length > 0 && clip.size() > history_length) {
+				Clip::iterator it = clip.begin();
+
+				std::advance(it, clip.size() - history_length);
+
+				clip.erase(clip.begin(), it);
+			}
+		}
 };
 
 
@@ -981,13 +2789,37 @@ class Targets	: public TimeUtil {
 
 			\param p_clips	The address of a Clips object initialized with the clips of a set of clients.
 			\param target	A TargetMap with the even times for a subset of the same clients (those who experienced the target).
+			\param p_frozen	Optionally, the frozen_clips() of the same Clips object. When that Clips is frozen, the Targets works
+							directly on the frozen layout.
 		*/
-		Targets(pClipMap p_clips, TargetMap target) : p_clips(p_clips), target(target) {
+		Targets(pClipMap p_clips, TargetMap target, pFrozenClips p_frozen = nullptr) : p_clips(p_clips), target(target), p_frozen(p_frozen) {
 			CodeTreeNode root = {0, 0, 0, {}};
 			tree.push_back(root);
 		}
 
 
+		/** \brief Construct a Targets object from a time window of a Clips object and a TargetMap.
+
+			\param view	A ClipsView returned by Clips::as_of() or Clips::between(). fit(), predict(), predict(Clients) and save()
+							only see the events in the window.
+			\param target	A TargetMap with the even times for a subset of the same clients (those who experienced the target).
+		*/
+		Targets(const ClipsView &view, TargetMap target) : Targets(view.p_clips, target, view.p_frozen) {
+			set_window(view.from, view.to);
+		}
+
+
+		/** \brief Restrict the events of the clips seen by this object to a time window. (Must be called before fit().)
+
+			\param from	The first time included.
+			\param to		The first time not included.
+		*/
+		inline void set_window(TimePoint from, TimePoint to) {
+			window_from = from;
+			window_to	= to;
+		}
+
+
 		/** \brief Utility to fill the internal TargetMap target
 
 			The TargetMap can be initialized and given to the constructor, or an empty TargetMap can be given to the constructor ans
@@ -1001,6 +2833,37 @@ class Targets	: public TimeUtil {
 		bool insert_target(pChar p_c, pChar p_t);
 
 
+		/** \brief Select the function used to hash the client IDs. It must be the same used by the Clients object of the Clips.
+
+			\param hash_fn The HashFunction.
+
+			\return	 True on success, false if the object already contains targets.
+		*/
+		inline bool set_hash_function(HashFunction hash_fn) {
+			if (target.size() != 0)
+				return false;
+
+			hash_function = hash_fn;
+
+			return true;
+		}
+
+
+		/** \brief Make fit() and predict() read the event codes of the clips as indices in a CodeDict. (Must be called before fit().)
+
+			This lets a model be fitted to clips whose codes are dense ids (like those of Events::optimize_events()) with the codes given by
+			a dictionary, without copying the clips to rename them. The ids mapped to the same code are the same event for the model.
+
+			\param code_map	The code of each index. All the codes in the clips must be valid indices.
+		*/
+		inline void set_code_map(const CodeDict &code_map) {
+			mapped_id.resize(code_map.size());
+
+			for (uint64_t i = 0; i < code_map.size(); i++)
+				mapped_id[i] = code_id.insert(code_map[i]);
+		}
+
+
 		/** \brief Fit the prediction model
 
 			\param x_form	 A possible transformation of the times. (Currently "log" or "linear".)
@@ -1042,13 +2905,51 @@ class Targets	: public TimeUtil {
 
 		/** \brief Predict time to target for a set of clients whose clips are given in a ClipMap.
 
-			\param p_clips A ClipMap of clients and clips to be used in prediction.
+			\param p_clips	 A ClipMap of clients and clips to be used in prediction.
+			\param as_states Treat the events as states, like fit() does, walking the repeated ones as one.
+
+			Only the events in the window set by set_window() are used.
+
+			predict() cannot be called before fit() and can be called any number of times in all overloaded forms after that.
+
+			\return	 A vector with the times.
+		*/
+		TimesToTarget predict(pClipMap p_clips, bool as_states = false);
+
+
+		/** \brief Predict time to target for a set of clients whose clips are given in a FrozenClips.
+
+			\param p_frozen A FrozenClips of clients and clips to be used in prediction.
+
+			Only the events in the window set by set_window() are used.
 
 			predict() cannot be called before fit() and can be called any number of times in all overloaded forms after that.
 
 			\return	 A vector with the times.
 		*/
-		TimesToTarget predict(pClipMap p_clips);
+		TimesToTarget predict(pFrozenClips p_frozen);
+
+
+		/** \brief Predict time to target for the clients of a time window of a Clips object, as if it only had the events in the window.
+
+			\param view A ClipsView returned by Clips::as_of() or Clips::between().
+
+			predict() cannot be called before fit() and can be called any number of times in all overloaded forms after that.
+
+			\return	 A vector with the times, one per client in the Clips object (including those without events in the window).
+		*/
+		TimesToTarget predict(const ClipsView &view);
+
+
+		/** \brief Predict time to target for the clients of a Clips object, only seeing the events in the window given by set_window().
+
+			\param clips A Clips object (frozen or not).
+
+			\return	 A vector with the times, one per client in the Clips object.
+		*/
+		inline TimesToTarget predict(Clips &clips) {
+			return predict(clips.between(window_from, window_to));
+		}
 
 
 		/** \brief Predict time for a single Clip returning all kind of prediction related information.
@@ -1093,13 +2994,13 @@ class Targets	: public TimeUtil {
 		/** \brief Update (fit) the CodeTree inserting new nodes as necessary.
 
 			\param idx_parent The index of the parent node. For the first insertion, root == 0. For more, returned values of this.
-			\param code		  The node will be the child of the parent node whose code is this code.
+			\param id		  The node will be the child of the parent node whose code has this id (in the CodeIdMap).
 			\param target	  The target was matched in the clip or not.
 			\param time_d	  The time difference from the code to the target (when there is a target, must be 0 otherwise).
 
 			\return	The index of the current node.
 		*/
-		inline int update_node(int idx_parent, uint64_t code, bool target, ExtFloat time_d) {
+		inline int update_node(int idx_parent, uint32_t id, bool target, ExtFloat time_d) {
 
 			if (idx_parent == 0) {		// The root node contains the prediction of the zero-length clip.
 				tree[0].n_seen++;
@@ -1109,10 +3010,10 @@ class Targets	: public TimeUtil {
 				}
 			}
 
-			ChildIndex::iterator it = tree[idx_parent].child.find(code);
+			ChildIndex::iterator it = find_link(tree[idx_parent].child, id);
 
-			if (it != tree[idx_parent].child.end()) {
-				int idx = it->second;
+			if (it != tree[idx_parent].child.end() && it->id == id) {
+				int idx = it->idx;
 
 				tree[idx].n_seen++;
 				if (target) {
@@ -1123,13 +3024,17 @@ class Targets	: public TimeUtil {
 				return idx;
 			}
 
+			int pos = it - tree[idx_parent].child.begin();
+
 			CodeTreeNode node = {1, target, time_d, {}};
 
-			tree.push_back(node);
+			tree.push_back(node);	// (Invalidates it.)
 
 			int idx = tree.size() - 1;
 
-			tree[idx_parent].child[code] = idx;
+			ChildIndex &child = tree[idx_parent].child;
+
+			child.insert(child.begin() + pos, ChildLink {id, idx});
 
 			return idx;
 		}
@@ -1245,27 +3150,85 @@ class Targets	: public TimeUtil {
 
 		/** \brief Predict the time to target for a clip.
 
-			\param clip	A clip containing a sequence of event codes.
+			\param clip		A clip containing a sequence of event codes.
+			\param from		The first time of the events used.
+			\param to			The first time after the events used.
+			\param as_states	Walk the repeated events as one.
 
 			\return	The predicted time to the target event.
 		*/
-		inline double predict_clip(Clip clip) {
+		inline double predict_clip(const Clip &clip, TimePoint from = INT64_MIN, TimePoint to = INT64_MAX, bool as_states = false) {
 
 			int idx = 0, n = 0;
 
 			double t[MAX_SEQ_LEN_IN_PREDICT];
 
-			for (Clip::reverse_iterator it = clip.rbegin(); it != clip.rend(); it++) {
-				ChildIndex::iterator jt = tree[idx].child.find(it->second);
+			Clip::const_reverse_iterator it(to == INT64_MAX ? clip.end() : clip.lower_bound(to));
+
+			int64_t last_id = -1;
 
-				if (jt == tree[idx].child.end())
+			for (; it != clip.rend() && it->first >= from; it++) {
+				int64_t id = tree_id(it->second);
+
+				if (as_states && id >= 0 && id == last_id)
+					continue;
+
+				last_id = id;
+
+				if ((idx = child_of(idx, id)) < 0)
 					break;
 
-				idx = jt->second;
+				t[n++] = predict_time(tree[idx]);
+			}
+
+			return aggregate_times(t, n);
+		}
+
+
+		/** \brief Predict the time to target for a clip in a FrozenClips.
+
+			\param frozen	A FrozenClips.
+			\param ix		The index of the clip in it.
+			\param from	The first time of the events used.
+			\param to		The first time after the events used.
+
+			\return	The predicted time to the target event.
+		*/
+		inline double predict_clip(const FrozenClips &frozen, uint64_t ix, TimePoint from = INT64_MIN, TimePoint to = INT64_MAX) {
+
+			int idx = 0, n = 0;
+
+			double t[MAX_SEQ_LEN_IN_PREDICT];
+
+			ClipCursor cur;
+			TimePoint  time_pt;
+			uint64_t   code;
+
+			if (to == INT64_MAX)
+				frozen.last_event(ix, cur);
+			else
+				frozen.last_event_before(ix, to, cur);
+
+			while (frozen.prev_event(cur, time_pt, code) && time_pt >= from) {
+				if ((idx = child_of(idx, tree_id(code))) < 0)
+					break;
 
 				t[n++] = predict_time(tree[idx]);
 			}
 
+			return aggregate_times(t, n);
+		}
+
+
+		/** \brief Aggregate the predictions of the nodes matched by a clip.
+
+			\param t	The predicted times along the matched sequence, starting from the last event.
+			\param n	The length of the matched sequence.
+
+			\return	The predicted time to the target event.
+		*/
+		inline double aggregate_times(double *t, int n) {
+
 			if (n == 0)
 				return predict_time(tree[0]);
 
@@ -1288,17 +3251,78 @@ class Targets	: public TimeUtil {
 		}
 
 
-		/** \brief Recursive tree exploration updating a CodeInTreeStatMap map.
+		/** \brief Recursive tree exploration updating a CodeInTreeStats vector.
 
 			\param depth	  The recursion depth
 			\param idx		  The index of the current node
 			\param parent_idx The index of the parent node
-			\param code		  The current code
-			\param codes_stat The CodeInTreeStatMap being updated
+			\param id		  The id of the current code
+			\param codes_stat The CodeInTreeStats being updated, indexed by the ids of tree_id() (with num_codes() elements)
 
 			\return	False on error.
 		*/
-		bool recurse_tree_stats(int depth, int idx, int parent_idx, uint64_t code, CodeInTreeStatMap &codes_stat);
+		bool recurse_tree_stats(int depth, int idx, int parent_idx, uint32_t id, CodeInTreeStats &codes_stat);
+
+
+		/** \brief The number of different codes in the tree (the ids of tree_id() are smaller than this).
+
+			\return	The number of codes.
+		*/
+		inline int num_codes() {
+			return code_id.size();
+		}
+
+
+		/** \brief The id a code has in the tree. (An index in the CodeDict given to set_code_map() if it was called.)
+
+			\param code	The event code.
+
+			\return	The id or -1 if the code is not in the tree.
+		*/
+		inline int64_t tree_id(uint64_t code) {
+			if (mapped_id.size() > 0)
+				return code < mapped_id.size() ? mapped_id[code] : -1;
+
+			return code_id.find(code);
+		}
+
+
+		/** \brief Find a child of a node by the id of its code.
+
+			\param idx	The index of the parent node.
+			\param id		The id returned by tree_id().
+
+			\return	The index of the child or -1 if the node has no child for the id.
+		*/
+		inline int child_of(int idx, int64_t id) {
+			if (id < 0)
+				return -1;
+
+			ChildIndex::iterator it = find_link(tree[idx].child, id);
+
+			return it != tree[idx].child.end() && it->id == id ? it->idx : -1;
+		}
+
+
+		/** \brief Find a child of a node by code.
+
+			\param idx	The index of the parent node.
+			\param code	The event code. (An index in the CodeDict given to set_code_map() if it was called.)
+
+			\return	The index of the child or -1 if the node has no child for the code.
+		*/
+		inline int tree_child(int idx, uint64_t code) {
+			return child_of(idx, tree_id(code));
+		}
+
+
+		/** \brief The codes of the children of a node.
+
+			\param idx	The index of the node.
+
+			\return	The codes sorted in increasing order.
+		*/
+		CodeDict child_codes(int idx);
 
 
 		/** \brief Return the size of the internal TargetMap.
@@ -1349,15 +3373,66 @@ class Targets	: public TimeUtil {
 	private:
 #endif
 
+		/// The first link of a ChildIndex whose id is not smaller than id (where a link for id is or should be inserted).
+		static inline ChildIndex::iterator find_link(ChildIndex &child, uint32_t id) {
+			return std::lower_bound(child.begin(), child.end(), ChildLink {id, 0});
+		}
+
+		/// The id of a code of the clips being fitted, adding it to the CodeIdMap if it is new.
+		inline uint32_t fit_id(uint64_t code) {
+			return mapped_id.size() > 0 ? mapped_id[code] : code_id.insert(code);
+		}
+
+		/// Fit the tree with one event of a clip (from last to first), return false when the sequence is complete.
+		inline bool fit_event(TimePoint target_time, TimePoint time_pt, uint32_t id, int &n, int &parent_idx, ExtFloat &time_d) {
+			if (target_time == 0) {
+				parent_idx = update_node(parent_idx, id, false, 0);
+
+				return ++n < tree_depth;
+			}
+
+			TimePoint elapsed_sec = target_time - time_pt;
+
+			if (elapsed_sec <= 0)
+				return true;
+
+			if (n == 0)
+				time_d = transform == tr_linear ? elapsed_sec : log(elapsed_sec);
+
+			parent_idx = update_node(parent_idx, id, true, time_d);
+
+			return ++n < tree_depth;
+		}
+
+		/// True if the Clips used to fit the model is frozen.
+		inline bool use_frozen() {
+			return p_frozen != nullptr && p_frozen->is_frozen();
+		}
+
+		/// Copy the events of a clip inside the window into a ClipMap (the clips left empty are not copied).
+		inline void window_clip(ElementHash client, const Clip &clip, ClipMap &window) {
+			Clip::const_iterator it_from = clip.lower_bound(window_from);
+			Clip::const_iterator it_to	 = window_to == INT64_MAX ? clip.end() : clip.lower_bound(window_to);
+
+			if (it_from != it_to)
+				window[client].insert(it_from, it_to);
+		}
+
 		pClipMap   p_clips;
 		TargetMap  target;
+		pFrozenClips p_frozen;
 		CodeTree   tree					= {};
+		CodeIdMap  code_id				= {};
+		std::vector<uint32_t> mapped_id	= {};
 		Transform  transform			= tr_undefined;
 		Aggregate  aggregate			= ag_undefined;
 		double	   binomial_z			= 0;
 		double	   binomial_z_sqr		= 0;
 		double	   binomial_z_sqr_div_2	= 0;
 		int		   tree_depth			= 0;
+		HashFunction hash_function		= hf_murmur;
+		TimePoint  window_from			= INT64_MIN;	///< The first time of the events seen by fit(), predict() and save()
+		TimePoint  window_to			= INT64_MAX;	///< The first time after the events seen by fit(), predict() and save()
 };
 
 } // namespace reels
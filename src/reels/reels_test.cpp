@@ -24,6 +24,7 @@
 #include <fstream>
 #include <sstream>
 #include <string.h>
+#include <chrono>
 
 #include "reels_test.h"
 
@@ -201,7 +202,8 @@ SCENARIO("Sizes/assumptions") {
 	REQUIRE(sizeof(BinEventPt) == 24);
 	REQUIRE(sizeof(BinTransaction) == 40);
 	REQUIRE(sizeof(EventStat) == 24);
-	REQUIRE(sizeof(CodeTreeNode) == 72);
+	REQUIRE(sizeof(CodeTreeNode) == 48);
+	REQUIRE(sizeof(ChildLink) == 8);
 }
 
 
@@ -270,6 +272,89 @@ SCENARIO("BinEventPt operators work as expected by map") {
 	REQUIRE(it == em.end());
 }
 
+
+SCENARIO("StringTable works as the map it replaces") {
+
+	StringTable st = {};
+
+	std::map<ElementHash, std::pair<uint64_t, String>> model = {};
+
+	char buffer[80];
+
+	REQUIRE(st.size() == 0);
+	REQUIRE(st.find(123) == -1);
+	REQUIRE(st.find(0) == -1);
+
+	for (int i = 0; i < 20000; i++) {
+		ElementHash hash = 1 + 64*((i*7919) % 3001);		// Many collisions in the low bits, long probe chains
+
+		sprintf(buffer, "string number %i", (int) hash);
+
+		if (i % 3 == 2) {
+			st.erase(hash, 2);
+
+			std::map<ElementHash, std::pair<uint64_t, String>>::iterator it = model.find(hash);
+
+			if (it != model.end()) {
+				if (it->second.first <= 2)
+					model.erase(it);
+				else
+					it->second.first -= 2;
+			}
+		} else {
+			st.add(hash, buffer, strlen(buffer), 1 + i % 2);
+
+			std::map<ElementHash, std::pair<uint64_t, String>>::iterator it = model.find(hash);
+
+			if (it != model.end())
+				it->second.first += 1 + i % 2;
+			else
+				model[hash] = std::make_pair((uint64_t) 1 + i % 2, String(buffer));
+		}
+
+		if (i % 4999 == 0) {
+			REQUIRE(st.size() == (int) model.size());
+
+			for (std::map<ElementHash, std::pair<uint64_t, String>>::iterator it = model.begin(); it != model.end(); ++it) {
+				int ix = st.find(it->first);
+
+				REQUIRE(ix >= 0);
+				REQUIRE(st.hash(ix) == it->first);
+				REQUIRE(st.seen(ix) == it->second.first);
+				REQUIRE(st.str(ix)	== it->second.second);
+			}
+		}
+	}
+
+	REQUIRE(st.size() == (int) model.size());
+
+	std::vector<int> sorted = st.sorted_slots();
+
+	REQUIRE(sorted.size() == model.size()); {
+		std::map<ElementHash, std::pair<uint64_t, String>>::iterator it = model.begin();
+
+		for (int i = 0; i < (int) sorted.size(); i++, ++it) {
+			REQUIRE(st.hash(sorted[i]) == it->first);
+			REQUIRE(st.str(sorted[i])  == it->second.second);
+		}
+	}
+
+	uint64_t arena_size = 0;
+
+	for (std::map<ElementHash, std::pair<uint64_t, String>>::iterator it = model.begin(); it != model.end(); ++it)
+		arena_size += it->second.second.length();
+
+	REQUIRE(st.arena.size() == arena_size + st.garbage);
+	REQUIRE((st.garbage <= 4096 || 2*st.garbage <= st.arena.size()));
+
+	for (std::map<ElementHash, std::pair<uint64_t, String>>::iterator it = model.begin(); it != model.end(); ++it)
+		st.erase(it->first, it->second.first);
+
+	REQUIRE(st.size() == 0);
+	REQUIRE(st.arena.size() == 0);
+	REQUIRE(st.capacity() == 0);
+}
+
 // -----------------------------------------------------------------------------------------------------------------------------------------
 //	Header methods, various utils
 // -----------------------------------------------------------------------------------------------------------------------------------------
@@ -475,12 +560,22 @@ SCENARIO("Basic math") {
 extern int new_events();
 extern bool destroy_events(int id);
 extern bool events_insert_row(int id, char *p_e, char *p_d, double w);
+extern bool events_insert_row_count(int id, char *p_e, char *p_d, double w, int n);
 extern bool events_define_event(int id, char *p_e, char *p_d, double w, int code);
 extern char *events_describe_next_event(int id, char *prev_event);
 extern bool events_load_block(int id, char *p_block);
 extern int events_save(int id);
 extern bool events_set_max_num_events(int id, int max_events);
 extern bool events_set_store_strings(int id, bool store);
+extern bool events_set_discovery(int id, char *mode);
+extern bool events_merge(int id, int id_other);
+extern bool events_set_admission_filter(int id, int width, int depth);
+extern bool events_set_decay(int id, int half_life);
+extern bool events_decay_events(int id);
+extern bool events_set_sample_rate(int id, double rate);
+extern char *events_estimate_count(int id, char *p_e, char *p_d, double w);
+extern bool events_export_columns(int id, String &raw);
+extern bool events_set_hash_function(int id, char *p_name);
 extern int events_num_events(int id);
 extern char *events_optimize_events(int id, int id_clips, int id_targets, int num_steps, int codes_per_step, double threshold,
 									char *force_include, char *force_exclude, char *x_form, char *agg, double p, int depth, int as_states,
@@ -490,6 +585,11 @@ extern int new_clients();
 extern bool destroy_clients(int id);
 extern char *clients_hash_client_id(int id, char *p_cli);
 extern bool clients_add_client_id(int id, char *p_cli);
+extern int64_t clients_add_client_hashes(int id, const uint64_t *p_hash, uint64_t n);
+extern int clients_hash_function(int id);
+extern void hash_client_ids(int hash_fn, char **p_cli, uint64_t *p_len, uint64_t n, uint64_t *p_hash);
+extern int	clients_load_client_ids(int id, char *p_path);
+extern bool clients_set_hash_function(int id, char *p_name);
 extern char *clients_hash_by_index(int id, int idx);
 extern int clients_num_clients(int id);
 extern bool clients_load_block(int id, char *p_block);
@@ -498,6 +598,12 @@ extern int clients_save(int id);
 extern int new_clips(int id_clients, int id_events);
 extern bool destroy_clips(int id);
 extern bool clips_set_time_format(int id, char *fmt);
+extern bool clips_set_client_filter(int id, bool use);
+extern bool clips_freeze(int id, bool compress);
+extern bool clips_begin_bulk(int id, bool compress);
+extern bool clips_end_bulk(int id);
+extern bool clips_merge(int id, int id_other);
+extern bool clips_set_history(int id, int length, int seconds);
 extern bool clips_scan_event(int id, char *p_e, char *p_d, double w, char *p_c, char *p_t);
 extern char *clips_hash_by_previous(int id, char *prev_hash);
 extern bool clips_load_block(int id, char *p_block);
@@ -505,11 +611,14 @@ extern int clips_save(int id);
 extern char *clips_describe_clip(int id, char *client_id);
 extern int clips_num_clips(int id);
 extern int clips_num_events(int id);
+extern void *clips_export_prepare(int id, uint64_t &n, uint64_t &m);
+extern void clips_export_columns(void *p_clips, char *p_raw, uint64_t n, uint64_t m);
 extern char *clips_test_sequence(int seq_num, bool target);
 
 extern int new_targets(int id_clips);
 extern bool destroy_targets(int id);
 extern bool targets_set_time_format(int id, char *fmt);
+extern bool targets_set_window(int id, char *since, char *until);
 extern bool targets_insert_target(int id, char *p_c, char *p_t);
 extern bool targets_fit(int id, char *x_form, char *agg, double p, int depth, int as_states);
 extern int targets_predict_clients(int id, int id_clients);
@@ -609,8 +718,9 @@ SCENARIO("Test Events") {
 				REQUIRE(ev_big_ins.priority.size() == 900);
 
 				int str_seen = 0;
-				for (StringUsageMap::iterator it = ev_big_ins.names_map.begin(); it != ev_big_ins.names_map.end(); ++it)
-					str_seen += it->second.seen;
+				for (int ix = 0; ix < ev_big_ins.names_map.capacity(); ix++)
+					if (ev_big_ins.names_map.used(ix))
+						str_seen += ev_big_ins.names_map.seen(ix);
 
 				REQUIRE(str_seen > 1000000);
 
@@ -858,18 +968,12 @@ SCENARIO("Test Events.save() / Events.load()") {
 				REQUIRE(ev_alt.next_code	    == cpy_alt.next_code);
 
 				REQUIRE(ev_alt.names_map.size() == cpy_alt.names_map.size()); {
-					StringUsageMap::iterator it1 = ev_alt.names_map.begin(), it2 = cpy_alt.names_map.begin();
-
-					for (int i = 0; i < 10; i++) {
-						if (it1 == ev_alt.names_map.end())
-							break;
+					std::vector<int> ix1 = ev_alt.names_map.sorted_slots(), ix2 = cpy_alt.names_map.sorted_slots();
 
-						REQUIRE(it1->first		 == it2->first);
-						REQUIRE(it1->second.seen == it2->second.seen);
-						REQUIRE(it1->second.str	 == it2->second.str);
-
-						++it1;
-						++it2;
+					for (int i = 0; i < (int) ix1.size(); i++) {
+						REQUIRE(ev_alt.names_map.hash(ix1[i]) == cpy_alt.names_map.hash(ix2[i]));
+						REQUIRE(ev_alt.names_map.seen(ix1[i]) == cpy_alt.names_map.seen(ix2[i]));
+						REQUIRE(ev_alt.names_map.str(ix1[i])  == cpy_alt.names_map.str(ix2[i]));
 					}
 				}
 
@@ -910,894 +1014,3539 @@ SCENARIO("Test Events.save() / Events.load()") {
 }
 
 
-SCENARIO("Test Clients") {
-
-	Clients cli = {};
+SCENARIO("Test Events.insert_row_count()") {
 
-	REQUIRE(cli.id.size() == 0);
-	REQUIRE(cli.id_set.size() == 0);
+	char emitter[80];
+	char description[80];
 
-	cli.add_client_id((char *) "");
+	GIVEN("Pairs of small Events objects in both discovery modes.") {
+		Events ev_row[2] = {}, ev_cnt[2] = {};
 
-	REQUIRE(cli.id.size() == 1);
-	REQUIRE(cli.id_set.size() == 1);
+		for (int m = 0; m < 2; m++) {
+			ev_row[m].set_max_num_events(7);
+			ev_cnt[m].set_max_num_events(7);
 
-	cli.add_client_id((char *) "client_a");
-	cli.add_client_id((char *) "client_b");
-	cli.add_client_id((char *) "client_c");
+			if (m == 1) {
+				REQUIRE(ev_row[m].set_discovery(ds_space_saving));
+				REQUIRE(ev_cnt[m].set_discovery(ds_space_saving));
+			}
+		}
 
-	REQUIRE(cli.id.size() == 4);
-	REQUIRE(cli.id_set.size() == 4);
+		WHEN("I insert the same aggregated stream row by row and as counts.") {
+			for (int i = 0; i < 800; i++) {
+				sprintf(emitter, "emi%i", (i*7) % 23);
+				sprintf(description, "prod%i", i % 3);
 
-	cli.add_client_id((char *) "");
+				double w = i % 5 ? 1.0 : 2.5;
+				int	   n = (i*13) % 6;
 
-	REQUIRE(cli.id.size() == 5);
-	REQUIRE(cli.id_set.size() == 4);
+				for (int m = 0; m < 2; m++) {
+					for (int j = 0; j < n; j++)
+						ev_row[m].insert_row(emitter, description, w);
 
-	ElementHash hash = MurmurHash64A((char *) "client_b", 8);
+					ev_cnt[m].insert_row_count(emitter, description, w, n);
+				}
+			}
 
-	REQUIRE(cli.id[2] == hash);
-	REQUIRE(cli.id_set.find(hash) != cli.id_set.end());
-}
+			THEN("The result is identical.") {
+				for (int m = 0; m < 2; m++) {
+					REQUIRE(ev_cnt[m].num_events() == 7);
+					REQUIRE(ev_cnt[m].num_events() == ev_row[m].num_events());
+					REQUIRE(ev_cnt[m].priority_low == ev_row[m].priority_low);
+					REQUIRE(ev_cnt[m].next_code == ev_row[m].next_code);
 
+					REQUIRE(ev_cnt[m].names_map.size() == ev_row[m].names_map.size()); {
+						std::vector<int> ix1 = ev_cnt[m].names_map.sorted_slots(), ix2 = ev_row[m].names_map.sorted_slots();
 
-SCENARIO("Test Clients.save() / Clients.load()") {
+						for (int i = 0; i < (int) ix1.size(); i++) {
+							REQUIRE(ev_cnt[m].names_map.hash(ix1[i]) == ev_row[m].names_map.hash(ix2[i]));
+							REQUIRE(ev_cnt[m].names_map.seen(ix1[i]) == ev_row[m].names_map.seen(ix2[i]));
+						}
+					}
 
-	GIVEN("I have two Clients objects.") {
-		Clients cli_def = {}, cli_alt = {};
+					EventMap::iterator it1 = ev_cnt[m].events_begin(), it2 = ev_row[m].events_begin();
 
-		char emitter[80];
+					for (; it1 != ev_cnt[m].events_end(); ++it1, ++it2) {
+						REQUIRE(it1->first			 == it2->first);
+						REQUIRE(it1->second.seen	 == it2->second.seen);
+						REQUIRE(it1->second.code	 == it2->second.code);
+						REQUIRE(it1->second.priority == it2->second.priority);
+					}
 
-		for (int i = 0; i < 250; i++) {
-			sprintf(emitter, "emi%i", (int) sqrt(i % 100));
+					REQUIRE(ev_cnt[m].priority == ev_row[m].priority);
+				}
 
-			cli_def.add_client_id(emitter);
+				for (int i = 0; i < (int) ev_cnt[1].ss_slot.size(); i++) {
+					REQUIRE(ev_cnt[1].ss_slot[i].ept	== ev_row[1].ss_slot[i].ept);
+					REQUIRE(ev_cnt[1].ss_slot[i].count	== ev_row[1].ss_slot[i].count);
+					REQUIRE(ev_cnt[1].ss_slot[i].error	== ev_row[1].ss_slot[i].error);
+				}
+			}
 		}
+	}
 
-		REQUIRE(cli_def.id.size()	  == 250);
-		REQUIRE(cli_def.id_set.size()  < 250);
-		REQUIRE(cli_def.id_set.size()  >   0);
-		REQUIRE(cli_alt.id.size()	  ==   0);
-		REQUIRE(cli_alt.id_set.size() ==   0);
+	GIVEN("The Python API.") {
+		int ev_id = new_events();
 
-		WHEN("I copy them.") {
-			Clients cpy_def = {}, cpy_alt = {};
+		REQUIRE(!events_insert_row_count(99999, (char *) "emi_1", (char *) "descr_1", 1.0, 5));
+		REQUIRE(!events_insert_row_count(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0, -5));
+		REQUIRE(events_insert_row_count(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0, 0));
+		REQUIRE(events_num_events(ev_id) == 0);
+		REQUIRE(events_insert_row_count(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0, 5));
+		REQUIRE(events_num_events(ev_id) == 1);
 
-			pBinaryImage p_def = new BinaryImage;
+		destroy_events(ev_id);
+	}
+}
 
-			REQUIRE(cli_def.save(p_def));
-			REQUIRE(cpy_def.load(p_def));
 
-			delete p_def;
+SCENARIO("Test Events Space-Saving discovery") {
 
-			pBinaryImage p_alt = new BinaryImage;
+	char emitter[80];
+	char description[80];
+	double w;
 
-			REQUIRE(cli_alt.save(p_alt));
-			REQUIRE(cpy_alt.load(p_alt));
+	GIVEN("A priority and a space_saving Events object large enough to hold everything.") {
+		Events ev_pri = {}, ev_ss = {};
 
-			delete p_alt;
+		REQUIRE(ev_ss.set_discovery(ds_space_saving));
 
-			THEN("They are identical.") {
-				REQUIRE(cpy_alt.id.size()	  ==   0);
-				REQUIRE(cpy_alt.id_set.size() ==   0);
+		for (int i = 0; i < 5000; i++) {
+			sprintf(emitter, "emi%i", (int) sqrt(i % 400));
+			sprintf(description, "prod%i", (i % 7) + 1);
+			w = i % 11 ? 1.3 : 4.2;
 
-				REQUIRE(cli_def.id.size()	  == cpy_def.id.size());
-				REQUIRE(cli_def.id_set.size() == cpy_def.id_set.size());
+			ev_pri.insert_row(emitter, description, w);
+			ev_ss.insert_row(emitter, description, w);
+		}
 
-				ClientIDSet::iterator it1 = cli_def.id_set.begin(), it2 = cpy_def.id_set.begin();
+		THEN("The result is identical.") {
+			REQUIRE(!ev_ss.set_discovery(ds_priority));
 
-				for (int i = 0; i < 10; i++) {
-					if (it1 == cli_def.id_set.end())
-						break;
+			REQUIRE(ev_ss.num_events() == ev_pri.num_events());
+			REQUIRE(ev_ss.priority_low == ev_pri.priority_low);
+			REQUIRE(ev_ss.next_code == ev_pri.next_code);
+			REQUIRE(ev_ss.names_map.size() == ev_pri.names_map.size());
 
-					REQUIRE(*it1 == *it2);
-					REQUIRE(cli_def.id[i] == cpy_def.id[i]);
-					REQUIRE(cpy_def.id_set.find(cli_def.id[i]) != cpy_def.id_set.end());
+			REQUIRE(ev_ss.event.size() == ev_pri.event.size()); {
+				EventMap::iterator it1 = ev_ss.event.begin(), it2 = ev_pri.event.begin();
 
-					++it1;
-					++it2;
+				for (; it1 != ev_ss.event.end(); ++it1, ++it2) {
+					REQUIRE(it1->first			 == it2->first);
+					REQUIRE(it1->second.seen	 == it2->second.seen);
+					REQUIRE(it1->second.code	 == it2->second.code);
+					REQUIRE(it1->second.priority == it2->second.priority);
+				}
+			}
+
+			REQUIRE(ev_ss.priority.size() == ev_pri.priority.size()); {
+				PriorityMap::iterator it1 = ev_ss.priority.begin(), it2 = ev_pri.priority.begin();
+
+				for (; it1 != ev_ss.priority.end(); ++it1, ++it2) {
+					REQUIRE(it1->first	== it2->first);
+					REQUIRE(it1->second == it2->second);
 				}
 			}
+
+			REQUIRE(!ev_ss.define_event((char *) "emi_A", (char *) "descr_A", 1, 'A'));
 		}
 	}
-}
 
+	GIVEN("A small space_saving Events object and a long tail stream.") {
+		Events ev_ss = {};
 
-SCENARIO("Test Clips") {
+		ev_ss.set_max_num_events(10);
+		REQUIRE(ev_ss.set_discovery(ds_space_saving));
 
-	GIVEN("I load a Clients, Events and a Clips object") {
-		Events events = {};
-		Clients clients = {};
+		EventCountMap true_count = {};
 
-		events.set_max_num_events(50);
+		int n_rows = 0;
 
-		for (int i = 0; i < 10000; i++) {
-			char emitter[80];
-			char description[80];
-			double w;
+		for (int i = 0; i < 6000; i++) {
+			if (i % 3 == 0)
+				sprintf(emitter, "heavy%i", i % 2);
+			else
+				sprintf(emitter, "tail%i", i);
 
-			if (i < 200) {
-				sprintf(emitter, "cli-id%i", 77*i);
-				clients.add_client_id(emitter);
+			sprintf(description, "prod");
+			w = 1;
+
+			ev_ss.insert_row(emitter, description, w);
+
+			BinEventPt ept = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A(description, strlen(description)), w};
+
+			true_count[ept]++;
+			n_rows++;
+		}
+
+		THEN("The Space-Saving guarantees hold.") {
+			REQUIRE(ev_ss.num_events() == 10);
+			REQUIRE(ev_ss.ss_slot.size() == 10);
+
+			uint64_t sum = 0;
+			CodeSet codes = {};
+
+			for (SummarySlots::iterator it = ev_ss.ss_slot.begin(); it != ev_ss.ss_slot.end(); ++it) {
+				uint64_t cnt = true_count[it->ept];
+
+				REQUIRE(it->count >= cnt);
+				REQUIRE(it->count - it->error <= cnt);
+
+				sum += it->count;
+				codes.insert(it->code);
 			}
+			REQUIRE(sum == (uint64_t) n_rows);
+			REQUIRE(codes.size() == 10);
 
-			sprintf(emitter, "emi%i", (int) sqrt(i % 100));
-			sprintf(description, "prod%i", (i % 5) + 1);
-			w = i % 11 ? 1.3 : 4.2;
+			for (int i = 0; i < 2; i++) {
+				sprintf(emitter, "heavy%i", i);
 
-			events.insert_row(emitter, description, w);
+				BinEventPt ept = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A("prod", 4), 1};
+
+				REQUIRE(ev_ss.event_code(ept) > 0);
+				REQUIRE(ev_ss.get_str(ept.e) == emitter);
+			}
+
+			REQUIRE(ev_ss.names_map.size() == 11);
 		}
 
-		REQUIRE(events.event.size() == 50);
-		REQUIRE(clients.id.size() == 200);
-		REQUIRE(clients.id_set.size() == 200);
+		WHEN("I copy it.") {
+			Events cpy_ss = {};
 
-		Clips clips(clients, events);
+			pBinaryImage p_ss = new BinaryImage;
 
-		WHEN("I feed the Clips with transactions from the same and other clients") {
+			REQUIRE(ev_ss.save(p_ss));
+			REQUIRE(cpy_ss.load(p_ss));
 
-			int i = 0;
-			for (int day = 10; day < 30; day++) {
-				for (int hour = 10; hour < 24; hour++) {
-					for (int min = 10; min < 60; min++) {
-						for (int sec = 10; sec < 60; sec++) {
-							char timestamp[80];
-							char client[80];
-							char emitter[80];
-							char description[80];
-							double w;
+			delete p_ss;
 
-							i++;
+			THEN("It is identical and keeps discovering identically.") {
+				REQUIRE(cpy_ss.discovery == ds_space_saving);
+				REQUIRE(cpy_ss.ss_slot.size() == ev_ss.ss_slot.size());
 
-							sprintf(timestamp, "2022-06-%i %i:%i:%i", day, hour, min, sec);
-							sprintf(client, "cli-id%i", 77*(i % 500));
-							sprintf(emitter, "emi%i", (int) sqrt(i % 200));
-							sprintf(description, "prod%i", (i % 9) + 1);
-							w = i % 11 ? 1.3 : 5.0;
+				for (int i = 0; i < 500; i++) {
+					sprintf(emitter, "more%i", i % 13);
+					sprintf(description, "prod");
 
-							clips.scan_event(emitter, description, w, client, timestamp);
-						}
-					}
+					ev_ss.insert_row(emitter, description, 1);
+					cpy_ss.insert_row(emitter, description, 1);
 				}
-			}
-			char timestamp[80] = {"2022-06-04 10:00:00"};
-			char client[80]	   = {"cli-id2541"};
-			String emitter	   = events.get_str(events.event.begin()->first.e);
-			String description = events.get_str(events.event.begin()->first.d);
-			double w		   = events.event.begin()->first.w;
 
-			REQUIRE( clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) client, (pChar) timestamp));
-			REQUIRE(!clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) "", (pChar) timestamp));
-			REQUIRE(!clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) "xx", (pChar) timestamp));
-			REQUIRE(!clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) client, (pChar) "xx"));
+				REQUIRE(cpy_ss.ss_dirty);
+				REQUIRE(cpy_ss.num_events() == ev_ss.num_events());
 
-			THEN("The ClipMap is as expected") {
-				REQUIRE(clips.clips.size() <= 200);
+				EventMap::iterator it1 = ev_ss.events_begin(), it2 = cpy_ss.events_begin();
+
+				for (; it1 != ev_ss.events_end(); ++it1, ++it2) {
+					REQUIRE(it1->first			 == it2->first);
+					REQUIRE(it1->second.seen	 == it2->second.seen);
+					REQUIRE(it1->second.code	 == it2->second.code);
+					REQUIRE(it1->second.priority == it2->second.priority);
+				}
 			}
 		}
 	}
-}
 
+	GIVEN("The Python API.") {
+		int ev_id = new_events();
 
-SCENARIO("Test Clips.save() / Clips.load()") {
+		REQUIRE(!events_set_discovery(ev_id, (char *) "bogus"));
+		REQUIRE(events_set_discovery(ev_id, (char *) "space_saving"));
+		REQUIRE(events_insert_row(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0));
+		REQUIRE(!events_set_discovery(ev_id, (char *) "priority"));
+		REQUIRE(events_num_events(ev_id) == 1);
+		REQUIRE(!events_set_discovery(99999, (char *) "priority"));
 
-	Events	ev = {};
-	Clients	cli = {};
+		destroy_events(ev_id);
+	}
+}
+
+
+SCENARIO("Test Events.merge()") {
 
-	char timestamp[80];
-	char client[80];
 	char emitter[80];
 	char description[80];
-	double w;
 
-	for (int i = 0; i < 5000; i++) {
-		sprintf(client, "cli-id%i", 77*(i % 500));
-		sprintf(emitter, "emi%i", (int) sqrt(i % 100));
-		sprintf(description, "prod%i", (i % 5) + 1);
+	GIVEN("A stream split in two priority Events objects large enough to hold everything.") {
+		Events ev_all = {}, ev_a = {}, ev_b = {};
 
-		w = i % 11 ? 1.3 : 5.0;
+		for (int i = 0; i < 4000; i++) {
+			sprintf(emitter, "emi%i", (int) sqrt(i % 300));
+			sprintf(description, "prod%i", (i % 5) + 1);
 
-		ev.insert_row(emitter, description, w);
-		cli.add_client_id(client);
-	}
+			ev_all.insert_row(emitter, description, 1);
 
-	Clips clp_def(cli, ev), clp_alt({}, {});
+			if (i % 2)
+				ev_a.insert_row(emitter, description, 1);
+			else
+				ev_b.insert_row(emitter, description, 1);
+		}
 
-	int i = 0;
-	for (int hour = 10; hour < 12; hour++) {
-		for (int min = 10; min < 60; min++) {
-			for (int sec = 10; sec < 60; sec++) {
-				i++;
+		REQUIRE(ev_a.num_events() < ev_all.num_events());
 
-				sprintf(timestamp, "2022-06-02 %i:%i:%i", hour, min, sec);
-				sprintf(client, "cli-id%i", 77*(i % 500));
-				sprintf(emitter, "emi%i", (int) sqrt(i % 100));
-				sprintf(description, "prod%i", (i % 5) + 1);
+		WHEN("I merge them.") {
+			EventMap code_a = ev_a.event;
 
-				w = i % 11 ? 1.3 : 5.0;
+			REQUIRE(ev_a.merge(ev_b));
 
-				clp_def.scan_event(emitter, description, w, client, timestamp);
-			}
-		}
-	}
+			THEN("The counts are the counts of the whole stream.") {
+				REQUIRE(ev_a.num_events() == ev_all.num_events());
+				REQUIRE(ev_a.priority.size() == ev_a.event.size());
+				REQUIRE(ev_a.names_map.size() == ev_all.names_map.size());
 
-	WHEN("I copy them.") {
-		Clips cpy_def({}, {}), cpy_alt({}, {});
+				CodeSet codes = {};
 
-		pBinaryImage p_def = new BinaryImage;
+				for (EventMap::iterator it = ev_all.event.begin(); it != ev_all.event.end(); ++it) {
+					EventMap::iterator jt = ev_a.event.find(it->first);
 
-		REQUIRE(clp_def.save(p_def));
-		REQUIRE(cpy_def.load(p_def));
+					REQUIRE(jt != ev_a.event.end());
+					REQUIRE(jt->second.seen == it->second.seen);
 
-		delete p_def;
+					codes.insert(jt->second.code);
 
-		pBinaryImage p_alt = new BinaryImage;
+					EventMap::iterator kt = code_a.find(it->first);
 
-		REQUIRE(clp_alt.save(p_alt));
-		REQUIRE(cpy_alt.load(p_alt));
+					if (kt != code_a.end())
+						REQUIRE(jt->second.code == kt->second.code);
+				}
+				REQUIRE(codes.size() == ev_a.event.size());
 
-		delete p_alt;
+				REQUIRE(ev_a.get_str(MurmurHash64A("emi3", 4)) == "emi3");
+			}
+		}
 
-		THEN("They are identical.") {
-			REQUIRE(strcmp(clp_def.time_format, cpy_def.time_format) == 0);
-			REQUIRE(strcmp(clp_alt.time_format, cpy_alt.time_format) == 0);
+		WHEN("I merge them into a smaller object.") {
+			ev_a.set_max_num_events(20);
 
-			REQUIRE(clp_def.clients.id_set.size() == cpy_def.clients.id_set.size());
-			REQUIRE(clp_alt.clients.id_set.size() == cpy_alt.clients.id_set.size());
+			REQUIRE(ev_a.merge(ev_b));
 
-			REQUIRE(clp_def.events.event.size()		== cpy_def.events.event.size());
-			REQUIRE(clp_def.events.names_map.size()	== cpy_def.events.names_map.size());
-			REQUIRE(clp_def.events.max_num_events	== cpy_def.events.max_num_events);
-			REQUIRE(clp_def.events.next_code		== cpy_def.events.next_code);
-			REQUIRE(clp_def.events.priority_low		== cpy_def.events.priority_low);
-			REQUIRE(clp_def.events.store_strings	== cpy_def.events.store_strings);
-			REQUIRE(clp_alt.events.event.size()		== cpy_alt.events.event.size());
-			REQUIRE(clp_alt.events.names_map.size()	== cpy_alt.events.names_map.size());
-			REQUIRE(clp_alt.events.max_num_events	== cpy_alt.events.max_num_events);
-			REQUIRE(clp_alt.events.next_code		== cpy_alt.events.next_code);
-			REQUIRE(clp_alt.events.priority_low		== cpy_alt.events.priority_low);
-			REQUIRE(clp_alt.events.store_strings	== cpy_alt.events.store_strings);
+			THEN("The most frequent events are kept.") {
+				REQUIRE(ev_a.num_events() == 20);
+				REQUIRE(ev_a.priority.size() == 20);
 
-			REQUIRE(clp_def.clips.size() == cpy_def.clips.size()); {
-				ClipMap::iterator it_clip1 = clp_def.clips.begin(), it_clip2 = cpy_def.clips.begin();
+				uint64_t min_kept = 0xffffffffffffffff;
 
-				for (int i = 0; i < 10; i++) {
-					if (it_clip1 == clp_def.clips.end())
-						break;
+				for (EventMap::iterator it = ev_a.event.begin(); it != ev_a.event.end(); ++it) {
+					REQUIRE(it->second.seen == ev_all.event[it->first].seen);
+
+					min_kept = std::min(min_kept, it->second.seen);
+				}
+
+				for (EventMap::iterator it = ev_all.event.begin(); it != ev_all.event.end(); ++it)
+					if (ev_a.event.find(it->first) == ev_a.event.end())
+						REQUIRE(it->second.seen <= min_kept);
+
+				REQUIRE(ev_a.names_map.size() <= ev_all.names_map.size());
+
+				for (EventMap::iterator it = ev_a.event.begin(); it != ev_a.event.end(); ++it) {
+					REQUIRE(ev_a.get_str(it->first.e) != "");
+					REQUIRE(ev_a.get_str(it->first.d) != "");
+				}
+			}
+		}
+
+		THEN("Invalid merges fail.") {
+			Events ev_ss = {}, ev_def = {};
+
+			REQUIRE(ev_ss.set_discovery(ds_space_saving));
+			REQUIRE(ev_def.define_event((char *) "emi_A", (char *) "descr_A", 1, 'A'));
+
+			REQUIRE(!ev_a.merge(ev_a));
+			REQUIRE(!ev_a.merge(ev_ss));
+			REQUIRE(!ev_ss.merge(ev_a));
+			REQUIRE(!ev_a.merge(ev_def));
+			REQUIRE(!ev_def.merge(ev_a));
+		}
+	}
+
+	GIVEN("A long tail stream split in two small space_saving Events objects.") {
+		Events ev_a = {}, ev_b = {}, ev_c = {}, ev_d = {};
+
+		ev_a.set_max_num_events(10);
+		ev_b.set_max_num_events(10);
+		ev_c.set_max_num_events(10);
+		ev_d.set_max_num_events(10);
+
+		REQUIRE(ev_a.set_discovery(ds_space_saving));
+		REQUIRE(ev_b.set_discovery(ds_space_saving));
+		REQUIRE(ev_c.set_discovery(ds_space_saving));
+		REQUIRE(ev_d.set_discovery(ds_space_saving));
+
+		EventCountMap true_count = {};
+
+		for (int i = 0; i < 6000; i++) {
+			if (i % 3 == 0)
+				sprintf(emitter, "heavy%i", i % 2);
+			else
+				sprintf(emitter, "tail%i", i);
+
+			sprintf(description, "prod");
+
+			if (i < 2500) {
+				ev_a.insert_row(emitter, description, 1);
+				ev_d.insert_row(emitter, description, 1);
+			} else {
+				ev_b.insert_row(emitter, description, 1);
+				ev_c.insert_row(emitter, description, 1);
+			}
+
+			BinEventPt ept = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A(description, strlen(description)), 1};
+
+			true_count[ept]++;
+		}
+
+		WHEN("I merge them in both orders.") {
+			REQUIRE(ev_a.merge(ev_b));
+			REQUIRE(ev_c.merge(ev_d));
+
+			THEN("The counts are upper bounds, the heavy hitters are found and the order does not matter.") {
+				REQUIRE(ev_a.ss_slot.size() == 10);
+				REQUIRE(ev_a.num_events() == 10);
+
+				for (SummarySlots::iterator it = ev_a.ss_slot.begin(); it != ev_a.ss_slot.end(); ++it) {
+					uint64_t cnt = true_count[it->ept];
+
+					REQUIRE(it->count >= cnt);
+					REQUIRE(it->count - it->error <= cnt);
+				}
+
+				for (int i = 0; i < 2; i++) {
+					sprintf(emitter, "heavy%i", i);
+
+					BinEventPt ept = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A("prod", 4), 1};
+
+					REQUIRE(ev_a.event_code(ept) > 0);
+					REQUIRE(ev_c.event_code(ept) > 0);
+				}
+
+				REQUIRE(ev_c.num_events() == 10);
+
+				for (EventMap::iterator it = ev_a.events_begin(); it != ev_a.events_end(); ++it) {
+					EventMap::iterator jt = ev_c.event.find(it->first);
+
+					REQUIRE(jt != ev_c.event.end());
+					REQUIRE(jt->second.seen == it->second.seen);
+				}
+			}
+		}
+
+		WHEN("I seed a partition from an empty image of one of them.") {
+			Events ev_part = {};
+
+			pBinaryImage p_bi = new BinaryImage;
+
+			REQUIRE(ev_a.save(p_bi, false));
+			REQUIRE(ev_part.load(p_bi));
+
+			delete p_bi;
+
+			THEN("It has the settings but not the events and merges back.") {
+				REQUIRE(ev_part.num_events() == 0);
+				REQUIRE(ev_part.ss_slot.size() == 0);
+				REQUIRE(ev_part.discovery == ds_space_saving);
+				REQUIRE(ev_part.max_num_events == 10);
+				REQUIRE(ev_part.hash_function == ev_a.hash_function);
+
+				ev_part.insert_row("heavy0", "prod", 1);
+
+				REQUIRE(ev_b.merge(ev_part));
+				REQUIRE(ev_a.merge(ev_part));
+			}
+		}
+	}
+
+	GIVEN("The Python API.") {
+		int ev_id = new_events(), ev_id2 = new_events();
+
+		REQUIRE(events_insert_row(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0));
+		REQUIRE(events_insert_row(ev_id2, (char *) "emi_2", (char *) "descr_1", 1.0));
+
+		REQUIRE(!events_merge(ev_id, ev_id));
+		REQUIRE(!events_merge(ev_id, 99999));
+		REQUIRE(!events_merge(99999, ev_id));
+		REQUIRE(events_merge(ev_id, ev_id2));
+		REQUIRE(events_num_events(ev_id) == 2);
+
+		destroy_events(ev_id);
+		destroy_events(ev_id2);
+	}
+}
+
+
+SCENARIO("Test Events admission filter") {
+
+	char emitter[80];
+	char description[80];
+
+	GIVEN("Two small Events objects, with and without admission filter, and a long tail stream.") {
+		Events ev_pri = {}, ev_adm = {};
+
+		ev_pri.set_max_num_events(10);
+		ev_adm.set_max_num_events(10);
+
+		REQUIRE(!ev_adm.set_admission_filter(-1, 4));
+		REQUIRE(!ev_adm.set_admission_filter(100, 0));
+		REQUIRE(ev_adm.set_admission_filter(1000, 4));
+		REQUIRE(ev_adm.cm_count.size() == 4000);
+		REQUIRE(!ev_adm.set_discovery(ds_space_saving));
+
+		for (int i = 0; i < 20; i++) {
+			sprintf(emitter, "emi%i", i % 8);
+
+			ev_pri.insert_row(emitter, "prod", 1);
+			ev_adm.insert_row(emitter, "prod", 1);
+		}
+
+		THEN("Before it is full, the result is identical.") {
+			REQUIRE(ev_adm.num_events() == 8);
+			REQUIRE(ev_adm.next_code == ev_pri.next_code);
+			REQUIRE(ev_adm.priority_low == ev_pri.priority_low);
+			REQUIRE(ev_adm.names_map.size() == ev_pri.names_map.size());
+
+			EventMap::iterator it1 = ev_adm.event.begin(), it2 = ev_pri.event.begin();
+
+			for (; it1 != ev_adm.event.end(); ++it1, ++it2) {
+				REQUIRE(it1->first			 == it2->first);
+				REQUIRE(it1->second.seen	 == it2->second.seen);
+				REQUIRE(it1->second.code	 == it2->second.code);
+				REQUIRE(it1->second.priority == it2->second.priority);
+			}
+
+			REQUIRE(!ev_adm.set_admission_filter(0, 0));
+		}
+
+		WHEN("The long tail arrives.") {
+			for (int i = 0; i < 3000; i++) {
+				if (i % 2 == 0)
+					sprintf(emitter, "heavy%i", (i/2) % 5);
+				else
+					sprintf(emitter, "tail%i", i);
+
+				ev_pri.insert_row(emitter, "prod", 1);
+				ev_adm.insert_row(emitter, "prod", 1);
+			}
+
+			THEN("The filter keeps the heavy hitters with much less churn.") {
+				REQUIRE(ev_adm.num_events() == 10);
+
+				for (int i = 0; i < 5; i++) {
+					sprintf(emitter, "heavy%i", i);
+
+					BinEventPt ept = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A("prod", 4), 1};
+
+					REQUIRE(ev_adm.event_code(ept) > 0);
+					REQUIRE(ev_adm.event.find(ept)->second.seen >= 250);
+				}
+
+				REQUIRE(ev_adm.next_code < ev_pri.next_code/10);
+			}
+
+			THEN("The filter survives a save/load.") {
+				Events cpy_adm = {};
+
+				pBinaryImage p_adm = new BinaryImage;
+
+				REQUIRE(ev_adm.save(p_adm));
+				REQUIRE(cpy_adm.load(p_adm));
+
+				delete p_adm;
+
+				REQUIRE(cpy_adm.cm_width == 1000);
+				REQUIRE(cpy_adm.cm_depth == 4);
+				REQUIRE(cpy_adm.cm_rows == ev_adm.cm_rows);
+				REQUIRE(cpy_adm.cm_count == ev_adm.cm_count);
+
+				for (int i = 0; i < 500; i++) {
+					sprintf(emitter, "more%i", i % 17);
+
+					ev_adm.insert_row(emitter, "prod", 1);
+					cpy_adm.insert_row(emitter, "prod", 1);
+				}
+
+				REQUIRE(cpy_adm.next_code == ev_adm.next_code);
+				REQUIRE(cpy_adm.event.size() == ev_adm.event.size());
+				REQUIRE(cpy_adm.cm_count == ev_adm.cm_count);
+
+				Events cpy_pri = {};
+
+				p_adm = new BinaryImage;
+
+				REQUIRE(ev_pri.save(p_adm));
+				REQUIRE(cpy_pri.load(p_adm));
+
+				delete p_adm;
+
+				REQUIRE(cpy_pri.cm_width == 0);
+				REQUIRE(cpy_pri.cm_count.size() == 0);
+			}
+		}
+	}
+
+	GIVEN("A space_saving Events object.") {
+		Events ev_ss = {};
+
+		REQUIRE(ev_ss.set_discovery(ds_space_saving));
+		REQUIRE(!ev_ss.set_admission_filter(100, 4));
+	}
+
+	GIVEN("The Python API.") {
+		int ev_id = new_events();
+
+		REQUIRE(!events_set_admission_filter(99999, 100, 4));
+		REQUIRE(!events_set_admission_filter(ev_id, 100, -4));
+		REQUIRE(events_set_admission_filter(ev_id, 100, 4));
+		REQUIRE(events_insert_row(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0));
+		REQUIRE(!events_set_admission_filter(ev_id, 0, 0));
+		REQUIRE(events_num_events(ev_id) == 1);
+
+		destroy_events(ev_id);
+	}
+}
+
+
+SCENARIO("Test Events decay") {
+
+	char emitter[80];
+
+	GIVEN("Events objects in both discovery modes with and without decay, fed with events that stop occurring.") {
+		Events ev_pri = {}, ev_dec = {}, ev_ss = {};
+
+		ev_pri.set_max_num_events(10);
+		ev_dec.set_max_num_events(10);
+		ev_ss.set_max_num_events(10);
+
+		REQUIRE(!ev_dec.set_decay(-1));
+		REQUIRE(ev_dec.set_decay(100));
+		REQUIRE(ev_ss.set_discovery(ds_space_saving));
+		REQUIRE(ev_ss.set_decay(100));
+
+		for (int i = 0; i < 1000; i++) {
+			sprintf(emitter, "old%i", i % 5);
+
+			ev_pri.insert_row(emitter, "prod", 1);
+			ev_dec.insert_row(emitter, "prod", 1);
+			ev_ss.insert_row(emitter, "prod", 1);
+		}
+
+		REQUIRE(!ev_dec.set_decay(0));
+
+		THEN("The counts are bounded by the half life.") {
+			REQUIRE(ev_pri.num_events() == 5);
+			REQUIRE(ev_dec.num_events() == 5);
+			REQUIRE(ev_ss.num_events() == 5);
+
+			for (EventMap::iterator it = ev_dec.event.begin(); it != ev_dec.event.end(); ++it)
+				REQUIRE(it->second.seen < 40);
+
+			REQUIRE(ev_pri.event.begin()->second.seen == 200);
+			REQUIRE(ev_dec.priority.size() == ev_dec.event.size());
+		}
+
+		WHEN("Other events replace them.") {
+			for (int i = 0; i < 2000; i++) {
+				sprintf(emitter, "new%i", i % 3);
+
+				ev_pri.insert_row(emitter, "prod", 1);
+				ev_dec.insert_row(emitter, "prod", 1);
+				ev_ss.insert_row(emitter, "prod", 1);
+			}
+
+			THEN("The old events age out with decay only.") {
+				REQUIRE(ev_pri.num_events() == 8);
+				REQUIRE(ev_dec.num_events() == 3);
+				REQUIRE(ev_ss.num_events() == 3);
+
+				BinEventPt ept = {MurmurHash64A("old0", 4), MurmurHash64A("prod", 4), 1};
+
+				REQUIRE(ev_pri.event_code(ept) > 0);
+				REQUIRE(ev_dec.event_code(ept) == 0);
+				REQUIRE(ev_ss.event_code(ept) == 0);
+				REQUIRE(ev_dec.names_map.find(MurmurHash64A("old0", 4)) < 0);
+				REQUIRE(ev_ss.names_map.find(MurmurHash64A("old0", 4)) < 0);
+
+				ept.e = MurmurHash64A("new0", 4);
+
+				REQUIRE(ev_dec.event_code(ept) > 0);
+				REQUIRE(ev_ss.event_code(ept) > 0);
+			}
+
+			THEN("decay_events() keeps the codes and the ranking.") {
+				EventMap before = ev_dec.event;
+				PriorityMap pri = ev_dec.priority;
+
+				ev_dec.decay_events();
+
+				REQUIRE(ev_dec.event.size() == before.size());
+
+				for (EventMap::iterator it = ev_dec.event.begin(); it != ev_dec.event.end(); ++it) {
+					REQUIRE(it->second.code == before[it->first].code);
+					REQUIRE(it->second.seen == before[it->first].seen/2);
+				}
+
+				PriorityMap::iterator it1 = ev_dec.priority.begin(), it2 = pri.begin();
+
+				for (; it1 != ev_dec.priority.end(); ++it1, ++it2)
+					REQUIRE(it1->second == it2->second);
+			}
+
+			THEN("decay_events(k) is k halvings in one pass.") {
+				Events twice = ev_dec;
+
+				twice.decay_events();
+				twice.decay_events();
+				twice.decay_events();
+
+				ev_dec.decay_events(3);
+
+				REQUIRE(ev_dec.event.size() == twice.event.size());
+
+				for (EventMap::iterator it = ev_dec.event.begin(); it != ev_dec.event.end(); ++it)
+					REQUIRE(it->second.seen == twice.event[it->first].seen);
+
+				ev_dec.decay_events(0);
+
+				REQUIRE(ev_dec.event.size() == twice.event.size());
+
+				ev_dec.decay_events(1000);
+
+				REQUIRE(ev_dec.num_events() == 0);
+			}
+
+			THEN("A huge pre-aggregated count ages everything out at once.") {
+				ev_dec.insert_row_count(emitter, "prod", 1, 1000000000000);
+
+				REQUIRE(ev_dec.num_events() == 1);
+				REQUIRE(ev_dec.event.begin()->second.seen == 1000000000000);
+				REQUIRE(ev_dec.decay_rows < 100);
+			}
+
+			THEN("The decay survives a save/load.") {
+				Events cpy_dec = {};
+
+				pBinaryImage p_bi = new BinaryImage;
+
+				REQUIRE(ev_dec.save(p_bi));
+				REQUIRE(cpy_dec.load(p_bi));
+
+				delete p_bi;
+
+				REQUIRE(cpy_dec.decay_half_life == 100);
+				REQUIRE(cpy_dec.decay_rows == ev_dec.decay_rows);
+
+				for (int i = 0; i < 500; i++) {
+					sprintf(emitter, "more%i", i % 17);
+
+					ev_dec.insert_row(emitter, "prod", 1);
+					cpy_dec.insert_row(emitter, "prod", 1);
+				}
+
+				REQUIRE(cpy_dec.next_code == ev_dec.next_code);
+				REQUIRE(cpy_dec.event.size() == ev_dec.event.size());
+
+				EventMap::iterator it1 = cpy_dec.event.begin(), it2 = ev_dec.event.begin();
+
+				for (; it1 != cpy_dec.event.end(); ++it1, ++it2) {
+					REQUIRE(it1->first		 == it2->first);
+					REQUIRE(it1->second.seen == it2->second.seen);
+					REQUIRE(it1->second.code == it2->second.code);
+				}
+
+				REQUIRE(!ev_pri.merge(ev_dec));
+			}
+		}
+	}
+
+	GIVEN("The Python API.") {
+		int ev_id = new_events();
+
+		REQUIRE(!events_set_decay(99999, 100));
+		REQUIRE(!events_decay_events(99999));
+		REQUIRE(!events_set_decay(ev_id, -100));
+		REQUIRE(events_set_decay(ev_id, 100));
+		REQUIRE(events_insert_row(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0));
+		REQUIRE(!events_set_decay(ev_id, 0));
+		REQUIRE(events_num_events(ev_id) == 1);
+		REQUIRE(events_decay_events(ev_id));
+		REQUIRE(events_num_events(ev_id) == 0);
+
+		destroy_events(ev_id);
+	}
+}
+
+
+SCENARIO("Test Events sampling") {
+
+	char emitter[80];
+
+	GIVEN("A full and two sampled Events objects and a stream of 5 heavy events and a long tail.") {
+		Events ev_all = {}, ev_smp = {}, ev_rep = {};
+
+		ev_all.set_max_num_events(20);
+		ev_smp.set_max_num_events(20);
+		ev_rep.set_max_num_events(20);
+
+		REQUIRE(!ev_smp.set_sample_rate(0));
+		REQUIRE(!ev_smp.set_sample_rate(1.5));
+		REQUIRE(ev_smp.set_sample_rate(0.1));
+		REQUIRE(ev_rep.set_sample_rate(0.1));
+
+		for (int i = 0; i < 100000; i++) {
+			if (i % 2 == 0)
+				sprintf(emitter, "heavy%i", (i/2) % 5);
+			else
+				sprintf(emitter, "tail%i", i);
+
+			ev_all.insert_row(emitter, "prod", 1);
+			ev_smp.insert_row(emitter, "prod", 1);
+			ev_rep.insert_row(emitter, "prod", 1);
+		}
+
+		REQUIRE(!ev_smp.set_sample_rate(1));
+
+		THEN("The heavy events are found with an interval containing their true count.") {
+			for (int i = 0; i < 5; i++) {
+				sprintf(emitter, "heavy%i", i);
+
+				BinEventPt ept = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A("prod", 4), 1};
+
+				double estimate, lower, upper;
+
+				REQUIRE(ev_all.estimate_count(ept, estimate, lower, upper));
+				REQUIRE(estimate == 10000);
+				REQUIRE(lower == 10000);
+				REQUIRE(upper == 10000);
+
+				REQUIRE(ev_smp.estimate_count(ept, estimate, lower, upper));
+				REQUIRE(lower < 10000);
+				REQUIRE(upper > 10000);
+				REQUIRE(upper - lower < 2000);
+				REQUIRE(abs(estimate - 10000) < 1000);
+			}
+
+			BinEventPt ept = {MurmurHash64A("none", 4), MurmurHash64A("prod", 4), 1};
+
+			double estimate, lower, upper;
+
+			REQUIRE(!ev_smp.estimate_count(ept, estimate, lower, upper));
+		}
+
+		THEN("The sampling is deterministic.") {
+			REQUIRE(ev_smp.next_code < ev_all.next_code/5);
+			REQUIRE(ev_smp.sample_rows == 100000);
+			REQUIRE(ev_rep.event.size() == ev_smp.event.size());
+
+			EventMap::iterator it1 = ev_rep.event.begin(), it2 = ev_smp.event.begin();
+
+			for (; it1 != ev_rep.event.end(); ++it1, ++it2) {
+				REQUIRE(it1->first			 == it2->first);
+				REQUIRE(it1->second.seen	 == it2->second.seen);
+				REQUIRE(it1->second.code	 == it2->second.code);
+				REQUIRE(it1->second.priority == it2->second.priority);
+			}
+		}
+
+		THEN("The sampling survives a save/load.") {
+			Events cpy_smp = {};
+
+			pBinaryImage p_bi = new BinaryImage;
+
+			REQUIRE(ev_smp.save(p_bi));
+			REQUIRE(cpy_smp.load(p_bi));
+
+			delete p_bi;
+
+			REQUIRE(cpy_smp.sample_rate == 0.1);
+			REQUIRE(cpy_smp.sample_rows == ev_smp.sample_rows);
+
+			for (int i = 0; i < 500; i++) {
+				sprintf(emitter, "more%i", i % 17);
+
+				ev_smp.insert_row(emitter, "prod", 1);
+				cpy_smp.insert_row(emitter, "prod", 1);
+			}
+
+			REQUIRE(cpy_smp.next_code == ev_smp.next_code);
+			REQUIRE(cpy_smp.event.size() == ev_smp.event.size());
+			REQUIRE(!ev_all.merge(ev_smp));
+		}
+	}
+
+	GIVEN("A sampled Events object in space_saving mode and pre-aggregated rows.") {
+		Events ev_ss = {};
+
+		REQUIRE(ev_ss.set_discovery(ds_space_saving));
+		REQUIRE(ev_ss.set_sample_rate(0.25));
+
+		ev_ss.insert_row_count("emi", "prod", 1, 1000);
+		ev_ss.insert_row_count("emi", "prod", 1, 2);
+
+		BinEventPt ept = {MurmurHash64A("emi", 3), MurmurHash64A("prod", 4), 1};
+
+		double estimate, lower, upper;
+
+		REQUIRE(ev_ss.estimate_count(ept, estimate, lower, upper));
+		REQUIRE(ev_ss.event.begin()->second.seen >= 250);
+		REQUIRE(ev_ss.event.begin()->second.seen <= 251);
+		REQUIRE(lower < estimate);
+		REQUIRE(upper > estimate);
+	}
+
+	GIVEN("The Python API.") {
+		int ev_id = new_events();
+
+		REQUIRE(!events_set_sample_rate(99999, 0.5));
+		REQUIRE(!events_set_sample_rate(ev_id, -0.5));
+		REQUIRE(events_set_sample_rate(ev_id, 0.5));
+		REQUIRE(events_insert_row_count(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0, 100));
+		REQUIRE(!events_set_sample_rate(ev_id, 1));
+		REQUIRE(events_num_events(ev_id) == 1);
+
+		String est = events_estimate_count(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0);
+
+		REQUIRE(est.rfind("100.000\t", 0) == 0);
+		REQUIRE(String(events_estimate_count(ev_id, (char *) "emi_1", (char *) "descr_2", 1.0)) == "");
+		REQUIRE(String(events_estimate_count(99999, (char *) "emi_1", (char *) "descr_1", 1.0)) == "");
+
+		destroy_events(ev_id);
+	}
+}
+
+
+SCENARIO("Test Events.export_columns()") {
+
+	GIVEN("An Events object with discovered events.") {
+		Events ev = {};
+
+		ev.set_max_num_events(20);
+
+		for (int i = 0; i < 1000; i++) {
+			char emitter[80], description[80];
+
+			sprintf(emitter, "emi%i", i % 7);
+			sprintf(description, "prod%i", i % 5);
+
+			ev.insert_row(emitter, description, 1 + i % 2);
+		}
+
+		EventColumns cols;
+
+		ev.export_columns(cols);
+
+		THEN("The columns are the EventMap in its order.") {
+			REQUIRE(cols.e.size() == 20);
+			REQUIRE(cols.d.size() == 20);
+			REQUIRE(cols.w.size() == 20);
+			REQUIRE(cols.seen.size() == 20);
+			REQUIRE(cols.code.size() == 20);
+			REQUIRE(cols.priority.size() == 20);
+			REQUIRE(cols.emitter.size() == 20);
+			REQUIRE(cols.description.size() == 20);
+
+			int i = 0;
+
+			for (EventMap::iterator it = ev.event.begin(); it != ev.event.end(); ++it, i++) {
+				REQUIRE(cols.e[i]		 == it->first.e);
+				REQUIRE(cols.d[i]		 == it->first.d);
+				REQUIRE(cols.w[i]		 == it->first.w);
+				REQUIRE(cols.seen[i]	 == it->second.seen);
+				REQUIRE(cols.code[i]	 == it->second.code);
+				REQUIRE(cols.priority[i] == it->second.priority);
+				REQUIRE(ev.hash_str(cols.strings[cols.emitter[i]].c_str()) == it->first.e);
+				REQUIRE(ev.hash_str(cols.strings[cols.description[i]].c_str()) == it->first.d);
+			}
+
+			REQUIRE(cols.strings.size() == 1 + 7 + 5);
+			REQUIRE(cols.strings[0] == "");
+		}
+
+		THEN("Without strings, the string columns are empty.") {
+			ev.set_store_strings(false);
+
+			ev.export_columns(cols);
+
+			REQUIRE(cols.e.size() == 20);
+			REQUIRE(cols.emitter.size() == 20);
+			REQUIRE(cols.emitter[0] == 0);
+			REQUIRE(cols.strings.size() == 1);
+		}
+	}
+
+	GIVEN("The Python API.") {
+		int ev_id = new_events();
+
+		String raw;
+
+		REQUIRE(!events_export_columns(99999, raw));
+		REQUIRE(events_export_columns(ev_id, raw));
+		REQUIRE(raw == String("\0\0\0\0\0\0\0\0\0", 9));
+
+		REQUIRE(events_insert_row(ev_id, (char *) "emi_1", (char *) "descr_1", 1.0));
+		REQUIRE(events_export_columns(ev_id, raw));
+		REQUIRE(raw.length() == 8 + 6*8 + 2*4 + 1 + 6 + 8);
+
+		uint64_t *p_col = (uint64_t *) raw.data();
+		uint32_t *p_ix	= (uint32_t *) (p_col + 7);
+
+		REQUIRE(p_col[0] == 1);
+		REQUIRE(p_col[1] == MurmurHash64A("emi_1", 5));
+		REQUIRE(p_col[2] == MurmurHash64A("descr_1", 7));
+		REQUIRE(*(double *) (p_col + 3) == 1.0);
+		REQUIRE(p_col[4] == 1);
+		REQUIRE(p_col[5] == 1);
+		REQUIRE(p_ix[0] == 1);
+		REQUIRE(p_ix[1] == 2);
+		REQUIRE(strcmp(raw.c_str() + 8 + 6*8 + 2*4 + 1, "emi_1") == 0);
+		REQUIRE(strcmp(raw.c_str() + 8 + 6*8 + 2*4 + 7, "descr_1") == 0);
+
+		destroy_events(ev_id);
+	}
+}
+
+
+SCENARIO("Test Events.freeze()") {
+
+	char emitter[80];
+	char description[80];
+
+	GIVEN("An Events object with defined events.") {
+		Events ev = {};
+
+		for (int i = 0; i < 500; i++) {
+			sprintf(emitter, "emi%i", i % 37);
+			sprintf(description, "descr%i", i);
+
+			REQUIRE(ev.define_event(emitter, description, (i % 3)*0.5, i + 1));
+		}
+
+		REQUIRE(ev.define_event("emi_zero", "descr_zero", 1, 0));
+
+		ev.freeze();
+
+		THEN("event_code() is the same as before.") {
+			REQUIRE(ev.frozen.size() == 1024);
+
+			for (int i = 0; i < 600; i++) {
+				sprintf(emitter, "emi%i", i % 37);
+				sprintf(description, "descr%i", i);
+
+				BinEventPt ept = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A(description, strlen(description)), (i % 3)*0.5};
+
+				uint64_t code = ev.event_code(ept);
+
+				if (i < 500)
+					REQUIRE(code == (uint64_t) i + 1);
+				else
+					REQUIRE(code == 0);
+
+				EventMap::iterator it = ev.event.find(ept);
+
+				REQUIRE(code == (it == ev.event.end() ? 0 : it->second.code));
+
+				ept.w += 0.00004;		// Same quantized weight
+
+				REQUIRE(ev.event_code(ept) == code);
+
+				ept.w += 0.001;
+
+				REQUIRE(ev.event_code(ept) == 0);
+			}
+
+			BinEventPt ept = {MurmurHash64A("emi_zero", 8), MurmurHash64A("descr_zero", 10), 1};
+
+			REQUIRE(ev.event_code(ept) == 0);
+		}
+
+		THEN("Any change drops the frozen copy.") {
+			REQUIRE(ev.define_event("emi_new", "descr_new", 1, 9999));
+			REQUIRE(ev.frozen.size() == 0);
+
+			BinEventPt ept = {MurmurHash64A("emi_new", 7), MurmurHash64A("descr_new", 9), 1};
+
+			REQUIRE(ev.event_code(ept) == 9999);
+
+			ev.freeze();
+
+			REQUIRE(ev.event_code(ept) == 9999);
+
+			pBinaryImage p_bi = new BinaryImage;
+
+			REQUIRE(ev.save(p_bi));
+			REQUIRE(ev.frozen.size() != 0);
+
+			Events cpy = {};
+
+			cpy.freeze();
+			REQUIRE(cpy.frozen.size() == 0);
+
+			REQUIRE(cpy.load(p_bi));
+			REQUIRE(cpy.frozen.size() == 0);
+			REQUIRE(cpy.event_code(ept) == 9999);
+
+			THEN("Clips objects freeze their events.") {
+				Clients clients = {};
+
+				Clips clips(clients, ev);
+
+				REQUIRE(clips.events.frozen.size() == ev.frozen.size());
+				REQUIRE(clips.scan_event("emi_new", "descr_new", 1, "cli_A", "2022-06-04 10:00:00"));
+				REQUIRE(!clips.scan_event("emi_new", "descr_new", 2, "cli_A", "2022-06-04 10:00:00"));
+
+				pBinaryImage p_clp = new BinaryImage;
+
+				REQUIRE(clips.save(p_clp));
+
+				Clips cpy_clips = {};
+
+				REQUIRE(cpy_clips.load(p_clp));
+				REQUIRE(cpy_clips.events.frozen.size() == ev.frozen.size());
+				REQUIRE(cpy_clips.events.event_code(ept) == 9999);
+
+				delete p_clp;
+			}
+
+			delete p_bi;
+		}
+	}
+
+	GIVEN("A discovered Events object.") {
+		Events ev = {};
+
+		ev.insert_row("emi_A", "descr_A", 1);
+		ev.freeze();
+
+		BinEventPt ept = {MurmurHash64A("emi_A", 5), MurmurHash64A("descr_A", 7), 1};
+
+		REQUIRE(ev.event_code(ept) == 1);
+
+		ev.insert_row("emi_B", "descr_B", 1);
+
+		REQUIRE(ev.frozen.size() == 0);
+		REQUIRE(ev.event_code(ept) == 1);
+	}
+}
+
+
+SCENARIO("Test Clients") {
+
+	Clients cli = {};
+
+	REQUIRE(cli.id.size() == 0);
+	REQUIRE(cli.id_set.size() == 0);
+
+	cli.add_client_id((char *) "");
+
+	REQUIRE(cli.id.size() == 1);
+	REQUIRE(cli.id_set.size() == 1);
+
+	cli.add_client_id((char *) "client_a");
+	cli.add_client_id((char *) "client_b");
+	cli.add_client_id((char *) "client_c");
+
+	REQUIRE(cli.id.size() == 4);
+	REQUIRE(cli.id_set.size() == 4);
+
+	cli.add_client_id((char *) "");
+
+	REQUIRE(cli.id.size() == 5);
+	REQUIRE(cli.id_set.size() == 4);
+
+	ElementHash hash = MurmurHash64A((char *) "client_b", 8);
+
+	REQUIRE(cli.id[2] == hash);
+	REQUIRE(cli.id_set.find(hash, cli.id) == 2);
+	REQUIRE(cli.contains(hash));
+	REQUIRE(cli.contains(0));
+	REQUIRE(!cli.contains(MurmurHash64A((char *) "client_d", 8)));
+
+	for (int i = 0; i < 1000; i++) {
+		char client[80];
+		sprintf(client, "many%i", i);
+
+		cli.add_client_id(client);
+	}
+
+	REQUIRE(cli.id.size() == 1005);
+	REQUIRE(cli.id_set.size() == 1004);
+	REQUIRE(cli.id_set.slot.size() == 2048);
+
+	for (int i = 0; i < (int) cli.id.size(); i++)
+		REQUIRE(cli.contains(cli.id[i]));
+
+	cli.id_set.clear();
+
+	REQUIRE(cli.id_set.size() == 0);
+	REQUIRE(!cli.contains(hash));
+}
+
+
+SCENARIO("Test Clients bulk loading") {
+
+	GIVEN("The same client ids as strings, hashes and a file.") {
+		Clients cli = {}, cli_str = {}, cli_hash = {}, cli_file = {};
+
+		int n = 3*BULK_HASH_MIN_PER_THREAD;
+
+		std::vector<String>		  ids;
+		std::vector<pChar>		  p_cli;
+		std::vector<uint64_t>	  p_len;
+		std::vector<ElementHash>  hash;
+
+		char client[80];
+
+		for (int i = 0; i < n; i++) {
+			sprintf(client, "client%i", i % (n - 1000));
+			ids.push_back(client);
+		}
+		ids.push_back("");
+
+		for (int i = 0; i < (int) ids.size(); i++) {
+			p_cli.push_back((pChar) ids[i].c_str());
+			p_len.push_back(ids[i].length());
+
+			cli.add_client_id(p_cli[i]);
+
+			hash.push_back(cli.hash_client_id(p_cli[i]));
+		}
+
+		FILE *f = fopen("/tmp/reels_test_clients.txt", "wb");
+
+		for (int i = 0; i < (int) ids.size(); i++)
+			fprintf(f, i % 2 ? "%s\n" : "%s\r\n", ids[i].c_str());
+
+		fclose(f);
+
+		WHEN("I load them in bulk.") {
+			REQUIRE(cli_str.add_client_ids(p_cli.data(), p_len.data(), p_cli.size()) == n - 1000);
+			REQUIRE(cli_hash.add_client_hashes(hash.data(), hash.size()) == n - 1000);
+			REQUIRE(cli_file.load_client_ids((char *) "/tmp/reels_test_clients.txt") == n - 1000);
+			REQUIRE(cli_file.load_client_ids((char *) "/tmp/reels_test_clients.txt") == 0);
+			REQUIRE(cli_file.load_client_ids((char *) "/tmp/no/such/file.txt") == -1);
+
+			THEN("They are the same new ids, in the same order, as loading them one by one.") {
+				REQUIRE(cli_str.id.size() == n - 1000);
+				REQUIRE(cli_str.id_set.size() == n - 1000);
+				REQUIRE(cli.id_set.size() == n - 999);
+
+				int differences = 0;
+
+				for (int i = 0; i < n - 1000; i++)
+					differences += (cli_str.id[i] != cli.id[i]) + (cli_hash.id[i] != cli.id[i]) + (cli_file.id[i] != cli.id[i]);
+
+				REQUIRE(differences == 0);
+				REQUIRE(cli_str.contains(cli.id[n - 1]));
+				REQUIRE(!cli_str.contains(0));
+			}
+		}
+		remove("/tmp/reels_test_clients.txt");
+	}
+}
+
+
+SCENARIO("Test Clients.save() / Clients.load()") {
+
+	GIVEN("I have two Clients objects.") {
+		Clients cli_def = {}, cli_alt = {};
+
+		char emitter[80];
+
+		for (int i = 0; i < 250; i++) {
+			sprintf(emitter, "emi%i", (int) sqrt(i % 100));
+
+			cli_def.add_client_id(emitter);
+		}
+
+		REQUIRE(cli_def.id.size()	  == 250);
+		REQUIRE(cli_def.id_set.size()  < 250);
+		REQUIRE(cli_def.id_set.size()  >   0);
+		REQUIRE(cli_alt.id.size()	  ==   0);
+		REQUIRE(cli_alt.id_set.size() ==   0);
+
+		WHEN("I copy them.") {
+			Clients cpy_def = {}, cpy_alt = {};
+
+			pBinaryImage p_def = new BinaryImage;
+
+			REQUIRE(cli_def.save(p_def));
+			REQUIRE(cpy_def.load(p_def));
+
+			delete p_def;
+
+			pBinaryImage p_alt = new BinaryImage;
+
+			REQUIRE(cli_alt.save(p_alt));
+			REQUIRE(cpy_alt.load(p_alt));
+
+			delete p_alt;
+
+			THEN("They are identical.") {
+				REQUIRE(cpy_alt.id.size()	  ==   0);
+				REQUIRE(cpy_alt.id_set.size() ==   0);
+
+				REQUIRE(cli_def.id.size()	  == cpy_def.id.size());
+				REQUIRE(cli_def.id_set.size() == cpy_def.id_set.size());
+
+				for (int i = 0; i < (int) cli_def.id.size(); i++) {
+					REQUIRE(cli_def.id[i] == cpy_def.id[i]);
+					REQUIRE(cpy_def.id_set.find(cli_def.id[i], cpy_def.id) == cli_def.id_set.find(cli_def.id[i], cli_def.id));
+				}
+			}
+		}
+	}
+}
+
+
+SCENARIO("Test ClientFilter") {
+
+	ClientFilter filter = {};
+	ClientIDs	 id		= {}, other = {};
+
+	REQUIRE(filter.may_contain(12345));
+
+	for (int i = 0; i < 20000; i++) {
+		char client[80];
+
+		sprintf(client, "cli-id%i", i);
+		id.push_back(MurmurHash64A(client, strlen(client)));
+
+		sprintf(client, "other%i", i);
+		other.push_back(MurmurHash64A(client, strlen(client)));
+	}
+
+	filter.build(id);
+
+	REQUIRE(filter.num_blocks == 1250);
+	REQUIRE(filter.word.size() == 10000);
+
+	int false_pos = 0;
+
+	for (int i = 0; i < 20000; i++) {
+		REQUIRE(filter.may_contain(id[i]));
+
+		false_pos += filter.may_contain(other[i]);
+	}
+
+	REQUIRE(false_pos < 100);
+
+	filter.build({});
+
+	REQUIRE(filter.num_blocks == 1);
+	REQUIRE(!filter.may_contain(id[0]));
+
+	filter.clear();
+
+	REQUIRE(filter.num_blocks == 0);
+	REQUIRE(filter.may_contain(id[0]));
+}
+
+
+SCENARIO("Test Clips") {
+
+	GIVEN("I load a Clients, Events and a Clips object") {
+		Events events = {};
+		Clients clients = {};
+
+		events.set_max_num_events(50);
+
+		for (int i = 0; i < 10000; i++) {
+			char emitter[80];
+			char description[80];
+			double w;
+
+			if (i < 200) {
+				sprintf(emitter, "cli-id%i", 77*i);
+				clients.add_client_id(emitter);
+			}
+
+			sprintf(emitter, "emi%i", (int) sqrt(i % 100));
+			sprintf(description, "prod%i", (i % 5) + 1);
+			w = i % 11 ? 1.3 : 4.2;
+
+			events.insert_row(emitter, description, w);
+		}
+
+		REQUIRE(events.event.size() == 50);
+		REQUIRE(clients.id.size() == 200);
+		REQUIRE(clients.id_set.size() == 200);
+
+		Clips clips(clients, events), no_filter(clients, events);
+
+		REQUIRE(clips.client_filter.num_blocks == 13);
+
+		no_filter.set_client_filter(false);
+
+		REQUIRE(no_filter.client_filter.num_blocks == 0);
+
+		WHEN("I feed the Clips with transactions from the same and other clients") {
+
+			int names_size = clips.events.names_map.size();
+			int differences = 0;
+
+			int i = 0;
+			for (int day = 10; day < 30; day++) {
+				for (int hour = 10; hour < 24; hour++) {
+					for (int min = 10; min < 60; min++) {
+						for (int sec = 10; sec < 60; sec++) {
+							char timestamp[80];
+							char client[80];
+							char emitter[80];
+							char description[80];
+							double w;
+
+							i++;
+
+							sprintf(timestamp, "2022-06-%i %i:%i:%i", day, hour, min, sec);
+							sprintf(client, "cli-id%i", 77*(i % 500));
+							sprintf(emitter, "emi%i", (int) sqrt(i % 200));
+							sprintf(description, "prod%i", (i % 9) + 1);
+							w = i % 11 ? 1.3 : 5.0;
+
+							differences += clips.scan_event(emitter, description, w, client, timestamp) !=
+										   no_filter.scan_event(emitter, description, w, client, timestamp);
+						}
+					}
+				}
+			}
+			char timestamp[80] = {"2022-06-04 10:00:00"};
+			char client[80]	   = {"cli-id2541"};
+			String emitter	   = events.get_str(events.event.begin()->first.e);
+			String description = events.get_str(events.event.begin()->first.d);
+			double w		   = events.event.begin()->first.w;
+
+			REQUIRE( clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) client, (pChar) timestamp));
+			REQUIRE(!clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) "", (pChar) timestamp));
+			REQUIRE(!clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) "xx", (pChar) timestamp));
+			REQUIRE(!clips.scan_event((pChar) emitter.c_str(), (pChar) description.c_str(), w, (pChar) client, (pChar) "xx"));
+
+			THEN("The ClipMap is as expected") {
+				REQUIRE(clips.clips.size() <= 200);
+			}
+
+			THEN("The client filter does not change the result") {
+				REQUIRE(differences == 0);
+				REQUIRE(clips.clips.size() == no_filter.clips.size());
+				REQUIRE(clips.num_events() == no_filter.num_events() + 1);
+
+				Clips cpy(no_filter);
+
+				REQUIRE(!cpy.use_client_filter);
+				REQUIRE(cpy.client_filter.num_blocks == 0);
+			}
+
+			THEN("Scanning does not touch the strings of the events") {
+				REQUIRE(clips.events.names_map.size() == names_size);
+				REQUIRE(clips.events.names_map.find(MurmurHash64A("prod9", 5)) < 0);
+				REQUIRE(clips.events.names_map.seen(clips.events.names_map.find(MurmurHash64A("prod1", 5))) ==
+						events.names_map.seen(events.names_map.find(MurmurHash64A("prod1", 5))));
+			}
+		}
+	}
+
+	GIVEN("A Clips object whose ClipMap loses nodes between insertions") {
+		Clips clips({}, {});
+		ClipMap expected = {};
+
+		for (int i = 0; i < 30000; i++) {
+			ElementHash client = MurmurHash64A(&i, 2) % 1000 + 1;
+			TimePoint	time_pt = 1650000000 + 60*(i % 7000);
+			uint64_t	code	= 1 + i % 5;
+
+			clips.insert_event(client, code, time_pt);
+			expected[client][time_pt] = code;
+
+			if (i == 10000) {
+				REQUIRE(clips.clip_index.num_used == (int64_t) expected.size());
+
+				clips.raw_clip_map()->erase(expected.begin()->first);
+				expected.erase(expected.begin());
+
+				REQUIRE(clips.clip_index.num_used == 0);
+			}
+
+			if (i == 20000)
+				clips.freeze();
+		}
+
+		Clips cpy(clips);
+
+		REQUIRE(cpy.clip_index.num_used == 0);
+
+		cpy.insert_event(expected.begin()->first, 1, 1650000000);
+		expected[expected.begin()->first][1650000000] = 1;
+
+		THEN("The clips found through the index are the ones in the ClipMap") {
+			REQUIRE(clips.clip_index.num_used > 0);
+			REQUIRE(clips.clip_index.find(expected.begin()->first) == &clips.clips[expected.begin()->first]);
+			REQUIRE(clips.clip_index.find(12345) == nullptr);
+			REQUIRE(*cpy.clip_map() == expected);
+		}
+	}
+}
+
+
+SCENARIO("Test Clips.save() / Clips.load()") {
+
+	Events	ev = {};
+	Clients	cli = {};
+
+	char timestamp[80];
+	char client[80];
+	char emitter[80];
+	char description[80];
+	double w;
+
+	for (int i = 0; i < 5000; i++) {
+		sprintf(client, "cli-id%i", 77*(i % 500));
+		sprintf(emitter, "emi%i", (int) sqrt(i % 100));
+		sprintf(description, "prod%i", (i % 5) + 1);
+
+		w = i % 11 ? 1.3 : 5.0;
+
+		ev.insert_row(emitter, description, w);
+		cli.add_client_id(client);
+	}
+
+	Clips clp_def(cli, ev), clp_alt({}, {});
+
+	int i = 0;
+	for (int hour = 10; hour < 12; hour++) {
+		for (int min = 10; min < 60; min++) {
+			for (int sec = 10; sec < 60; sec++) {
+				i++;
+
+				sprintf(timestamp, "2022-06-02 %i:%i:%i", hour, min, sec);
+				sprintf(client, "cli-id%i", 77*(i % 500));
+				sprintf(emitter, "emi%i", (int) sqrt(i % 100));
+				sprintf(description, "prod%i", (i % 5) + 1);
+
+				w = i % 11 ? 1.3 : 5.0;
+
+				clp_def.scan_event(emitter, description, w, client, timestamp);
+			}
+		}
+	}
+
+	WHEN("I copy them.") {
+		Clips cpy_def({}, {}), cpy_alt({}, {});
+
+		pBinaryImage p_def = new BinaryImage;
+
+		REQUIRE(clp_def.save(p_def));
+		REQUIRE(cpy_def.load(p_def));
+
+		delete p_def;
+
+		pBinaryImage p_alt = new BinaryImage;
+
+		REQUIRE(clp_alt.save(p_alt));
+		REQUIRE(cpy_alt.load(p_alt));
+
+		delete p_alt;
+
+		THEN("They are identical.") {
+			REQUIRE(strcmp(clp_def.time_format, cpy_def.time_format) == 0);
+			REQUIRE(strcmp(clp_alt.time_format, cpy_alt.time_format) == 0);
+
+			REQUIRE(clp_def.clients.id_set.size() == cpy_def.clients.id_set.size());
+			REQUIRE(clp_alt.clients.id_set.size() == cpy_alt.clients.id_set.size());
+
+			REQUIRE(clp_def.events.event.size()		== cpy_def.events.event.size());
+			REQUIRE(clp_def.events.names_map.size()	== cpy_def.events.names_map.size());
+			REQUIRE(clp_def.events.max_num_events	== cpy_def.events.max_num_events);
+			REQUIRE(clp_def.events.next_code		== cpy_def.events.next_code);
+			REQUIRE(clp_def.events.priority_low		== cpy_def.events.priority_low);
+			REQUIRE(clp_def.events.store_strings	== cpy_def.events.store_strings);
+			REQUIRE(clp_alt.events.event.size()		== cpy_alt.events.event.size());
+			REQUIRE(clp_alt.events.names_map.size()	== cpy_alt.events.names_map.size());
+			REQUIRE(clp_alt.events.max_num_events	== cpy_alt.events.max_num_events);
+			REQUIRE(clp_alt.events.next_code		== cpy_alt.events.next_code);
+			REQUIRE(clp_alt.events.priority_low		== cpy_alt.events.priority_low);
+			REQUIRE(clp_alt.events.store_strings	== cpy_alt.events.store_strings);
+
+			REQUIRE(clp_def.clips.size() == cpy_def.clips.size()); {
+				ClipMap::iterator it_clip1 = clp_def.clips.begin(), it_clip2 = cpy_def.clips.begin();
+
+				for (int i = 0; i < 10; i++) {
+					if (it_clip1 == clp_def.clips.end())
+						break;
+
+					REQUIRE(it_clip1->first			== it_clip2->first);
+					REQUIRE(it_clip1->second.size()	== it_clip2->second.size());
+					Clip::iterator it1 = it_clip1->second.begin(), it2 = it_clip2->second.begin();
+
+					for (int j = 0; j < 10; j++) {
+						if (it1 == it_clip1->second.end())
+							break;
+
+						REQUIRE(it1->first	== it2->first);
+						REQUIRE(it1->second	== it2->second);
+
+						++it1;
+						++it2;
+					}
+
+					++it_clip1;
+					++it_clip2;
+				}
+			}
+			REQUIRE(clp_alt.clips.size() == cpy_alt.clips.size()); {
+				ClipMap::iterator it_clip1 = clp_alt.clips.begin(), it_clip2 = cpy_alt.clips.begin();
+
+				for (int i = 0; i < 10; i++) {
+					if (it_clip1 == clp_alt.clips.end())
+						break;
+
+					REQUIRE(it_clip1->first			== it_clip2->first);
+					REQUIRE(it_clip1->second.size()	== it_clip2->second.size());
+					Clip::iterator it1 = it_clip1->second.begin(), it2 = it_clip2->second.begin();
+
+					for (int j = 0; j < 10; j++) {
+						if (it1 == it_clip1->second.end())
+							break;
+
+						REQUIRE(it1->first	== it2->first);
+						REQUIRE(it1->second	== it2->second);
+
+						++it1;
+						++it2;
+					}
+
+					++it_clip1;
+					++it_clip2;
+				}
+			}
+		}
+	}
+
+	WHEN("I save one without the clips.") {
+		Clips cpy_emp({}, {});
+
+		pBinaryImage p_emp = new BinaryImage;
+
+		REQUIRE(clp_def.save(p_emp, false));
+		REQUIRE(cpy_emp.load(p_emp));
+
+		delete p_emp;
+
+		THEN("It is empty but has the same clients, events and time format.") {
+			REQUIRE(clp_def.num_clips() > 0);
+			REQUIRE(cpy_emp.num_clips() == 0);
+			REQUIRE(cpy_emp.num_events() == 0);
+
+			REQUIRE(strcmp(clp_def.time_format, cpy_emp.time_format) == 0);
+			REQUIRE(clp_def.clients.id_set.size() == cpy_emp.clients.id_set.size());
+			REQUIRE(clp_def.events.event.size()	== cpy_emp.events.event.size());
+
+			REQUIRE(cpy_emp.scan_event("emi3", "prod2", 1.3, "cli-id77", "2022-06-02 10:10:10"));
+			REQUIRE(cpy_emp.num_events() == 1);
+		}
+	}
+}
+
+
+SCENARIO("Test CodeIdMap") {
+
+	CodeIdMap code_id = {};
+
+	REQUIRE(code_id.size() == 0);
+	REQUIRE(code_id.find(0) == -1);
+
+	for (uint64_t i = 0; i < 1000; i++)
+		REQUIRE(code_id.insert(1000 - 3*i) == i);
+
+	REQUIRE(code_id.size() == 1000);
+	REQUIRE(code_id.slot.size() == 2048);
+
+	for (uint64_t i = 0; i < 1000; i++) {
+		REQUIRE(code_id.insert(1000 - 3*i) == i);
+		REQUIRE(code_id.find(1000 - 3*i) == i);
+		REQUIRE(code_id.code(i) == 1000 - 3*i);
+	}
+
+	REQUIRE(code_id.size() == 1000);
+	REQUIRE(code_id.find(1001) == -1);
+	REQUIRE(code_id.find(999) == -1);
+
+	code_id.clear();
+
+	REQUIRE(code_id.size() == 0);
+	REQUIRE(code_id.find(1000) == -1);
+	REQUIRE(code_id.insert(1000) == 0);
+}
+
+
+SCENARIO("Test Targets") {
+
+	Events events = {};
+
+	events.define_event((char *) "emi_A", (char *) "descr_A", 1, 'A');
+	events.define_event((char *) "emi_B", (char *) "descr_B", 1, 'B');
+	events.define_event((char *) "emi_C", (char *) "descr_C", 1, 'C');
+	events.define_event((char *) "emi_D", (char *) "descr_D", 1, 'D');
+	events.define_event((char *) "emi_E", (char *) "descr_E", 1, 'E');
+	events.define_event((char *) "emi_F", (char *) "descr_F", 1, 'F');
+
+	BinEventPt event_A = {MurmurHash64A((char *) "emi_A", 5), MurmurHash64A((char *) "descr_A", 7), 1};
+	BinEventPt event_B = {MurmurHash64A((char *) "emi_B", 5), MurmurHash64A((char *) "descr_B", 7), 1};
+	BinEventPt event_C = {MurmurHash64A((char *) "emi_C", 5), MurmurHash64A((char *) "descr_C", 7), 1};
+	BinEventPt event_D = {MurmurHash64A((char *) "emi_D", 5), MurmurHash64A((char *) "descr_D", 7), 1};
+	BinEventPt event_E = {MurmurHash64A((char *) "emi_E", 5), MurmurHash64A((char *) "descr_E", 7), 1};
+	BinEventPt event_F = {MurmurHash64A((char *) "emi_F", 5), MurmurHash64A((char *) "descr_F", 7), 1};
+
+	REQUIRE(events.event.size() == 6);
+
+	REQUIRE(events.event[event_A].code == 'A');
+	REQUIRE(events.event[event_B].code == 'B');
+	REQUIRE(events.event[event_C].code == 'C');
+	REQUIRE(events.event[event_D].code == 'D');
+	REQUIRE(events.event[event_E].code == 'E');
+	REQUIRE(events.event[event_F].code == 'F');
+
+	Clients clients = {};
+
+	clients.add_client_id((char *) "cli_U");
+	clients.add_client_id((char *) "cli_V");
+	clients.add_client_id((char *) "cli_W");
+	clients.add_client_id((char *) "cli_X");
+	clients.add_client_id((char *) "cli_Y");
+	clients.add_client_id((char *) "cli_Z");
+
+	ElementHash cli_U = MurmurHash64A((char *) "cli_U", 5);
+	ElementHash cli_V = MurmurHash64A((char *) "cli_V", 5);
+	ElementHash cli_W = MurmurHash64A((char *) "cli_W", 5);
+	ElementHash cli_X = MurmurHash64A((char *) "cli_X", 5);
+	ElementHash cli_Y = MurmurHash64A((char *) "cli_Y", 5);
+	ElementHash cli_Z = MurmurHash64A((char *) "cli_Z", 5);
+
+	REQUIRE(clients.id.size() == 6);
+
+	REQUIRE(clients.contains(cli_U));
+	REQUIRE(clients.contains(cli_V));
+	REQUIRE(clients.contains(cli_W));
+	REQUIRE(clients.contains(cli_X));
+	REQUIRE(clients.contains(cli_Y));
+	REQUIRE(clients.contains(cli_Z));
+
+	Clips clips(clients, events);
+
+	TimePoint day_10 = clips.get_time((char *) "2022-01-10 12:33:44");
+
+	REQUIRE(day_10 > 0);
+
+	TimePoint day_11 = clips.get_time((char *) "2022-01-11 12:33:44");
+	TimePoint day_12 = clips.get_time((char *) "2022-01-12 12:33:44");
+	TimePoint day_13 = clips.get_time((char *) "2022-01-13 12:33:44");
+	TimePoint day_14 = clips.get_time((char *) "2022-01-14 12:33:44");
+	TimePoint day_15 = clips.get_time((char *) "2022-01-15 12:33:44");
+	TimePoint day_16 = clips.get_time((char *) "2022-01-16 12:33:44");
+	TimePoint day_17 = clips.get_time((char *) "2022-01-17 12:33:44");
+	TimePoint day_18 = clips.get_time((char *) "2022-01-18 12:33:44");
+	TimePoint day_19 = clips.get_time((char *) "2022-01-19 12:33:44");
+
+	TimePoint day_20 = clips.get_time((char *) "2022-01-20 12:33:44");
+	TimePoint day_21 = clips.get_time((char *) "2022-01-21 12:33:44");
+	TimePoint day_22 = clips.get_time((char *) "2022-01-22 12:33:44");
+	TimePoint day_23 = clips.get_time((char *) "2022-01-23 12:33:44");
+	TimePoint day_24 = clips.get_time((char *) "2022-01-24 12:33:44");
+	TimePoint day_25 = clips.get_time((char *) "2022-01-25 12:33:44");
+	TimePoint day_26 = clips.get_time((char *) "2022-01-26 12:33:44");
+	TimePoint day_27 = clips.get_time((char *) "2022-01-27 12:33:44");
+	TimePoint day_28 = clips.get_time((char *) "2022-01-28 12:33:44");
+	TimePoint day_29 = clips.get_time((char *) "2022-01-29 12:33:44");
+
+	TimePoint day_30 = clips.get_time((char *) "2022-01-30 12:33:44");
+
+	REQUIRE(day_30 - day_10 ==  2*(day_20 - day_10));
+	REQUIRE(day_30 - day_10 ==  4*(day_15 - day_10));
+	REQUIRE(day_30 - day_10 ==  5*(day_14 - day_10));
+	REQUIRE(day_30 - day_10 == 10*(day_12 - day_10));
+	REQUIRE(day_30 - day_10 == 20*(day_11 - day_10));
+
+	TargetMap target_map = {};
+
+	target_map[cli_X] = day_25;
+	target_map[cli_Y] = day_25;
+	target_map[cli_Z] = day_25;
+
+	GIVEN("I create the clips for some clients") {
+		clips.insert_event(cli_U, 'A', day_10);
+		clips.insert_event(cli_U, 'A', day_12);
+		clips.insert_event(cli_U, 'A', day_14);
+		clips.insert_event(cli_U, 'A', day_16);
+
+		clips.insert_event(cli_V, 'B', day_10);
+		clips.insert_event(cli_V, 'C', day_11);
+		clips.insert_event(cli_V, 'C', day_14);
+		clips.insert_event(cli_V, 'A', day_15);
+		clips.insert_event(cli_V, 'B', day_20);
+		clips.insert_event(cli_V, 'C', day_22);
+		clips.insert_event(cli_V, 'C', day_24);
+		clips.insert_event(cli_V, 'A', day_29);
+
+		clips.insert_event(cli_W, 'A', day_18);
+		clips.insert_event(cli_W, 'A', day_22);
+		clips.insert_event(cli_W, 'C', day_28);
+
+		clips.insert_event(cli_X, 'A', day_10);
+		clips.insert_event(cli_X, 'E', day_14);
+		clips.insert_event(cli_X, 'E', day_24);
+		clips.insert_event(cli_X, 'A', day_27);
+		clips.insert_event(cli_X, 'F', day_30);
+
+		clips.insert_event(cli_Y, 'B', day_12);
+		clips.insert_event(cli_Y, 'D', day_13);
+		clips.insert_event(cli_Y, 'D', day_15);
+		clips.insert_event(cli_Y, 'E', day_16);
+		clips.insert_event(cli_Y, 'F', day_18);
+		clips.insert_event(cli_Y, 'F', day_23);
+
+		clips.insert_event(cli_Z, 'A', day_18);
+		clips.insert_event(cli_Z, 'A', day_20);
+		clips.insert_event(cli_Z, 'A', day_21);
+		clips.insert_event(cli_Z, 'F', day_28);
+		clips.insert_event(cli_Z, 'F', day_30);
+
+		WHEN("I fit everything into a tree") {
+			Targets targ_mm(&clips.clips, target_map);
+			Targets targ_av(&clips.clips, target_map);
+			Targets targ_ll(&clips.clips, target_map);
+
+			ClipMap clips_copy(clips.clips);
+
+			Targets targ_sq(&clips_copy, target_map);
+
+			TimesToTarget t = targ_mm.predict();
+			REQUIRE(t.size() == 0);
+			t = targ_mm.predict(clients);
+			REQUIRE(t.size() == 0);
+			t = targ_mm.predict(clips.clip_map());
+			REQUIRE(t.size() == 0);
+
+			REQUIRE( targ_mm.fit(tr_log, ag_minimax, 0.8, 12, false));
+			REQUIRE(!targ_mm.fit(tr_log, ag_minimax, 0.8, 12, false));
+			REQUIRE( targ_av.fit(tr_linear, ag_mean, 0.0, 2, false));
+			REQUIRE( targ_ll.fit(tr_linear, ag_longest, 0.0, 2, false));
+			REQUIRE( targ_sq.fit(tr_log, ag_minimax, 0.8, 12, true));
+
+			REQUIRE(targ_mm.tree[0].n_seen == 6);
+			REQUIRE(targ_mm.tree[0].n_target == 3);
+			REQUIRE(targ_mm.tree[0].child.size() == 4);
+
+			REQUIRE(targ_av.tree[0].n_seen == 6);
+			REQUIRE(targ_av.tree[0].n_target == 3);
+			REQUIRE(targ_av.tree[0].child.size() == 4);
+
+			REQUIRE(targ_mm.tree[0].sum_time_d < targ_av.tree[0].sum_time_d);
+			REQUIRE(targ_mm.tree.size() > targ_av.tree.size());
+
+			REQUIRE(targ_ll.tree[0].n_seen == 6);
+			REQUIRE(targ_ll.tree[0].n_target == 3);
+			REQUIRE(targ_ll.tree[0].child.size() == 4);
+
+			REQUIRE(targ_sq.tree[0].n_seen == 6);
+			REQUIRE(targ_sq.tree[0].n_target == 3);
+			REQUIRE(targ_sq.tree[0].child.size() == 4);
+
+			THEN("I can make some predictions") {
+				TimesToTarget tt_mm = targ_mm.predict();
+				REQUIRE(tt_mm.size() == 6);
+				TimesToTarget tt_av = targ_av.predict();
+				REQUIRE(tt_av.size() == 6);
+				TimesToTarget tt_ll = targ_av.predict();
+				REQUIRE(tt_ll.size() == 6);
+				TimesToTarget tt_sq = targ_av.predict();
+				REQUIRE(tt_sq.size() == 6);
+
+				CodeTreeNode node;
+				node.n_seen		= 0;
+				node.n_target	= 0;
+				node.sum_time_d = 1;
+
+				REQUIRE(targ_av.predict_time(node) == PREDICT_MAX_TIME);
+
+				node.n_seen = 1;
+
+				REQUIRE(targ_av.predict_time(node) == PREDICT_MAX_TIME);
+
+				node.n_target = 1;
+
+				REQUIRE(targ_av.predict_time(node) > 0.99);
+				REQUIRE(targ_av.predict_time(node) < 1.01);
+
+				node.sum_time_d = 0;
+
+				REQUIRE(targ_mm.predict_time(node) > 3.0);
+				REQUIRE(targ_mm.predict_time(node) < 3.1);
+
+				REQUIRE(targ_sq.predict_time(node) > 3.0);
+				REQUIRE(targ_sq.predict_time(node) < 3.1);
+
+				node.n_seen		= 2;
+				node.sum_time_d = 1;
+
+				REQUIRE(targ_av.predict_time(node) > 1.99);
+				REQUIRE(targ_av.predict_time(node) < 2.01);
+
+				if (clients.id.size() == 6)
+					clients.add_client_id((char *) "unknown_clip");
+
+				tt_mm = targ_mm.predict(clients);
+				REQUIRE(tt_mm.size() == 7);
+				double default_t_mm = targ_mm.predict_time(targ_mm.tree[0]);
+				REQUIRE(tt_mm[6] == default_t_mm);
+
+				tt_av = targ_av.predict(clients);
+				REQUIRE(tt_av.size() == 7);
+				double default_t_av = targ_av.predict_time(targ_av.tree[0]);
+				REQUIRE(tt_av[6] == default_t_av);
+
+				tt_sq = targ_sq.predict(clients);
+				REQUIRE(tt_sq.size() == 7);
+				double default_t_sq = targ_sq.predict_time(targ_sq.tree[0]);
+				REQUIRE(tt_sq[6] == default_t_sq);
+
+				Clips clp(clients, events);
+
+				clp.insert_event(0, 'H', day_15);
+				clp.insert_event(0, 'H', day_16);
+				clp.insert_event(0, 'H', day_17);
+
+				clp.insert_event(1, 'A', day_18);
+				clp.insert_event(1, 'A', day_20);
+				clp.insert_event(1, 'A', day_21);
+				clp.insert_event(1, 'H', day_10);
+				clp.insert_event(1, 'H', day_11);
+
+				clp.insert_event(2, 'A', day_18);
+				clp.insert_event(2, 'A', day_20);
+				clp.insert_event(2, 'A', day_21);
+
+				double t_mm = targ_mm.predict_clip(clp.clips.begin()->second);
+
+				REQUIRE(t_mm == default_t_mm);
+
+				double t_av = targ_av.predict_clip(clp.clips.begin()->second);
+
+				REQUIRE(t_av == default_t_av);
+
+				tt_mm = targ_mm.predict(&clp.clips);
+				REQUIRE(tt_mm.size() == 3);
+				REQUIRE(tt_mm[0] == default_t_mm);
+				REQUIRE(tt_mm[1] == tt_mm[2]);
+
+				tt_av = targ_av.predict(&clp.clips);
+				REQUIRE(tt_av.size() == 3);
+				REQUIRE(tt_av[0] == default_t_av);
+				REQUIRE(tt_av[1] == tt_av[2]);
+
+				tt_ll = targ_ll.predict(&clp.clips);
+				REQUIRE(tt_ll.size() == 3);
+				REQUIRE(tt_ll[0] == default_t_av);
+				REQUIRE(tt_ll[1] == tt_ll[2]);
+				REQUIRE(tt_ll[1] != tt_av[1]);
+
+				tt_sq = targ_sq.predict(&clp.clips);
+				REQUIRE(tt_sq.size() == 3);
+				REQUIRE(tt_sq[0] == default_t_sq);
+				REQUIRE(tt_sq[1] == tt_sq[2]);
+			}
+			THEN("My sequences are as expected") {
+				REQUIRE(targ_sq.p_clips->size() == 6);
+
+				// Now length should be unaffected
+				Clip clp = targ_sq.p_clips->find(cli_U)->second;
+				REQUIRE(clp.size() == 4);
+
+				clp = targ_sq.p_clips->find(cli_V)->second;
+				REQUIRE(clp.size() == 8);
+
+				clp = targ_sq.p_clips->find(cli_W)->second;
+				REQUIRE(clp.size() == 3);
+
+				clp = targ_sq.p_clips->find(cli_X)->second;
+				REQUIRE(clp.size() == 5);
+
+				clp = targ_sq.p_clips->find(cli_Y)->second;
+				REQUIRE(clp.size() == 6);
+
+				clp = targ_sq.p_clips->find(cli_Z)->second;
+				REQUIRE(clp.size() == 5);
+
+				Clips clp_sq(*targ_sq.p_clips);
+				clp_sq.collapse_to_states();
+
+				// Now we test the collapsed ones, just like the old object used to return
+
+				// clips.insert_event(cli_U, 'A', day_10);
+				clp = clp_sq.clips.find(cli_U)->second;
+				REQUIRE(clp.size() == 1);
+				REQUIRE(clp.find(day_10)->second == 'A');
+
+				// clips.insert_event(cli_V, 'B', day_10);
+				// clips.insert_event(cli_V, 'C', day_11);
+				// clips.insert_event(cli_V, 'A', day_15);
+				// clips.insert_event(cli_V, 'B', day_20);
+				// clips.insert_event(cli_V, 'C', day_22);
+				// clips.insert_event(cli_V, 'A', day_29);
+				clp = clp_sq.clips.find(cli_V)->second;
+				REQUIRE(clp.size() == 6);
+				REQUIRE(clp.find(day_10)->second == 'B');
+				REQUIRE(clp.find(day_11)->second == 'C');
+				REQUIRE(clp.find(day_15)->second == 'A');
+				REQUIRE(clp.find(day_20)->second == 'B');
+				REQUIRE(clp.find(day_22)->second == 'C');
+				REQUIRE(clp.find(day_29)->second == 'A');
+
+				// clips.insert_event(cli_W, 'A', day_18);
+				// clips.insert_event(cli_W, 'C', day_28);
+				clp = clp_sq.clips.find(cli_W)->second;
+				REQUIRE(clp.size() == 2);
+				REQUIRE(clp.find(day_18)->second == 'A');
+				REQUIRE(clp.find(day_28)->second == 'C');
+
+				// clips.insert_event(cli_X, 'A', day_10);
+				// clips.insert_event(cli_X, 'E', day_14);
+				// clips.insert_event(cli_X, 'A', day_27);
+				// clips.insert_event(cli_X, 'F', day_30);
+				clp = clp_sq.clips.find(cli_X)->second;
+				REQUIRE(clp.size() == 4);
+				REQUIRE(clp.find(day_10)->second == 'A');
+				REQUIRE(clp.find(day_14)->second == 'E');
+				REQUIRE(clp.find(day_27)->second == 'A');
+				REQUIRE(clp.find(day_30)->second == 'F');
+
+				// clips.insert_event(cli_Y, 'B', day_12);
+				// clips.insert_event(cli_Y, 'D', day_13);
+				// clips.insert_event(cli_Y, 'E', day_16);
+				// clips.insert_event(cli_Y, 'F', day_18);
+				clp = clp_sq.clips.find(cli_Y)->second;
+				REQUIRE(clp.size() == 4);
+				REQUIRE(clp.find(day_12)->second == 'B');
+				REQUIRE(clp.find(day_13)->second == 'D');
+				REQUIRE(clp.find(day_16)->second == 'E');
+				REQUIRE(clp.find(day_18)->second == 'F');
+
+				// clips.insert_event(cli_Z, 'A', day_18);
+				// clips.insert_event(cli_Z, 'F', day_28);
+
+				clp = clp_sq.clips.find(cli_Z)->second;
+				REQUIRE(clp.size() == 2);
+				REQUIRE(clp.find(day_18)->second == 'A');
+				REQUIRE(clp.find(day_28)->second == 'F');
+			}
+		}
+
+		WHEN("I fit a tree to the same clips with dense ids read through a code map") {
+			CodeDict dict = {'A', 'B', 'C', 'D', 'E', 'F', 'A'};
+
+			ClipMap id_clips = {};
+
+			for (ClipMap::iterator it = clips.clips.begin(); it != clips.clips.end(); ++it)
+				for (Clip::iterator jt = it->second.begin(); jt != it->second.end(); ++jt)
+					id_clips[it->first][jt->first] = it->first == cli_X && jt->second == 'A' ? 6 : jt->second - 'A';
+
+			Targets targ_cd(&clips.clips, target_map);
+			Targets targ_id(&id_clips, target_map);
+
+			targ_id.set_code_map(dict);
+
+			REQUIRE(targ_cd.fit(tr_log, ag_minimax, 0.8, 12, true));
+			REQUIRE(targ_id.fit(tr_log, ag_minimax, 0.8, 12, true));
+
+			THEN("It is the same tree and predicts the same") {
+				REQUIRE(targ_id.num_codes() == 6);
+				REQUIRE(targ_id.tree.size() == targ_cd.tree.size());
+
+				for (int i = 0; i < (int) targ_id.tree.size(); i++) {
+					REQUIRE(targ_id.tree[i].n_seen	   == targ_cd.tree[i].n_seen);
+					REQUIRE(targ_id.tree[i].n_target   == targ_cd.tree[i].n_target);
+					REQUIRE(targ_id.tree[i].sum_time_d == targ_cd.tree[i].sum_time_d);
+					REQUIRE(targ_id.child_codes(i)	   == targ_cd.child_codes(i));
+				}
+
+				REQUIRE(targ_id.tree_child(0, 6) == targ_id.tree_child(0, 0));
+				REQUIRE(targ_id.tree_child(0, 0) == targ_cd.tree_child(0, 'A'));
+				REQUIRE(targ_id.tree_child(0, 7) == -1);
+				REQUIRE(targ_cd.tree_child(0, 'Z') == -1);
+
+				REQUIRE(targ_id.predict(&id_clips) == targ_cd.predict(&clips.clips));
+				REQUIRE(targ_id.predict(&id_clips, true) == targ_cd.predict(&clips.clips, true));
+			}
+		}
+	}
+}
+
+
+SCENARIO("Test Targets.save() / Targets.load()") {
+
+	Events	ev = {};
+	Clients	cli = {};
+
+	char timestamp[80];
+	char client[80];
+	char emitter[80];
+	char description[80];
+	double w;
+
+	for (int i = 0; i < 5000; i++) {
+		sprintf(client, "cli-id%i", 77*(i % 500));
+		sprintf(emitter, "emi%i", (int) sqrt(i % 100));
+		sprintf(description, "prod%i", (i % 5) + 1);
+
+		w = i % 11 ? 1.3 : 5.0;
+
+		ev.insert_row(emitter, description, w);
+		cli.add_client_id(client);
+	}
+
+	Clips clp(cli, ev), clp_void({}, {});
+
+	int i = 0;
+	for (int hour = 10; hour < 12; hour++) {
+		for (int min = 10; min < 60; min++) {
+			for (int sec = 10; sec < 60; sec++) {
+				i++;
+
+				sprintf(timestamp, "2022-06-02 %i:%i:%i", hour, min, sec);
+				sprintf(client, "cli-id%i", 77*(i % 500));
+				sprintf(emitter, "emi%i", (int) sqrt(i % 100));
+				sprintf(description, "prod%i", (i % 5) + 1);
+
+				w = i % 11 ? 1.3 : 5.0;
+
+				clp.scan_event(emitter, description, w, client, timestamp);
+			}
+		}
+	}
+
+	Targets trg_def(&clp.clips, {}), trg_alt(&clp_void.clips, {});
+
+	sprintf(timestamp, "2022-06-03 01:02:03");
+
+	for (int i = 0; i < 5000; i++) {
+		if (i % 9 == 2) {
+			sprintf(client, "cli-id%i", 77*(i % 500));
+
+			trg_def.insert_target(client, timestamp);
+		}
+	}
+
+	REQUIRE(trg_def.fit(tr_log, ag_minimax, 0.6, 10, false));
+
+	WHEN("I copy them.") {
+		Targets cpy_def({}, {}), cpy_alt({}, {});
+
+		pBinaryImage p_def = new BinaryImage;
+
+		REQUIRE(trg_def.save(p_def));
+		REQUIRE(cpy_def.load(p_def));
+
+		delete p_def;
+
+		pBinaryImage p_alt = new BinaryImage;
+
+		REQUIRE(trg_alt.save(p_alt));
+		REQUIRE(cpy_alt.load(p_alt));
+
+		delete p_alt;
+
+		THEN("They are identical.") {
+			REQUIRE(strcmp(trg_def.time_format, cpy_def.time_format) == 0);
+			REQUIRE(trg_def.transform == cpy_def.transform);
+			REQUIRE(trg_def.aggregate == cpy_def.aggregate);
+			REQUIRE(trg_def.binomial_z == cpy_def.binomial_z);
+			REQUIRE(trg_def.binomial_z_sqr == cpy_def.binomial_z_sqr);
+			REQUIRE(trg_def.binomial_z_sqr_div_2 == cpy_def.binomial_z_sqr_div_2);
+			REQUIRE(trg_def.tree_depth == cpy_def.tree_depth);
+
+			REQUIRE(strcmp(trg_alt.time_format, cpy_alt.time_format) == 0);
+			REQUIRE(trg_alt.transform == cpy_alt.transform);
+			REQUIRE(trg_alt.aggregate == cpy_alt.aggregate);
+			REQUIRE(trg_alt.binomial_z == cpy_alt.binomial_z);
+			REQUIRE(trg_alt.binomial_z_sqr == cpy_alt.binomial_z_sqr);
+			REQUIRE(trg_alt.binomial_z_sqr_div_2 == cpy_alt.binomial_z_sqr_div_2);
+			REQUIRE(trg_alt.tree_depth == cpy_alt.tree_depth);
+
+			REQUIRE(trg_def.p_clips->size() == cpy_def.p_clips->size()); {
+				ClipMap::iterator it_clip1 = trg_def.p_clips->begin(), it_clip2 = cpy_def.p_clips->begin();
+
+				for (int i = 0; i < 10; i++) {
+					if (it_clip1 == trg_def.p_clips->end())
+						break;
+
+					REQUIRE(it_clip1->first			== it_clip2->first);
+					REQUIRE(it_clip1->second.size()	== it_clip2->second.size());
+					Clip::iterator it1 = it_clip1->second.begin(), it2 = it_clip2->second.begin();
+
+					for (int j = 0; j < 10; j++) {
+						if (it1 == it_clip1->second.end())
+							break;
+
+						REQUIRE(it1->first	== it2->first);
+						REQUIRE(it1->second	== it2->second);
+
+						++it1;
+						++it2;
+					}
+
+					++it_clip1;
+					++it_clip2;
+				}
+			}
+			REQUIRE(trg_alt.p_clips->size() == cpy_alt.p_clips->size()); {
+				ClipMap::iterator it_clip1 = trg_alt.p_clips->begin(), it_clip2 = cpy_alt.p_clips->begin();
+
+				for (int i = 0; i < 10; i++) {
+					if (it_clip1 == trg_alt.p_clips->end())
+						break;
 
 					REQUIRE(it_clip1->first			== it_clip2->first);
 					REQUIRE(it_clip1->second.size()	== it_clip2->second.size());
 					Clip::iterator it1 = it_clip1->second.begin(), it2 = it_clip2->second.begin();
 
-					for (int j = 0; j < 10; j++) {
-						if (it1 == it_clip1->second.end())
-							break;
+					for (int j = 0; j < 10; j++) {
+						if (it1 == it_clip1->second.end())
+							break;
+
+						REQUIRE(it1->first	== it2->first);
+						REQUIRE(it1->second	== it2->second);
+
+						++it1;
+						++it2;
+					}
+
+					++it_clip1;
+					++it_clip2;
+				}
+			}
+			REQUIRE(trg_def.target.size() == cpy_def.target.size()); {
+				TargetMap::iterator it1 = trg_def.target.begin(), it2 = cpy_def.target.begin();
+
+				for (int i = 0; i < 10; i++) {
+					if (it1 == trg_def.target.end())
+						break;
+
+					REQUIRE(it1->first	== it2->first);
+					REQUIRE(it1->second	== it2->second);
+
+					++it1;
+					++it2;
+				}
+			}
+			REQUIRE(trg_alt.target.size() == cpy_alt.target.size()); {
+				TargetMap::iterator it1 = trg_alt.target.begin(), it2 = cpy_alt.target.begin();
+
+				for (int i = 0; i < 10; i++) {
+					if (it1 == trg_alt.target.end())
+						break;
+
+					REQUIRE(it1->first	== it2->first);
+					REQUIRE(it1->second	== it2->second);
+
+					++it1;
+					++it2;
+				}
+			}
+			REQUIRE(trg_def.tree.size() == cpy_def.tree.size()); {
+				for (int i = 0; i < 10; i++) {
+					if (i == trg_def.tree.size())
+						break;
+
+					REQUIRE(trg_def.tree[i].n_seen		 == cpy_def.tree[i].n_seen);
+					REQUIRE(trg_def.tree[i].n_target	 == cpy_def.tree[i].n_target);
+					REQUIRE(trg_def.tree[i].sum_time_d	 == cpy_def.tree[i].sum_time_d);
+					REQUIRE(trg_def.tree[i].child.size() == cpy_def.tree[i].child.size());
+
+					CodeDict code = trg_def.child_codes(i);
+
+					REQUIRE(code == cpy_def.child_codes(i));
+
+					for (int j = 0; j < 10; j++) {
+						if (j == code.size())
+							break;
+
+						REQUIRE(trg_def.tree_child(i, code[j]) == cpy_def.tree_child(i, code[j]));
+					}
+				}
+			}
+			REQUIRE(trg_alt.tree.size() == cpy_alt.tree.size()); {
+				for (int i = 0; i < 10; i++) {
+					if (i == trg_alt.tree.size())
+						break;
+
+					REQUIRE(trg_alt.tree[i].n_seen		 == cpy_alt.tree[i].n_seen);
+					REQUIRE(trg_alt.tree[i].n_target	 == cpy_alt.tree[i].n_target);
+					REQUIRE(trg_alt.tree[i].sum_time_d	 == cpy_alt.tree[i].sum_time_d);
+					REQUIRE(trg_alt.tree[i].child.size() == cpy_alt.tree[i].child.size());
+
+					CodeDict code = trg_alt.child_codes(i);
+
+					REQUIRE(code == cpy_alt.child_codes(i));
+
+					for (int j = 0; j < 10; j++) {
+						if (j == code.size())
+							break;
+
+						REQUIRE(trg_alt.tree_child(i, code[j]) == cpy_alt.tree_child(i, code[j]));
+					}
+				}
+			}
+		}
+	}
+}
+
+
+SCENARIO("Test Clips concurrent ingestion") {
+
+	Events events = {};
+	Clients clients = {};
+
+	char emitter[80], description[80];
+
+	for (int i = 0; i < 1000; i++) {
+		sprintf(emitter, "emi%i", i % 7);
+		sprintf(description, "prod%i", i % 5);
+
+		events.insert_row(emitter, description, 1);
+	}
+
+	Clips sequential(clients, events), concurrent(clients, events);
+
+	auto scan_rows = [](Clips *p_clips, int first, int step) {
+		char timestamp[80], client[80], emitter[80], description[80];
+
+		for (int i = first; i < 40000; i += step) {
+			TimePoint t = 1650000000 + 37*i;
+			TimeStruct ts;
+
+			gmtime_r(&t, &ts);
+			strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &ts);
+
+			sprintf(client, "cli%i", (i*7919) % 503);
+			sprintf(emitter, "emi%i", i % 7);
+			sprintf(description, "prod%i", (i/3) % 6);
+
+			p_clips->scan_event(emitter, description, 1, client, timestamp);
+		}
+	};
+
+	scan_rows(&sequential, 0, 1);
+
+	sequential.insert_event(12345, 1, 1650000000);
+	concurrent.insert_event(12345, 1, 1650000000);
+
+	GIVEN("Four threads scanning the rows in concurrent mode") {
+		concurrent.begin_concurrent(6);
+
+		REQUIRE(concurrent.is_concurrent());
+		REQUIRE(concurrent.shards.size() == 8);
+		REQUIRE(concurrent.shard_shift == 61);
+		REQUIRE(concurrent.clips.size() == 0);
+
+		std::thread threads[4];
+
+		for (int t = 0; t < 4; t++)
+			threads[t] = std::thread(scan_rows, &concurrent, t, 4);
+
+		for (int t = 0; t < 4; t++)
+			threads[t].join();
+
+		THEN("The result is the same as scanning them in one thread") {
+			REQUIRE(sequential.num_events() > 30000);
+			REQUIRE(concurrent.num_events() == sequential.num_events());
+			REQUIRE(!concurrent.is_concurrent());
+			REQUIRE(concurrent.clips == sequential.clips);
+		}
+
+		THEN("The other methods end the concurrent mode") {
+			pBinaryImage p_bi = new BinaryImage;
+
+			REQUIRE(concurrent.save(p_bi));
+			REQUIRE(!concurrent.is_concurrent());
+
+			Clips loaded = {};
+
+			REQUIRE(loaded.load(p_bi));
+			REQUIRE(loaded.clips == sequential.clips);
+
+			delete p_bi;
+
+			concurrent.begin_concurrent(1000000);
+
+			REQUIRE(concurrent.shards.size() == MAX_CLIP_SHARDS);
+
+			concurrent.freeze();
+
+			REQUIRE(!concurrent.is_concurrent());
+			REQUIRE(concurrent.is_frozen());
+			REQUIRE(*concurrent.clip_map() == sequential.clips);
+		}
+	}
+
+	GIVEN("Rows of the same clients at the same times in every range of the rows") {
+		Clips in_order(clients, events);
+
+		String rows;
+
+		char timestamp[80], client[80], line[320];
+
+		for (int i = 0; i < 20000; i++) {
+			TimePoint t = 1650000000 + 60*(i % 1000);
+			TimeStruct ts;
+
+			gmtime_r(&t, &ts);
+			strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &ts);
+
+			sprintf(client, "cli%i", i % 50);
+			sprintf(emitter, "emi%i", (i/1000) % 7);
+			sprintf(description, "prod%i", (i/3000) % 5);
+
+			in_order.scan_event(emitter, description, 1, client, timestamp);
+
+			sprintf(line, "%s\t%s\t1\t%s\t%s\n", emitter, description, client, timestamp);
+			rows += line;
+		}
+
+		THEN("scan_rows() keeps the last row of each client and time, as scanning them in order") {
+			REQUIRE(in_order.num_events() == 1000);
+
+			int num_threads[4] = {1, 2, 3, 7};
+
+			for (int k = 0; k < 4; k++) {
+				Clips scanned(clients, events);
+
+				String buffer = rows;
+
+				scanned.scan_rows(&buffer[0], buffer.size(), num_threads[k]);
+
+				REQUIRE(scanned.clips == in_order.clips);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Test Clips bulk loading") {
+
+	Clips sequential({}, {}), bulk({}, {}), bulk_cmp({}, {}), bounded({}, {}), bulk_bounded({}, {});
+
+	bulk.begin_bulk();
+	bulk_cmp.begin_bulk(true);
+	bulk_bounded.begin_bulk();
+
+	bounded.set_history(4, 3600*500);
+	bulk_bounded.set_history(4, 3600*500);
+
+	REQUIRE(bulk.is_bulk());
+	REQUIRE(!bulk_bounded.is_bulk());
+
+	bulk_bounded.begin_bulk();
+
+	for (int i = 0; i < 30000; i++) {
+		ElementHash client = MurmurHash64A(&i, 2) % 700 + 1;
+		TimePoint	time_pt = 1650000000 + 3600*((i*7919) % 3000);	// Repeated times, the last one must win.
+		uint64_t	code	= 1 + (i*i % 11) % 6;
+
+		sequential.insert_event(client, code, time_pt);
+		bulk.insert_event(client, code, time_pt);
+		bulk_cmp.insert_event(client, code, time_pt);
+		bounded.insert_event(client, code, time_pt);
+		bulk_bounded.insert_event(client, code, time_pt);
+	}
+
+	REQUIRE(bulk.bulk_events.size() == 1);
+	REQUIRE(bulk.bulk_events[0].size() == 30000);
+	REQUIRE(bulk.bulk_events[0].capacity() == BULK_CHUNK_EVENTS);
+	REQUIRE(bulk.clips.size() == 0);
+
+	GIVEN("The objects after ending the bulk mode") {
+		REQUIRE(bulk.num_events() == sequential.num_events());
+		REQUIRE(!bulk.is_bulk());
+		REQUIRE(bulk.is_frozen());
+		REQUIRE(bulk.bulk_events.size() == 0);
+
+		bulk_cmp.end_bulk();
+		bulk_bounded.end_bulk();
+
+		REQUIRE(bulk_cmp.frozen.compressed);
+		REQUIRE(bulk_bounded.num_events() == bounded.num_events());
+
+		THEN("They have the same clips as the ones inserted one by one") {
+			REQUIRE(*bulk.clip_map() == sequential.clips);
+			REQUIRE(*bulk_cmp.clip_map() == sequential.clips);
+			REQUIRE(*bulk_bounded.clip_map() == bounded.clips);
+		}
+
+		WHEN("More events are inserted in bulk mode") {
+			bulk.begin_bulk();
+
+			for (int i = 0; i < 100; i++) {
+				bulk.insert_event(i + 1, 9, 1650000000 + 3600*i);
+				sequential.insert_event(i + 1, 9, 1650000000 + 3600*i);
+			}
+
+			THEN("They are merged with the clips already in the object") {
+				REQUIRE(*bulk.clip_map() == sequential.clips);
+			}
+		}
+
+		WHEN("More events are inserted in bulk mode after thawing the clips") {
+			REQUIRE(bulk.clip_map()->size() > 0);
+			REQUIRE(!bulk.is_frozen());
+
+			bulk.begin_bulk();
+
+			for (int i = 0; i < 100; i++) {
+				bulk.insert_event(i + 1, 9, 1650000000 + 7200*i);
+				sequential.insert_event(i + 1, 9, 1650000000 + 7200*i);
+			}
+
+			THEN("They are merged with the clips of the ClipMap") {
+				REQUIRE(*bulk.clip_map() == sequential.clips);
+			}
+		}
+	}
+
+	GIVEN("Rows sorted from many threads") {
+		ClipEvents		rows = {}, by_threads = {};
+		ClipEventChunks chunks = {};
+
+		for (int i = 0; i < 200000; i++) {
+			uint64_t hh = MurmurHash64A(&i, 4);
+
+			rows.push_back(ClipEvent {hh % 5 == 0 ? hh : hh % 3000, (TimePoint) (hh >> 40) % 50, (uint64_t) i});
+
+			if (i % 30000 == 0 || i == 12345)		// Chunks of uneven sizes
+				chunks.push_back(ClipEvents());
+
+			chunks.back().push_back(rows.back());
+		}
+
+		std::stable_sort(rows.begin(), rows.end(), [](const ClipEvent &a, const ClipEvent &b) {
+			return a.client < b.client || (a.client == b.client && a.time < b.time);
+		});
+
+		bulk.sort_bulk(chunks, by_threads, 4);
+
+		REQUIRE(chunks.size() == 0);
+
+		THEN("The result is the same as a stable sort") {
+			int differences = 0;
+
+			for (uint64_t i = 0; i < rows.size(); i++)
+				differences += rows[i].client != by_threads[i].client || rows[i].time != by_threads[i].time || rows[i].code != by_threads[i].code;
+
+			REQUIRE(by_threads.size() == rows.size());
+			REQUIRE(differences == 0);
+		}
+	}
+}
+
+
+SCENARIO("Test Clips.merge()") {
+
+	Clips whole = {}, part_1 = {}, part_2 = {}, part_3 = {};
+
+	for (int i = 0; i < 30000; i++) {
+		ElementHash client = MurmurHash64A(&i, 3) % 400 + 1;
+		uint64_t	code   = 1 + i % 5;
+		TimePoint	time   = 1650000000 + 600*((i*7919) % 20000);
+
+		whole.insert_event(client, code, time);
+
+		Clips &part = i < 10000 ? part_1 : (i < 20000 ? part_2 : part_3);
+
+		part.insert_event(client, code, time);
+	}
+
+	GIVEN("Three Clips built over disjoint slices of the rows") {
+		part_3.freeze(true);
+
+		REQUIRE(part_1.num_events() < whole.num_events());
+
+		WHEN("I merge them into the first one") {
+			REQUIRE(!part_1.merge(part_1));
+			REQUIRE(part_1.merge(part_2));
+			REQUIRE(part_1.merge(part_3));
+
+			THEN("It is the same as the Clips built over all the rows") {
+				REQUIRE(part_1.num_clips() == whole.num_clips());
+				REQUIRE(part_1.num_events() == whole.num_events());
+				REQUIRE(part_1.clips == whole.clips);
+				REQUIRE(part_3.is_frozen());
+			}
+		}
+
+		WHEN("They have events at the same time or different hash functions") {
+			ElementHash client = part_1.clips.begin()->first;
+			TimePoint	time   = part_1.clips.begin()->second.begin()->first;
+
+			part_2.insert_event(client, 99, time);
+
+			REQUIRE(part_1.merge(part_2));
+
+			Clips wyhash = {};
+
+			wyhash.clients.hash_function = hf_wyhash;
+
+			THEN("The last merged wins") {
+				REQUIRE(part_1.clips[client][time] == 99);
+				REQUIRE(!part_1.merge(wyhash));
+			}
+		}
+	}
+}
+
+
+SCENARIO("Test Clips bounded history") {
+
+	Clips whole = {}, by_length = {}, by_time = {}, reversed = {};
+
+	by_length.set_history(5, 0);
+	by_time.set_history(0, 3600*24);
+	reversed.set_history(5, 3600*24);
+
+	for (int i = 0; i < 20000; i++) {
+		ElementHash client = MurmurHash64A(&i, 3) % 200 + 1;
+		uint64_t	code   = 1 + i % 7;
+		TimePoint	time   = 1650000000 + 600*((i*7919) % 20000);
+
+		whole.insert_event(client, code, time);
+		by_length.insert_event(client, code, time);
+		by_time.insert_event(client, code, time);
+	}
+
+	for (int i = 19999; i >= 0; i--) {
+		ElementHash client = MurmurHash64A(&i, 3) % 200 + 1;
+
+		reversed.insert_event(client, 1 + i % 7, 1650000000 + 600*((i*7919) % 20000));
+	}
+
+	GIVEN("Clips with a bounded history") {
+		REQUIRE(by_length.num_clips() == whole.num_clips());
+		REQUIRE(by_length.num_events() == 5*whole.num_clips());
+
+		THEN("They keep the most recent events of the whole clips in any arrival order") {
+			int differences = 0;
+
+			for (ClipMap::iterator it = whole.clips.begin(); it != whole.clips.end(); ++it) {
+				Clip last_5 = {}, last_day = {}, both = {};
+
+				TimePoint last_time = it->second.rbegin()->first;
+
+				for (Clip::reverse_iterator jt = it->second.rbegin(); jt != it->second.rend(); ++jt) {
+					if (last_5.size() < 5)
+						last_5[jt->first] = jt->second;
+
+					if (jt->first >= last_time - 3600*24) {
+						last_day[jt->first] = jt->second;
+
+						if (both.size() < 5)
+							both[jt->first] = jt->second;
+					}
+				}
+
+				differences += by_length.clips[it->first] != last_5;
+				differences += by_time.clips[it->first] != last_day;
+				differences += reversed.clips[it->first] != both;
+			}
+
+			REQUIRE(differences == 0);
+		}
+
+		WHEN("I fit Targets with a shorter tree depth on whole and bounded clips") {
+			TargetMap target_map = {};
+
+			for (ClipMap::iterator it = whole.clips.begin(); it != whole.clips.end(); ++it)
+				if (it->first % 3 == 0)
+					target_map[it->first] = it->second.rbegin()->first + 3600;
+
+			Targets targ_whole(whole.clip_map(), target_map), targ_bounded(by_length.clip_map(), target_map);
+
+			REQUIRE(targ_whole.fit(tr_log, ag_minimax, 0.5, 5, false));
+			REQUIRE(targ_bounded.fit(tr_log, ag_minimax, 0.5, 5, false));
+
+			THEN("The models are the same") {
+				REQUIRE(targ_bounded.tree.size() == targ_whole.tree.size());
+				REQUIRE(targ_bounded.predict(by_length.clip_map()) == targ_whole.predict(by_length.clip_map()));
+			}
+		}
+
+		WHEN("I bound the history of a Clips object afterwards") {
+			whole.set_history(5, 0);
+
+			THEN("It is trimmed") {
+				REQUIRE(whole.clips == by_length.clips);
+			}
+		}
+	}
+}
+
+
+SCENARIO("Test Clips.freeze()") {
+
+	Clips thawed({}, {});
+
+	TargetMap target_map = {};
+	Clients	  some_clients = {};
+
+	for (int i = 0; i < 20000; i++) {
+		ElementHash client = MurmurHash64A(&i, 2) % 300 + 1;
+
+		thawed.insert_event(client, 1 + (i*i % 7) % 4, 1650000000 + 3600*((i*7919) % 5000));
+
+		if (i % 3 == 0)
+			target_map[client] = 1650000000 + 3600*5000 - i;
+
+		if (i % 500 == 0)
+			some_clients.id.push_back(client);
+	}
+	some_clients.id.push_back(12345);
+
+	Clips frozen(thawed);
+
+	REQUIRE(!frozen.is_frozen());
+
+	frozen.freeze();
+
+	GIVEN("A frozen copy of a Clips object") {
+		REQUIRE(frozen.is_frozen());
+		REQUIRE(frozen.clips.size() == 0);
+		REQUIRE(frozen.num_clips() == thawed.num_clips());
+		REQUIRE(frozen.num_events() == thawed.num_events());
+		REQUIRE(frozen.frozen.offset.size() == thawed.clips.size() + 1);
+		REQUIRE(frozen.frozen.offset.back() == thawed.num_events());
+		REQUIRE(std::is_sorted(frozen.frozen.client.begin(), frozen.frozen.client.end()));
+
+		ClipMap clip_map = {};
+
+		frozen.frozen.to_clip_map(clip_map);
+
+		REQUIRE(clip_map == thawed.clips);
+		REQUIRE(frozen.frozen.find(12345) == -1);
+		REQUIRE(frozen.frozen.clip(frozen.frozen.find(frozen.frozen.client[7])) == thawed.clips[frozen.frozen.client[7]]);
+
+		WHEN("I save it and load it into another object") {
+			pBinaryImage p_bi = new BinaryImage;
+
+			REQUIRE(frozen.save(p_bi));
+
+			Clips loaded = {};
+
+			REQUIRE(loaded.load(p_bi));
+
+			delete p_bi;
+
+			THEN("It is the same as the original") {
+				REQUIRE(!loaded.is_frozen());
+				REQUIRE(loaded.clips == thawed.clips);
+
+				Clips cpy(frozen);
+
+				REQUIRE(cpy.is_frozen());
+				REQUIRE(cpy.frozen.code == frozen.frozen.code);
+			}
+		}
+
+		WHEN("I collapse both to states") {
+			thawed.collapse_to_states();
+			frozen.collapse_to_states();
+
+			THEN("They are still the same") {
+				REQUIRE(frozen.num_events() == thawed.num_events());
+				REQUIRE(frozen.num_events() < 20000);
+
+				clip_map.clear();
+				frozen.frozen.to_clip_map(clip_map);
+
+				REQUIRE(clip_map == thawed.clips);
+			}
+		}
+
+		WHEN("I fit as states without collapsing the clips first") {
+			uint64_t num_events = thawed.num_events();
+
+			Clips collapsed(thawed);
+
+			collapsed.collapse_to_states();
+
+			Targets on_states(thawed.raw_clip_map(), target_map), on_collapsed(collapsed.raw_clip_map(), target_map);
+			Targets on_frozen(frozen.raw_clip_map(), target_map, frozen.frozen_clips());
+
+			REQUIRE(on_states.fit(tr_log, ag_minimax, 0.5, 6, true));
+			REQUIRE(on_collapsed.fit(tr_log, ag_minimax, 0.5, 6, false));
+			REQUIRE(on_frozen.fit(tr_log, ag_minimax, 0.5, 6, true));
+
+			THEN("The models are the same and the clips are not modified") {
+				REQUIRE(thawed.num_events() == num_events);
+				REQUIRE(frozen.num_events() == num_events);
+				REQUIRE(collapsed.num_events() < num_events);
+
+				REQUIRE(on_states.tree.size() == on_collapsed.tree.size());
+				REQUIRE(on_frozen.tree.size() == on_collapsed.tree.size());
+
+				REQUIRE(on_states.predict(collapsed.raw_clip_map()) == on_collapsed.predict());
+				REQUIRE(on_frozen.predict(collapsed.raw_clip_map()) == on_collapsed.predict());
+
+				ClipCursor cur;
+				TimePoint  time_pt;
+				uint64_t   code;
+				Clip	   states = {};
+
+				frozen.frozen.last_event(3, cur);
+
+				while (frozen.frozen.prev_state(cur, time_pt, code))
+					states[time_pt] = code;
+
+				REQUIRE(states == collapsed.clips[frozen.frozen.client[3]]);
+			}
+		}
+
+		WHEN("I fit Targets on both") {
+			Targets targ_thawed(thawed.raw_clip_map(), target_map), targ_frozen(frozen.raw_clip_map(), target_map, frozen.frozen_clips());
+			Targets sts_thawed(thawed.raw_clip_map(), target_map), sts_frozen(frozen.raw_clip_map(), target_map, frozen.frozen_clips());
+
+			REQUIRE(targ_thawed.fit(tr_log, ag_minimax, 0.5, 8, false));
+			REQUIRE(targ_frozen.fit(tr_log, ag_minimax, 0.5, 8, false));
+			REQUIRE(sts_thawed.fit(tr_linear, ag_mean, 0.5, 4, true));
+			REQUIRE(sts_frozen.fit(tr_linear, ag_mean, 0.5, 4, true));
+
+			THEN("They make the same predictions") {
+				REQUIRE(frozen.is_frozen());
+				REQUIRE(targ_frozen.tree.size() == targ_thawed.tree.size());
+				REQUIRE(sts_frozen.tree.size() == sts_thawed.tree.size());
+				REQUIRE(sts_frozen.tree.size() < targ_frozen.tree.size());
+
+				REQUIRE(targ_frozen.predict() == targ_thawed.predict());
+				REQUIRE(sts_frozen.predict() == sts_thawed.predict());
+				REQUIRE(targ_frozen.predict(some_clients) == targ_thawed.predict(some_clients));
+				REQUIRE(targ_frozen.predict(frozen.frozen_clips()) == targ_thawed.predict(thawed.raw_clip_map()));
+
+				pBinaryImage p_bi_thawed = new BinaryImage, p_bi_frozen = new BinaryImage;
+
+				REQUIRE(targ_thawed.save(p_bi_thawed));
+				REQUIRE(targ_frozen.save(p_bi_frozen));
+
+				Targets loaded(nullptr, {});
+
+				REQUIRE(loaded.load(p_bi_frozen));
+				REQUIRE(*loaded.clip_map() == thawed.clips);
+				REQUIRE(loaded.predict() == targ_thawed.predict());
+
+				Targets reloaded(nullptr, {}, frozen.frozen_clips());
+
+				REQUIRE(reloaded.use_frozen());
+				REQUIRE(reloaded.load(p_bi_thawed));
+				REQUIRE(!reloaded.use_frozen());
+				REQUIRE(reloaded.predict() == targ_thawed.predict());
+
+				delete p_bi_thawed;
+				delete p_bi_frozen;
+			}
+
+			THEN("Inserting events thaws the object") {
+				frozen.insert_event(12345, 1, 1650000000);
+
+				REQUIRE(!frozen.is_frozen());
+				REQUIRE(frozen.frozen.offset.size() == 0);
+				REQUIRE(frozen.num_events() == thawed.num_events() + 1);
+				REQUIRE(frozen.clip_map()->size() == thawed.clips.size() + 1);
+			}
+		}
+	}
+
+	GIVEN("A compressed frozen copy of a Clips object") {
+		Clips compressed(thawed);
+
+		compressed.freeze(true);
+
+		REQUIRE(compressed.is_frozen());
+		REQUIRE(compressed.frozen.compressed);
+		REQUIRE(compressed.frozen.code.size() == 0);
+		REQUIRE(compressed.frozen.code_dict.size() == 3);
+		REQUIRE(compressed.frozen.code_bits == 2);
+		REQUIRE(compressed.num_events() == thawed.num_events());
+		REQUIRE(compressed.frozen.client == frozen.frozen.client);
+		REQUIRE(compressed.frozen.offset == frozen.frozen.offset);
+		REQUIRE(4*compressed.frozen.memory_size() < frozen.frozen.memory_size());
+
+		ClipMap clip_map = {};
+
+		compressed.frozen.to_clip_map(clip_map);
+
+		REQUIRE(clip_map == thawed.clips);
+
+		WHEN("I save it, load it and copy it") {
+			pBinaryImage p_bi = new BinaryImage;
+
+			REQUIRE(compressed.save(p_bi));
+
+			Clips loaded = {};
+
+			REQUIRE(loaded.load(p_bi));
+
+			delete p_bi;
+
+			Clips cpy(compressed);
+
+			THEN("It is the same as the original") {
+				REQUIRE(loaded.clips == thawed.clips);
+				REQUIRE(cpy.frozen.compressed);
+				REQUIRE(cpy.frozen.packed_code == compressed.frozen.packed_code);
+				REQUIRE(cpy.frozen.time_bytes == compressed.frozen.time_bytes);
+			}
+		}
+
+		WHEN("I collapse both to states") {
+			thawed.collapse_to_states();
+			compressed.collapse_to_states();
+
+			THEN("They are still the same") {
+				REQUIRE(compressed.frozen.compressed);
+				REQUIRE(compressed.num_events() == thawed.num_events());
+
+				clip_map.clear();
+				compressed.frozen.to_clip_map(clip_map);
+
+				REQUIRE(clip_map == thawed.clips);
+			}
+		}
+
+		WHEN("I fit Targets on both") {
+			Targets targ_thawed(thawed.raw_clip_map(), target_map), targ_frozen(compressed.raw_clip_map(), target_map, compressed.frozen_clips());
+			Targets sts_thawed(thawed.raw_clip_map(), target_map), sts_frozen(compressed.raw_clip_map(), target_map, compressed.frozen_clips());
+
+			REQUIRE(targ_thawed.fit(tr_log, ag_minimax, 0.5, 8, false));
+			REQUIRE(targ_frozen.fit(tr_log, ag_minimax, 0.5, 8, false));
+			REQUIRE(sts_thawed.fit(tr_linear, ag_mean, 0.5, 4, true));
+			REQUIRE(sts_frozen.fit(tr_linear, ag_mean, 0.5, 4, true));
+
+			THEN("They make the same predictions") {
+				REQUIRE(targ_frozen.tree.size() == targ_thawed.tree.size());
+				REQUIRE(sts_frozen.tree.size() == sts_thawed.tree.size());
+
+				REQUIRE(targ_frozen.predict() == targ_thawed.predict());
+				REQUIRE(sts_frozen.predict() == sts_thawed.predict());
+				REQUIRE(targ_frozen.predict(some_clients) == targ_thawed.predict(some_clients));
+			}
+		}
+	}
+
+	GIVEN("Clips with times before 1970, equal times and large codes") {
+		ClipMap clip_map = {};
+
+		clip_map[11][-86400*365] = 0xffffffffffffffff;
+		clip_map[11][-1]		 = 3;
+		clip_map[11][0]			 = 0x8000000000000000;
+		clip_map[11][1]			 = 3;
+		clip_map[22][1650000000] = 0xffffffffffffffff;
+		clip_map[33][-5]		 = 7;
+		clip_map[33][1650000000] = 7;
+		clip_map[33][1650000001] = 7;
+
+		FrozenClips packed;
+
+		packed.build(clip_map, true);
+
+		THEN("They are restored exactly") {
+			REQUIRE(packed.num_events() == 8);
+			REQUIRE(packed.code_dict.size() == 4);
+
+			ClipMap restored = {};
+
+			packed.to_clip_map(restored);
+
+			REQUIRE(restored == clip_map);
+
+			packed.collapse_to_states();
+
+			REQUIRE(packed.num_events() == 6);
+			REQUIRE(packed.clip(2).size() == 1);
+			REQUIRE(packed.clip(2).begin()->first == -5);
+
+			packed.clear();
+
+			REQUIRE(!packed.is_frozen());
+			REQUIRE(!packed.compressed);
+		}
+	}
+
+	GIVEN("Clips whose codes are some of the ids of an Events object") {
+		Events events = {};
+
+		REQUIRE(events.define_event((char *) "emi_A", (char *) "descr_A", 1, 30));
+		REQUIRE(events.define_event((char *) "emi_B", (char *) "descr_B", 1, 10));
+		REQUIRE(events.define_event((char *) "emi_C", (char *) "descr_C", 1, 40));
+		REQUIRE(events.define_event((char *) "emi_D", (char *) "descr_D", 1, 20));
+
+		REQUIRE(events.num_ids() == 0);
+
+		events.freeze();
+
+		REQUIRE(events.num_ids() == 4);
+		REQUIRE(events.event_id(10) == 0);
+		REQUIRE(events.event_id(30) == 2);
+		REQUIRE(events.event_id(40) == 3);
+		REQUIRE(events.event_id(31) == -1);
+		REQUIRE(events.event_id(99) == -1);
+		REQUIRE(events.id_codes()[1] == 20);
+
+		ClipMap clip_map = {};
+
+		clip_map[11][1] = 40;
+		clip_map[11][2] = 20;
+		clip_map[22][5] = 40;
+
+		ClipMap with_other = clip_map;
+
+		with_other[22][6] = 50;
+
+		FrozenClips by_id, by_code;
+
+		by_id.build(clip_map, true, &events.id_codes());
+		by_code.build(with_other, true, &events.id_codes());
+
+		THEN("The index of an event is its Events id, unless a code is not in the Events.") {
+			REQUIRE(by_id.code_dict == events.id_codes());
+			REQUIRE(by_id.packed_index(0) == 3);
+			REQUIRE(by_id.packed_index(1) == 1);
+			REQUIRE(by_id.packed_index(2) == 3);
+
+			REQUIRE(by_code.code_dict.size() == 3);
+			REQUIRE(by_code.code_dict[2] == 50);
+
+			ClipMap restored = {}, restored_other = {};
+
+			by_id.to_clip_map(restored);
+			by_code.to_clip_map(restored_other);
+
+			REQUIRE(restored == clip_map);
+			REQUIRE(restored_other == with_other);
+		}
+
+		THEN("A Clips compresses its clips with the ids of its own events.") {
+			Clips clips({}, events);
+
+			for (ClipMap::iterator it = clip_map.begin(); it != clip_map.end(); ++it)
+				for (Clip::iterator jt = it->second.begin(); jt != it->second.end(); ++jt)
+					clips.insert_event(it->first, jt->second, jt->first);
+
+			clips.freeze(true);
+
+			REQUIRE(clips.events.num_ids() == 4);
+			REQUIRE(clips.frozen_clips()->code_dict == events.id_codes());
+			REQUIRE(clips.frozen_clips()->packed_code == by_id.packed_code);
+		}
+
+		THEN("Modifying the events drops the ids.") {
+			REQUIRE(events.define_event((char *) "emi_E", (char *) "descr_E", 1, 50));
+			REQUIRE(events.num_ids() == 0);
+		}
+	}
+}
+
+
+SCENARIO("Test Clips time window views") {
+
+	Clips all({}, {}), in_window({}, {});
+
+	TimePoint from = 1650000000 + 3600*1000, to = 1650000000 + 3600*4000;
+
+	TargetMap target_map = {};
+
+	for (int i = 0; i < 20000; i++) {
+		ElementHash client = MurmurHash64A(&i, 2) % 300 + 1;
+		TimePoint	time_pt = 1650000000 + 3600*((i*7919) % 5000);
+		uint64_t	code	= 1 + (i*i % 7) % 4;
+
+		all.insert_event(client, code, time_pt);
+
+		if (time_pt >= from && time_pt < to)
+			in_window.insert_event(client, code, time_pt);
+
+		if (i % 3 == 0)
+			target_map[client] = to + 3600 - i;
+	}
+
+	REQUIRE(in_window.num_events() < all.num_events());
+
+	Clients window_clients = {};
+
+	for (ClipMap::iterator it = in_window.clips.begin(); it != in_window.clips.end(); ++it)
+		window_clients.id.push_back(it->first);
+
+	Targets rebuilt(in_window.raw_clip_map(), target_map), sts_rebuilt(in_window.raw_clip_map(), target_map);
+
+	REQUIRE(rebuilt.fit(tr_log, ag_minimax, 0.5, 8, false));
+	REQUIRE(sts_rebuilt.fit(tr_log, ag_minimax, 0.5, 6, true));
+
+	GIVEN("A ClipsView of a thawed, a frozen and a compressed Clips object") {
+		Clips frozen(all), compressed(all);
+
+		frozen.freeze();
+		compressed.freeze(true);
+
+		Clips *p_clips[3] = {&all, &frozen, &compressed};
 
-						REQUIRE(it1->first	== it2->first);
-						REQUIRE(it1->second	== it2->second);
+		for (int k = 0; k < 3; k++) {
+			Targets targ(p_clips[k]->between(from, to), target_map), sts(p_clips[k]->between(from, to), target_map);
 
-						++it1;
-						++it2;
-					}
+			REQUIRE(targ.fit(tr_log, ag_minimax, 0.5, 8, false));
+			REQUIRE(sts.fit(tr_log, ag_minimax, 0.5, 6, true));
 
-					++it_clip1;
-					++it_clip2;
-				}
-			}
-			REQUIRE(clp_alt.clips.size() == cpy_alt.clips.size()); {
-				ClipMap::iterator it_clip1 = clp_alt.clips.begin(), it_clip2 = cpy_alt.clips.begin();
+			THEN("It fits and predicts the same as a Clips object rebuilt from the events in the window") {
+				REQUIRE(targ.tree.size() == rebuilt.tree.size());
+				REQUIRE(sts.tree.size() == sts_rebuilt.tree.size());
+				REQUIRE(sts.tree.size() < targ.tree.size());
 
-				for (int i = 0; i < 10; i++) {
-					if (it_clip1 == clp_alt.clips.end())
-						break;
+				REQUIRE(targ.predict().size() == p_clips[k]->num_clips());
+				REQUIRE(targ.predict(window_clients) == rebuilt.predict(window_clients));
+				REQUIRE(sts.predict(window_clients) == sts_rebuilt.predict(window_clients));
+				REQUIRE(targ.predict(in_window.between(from, to)) == rebuilt.predict());
+				REQUIRE(targ.predict(all.raw_clip_map()) == targ.predict());
+				REQUIRE(targ.predict(frozen.frozen_clips()) == targ.predict());
+				REQUIRE(targ.predict(compressed.frozen_clips()) == targ.predict());
 
-					REQUIRE(it_clip1->first			== it_clip2->first);
-					REQUIRE(it_clip1->second.size()	== it_clip2->second.size());
-					Clip::iterator it1 = it_clip1->second.begin(), it2 = it_clip2->second.begin();
+				pBinaryImage p_bi = new BinaryImage;
 
-					for (int j = 0; j < 10; j++) {
-						if (it1 == it_clip1->second.end())
-							break;
+				REQUIRE(targ.save(p_bi));
 
-						REQUIRE(it1->first	== it2->first);
-						REQUIRE(it1->second	== it2->second);
+				Targets loaded(nullptr, {});
 
-						++it1;
-						++it2;
-					}
+				REQUIRE(loaded.load(p_bi));
+				REQUIRE(*loaded.clip_map() == in_window.clips);
+				REQUIRE(loaded.predict() == rebuilt.predict());
 
-					++it_clip1;
-					++it_clip2;
-				}
+				delete p_bi;
 			}
 		}
 	}
-}
 
+	GIVEN("A ClipsView of a Clips object up to a time") {
+		Clips up_to({}, {});
 
-SCENARIO("Test Targets") {
+		for (ClipMap::iterator it = all.clips.begin(); it != all.clips.end(); ++it)
+			for (Clip::iterator jt = it->second.begin(); jt != it->second.end() && jt->first < to; ++jt)
+				up_to.insert_event(it->first, jt->second, jt->first);
 
-	Events events = {};
+		Targets targ(all.as_of(to), target_map), targ_up_to(up_to.raw_clip_map(), target_map);
 
-	events.define_event((char *) "emi_A", (char *) "descr_A", 1, 'A');
-	events.define_event((char *) "emi_B", (char *) "descr_B", 1, 'B');
-	events.define_event((char *) "emi_C", (char *) "descr_C", 1, 'C');
-	events.define_event((char *) "emi_D", (char *) "descr_D", 1, 'D');
-	events.define_event((char *) "emi_E", (char *) "descr_E", 1, 'E');
-	events.define_event((char *) "emi_F", (char *) "descr_F", 1, 'F');
+		REQUIRE(targ.fit(tr_linear, ag_mean, 0.5, 8, false));
+		REQUIRE(targ_up_to.fit(tr_linear, ag_mean, 0.5, 8, false));
 
-	BinEventPt event_A = {MurmurHash64A((char *) "emi_A", 5), MurmurHash64A((char *) "descr_A", 7), 1};
-	BinEventPt event_B = {MurmurHash64A((char *) "emi_B", 5), MurmurHash64A((char *) "descr_B", 7), 1};
-	BinEventPt event_C = {MurmurHash64A((char *) "emi_C", 5), MurmurHash64A((char *) "descr_C", 7), 1};
-	BinEventPt event_D = {MurmurHash64A((char *) "emi_D", 5), MurmurHash64A((char *) "descr_D", 7), 1};
-	BinEventPt event_E = {MurmurHash64A((char *) "emi_E", 5), MurmurHash64A((char *) "descr_E", 7), 1};
-	BinEventPt event_F = {MurmurHash64A((char *) "emi_F", 5), MurmurHash64A((char *) "descr_F", 7), 1};
+		THEN("It is the same as a Clips object with the events up to that time") {
+			REQUIRE(targ.tree.size() == targ_up_to.tree.size());
+			REQUIRE(targ.predict(up_to) == targ_up_to.predict());
+			REQUIRE(targ.predict(all) == targ.predict());
+			REQUIRE(targ.predict(all.raw_clip_map()) == targ.predict());
+			REQUIRE(targ.predict(all) != targ_up_to.predict(all.raw_clip_map()));
+		}
+	}
+}
 
-	REQUIRE(events.event.size() == 6);
 
-	REQUIRE(events.event[event_A].code == 'A');
-	REQUIRE(events.event[event_B].code == 'B');
-	REQUIRE(events.event[event_C].code == 'C');
-	REQUIRE(events.event[event_D].code == 'D');
-	REQUIRE(events.event[event_E].code == 'E');
-	REQUIRE(events.event[event_F].code == 'F');
+SCENARIO("Test Clips.export_columns()") {
 
-	Clients clients = {};
+	GIVEN("A thawed, a frozen and a compressed Clips object.") {
+		Clips thawed({}, {});
 
-	clients.add_client_id((char *) "cli_U");
-	clients.add_client_id((char *) "cli_V");
-	clients.add_client_id((char *) "cli_W");
-	clients.add_client_id((char *) "cli_X");
-	clients.add_client_id((char *) "cli_Y");
-	clients.add_client_id((char *) "cli_Z");
+		for (int i = 0; i < 5000; i++)
+			thawed.insert_event(MurmurHash64A(&i, 2) % 100 + 1, 1 + i % 9, 1650000000 + 60*((i*7919) % 3000));
 
-	ElementHash cli_U = MurmurHash64A((char *) "cli_U", 5);
-	ElementHash cli_V = MurmurHash64A((char *) "cli_V", 5);
-	ElementHash cli_W = MurmurHash64A((char *) "cli_W", 5);
-	ElementHash cli_X = MurmurHash64A((char *) "cli_X", 5);
-	ElementHash cli_Y = MurmurHash64A((char *) "cli_Y", 5);
-	ElementHash cli_Z = MurmurHash64A((char *) "cli_Z", 5);
+		Clips frozen(thawed), compressed(thawed);
 
-	REQUIRE(clients.id.size() == 6);
+		frozen.freeze();
+		compressed.freeze(true);
 
-	REQUIRE(clients.id_set.find(cli_U) != clients.id_set.end());
-	REQUIRE(clients.id_set.find(cli_V) != clients.id_set.end());
-	REQUIRE(clients.id_set.find(cli_W) != clients.id_set.end());
-	REQUIRE(clients.id_set.find(cli_X) != clients.id_set.end());
-	REQUIRE(clients.id_set.find(cli_Y) != clients.id_set.end());
-	REQUIRE(clients.id_set.find(cli_Z) != clients.id_set.end());
+		Clips *p_clips[3] = {&thawed, &frozen, &compressed};
 
-	Clips clips(clients, events);
+		uint64_t n = thawed.num_clips(), m = thawed.num_events();
 
-	TimePoint day_10 = clips.get_time((char *) "2022-01-10 12:33:44");
+		for (int k = 0; k < 3; k++) {
+			std::vector<ElementHash> client(n);
+			std::vector<uint64_t>	 offset(n + 1), code(m);
+			std::vector<TimePoint>	 time(m);
 
-	REQUIRE(day_10 > 0);
+			ClipColumns cols = {client.data(), offset.data(), time.data(), code.data()};
 
-	TimePoint day_11 = clips.get_time((char *) "2022-01-11 12:33:44");
-	TimePoint day_12 = clips.get_time((char *) "2022-01-12 12:33:44");
-	TimePoint day_13 = clips.get_time((char *) "2022-01-13 12:33:44");
-	TimePoint day_14 = clips.get_time((char *) "2022-01-14 12:33:44");
-	TimePoint day_15 = clips.get_time((char *) "2022-01-15 12:33:44");
-	TimePoint day_16 = clips.get_time((char *) "2022-01-16 12:33:44");
-	TimePoint day_17 = clips.get_time((char *) "2022-01-17 12:33:44");
-	TimePoint day_18 = clips.get_time((char *) "2022-01-18 12:33:44");
-	TimePoint day_19 = clips.get_time((char *) "2022-01-19 12:33:44");
+			p_clips[k]->export_columns(cols);
 
-	TimePoint day_20 = clips.get_time((char *) "2022-01-20 12:33:44");
-	TimePoint day_21 = clips.get_time((char *) "2022-01-21 12:33:44");
-	TimePoint day_22 = clips.get_time((char *) "2022-01-22 12:33:44");
-	TimePoint day_23 = clips.get_time((char *) "2022-01-23 12:33:44");
-	TimePoint day_24 = clips.get_time((char *) "2022-01-24 12:33:44");
-	TimePoint day_25 = clips.get_time((char *) "2022-01-25 12:33:44");
-	TimePoint day_26 = clips.get_time((char *) "2022-01-26 12:33:44");
-	TimePoint day_27 = clips.get_time((char *) "2022-01-27 12:33:44");
-	TimePoint day_28 = clips.get_time((char *) "2022-01-28 12:33:44");
-	TimePoint day_29 = clips.get_time((char *) "2022-01-29 12:33:44");
+			THEN("The columns are the clips in ClipMap order.") {
+				REQUIRE(offset[0] == 0);
+				REQUIRE(offset[n] == m);
 
-	TimePoint day_30 = clips.get_time((char *) "2022-01-30 12:33:44");
+				uint64_t i = 0;
 
-	REQUIRE(day_30 - day_10 ==  2*(day_20 - day_10));
-	REQUIRE(day_30 - day_10 ==  4*(day_15 - day_10));
-	REQUIRE(day_30 - day_10 ==  5*(day_14 - day_10));
-	REQUIRE(day_30 - day_10 == 10*(day_12 - day_10));
-	REQUIRE(day_30 - day_10 == 20*(day_11 - day_10));
+				for (ClipMap::iterator it = thawed.clips.begin(); it != thawed.clips.end(); ++it, i++) {
+					REQUIRE(client[i] == it->first);
 
-	TargetMap target_map = {};
+					Clip clip = {};
 
-	target_map[cli_X] = day_25;
-	target_map[cli_Y] = day_25;
-	target_map[cli_Z] = day_25;
+					for (uint64_t j = offset[i]; j < offset[i + 1]; j++)
+						clip[time[j]] = code[j];
 
-	GIVEN("I create the clips for some clients") {
-		clips.insert_event(cli_U, 'A', day_10);
-		clips.insert_event(cli_U, 'A', day_12);
-		clips.insert_event(cli_U, 'A', day_14);
-		clips.insert_event(cli_U, 'A', day_16);
+					REQUIRE(offset[i + 1] - offset[i] == it->second.size());
+					REQUIRE(clip == it->second);
+				}
+			}
+		}
+	}
 
-		clips.insert_event(cli_V, 'B', day_10);
-		clips.insert_event(cli_V, 'C', day_11);
-		clips.insert_event(cli_V, 'C', day_14);
-		clips.insert_event(cli_V, 'A', day_15);
-		clips.insert_event(cli_V, 'B', day_20);
-		clips.insert_event(cli_V, 'C', day_22);
-		clips.insert_event(cli_V, 'C', day_24);
-		clips.insert_event(cli_V, 'A', day_29);
+	GIVEN("The Python API.") {
+		int ev_id = new_events(), cl_id = new_clients();
 
-		clips.insert_event(cli_W, 'A', day_18);
-		clips.insert_event(cli_W, 'A', day_22);
-		clips.insert_event(cli_W, 'C', day_28);
+		REQUIRE(events_insert_row(ev_id, (char *) "emi_A", (char *) "descr_A", 1.0));
 
-		clips.insert_event(cli_X, 'A', day_10);
-		clips.insert_event(cli_X, 'E', day_14);
-		clips.insert_event(cli_X, 'E', day_24);
-		clips.insert_event(cli_X, 'A', day_27);
-		clips.insert_event(cli_X, 'F', day_30);
+		int clips_id = new_clips(cl_id, ev_id);
 
-		clips.insert_event(cli_Y, 'B', day_12);
-		clips.insert_event(cli_Y, 'D', day_13);
-		clips.insert_event(cli_Y, 'D', day_15);
-		clips.insert_event(cli_Y, 'E', day_16);
-		clips.insert_event(cli_Y, 'F', day_18);
-		clips.insert_event(cli_Y, 'F', day_23);
+		uint64_t n = 99, m = 99;
 
-		clips.insert_event(cli_Z, 'A', day_18);
-		clips.insert_event(cli_Z, 'A', day_20);
-		clips.insert_event(cli_Z, 'A', day_21);
-		clips.insert_event(cli_Z, 'F', day_28);
-		clips.insert_event(cli_Z, 'F', day_30);
+		REQUIRE(clips_export_prepare(99999, n, m) == nullptr);
+		REQUIRE(clips_export_prepare(clips_id, n, m) != nullptr);
+		REQUIRE(n == 0);
+		REQUIRE(m == 0);
 
-		WHEN("I fit everything into a tree") {
-			Targets targ_mm(&clips.clips, target_map);
-			Targets targ_av(&clips.clips, target_map);
-			Targets targ_ll(&clips.clips, target_map);
+		REQUIRE(clips_scan_event(clips_id, (char *) "emi_A", (char *) "descr_A", 1.0, (char *) "cli_A", (char *) "2022-06-04 10:00:00"));
+		REQUIRE(clips_scan_event(clips_id, (char *) "emi_A", (char *) "descr_A", 1.0, (char *) "cli_A", (char *) "2022-06-04 10:01:00"));
 
-			ClipMap clips_copy(clips.clips);
+		void *p_clips = clips_export_prepare(clips_id, n, m);
 
-			Targets targ_sq(&clips_copy, target_map);
+		REQUIRE(p_clips != nullptr);
+		REQUIRE(n == 1);
+		REQUIRE(m == 2);
 
-			TimesToTarget t = targ_mm.predict();
-			REQUIRE(t.size() == 0);
-			t = targ_mm.predict(clients);
-			REQUIRE(t.size() == 0);
-			t = targ_mm.predict(clips.clip_map());
-			REQUIRE(t.size() == 0);
+		std::vector<uint64_t> raw(3 + 2*n + 2*m);
 
-			REQUIRE( targ_mm.fit(tr_log, ag_minimax, 0.8, 12, false));
-			REQUIRE(!targ_mm.fit(tr_log, ag_minimax, 0.8, 12, false));
-			REQUIRE( targ_av.fit(tr_linear, ag_mean, 0.0, 2, false));
-			REQUIRE( targ_ll.fit(tr_linear, ag_longest, 0.0, 2, false));
-			REQUIRE( targ_sq.fit(tr_log, ag_minimax, 0.8, 12, true));
+		clips_export_columns(p_clips, (char *) raw.data(), n, m);
 
-			REQUIRE(targ_mm.tree[0].n_seen == 6);
-			REQUIRE(targ_mm.tree[0].n_target == 3);
-			REQUIRE(targ_mm.tree[0].child.size() == 4);
+		REQUIRE(raw[0] == 1);
+		REQUIRE(raw[1] == 2);
+		REQUIRE(raw[2] == MurmurHash64A("cli_A", 5));
+		REQUIRE(raw[3] == 0);
+		REQUIRE(raw[4] == 2);
+		REQUIRE(raw[6] == raw[5] + 60);
+		REQUIRE(raw[7] == 1);
+		REQUIRE(raw[8] == 1);
 
-			REQUIRE(targ_av.tree[0].n_seen == 6);
-			REQUIRE(targ_av.tree[0].n_target == 3);
-			REQUIRE(targ_av.tree[0].child.size() == 4);
+		destroy_clips(clips_id);
+		destroy_clients(cl_id);
+		destroy_events(ev_id);
+	}
+}
 
-			REQUIRE(targ_mm.tree[0].sum_time_d < targ_av.tree[0].sum_time_d);
-			REQUIRE(targ_mm.tree.size() > targ_av.tree.size());
 
-			REQUIRE(targ_ll.tree[0].n_seen == 6);
-			REQUIRE(targ_ll.tree[0].n_target == 3);
-			REQUIRE(targ_ll.tree[0].child.size() == 4);
+SCENARIO("Test TimeUtil fixed layout time parsing") {
 
-			REQUIRE(targ_sq.tree[0].n_seen == 6);
-			REQUIRE(targ_sq.tree[0].n_target == 3);
-			REQUIRE(targ_sq.tree[0].child.size() == 4);
+	TimeUtil fast, slow;
 
-			THEN("I can make some predictions") {
-				TimesToTarget tt_mm = targ_mm.predict();
-				REQUIRE(tt_mm.size() == 6);
-				TimesToTarget tt_av = targ_av.predict();
-				REQUIRE(tt_av.size() == 6);
-				TimesToTarget tt_ll = targ_av.predict();
-				REQUIRE(tt_ll.size() == 6);
-				TimesToTarget tt_sq = targ_av.predict();
-				REQUIRE(tt_sq.size() == 6);
+	slow.set_time_format((char *) "%Y-%m-%d %H:%M:%S");
+	slow.time_layout = tl_strptime;
 
-				CodeTreeNode node;
-				node.n_seen		= 0;
-				node.n_target	= 0;
-				node.sum_time_d = 1;
+	GIVEN("The default time format") {
+		REQUIRE(fast.time_layout == tl_date_time);
 
-				REQUIRE(targ_av.predict_time(node) == PREDICT_MAX_TIME);
+		char buffer[64];
+		int	 differences = 0, accepted = 0;
 
-				node.n_seen = 1;
+		for (int i = 0; i < 20000; i++) {
+			uint64_t h = MurmurHash64A(&i, sizeof(i));
 
-				REQUIRE(targ_av.predict_time(node) == PREDICT_MAX_TIME);
+			int year = h % 10000, month = (h >> 16) % 14, day = (h >> 24) % 33, hour = (h >> 32) % 25, min = (h >> 40) % 61, sec = (h >> 48) % 63;
 
-				node.n_target = 1;
+			if (i % 2 == 0)
+				year = 1960 + year % 100;
 
-				REQUIRE(targ_av.predict_time(node) > 0.99);
-				REQUIRE(targ_av.predict_time(node) < 1.01);
+			snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d", year, month, day, hour, min, sec);
 
-				node.sum_time_d = 0;
+			TimePoint t_slow = slow.get_time(buffer), t_fast = fast.get_time(buffer);
 
-				REQUIRE(targ_mm.predict_time(node) > 3.0);
-				REQUIRE(targ_mm.predict_time(node) < 3.1);
+			differences += t_slow != t_fast;
+			accepted	+= t_slow >= 0 || fast.parse_fixed_time(buffer, fast.day_cache, t_fast);
+		}
+		REQUIRE(differences == 0);
+		REQUIRE(accepted > 10000);
 
-				REQUIRE(targ_sq.predict_time(node) > 3.0);
-				REQUIRE(targ_sq.predict_time(node) < 3.1);
+		const char *odd[] = {"2022-02-31 10:00:00", "1969-12-31 23:59:59", "0000-03-01 00:00:00", "2022-1-05 10:00:00",
+							 "2022-01-05  10:00:00", "2022-01-05 10:00", "2022-01-05", "2022-01-05 10:00:00.123", " 2022-01-05 10:00:00",
+							 "2022/01/05 10:00:00", "2022-01-05T10:00:00", "2022-00-05 10:00:00", "", "2022-01-05 24:00:00"};
 
-				node.n_seen		= 2;
-				node.sum_time_d = 1;
+		for (const char *p_t : odd)
+			REQUIRE(fast.get_time((char *) p_t) == slow.get_time((char *) p_t));
 
-				REQUIRE(targ_av.predict_time(node) > 1.99);
-				REQUIRE(targ_av.predict_time(node) < 2.01);
+		REQUIRE(fast.get_time((char *) "1970-01-02 00:00:01") == 86401);
+		REQUIRE(fast.get_time((char *) "1969-12-31 23:59:59") == -1);
+	}
 
-				if (clients.id.size() == 6)
-					clients.add_client_id((char *) "unknown_clip");
+	GIVEN("The other fixed layouts") {
+		const char *formats[] = {"%Y-%m-%d", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%dT%H:%M:%SZ", "%Y%m%d%H%M%S"};
+		TimeLayout	layouts[] = {tl_date, tl_iso, tl_iso_z, tl_strptime};
 
-				tt_mm = targ_mm.predict(clients);
-				REQUIRE(tt_mm.size() == 7);
-				double default_t_mm = targ_mm.predict_time(targ_mm.tree[0]);
-				REQUIRE(tt_mm[6] == default_t_mm);
+		const char *times[] = {"2022-06-30", "2022-06-30T23:59:60", "2022-06-30T12:00:00Z", "2022-06-30T12:00:00", "20220630120000",
+							   "2022-06-30 12:00:00Z"};
 
-				tt_av = targ_av.predict(clients);
-				REQUIRE(tt_av.size() == 7);
-				double default_t_av = targ_av.predict_time(targ_av.tree[0]);
-				REQUIRE(tt_av[6] == default_t_av);
+		for (int i = 0; i < 4; i++) {
+			fast.set_time_format((char *) formats[i]);
+			slow.set_time_format((char *) formats[i]);
+			slow.time_layout = tl_strptime;
 
-				tt_sq = targ_sq.predict(clients);
-				REQUIRE(tt_sq.size() == 7);
-				double default_t_sq = targ_sq.predict_time(targ_sq.tree[0]);
-				REQUIRE(tt_sq[6] == default_t_sq);
+			REQUIRE(fast.time_layout == layouts[i]);
 
-				Clips clp(clients, events);
+			for (const char *p_t : times)
+				REQUIRE(fast.get_time((char *) p_t) == slow.get_time((char *) p_t));
+		}
+		REQUIRE(fast.get_time((char *) "20220630120000") == 1656590400);
+	}
+}
 
-				clp.insert_event(0, 'H', day_15);
-				clp.insert_event(0, 'H', day_16);
-				clp.insert_event(0, 'H', day_17);
 
-				clp.insert_event(1, 'A', day_18);
-				clp.insert_event(1, 'A', day_20);
-				clp.insert_event(1, 'A', day_21);
-				clp.insert_event(1, 'H', day_10);
-				clp.insert_event(1, 'H', day_11);
+SCENARIO("Test hash functions and the image tag that records them") {
 
-				clp.insert_event(2, 'A', day_18);
-				clp.insert_event(2, 'A', day_20);
-				clp.insert_event(2, 'A', day_21);
+	char buffer[128];
 
-				double t_mm = targ_mm.predict_clip(clp.clips.begin()->second);
+	GIVEN("The hash functions.") {
+		std::set<uint64_t> wy = {}, mm = {};
 
-				REQUIRE(t_mm == default_t_mm);
+		for (int i = 0; i < 100; i++)
+			buffer[i] = 'a' + (i % 26);
 
-				double t_av = targ_av.predict_clip(clp.clips.begin()->second);
+		for (int len = 1; len <= 100; len++) {
+			REQUIRE(hash_block(hf_murmur, buffer, len) == MurmurHash64A(buffer, len));
+			REQUIRE(hash_block(hf_wyhash, buffer, len) == WyHash64(buffer, len));
+			REQUIRE(WyHash64(buffer, len) != MurmurHash64A(buffer, len));
 
-				REQUIRE(t_av == default_t_av);
+			wy.insert(WyHash64(buffer, len));
+			mm.insert(MurmurHash64A(buffer, len));
+		}
+		REQUIRE(wy.size() == 100);
+		REQUIRE(mm.size() == 100);
 
-				tt_mm = targ_mm.predict(&clp.clips);
-				REQUIRE(tt_mm.size() == 3);
-				REQUIRE(tt_mm[0] == default_t_mm);
-				REQUIRE(tt_mm[1] == tt_mm[2]);
+		REQUIRE(WyHash64("emitter_1", 9) != WyHash64("emitter_2", 9));
+		REQUIRE(WyHash64("emitter_1", 9) == WyHash64(String("emitter_1").c_str(), 9));
 
-				tt_av = targ_av.predict(&clp.clips);
-				REQUIRE(tt_av.size() == 3);
-				REQUIRE(tt_av[0] == default_t_av);
-				REQUIRE(tt_av[1] == tt_av[2]);
+		HashFunction hash_fn = hf_murmur;
 
-				tt_ll = targ_ll.predict(&clp.clips);
-				REQUIRE(tt_ll.size() == 3);
-				REQUIRE(tt_ll[0] == default_t_av);
-				REQUIRE(tt_ll[1] == tt_ll[2]);
-				REQUIRE(tt_ll[1] != tt_av[1]);
+		REQUIRE(parse_hash_function("wyhash", hash_fn));
+		REQUIRE(hash_fn == hf_wyhash);
+		REQUIRE(parse_hash_function("murmur", hash_fn));
+		REQUIRE(hash_fn == hf_murmur);
+		REQUIRE(!parse_hash_function("xxh3", hash_fn));
 
-				tt_sq = targ_sq.predict(&clp.clips);
-				REQUIRE(tt_sq.size() == 3);
-				REQUIRE(tt_sq[0] == default_t_sq);
-				REQUIRE(tt_sq[1] == tt_sq[2]);
-			}
-			THEN("My sequences are as expected") {
-				REQUIRE(targ_sq.p_clips->size() == 6);
+		REQUIRE(hashed_section("events", hf_murmur) == "events");
+		REQUIRE(hashed_section("events", hf_wyhash) == "events/wyhash");
+
+		REQUIRE(find_hashed_section(MurmurHash64A("clients", 7), "clients", hash_fn));
+		REQUIRE(hash_fn == hf_murmur);
+		REQUIRE(find_hashed_section(MurmurHash64A("clients/wyhash", 14), "clients", hash_fn));
+		REQUIRE(hash_fn == hf_wyhash);
+		REQUIRE(!find_hashed_section(MurmurHash64A("clips", 5), "clients", hash_fn));
+	}
+
+	GIVEN("Events, Clients, Clips and Targets using wyhash.") {
+		Events ev = {}, ev_mm = {};
+		Clients cli = {};
+
+		REQUIRE(ev.set_hash_function(hf_wyhash));
+		REQUIRE(cli.set_hash_function(hf_wyhash));
 
-				// Now length should be unaffected
-				Clip clp = targ_sq.p_clips->find(cli_U)->second;
-				REQUIRE(clp.size() == 4);
+		ev.insert_row("emi_A", "descr_A", 1);
+		ev.insert_row("emi_B", "descr_B", 1);
+		ev_mm.insert_row("emi_A", "descr_A", 1);
 
-				clp = targ_sq.p_clips->find(cli_V)->second;
-				REQUIRE(clp.size() == 8);
+		cli.add_client_id("cli_A");
+		cli.add_client_id("cli_B");
 
-				clp = targ_sq.p_clips->find(cli_W)->second;
-				REQUIRE(clp.size() == 3);
+		REQUIRE(!ev.set_hash_function(hf_murmur));
+		REQUIRE(!cli.set_hash_function(hf_murmur));
 
-				clp = targ_sq.p_clips->find(cli_X)->second;
-				REQUIRE(clp.size() == 5);
+		REQUIRE(ev.hash_str("emi_A") == WyHash64("emi_A", 5));
+		REQUIRE(ev.get_str(WyHash64("emi_A", 5)) == "emi_A");
+		REQUIRE(cli.hash_client_id("cli_A") == WyHash64("cli_A", 5));
+		REQUIRE(cli.contains(WyHash64("cli_B", 5)));
 
-				clp = targ_sq.p_clips->find(cli_Y)->second;
-				REQUIRE(clp.size() == 6);
+		REQUIRE(!ev.merge(ev_mm));
+		REQUIRE(!ev_mm.merge(ev));
 
-				clp = targ_sq.p_clips->find(cli_Z)->second;
-				REQUIRE(clp.size() == 5);
+		THEN("Images record the hash function and murmur images are unchanged.") {
+			pBinaryImage p_ev = new BinaryImage, p_mm = new BinaryImage, p_cli = new BinaryImage;
 
-				Clips clp_sq(*targ_sq.p_clips);
-				clp_sq.collapse_to_states();
+			REQUIRE(ev.save(p_ev));
+			REQUIRE(ev_mm.save(p_mm));
+			REQUIRE(cli.save(p_cli));
 
-				// Now we test the collapsed ones, just like the old object used to return
+			ElementHash hs;
 
-				// clips.insert_event(cli_U, 'A', day_10);
-				clp = clp_sq.clips.find(cli_U)->second;
-				REQUIRE(clp.size() == 1);
-				REQUIRE(clp.find(day_10)->second == 'A');
+			memcpy(&hs, (*p_mm)[0].buffer, sizeof(hs));
+			REQUIRE(hs == MurmurHash64A("events", 6));
 
-				// clips.insert_event(cli_V, 'B', day_10);
-				// clips.insert_event(cli_V, 'C', day_11);
-				// clips.insert_event(cli_V, 'A', day_15);
-				// clips.insert_event(cli_V, 'B', day_20);
-				// clips.insert_event(cli_V, 'C', day_22);
-				// clips.insert_event(cli_V, 'A', day_29);
-				clp = clp_sq.clips.find(cli_V)->second;
-				REQUIRE(clp.size() == 6);
-				REQUIRE(clp.find(day_10)->second == 'B');
-				REQUIRE(clp.find(day_11)->second == 'C');
-				REQUIRE(clp.find(day_15)->second == 'A');
-				REQUIRE(clp.find(day_20)->second == 'B');
-				REQUIRE(clp.find(day_22)->second == 'C');
-				REQUIRE(clp.find(day_29)->second == 'A');
+			memcpy(&hs, (*p_ev)[0].buffer, sizeof(hs));
+			REQUIRE(hs == MurmurHash64A("events/wyhash", 13));
 
-				// clips.insert_event(cli_W, 'A', day_18);
-				// clips.insert_event(cli_W, 'C', day_28);
-				clp = clp_sq.clips.find(cli_W)->second;
-				REQUIRE(clp.size() == 2);
-				REQUIRE(clp.find(day_18)->second == 'A');
-				REQUIRE(clp.find(day_28)->second == 'C');
+			Events cpy_ev = {}, cpy_mm = {};
+			Clients cpy_cli = {};
 
-				// clips.insert_event(cli_X, 'A', day_10);
-				// clips.insert_event(cli_X, 'E', day_14);
-				// clips.insert_event(cli_X, 'A', day_27);
-				// clips.insert_event(cli_X, 'F', day_30);
-				clp = clp_sq.clips.find(cli_X)->second;
-				REQUIRE(clp.size() == 4);
-				REQUIRE(clp.find(day_10)->second == 'A');
-				REQUIRE(clp.find(day_14)->second == 'E');
-				REQUIRE(clp.find(day_27)->second == 'A');
-				REQUIRE(clp.find(day_30)->second == 'F');
+			REQUIRE(cpy_ev.load(p_ev));
+			REQUIRE(cpy_mm.load(p_mm));
+			REQUIRE(cpy_cli.load(p_cli));
 
-				// clips.insert_event(cli_Y, 'B', day_12);
-				// clips.insert_event(cli_Y, 'D', day_13);
-				// clips.insert_event(cli_Y, 'E', day_16);
-				// clips.insert_event(cli_Y, 'F', day_18);
-				clp = clp_sq.clips.find(cli_Y)->second;
-				REQUIRE(clp.size() == 4);
-				REQUIRE(clp.find(day_12)->second == 'B');
-				REQUIRE(clp.find(day_13)->second == 'D');
-				REQUIRE(clp.find(day_16)->second == 'E');
-				REQUIRE(clp.find(day_18)->second == 'F');
+			REQUIRE(cpy_ev.hash_function == hf_wyhash);
+			REQUIRE(cpy_mm.hash_function == hf_murmur);
+			REQUIRE(cpy_cli.hash_function == hf_wyhash);
+			REQUIRE(cpy_ev.num_events() == 2);
+			REQUIRE(cpy_cli.id.size() == 2);
 
-				// clips.insert_event(cli_Z, 'A', day_18);
-				// clips.insert_event(cli_Z, 'F', day_28);
+			cpy_ev.insert_row("emi_A", "descr_A", 1);
+			REQUIRE(cpy_ev.num_events() == 2);
 
-				clp = clp_sq.clips.find(cli_Z)->second;
-				REQUIRE(clp.size() == 2);
-				REQUIRE(clp.find(day_18)->second == 'A');
-				REQUIRE(clp.find(day_28)->second == 'F');
-			}
+			delete p_ev;
+			delete p_mm;
+			delete p_cli;
 		}
-	}
-}
-
 
-SCENARIO("Test Targets.save() / Targets.load()") {
+		THEN("Clips and Targets hash consistently.") {
+			Clips clips(cli, ev);
 
-	Events	ev = {};
-	Clients	cli = {};
+			REQUIRE(clips.client_hash_function() == hf_wyhash);
 
-	char timestamp[80];
-	char client[80];
-	char emitter[80];
-	char description[80];
-	double w;
+			REQUIRE(clips.scan_event("emi_A", "descr_A", 1, "cli_A", "2022-06-04 10:00:00"));
+			REQUIRE(clips.scan_event("emi_B", "descr_B", 1, "cli_A", "2022-06-04 10:01:00"));
+			REQUIRE(!clips.scan_event("emi_B", "descr_B", 1, "cli_C", "2022-06-04 10:01:00"));
 
-	for (int i = 0; i < 5000; i++) {
-		sprintf(client, "cli-id%i", 77*(i % 500));
-		sprintf(emitter, "emi%i", (int) sqrt(i % 100));
-		sprintf(description, "prod%i", (i % 5) + 1);
+			REQUIRE(clips.clips.size() == 1);
+			REQUIRE(clips.clips.count(WyHash64("cli_A", 5)) == 1);
 
-		w = i % 11 ? 1.3 : 5.0;
+			Targets targets(clips.clip_map(), {});
 
-		ev.insert_row(emitter, description, w);
-		cli.add_client_id(client);
-	}
+			REQUIRE(targets.set_hash_function(clips.client_hash_function()));
+			REQUIRE(targets.insert_target("cli_A", "2022-06-05 10:00:00"));
+			REQUIRE(!targets.set_hash_function(hf_murmur));
+			REQUIRE(targets.target.count(WyHash64("cli_A", 5)) == 1);
 
-	Clips clp(cli, ev), clp_void({}, {});
+			pBinaryImage p_targ = new BinaryImage;
 
-	int i = 0;
-	for (int hour = 10; hour < 12; hour++) {
-		for (int min = 10; min < 60; min++) {
-			for (int sec = 10; sec < 60; sec++) {
-				i++;
+			REQUIRE(targets.save(p_targ));
 
-				sprintf(timestamp, "2022-06-02 %i:%i:%i", hour, min, sec);
-				sprintf(client, "cli-id%i", 77*(i % 500));
-				sprintf(emitter, "emi%i", (int) sqrt(i % 100));
-				sprintf(description, "prod%i", (i % 5) + 1);
+			Targets cpy_targ(nullptr, {});
 
-				w = i % 11 ? 1.3 : 5.0;
+			REQUIRE(cpy_targ.load(p_targ));
+			REQUIRE(cpy_targ.hash_function == hf_wyhash);
 
-				clp.scan_event(emitter, description, w, client, timestamp);
-			}
+			delete p_targ;
 		}
 	}
 
-	Targets trg_def(&clp.clips, {}), trg_alt(&clp_void.clips, {});
-
-	sprintf(timestamp, "2022-06-03 01:02:03");
+	GIVEN("The Python API.") {
+		int ev_id = new_events(), cl_id = new_clients();
 
-	for (int i = 0; i < 5000; i++) {
-		if (i % 9 == 2) {
-			sprintf(client, "cli-id%i", 77*(i % 500));
+		REQUIRE(!events_set_hash_function(99999, (char *) "wyhash"));
+		REQUIRE(!events_set_hash_function(ev_id, (char *) "bogus"));
+		REQUIRE(events_set_hash_function(ev_id, (char *) "wyhash"));
+		REQUIRE(!clients_set_hash_function(99999, (char *) "wyhash"));
+		REQUIRE(!clients_set_hash_function(cl_id, (char *) "bogus"));
+		REQUIRE(clients_set_hash_function(cl_id, (char *) "wyhash"));
 
-			trg_def.insert_target(client, timestamp);
-		}
-	}
+		REQUIRE(events_insert_row(ev_id, (char *) "emi_A", (char *) "descr_A", 1.0));
+		REQUIRE(String(events_describe_next_event(ev_id, (char *) "")) == "emi_A\tdescr_A\t1.00000\t1");
+		REQUIRE(String(events_describe_next_event(ev_id, (char *) "emi_A\tdescr_A\t1.00000\t1")) == "");
 
-	REQUIRE(trg_def.fit(tr_log, ag_minimax, 0.6, 10, false));
+		REQUIRE(clients_add_client_id(cl_id, (char *) "cli_A"));
+		REQUIRE(!clients_add_client_id(cl_id, (char *) "cli_A"));
 
-	WHEN("I copy them.") {
-		Targets cpy_def({}, {}), cpy_alt({}, {});
+		int clips_id = new_clips(cl_id, ev_id);
 
-		pBinaryImage p_def = new BinaryImage;
+		REQUIRE(clips_scan_event(clips_id, (char *) "emi_A", (char *) "descr_A", 1.0, (char *) "cli_A", (char *) "2022-06-04 10:00:00"));
+		REQUIRE(String(clips_describe_clip(clips_id, (char *) "cli_A")) != "");
 
-		REQUIRE(trg_def.save(p_def));
-		REQUIRE(cpy_def.load(p_def));
+		int targ_id = new_targets(clips_id);
 
-		delete p_def;
+		REQUIRE(targets_insert_target(targ_id, (char *) "cli_A", (char *) "2022-06-05 10:00:00"));
+		REQUIRE(!targets_insert_target(targ_id, (char *) "cli_A", (char *) "2022-06-06 10:00:00"));
+		REQUIRE(targets_num_targets(targ_id) == 1);
 
-		pBinaryImage p_alt = new BinaryImage;
+		destroy_targets(targ_id);
+		destroy_clips(clips_id);
+		destroy_clients(cl_id);
+		destroy_events(ev_id);
+	}
+}
 
-		REQUIRE(trg_alt.save(p_alt));
-		REQUIRE(cpy_alt.load(p_alt));
 
-		delete p_alt;
+SCENARIO("Benchmark the per row cost of the hash functions", "[.][benchmark]") {
 
-		THEN("They are identical.") {
-			REQUIRE(strcmp(trg_def.time_format, cpy_def.time_format) == 0);
-			REQUIRE(trg_def.transform == cpy_def.transform);
-			REQUIRE(trg_def.aggregate == cpy_def.aggregate);
-			REQUIRE(trg_def.binomial_z == cpy_def.binomial_z);
-			REQUIRE(trg_def.binomial_z_sqr == cpy_def.binomial_z_sqr);
-			REQUIRE(trg_def.binomial_z_sqr_div_2 == cpy_def.binomial_z_sqr_div_2);
-			REQUIRE(trg_def.tree_depth == cpy_def.tree_depth);
+	const int n_rows = 2000000;
 
-			REQUIRE(strcmp(trg_alt.time_format, cpy_alt.time_format) == 0);
-			REQUIRE(trg_alt.transform == cpy_alt.transform);
-			REQUIRE(trg_alt.aggregate == cpy_alt.aggregate);
-			REQUIRE(trg_alt.binomial_z == cpy_alt.binomial_z);
-			REQUIRE(trg_alt.binomial_z_sqr == cpy_alt.binomial_z_sqr);
-			REQUIRE(trg_alt.binomial_z_sqr_div_2 == cpy_alt.binomial_z_sqr_div_2);
-			REQUIRE(trg_alt.tree_depth == cpy_alt.tree_depth);
+	std::vector<String> str = {};
 
-			REQUIRE(trg_def.p_clips->size() == cpy_def.p_clips->size()); {
-				ClipMap::iterator it_clip1 = trg_def.p_clips->begin(), it_clip2 = cpy_def.p_clips->begin();
+	for (int i = 0; i < 10000; i++) {
+		char buffer[80];
 
-				for (int i = 0; i < 10; i++) {
-					if (it_clip1 == trg_def.p_clips->end())
-						break;
+		sprintf(buffer, i % 2 ? "emitter_%i" : "a_longer_product_description_%i", i);
 
-					REQUIRE(it_clip1->first			== it_clip2->first);
-					REQUIRE(it_clip1->second.size()	== it_clip2->second.size());
-					Clip::iterator it1 = it_clip1->second.begin(), it2 = it_clip2->second.begin();
+		str.push_back(buffer);
+	}
 
-					for (int j = 0; j < 10; j++) {
-						if (it1 == it_clip1->second.end())
-							break;
+	HashFunction all[] = {hf_murmur, hf_wyhash};
 
-						REQUIRE(it1->first	== it2->first);
-						REQUIRE(it1->second	== it2->second);
+	for (int k = 0; k < 2; k++) {
+		uint64_t chk = 0;
 
-						++it1;
-						++it2;
-					}
+		auto t0 = std::chrono::steady_clock::now();
 
-					++it_clip1;
-					++it_clip2;
-				}
-			}
-			REQUIRE(trg_alt.p_clips->size() == cpy_alt.p_clips->size()); {
-				ClipMap::iterator it_clip1 = trg_alt.p_clips->begin(), it_clip2 = cpy_alt.p_clips->begin();
+		for (int i = 0; i < n_rows; i++)
+			chk += hash_block(all[k], str[i % 10000].c_str(), str[i % 10000].length());
 
-				for (int i = 0; i < 10; i++) {
-					if (it_clip1 == trg_alt.p_clips->end())
-						break;
+		auto t1 = std::chrono::steady_clock::now();
 
-					REQUIRE(it_clip1->first			== it_clip2->first);
-					REQUIRE(it_clip1->second.size()	== it_clip2->second.size());
-					Clip::iterator it1 = it_clip1->second.begin(), it2 = it_clip2->second.begin();
+		Events ev = {};
 
-					for (int j = 0; j < 10; j++) {
-						if (it1 == it_clip1->second.end())
-							break;
+		ev.set_hash_function(all[k]);
 
-						REQUIRE(it1->first	== it2->first);
-						REQUIRE(it1->second	== it2->second);
+		for (int i = 0; i < n_rows; i++)
+			ev.insert_row(str[(i*7) % 10000].c_str(), str[(i*3) % 1000].c_str(), 1);
 
-						++it1;
-						++it2;
-					}
+		auto t2 = std::chrono::steady_clock::now();
 
-					++it_clip1;
-					++it_clip2;
-				}
-			}
-			REQUIRE(trg_def.target.size() == cpy_def.target.size()); {
-				TargetMap::iterator it1 = trg_def.target.begin(), it2 = cpy_def.target.begin();
+		printf("%-8s hash: %6.2f ns/string  insert_row: %7.2f ns/row  (%lx)\n", k == 0 ? "murmur" : "wyhash",
+			   std::chrono::duration<double, std::nano>(t1 - t0).count()/n_rows,
+			   std::chrono::duration<double, std::nano>(t2 - t1).count()/n_rows, chk & 0xff);
+	}
+}
 
-				for (int i = 0; i < 10; i++) {
-					if (it1 == trg_def.target.end())
-						break;
 
-					REQUIRE(it1->first	== it2->first);
-					REQUIRE(it1->second	== it2->second);
+SCENARIO("Benchmark event_code() with and without freeze()", "[.][benchmark]") {
 
-					++it1;
-					++it2;
-				}
-			}
-			REQUIRE(trg_alt.target.size() == cpy_alt.target.size()); {
-				TargetMap::iterator it1 = trg_alt.target.begin(), it2 = cpy_alt.target.begin();
+	const int n_rows = 2000000;
 
-				for (int i = 0; i < 10; i++) {
-					if (it1 == trg_alt.target.end())
-						break;
+	Events ev = {};
 
-					REQUIRE(it1->first	== it2->first);
-					REQUIRE(it1->second	== it2->second);
+	std::vector<BinEventPt> ept = {};
 
-					++it1;
-					++it2;
-				}
-			}
-			REQUIRE(trg_def.tree.size() == cpy_def.tree.size()); {
-				for (int i = 0; i < 10; i++) {
-					if (i == trg_def.tree.size())
-						break;
+	for (int i = 0; i < 5000; i++) {
+		char emitter[80], description[80];
 
-					REQUIRE(trg_def.tree[i].n_seen		 == cpy_def.tree[i].n_seen);
-					REQUIRE(trg_def.tree[i].n_target	 == cpy_def.tree[i].n_target);
-					REQUIRE(trg_def.tree[i].sum_time_d	 == cpy_def.tree[i].sum_time_d);
-					REQUIRE(trg_def.tree[i].child.size() == cpy_def.tree[i].child.size());
+		sprintf(emitter, "emitter_%i", i % 97);
+		sprintf(description, "description_%i", i);
 
-					ChildIndex::iterator it1 = trg_def.tree[i].child.begin(), it2 = cpy_def.tree[i].child.begin();
+		ev.define_event(emitter, description, 1 + i % 3, i + 1);
 
-					for (int j = 0; j < 10; j++) {
-						if (it1 == trg_def.tree[i].child.end())
-							break;
+		BinEventPt ep = {MurmurHash64A(emitter, strlen(emitter)), MurmurHash64A(description, strlen(description)), (double) (1 + i % 3)};
 
-						REQUIRE(it1->first	== it2->first);
-						REQUIRE(it1->second	== it2->second);
+		ept.push_back(ep);
+	}
 
-						++it1;
-						++it2;
-					}
-				}
-			}
-			REQUIRE(trg_alt.tree.size() == cpy_alt.tree.size()); {
-				for (int i = 0; i < 10; i++) {
-					if (i == trg_alt.tree.size())
-						break;
+	for (int k = 0; k < 2; k++) {
+		if (k == 1)
+			ev.freeze();
 
-					REQUIRE(trg_alt.tree[i].n_seen		 == cpy_alt.tree[i].n_seen);
-					REQUIRE(trg_alt.tree[i].n_target	 == cpy_alt.tree[i].n_target);
-					REQUIRE(trg_alt.tree[i].sum_time_d	 == cpy_alt.tree[i].sum_time_d);
-					REQUIRE(trg_alt.tree[i].child.size() == cpy_alt.tree[i].child.size());
+		uint64_t chk = 0;
 
-					ChildIndex::iterator it1 = trg_alt.tree[i].child.begin(), it2 = cpy_alt.tree[i].child.begin();
+		auto t0 = std::chrono::steady_clock::now();
 
-					for (int j = 0; j < 10; j++) {
-						if (it1 == trg_alt.tree[i].child.end())
-							break;
+		for (int i = 0; i < n_rows; i++)
+			chk += ev.event_code(ept[((uint64_t) i*7919) % 5000]);
 
-						REQUIRE(it1->first	== it2->first);
-						REQUIRE(it1->second	== it2->second);
+		auto t1 = std::chrono::steady_clock::now();
 
-						++it1;
-						++it2;
-					}
-				}
-			}
-		}
+		printf("%-8s event_code: %6.2f ns/row  (%lx)\n", k == 0 ? "EventMap" : "frozen",
+			   std::chrono::duration<double, std::nano>(t1 - t0).count()/n_rows, chk & 0xff);
 	}
 }
 
@@ -1824,9 +4573,38 @@ SCENARIO("Extended Testing Emulating the Python API ") {
 	REQUIRE(hash_a.length() == 18);
 	REQUIRE(hash_a == hash_a_idx);
 
+	int cl_bulk = new_clients();
+
+	char	*bulk_cli[] = {(char *) "cli_A", (char *) "cli_C", (char *) "cli_A"};
+	uint64_t bulk_len[] = {5, 5, 5};
+	uint64_t bulk_hash[] = {0, 0};
+
+	sscanf(hash_a.c_str(), "<%016lx>", &bulk_hash[0]);
+
+	uint64_t cli_hash[3];
+
+	REQUIRE(clients_hash_function(99999) == -1);
+	REQUIRE(clients_hash_function(cl_bulk) == hf_murmur);
+
+	hash_client_ids(clients_hash_function(cl_bulk), bulk_cli, bulk_len, 3, cli_hash);
+
+	REQUIRE(cli_hash[0] == cli_hash[2]);
+	REQUIRE(clients_add_client_hashes(cl_bulk, cli_hash, 3) == 2);
+	REQUIRE(clients_add_client_hashes(99999, bulk_hash, 2) == -1);
+	REQUIRE(clients_add_client_hashes(cl_bulk, bulk_hash, 2) == 0);
+	REQUIRE(clients_load_client_ids(99999, (char *) "/tmp/no/such/file.txt") == -1);
+	REQUIRE(clients_load_client_ids(cl_bulk, (char *) "/tmp/no/such/file.txt") == -1);
+	REQUIRE(clients_num_clients(cl_bulk) == 2);
+	REQUIRE(hash_a == clients_hash_by_index(cl_bulk, 0));
+
+	REQUIRE(destroy_clients(cl_bulk));
+
 	int clips_id = new_clips(cl_id, ev_id);
 	REQUIRE(clips_id > 0);
 	REQUIRE(clips_set_time_format(clips_id, (char *) "%Y-%m-%d %H:%M:%S"));
+	REQUIRE(!clips_set_client_filter(99999, true));
+	REQUIRE(clips_set_client_filter(clips_id, false));
+	REQUIRE(clips_set_client_filter(clips_id, true));
 
 	REQUIRE(clips_scan_event(clips_id, (char *) "emi_A", (char *) "descr_A", 1.0, (char *) "cli_A", (char *) "2022-06-04 10:00:00"));
 	REQUIRE(clips_scan_event(clips_id, (char *) "emi_B", (char *) "descr_B", 1.0, (char *) "cli_A", (char *) "2022-06-04 10:01:00"));
@@ -1834,6 +4612,30 @@ SCENARIO("Extended Testing Emulating the Python API ") {
 	REQUIRE(!clips_scan_event(clips_id, (char *) "emi_X", (char *) "descr_X", 1.0, (char *) "cli_A", (char *) "2022-06-04 10:02:00"));
 	REQUIRE(!clips_scan_event(clips_id, (char *) "emi_A", (char *) "descr_A", 1.0, (char *) "cli_X", (char *) "2022-06-04 10:02:00"));
 
+	REQUIRE(!clips_set_history(99999, 8, 0));
+	REQUIRE(!clips_set_history(clips_id, -1, 0));
+	REQUIRE(clips_set_history(clips_id, 8, 0));
+	REQUIRE(clips_set_history(clips_id, 0, 0));
+
+	int clips_id2 = new_clips(cl_id, ev_id);
+	REQUIRE(clips_id2 > 0);
+	REQUIRE(!clips_begin_bulk(99999, false));
+	REQUIRE(clips_begin_bulk(clips_id2, false));
+	REQUIRE(clips_scan_event(clips_id2, (char *) "emi_B", (char *) "descr_B", 1.0, (char *) "cli_A", (char *) "2022-06-04 10:01:00"));
+	REQUIRE(!clips_end_bulk(99999));
+	REQUIRE(clips_end_bulk(clips_id2));
+	REQUIRE(clips_num_events(clips_id2) == 1);
+
+	REQUIRE(!clips_merge(clips_id, clips_id));
+	REQUIRE(!clips_merge(clips_id, 99999));
+	REQUIRE(!clips_merge(99999, clips_id2));
+	REQUIRE(clips_merge(clips_id, clips_id2));
+	REQUIRE(clips_num_events(clips_id) == 3);
+	REQUIRE(destroy_clips(clips_id2));
+
+	REQUIRE(!clips_freeze(99999, false));
+	REQUIRE(clips_freeze(clips_id, true));
+
 	REQUIRE(clips_num_clips(clips_id) == 2);
 	REQUIRE(clips_num_events(clips_id) == 3);
 
@@ -1855,6 +4657,9 @@ SCENARIO("Extended Testing Emulating the Python API ") {
 	REQUIRE(targets_insert_target(targ_id, (char *) "cli_A", (char *) "2022-06-04 10:02:00"));
 	REQUIRE(!targets_insert_target(targ_id, (char *) "cli_A", (char *) "2022-06-04 10:02:00"));
 	REQUIRE(targets_num_targets(targ_id) == 1);
+	REQUIRE(!targets_set_window(targ_id, (char *) "2022-06", (char *) ""));
+	REQUIRE(!targets_set_window(targ_id, (char *) "", (char *) "June"));
+	REQUIRE(targets_set_window(targ_id, (char *) "", (char *) ""));
 	REQUIRE(targets_fit(targ_id, (char *) "log", (char *) "mean", 0.5, 5, 0));
 
 	String tree_desc = targets_describe_tree(targ_id);
@@ -2271,6 +5076,7 @@ SCENARIO("Error paths from coverage report") {
 	REQUIRE(new_targets(99999) == -1);
 	REQUIRE(!destroy_targets(99999));
 	REQUIRE(!targets_set_time_format(99999, (char *) "%Y"));
+	REQUIRE(!targets_set_window(99999, (char *) "", (char *) ""));
 	REQUIRE(!targets_insert_target(99999, (char *) "cli", (char *) "2022-06-01 00:00:00"));
 	REQUIRE(!targets_fit(99999, (char *) "log", (char *) "mean", 0.5, 2, 0));
 	REQUIRE(targets_predict_clients(99999, cl_id) == -1);
@@ -2543,6 +5349,25 @@ SCENARIO("Test for optimize_events() (basic)") {
 				REQUIRE(first_line_alt == "SUCCESS");
 			}
 		}
+
+		WHEN("I run it on a frozen copy of the clips") {
+			Events events_frz = events;
+			Clips  clips_frz(clips);
+
+			clips_frz.freeze(true);
+
+			String log	   = events.optimize_events(clips, target_map, 3, 2, 0.0001, nullptr, nullptr, tr_linear, ag_longest, 0.5, 10,
+												true, 0.00693, 0.95, true);
+			String log_frz = events_frz.optimize_events(clips_frz, target_map, 3, 2, 0.0001, nullptr, nullptr, tr_linear, ag_longest,
+														0.5, 10, true, 0.00693, 0.95, true);
+
+			THEN("The result is the same and the clips are not thawed.") {
+				REQUIRE(log_frz == log);
+				REQUIRE(clips_frz.is_frozen());
+				REQUIRE(clips_frz.frozen_clips()->compressed);
+				REQUIRE(clips_frz.num_events() == 6);
+			}
+		}
 	}
 
 	GIVEN("A dataset where Clips contains a code that is not defined in Events") {
@@ -105,6 +105,18 @@ def test_events():
 
 	assert ev3.num_events() == 2
 
+	evs = reels.Events(max_num_events = 5, discovery = 'space_saving', hash_function = 'wyhash', decay_half_life = 1000)
+	assert evs.insert_row('emi1', 'des', 1)
+
+	evr = reels.Events(binary_image = evs.save_as_binary_image())
+	prt = reels.Events(binary_image = evr.save_as_binary_image(empty = True))
+
+	assert prt.num_events() == 0
+	assert prt.insert_row('emi3', 'des', 1)
+	assert evr.merge(prt)
+	assert evr.num_events() == 2
+	assert not evr.merge(reels.Events())
+
 	assert evn.insert_row('emi2', 'des3', 1)
 	assert evn.num_events() == 3
 
@@ -214,6 +226,28 @@ def test_clients():
 
 	assert cl3.num_clients() == 0
 
+	import numpy as np
+
+	cl5 = reels.Clients(client_ids = ['cli1', 'cli2', '', 'cli1'])
+
+	assert cl5.num_clients() == 2
+	assert cl5.add_client_ids(['cli2', 'cli3']) == 1
+	assert list(cl5.client_hashes()) == [cl5.hash_client_id('cli%i' % i) for i in range(1, 4)]
+
+	hashes = np.array([int(h[1:-1], 16) for h in cl5.client_hashes()], dtype = np.uint64)
+
+	cl6 = reels.Clients(client_ids = hashes)
+
+	assert cl6.num_clients() == 3
+	assert cl6.add_client_ids(hashes) == 0
+	assert list(cl6.client_hashes()) == list(cl5.client_hashes())
+
+	try:
+		cl6.add_client_ids(hashes.astype(np.float64))
+		assert False
+	except TypeError:
+		pass
+
 	cl4 = reels.Clients()
 
 	assert not cl4.load_from_binary_image('hi')
@@ -318,6 +352,26 @@ def test_clips():
 
 	assert ll1 == ll4
 
+	cols = clp.export_columns()
+
+	assert [int(h) for h in cols['client_hash']] == sorted(int(h[1:-1], 16) for h in ll1)
+	assert cols['offset'][0] == 0 and cols['offset'][3] == 7
+
+	codes = {}
+	for i in range(3):
+		codes['<%016x>' % cols['client_hash'][i]] = list(cols['code'][cols['offset'][i]:cols['offset'][i + 1]])
+
+	assert codes == {cli.hash_client_id('cli1'): [1, 2], cli.hash_client_id('cli2'): [1, 1, 3], cli.hash_client_id('cli3'): [2, 3]}
+	assert cols['time'].dtype == 'int64'
+	assert not cols['time'].flags.writeable
+
+	clp5 = reels.Clips(reels.Clients(), reels.Events(), binary_image = clp.save_as_binary_image(empty = True))
+
+	assert clp5.num_clips() == 0
+	assert clp5.scan_event('em2', 'des', 1, 'cli4', '2022-06-01 09:00:00')
+	assert not clp5.scan_event('em2', 'des', 1, 'cli9', '2022-06-01 09:00:00')
+	assert clp5.num_clips() == 1
+
 	clp = reels.Clips(cli, evn, time_format = '%Y%m%d%H%M')
 	assert clp.scan_event('em1', 'des', 1, 'cli1', '202206010900')
 	assert clp.scan_event('em2', 'des', 1, 'cli1', '202206010901')